@@ -0,0 +1,184 @@
+#!/usr/bin/env python
+"""\
+
+Stream g-code to grbl in framed mode
+
+Sends $B to switch grbl to framed mode, then streams the program as
+CRC-checked line frames with up to WINDOW frames unacknowledged.
+Each frame is acknowledged with its status once executed. A NAK, or
+no acknowledgement within the timeout, resends all unacknowledged
+frames from the oldest (go-back-N). Text output from grbl, like
+status reports and [MSG:] lines, is printed as it arrives. Real-time
+commands can still be sent as raw ASCII bytes between frames. See
+lib/grbl/src/serial_frame.h for the frame format. Raster hosts can build
+scanline frames with scanline_payload(), see lib/grbl/src/raster.h.
+
+---------------------
+The MIT License (MIT)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+---------------------
+"""
+
+import argparse
+import struct
+import time
+
+FRAME_START = 0x02
+FRAME_END = 0x03
+FRAME_ESCAPE = 0x10
+FRAME_ESCAPE_XOR = 0x20
+ESCAPED = (FRAME_START, FRAME_END, FRAME_ESCAPE, 0x18, ord('?'), ord('~'), ord('!'))
+
+WINDOW = 4 # SERIAL_FRAME_WINDOW in config.h
+ACK_TIMEOUT = 2.0 # Seconds. Long moves can hold a frame in grbl's queue for a while.
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE."""
+    crc = 0xFFFF
+    for b in bytearray(data):
+        crc ^= b << 8
+        for i in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def encode_frame(frame_type, seq, payload=b''):
+    body = bytearray([ord(frame_type), seq]) + bytearray(payload)
+    crc = crc16(body)
+    body += bytearray([crc >> 8, crc & 0xFF])
+    out = bytearray([FRAME_START])
+    for b in body:
+        if b in ESCAPED: out += bytearray([FRAME_ESCAPE, b ^ FRAME_ESCAPE_XOR])
+        else: out.append(b)
+    out.append(FRAME_END)
+    return bytes(out)
+
+
+RASTER_AXIS_Y = 0x01 # RASTER_FLAG_* in raster.h
+RASTER_REVERSE = 0x02
+RASTER_CONTINUED = 0x04
+
+
+def scanline_payload(flags, x, y, pitch, feed, power, pixels):
+    """Payload of an 'S' frame. x, y in mm work coordinates, pitch in mm,
+    feed in mm/min, power is S of pixel value 255, pixels are 0-255."""
+    return struct.pack('<B5f', flags, x, y, pitch, feed, power) + bytes(bytearray(pixels))
+
+
+class FrameReader:
+    """Splits grbl's output into text lines and decoded frames."""
+
+    def __init__(self):
+        self.text = bytearray()
+        self.body = None
+        self.escape = False
+
+    def feed(self, data):
+        events = []
+        for b in bytearray(data):
+            if b == FRAME_START:
+                self.body = bytearray()
+                self.escape = False
+            elif self.body is None:
+                if b == ord('\n'):
+                    events.append(('text', self.text.decode('ascii', 'replace').strip()))
+                    self.text = bytearray()
+                else:
+                    self.text.append(b)
+            elif b == FRAME_END:
+                body, self.body = self.body, None
+                if len(body) >= 4 and crc16(body[:-2]) == (body[-2] << 8 | body[-1]):
+                    events.append((chr(body[0]), body[1], body[2:-2]))
+            elif self.escape:
+                self.body.append(b ^ FRAME_ESCAPE_XOR)
+                self.escape = False
+            elif b == FRAME_ESCAPE:
+                self.escape = True
+            else:
+                self.body.append(b)
+        return events
+
+
+if __name__ == '__main__':
+    import serial
+    from gcode_tokenize import Tokenizer, filter_line
+
+    parser = argparse.ArgumentParser(description='Stream g-code file to grbl in framed mode. (pySerial and argparse libraries required)')
+    parser.add_argument('gcode_file', type=argparse.FileType('r'),
+            help='g-code filename to be streamed')
+    parser.add_argument('device_file',
+            help='serial device path')
+    parser.add_argument('-q','--quiet',action='store_true', default=False,
+            help='suppress output text')
+    parser.add_argument('-t','--tokenize',action='store_true', default=False,
+            help='send g-code blocks tokenized (see gcode_tokenize.py)')
+    args = parser.parse_args()
+
+    s = serial.Serial(args.device_file, 115200, timeout=0.05)
+    print("Initializing grbl...")
+    s.write(b"\r\n\r\n")
+    time.sleep(2)
+    s.flushInput()
+    s.write(b"$B\n")
+    while s.readline().strip() != b'ok': pass
+
+    tokenizer = Tokenizer() if args.tokenize else None
+    lines = [line for line in (filter_line(line) for line in args.gcode_file) if line]
+    blocks = [] # Tokenized when first sent, so a tokenizer reset applies to the blocks after it.
+
+    reader = FrameReader()
+    base = 0 # Index of the oldest unacknowledged block.
+    sent = 0 # Blocks sent at least once.
+    errors = 0
+    last_ack = time.time()
+    while base < len(lines):
+        while sent < len(lines) and sent - base < WINDOW:
+            if sent == len(blocks):
+                blocks.append(tokenizer.block(lines[sent]) if tokenizer else lines[sent].encode('ascii'))
+            s.write(encode_frame('L', sent & 0xFF, blocks[sent]))
+            sent += 1
+        for event in reader.feed(s.read(256)):
+            if event[0] == 'text':
+                if event[1] and not args.quiet: print(event[1])
+                if tokenizer and event[1].startswith(('ALARM', 'Grbl')):
+                    tokenizer.reset() # Grbl dropped its axis references.
+            elif event[0] == 'A':
+                acked = base + ((event[1] - base) & 0xFF)
+                if acked < sent: # Cumulative. Repeats of older ACKs are ignored.
+                    status = event[2][0] if event[2] else 0
+                    if status:
+                        errors += 1
+                        if tokenizer: tokenizer.reset() # Blocks sent after this one fail until an absolute word.
+                        print("error:%d in block %d: %r" % (status, acked+1, blocks[acked]))
+                    base = acked + 1
+                    last_ack = time.time()
+            elif event[0] == 'N':
+                base = base + ((event[1] - base) & 0xFF)
+                sent = base # Go back to the expected frame.
+        if sent > base and time.time() - last_ack > ACK_TIMEOUT:
+            sent = base
+            last_ack = time.time()
+
+    s.write(encode_frame('X', 0))
+    print("G-code streaming finished with %d errors!\n" % errors)
+    print("WARNING: Wait until grbl completes buffered g-code blocks before exiting.")
+    s.close()
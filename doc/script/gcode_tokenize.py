@@ -0,0 +1,188 @@
+#!/usr/bin/env python
+"""\
+
+Convert a g-code program to Grbl's tokenized g-code format
+
+Each word becomes a token byte carrying the letter, followed by a
+fixed-point value in 6-bit payload bytes. Axis words are sent relative
+to the previous value of the axis when that is shorter, and other words
+stay text when that is shorter. Grbl decodes a
+tokenized word to exactly the float its text gives, so the converted
+program runs identically. Grbl forgets the axis references after a reset,
+an error and around a stored job, and rejects delta words until the next
+absolute word of the axis; streamers call Tokenizer.reset() on the same
+responses. Words that have no exact token form (more
+than 4 decimals or 8 digits, or -0) are kept as text, and lines that
+are not g-code blocks ('$' commands, malformed lines) are copied as
+they are, so Grbl still reports their errors.
+
+The output has one block per line and can be streamed with
+stream.py -t, or stored with $FW=NAME ... $FE. See
+lib/grbl/src/gcode_token.h for the format.
+
+---------------------
+The MIT License (MIT)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+---------------------
+"""
+
+import argparse
+import sys
+
+TOKEN_PAYLOAD = 0x80
+TOKEN_WORD = 0xC0
+TOKEN_DELTA = 0xE0
+DECIMALS_MAX = 4
+MAX_INT_DIGITS = 8 # As read_float() in nuts_bolts.c
+AXES = 'XYZA'
+
+
+def filter_line(line):
+    """Strip spaces, comments and block deletes and capitalize, as Grbl's serial receiver does."""
+    out = []
+    comment = False
+    for c in line:
+        if comment:
+            if c == ')': comment = False
+        elif c == '(': comment = True
+        elif c == ';': break
+        elif c <= ' ' or c == '/': pass
+        else: out.append(c.upper())
+    return ''.join(out)
+
+
+def read_number(line, pos):
+    """Parse a number as read_float() does. Returns (negative, intval, decimals, ndigit, end)."""
+    negative = False
+    if pos < len(line) and line[pos] in '+-':
+        negative = line[pos] == '-'
+        pos += 1
+    intval = 0
+    decimals = 0
+    ndigit = 0
+    isdecimal = False
+    while pos < len(line):
+        c = line[pos]
+        if c.isdigit():
+            ndigit += 1
+            intval = intval*10 + int(c)
+            if isdecimal: decimals += 1
+        elif c == '.' and not isdecimal:
+            isdecimal = True
+        else:
+            break
+        pos += 1
+    if not ndigit: return None
+    return (negative, intval, decimals, ndigit, pos)
+
+
+def payload(value, decimals=None):
+    """Payload bytes of a value. Absolute words carry their decimals, delta words in the token."""
+    n = value*2 if value >= 0 else -value*2 - 1
+    if decimals is not None: n = (n << 3) | decimals
+    groups = [n & 0x3F]
+    n >>= 6
+    while n:
+        groups.append(n & 0x3F)
+        n >>= 6
+    return [TOKEN_PAYLOAD | g for g in reversed(groups)]
+
+
+class Tokenizer:
+    """Converts blocks one at a time. Keeps the axis references the decoder keeps."""
+
+    def __init__(self):
+        self.reset()
+
+    def reset(self):
+        """Forgets the axis references, as Grbl does after a reset or a rejected line.
+
+        Call it on any error, alarm or reset response, so the next axis words
+        are absolute. Grbl rejects a delta word until it has seen one."""
+        self.ref = [None]*len(AXES) # Last tokenized axis value, in 1e-4 units.
+
+    def word(self, letter, number, text):
+        axis = AXES.find(letter)
+        negative, intval, decimals, ndigit, end = number
+        if ndigit > MAX_INT_DIGITS or decimals > DECIMALS_MAX or (negative and intval == 0):
+            if axis >= 0: self.ref[axis] = None # Grbl does not track text words.
+            return [ord(c) for c in text]
+        value = -intval if negative else intval
+        scale = 10**(DECIMALS_MAX - decimals)
+        fixed = value*scale
+        if abs(fixed) > 0x7FFFFFFF:
+            if axis >= 0: self.ref[axis] = None
+            return [ord(c) for c in text]
+        out = [TOKEN_WORD + ord(letter) - ord('A')] + payload(value, decimals)
+        if axis < 0 and len(out) > len(text):
+            return [ord(c) for c in text] # Short integer words, like M5, are shorter as text.
+        if axis >= 0:
+            ref = self.ref[axis]
+            if ref is not None and ref % scale == 0:
+                delta = (fixed - ref)//scale
+                if abs(delta) < (1 << 30):
+                    delta_out = [TOKEN_DELTA + axis*(DECIMALS_MAX+1) + decimals] + payload(delta)
+                    if len(delta_out) < len(out): out = delta_out
+            self.ref[axis] = fixed
+        return out
+
+    def block(self, line):
+        """Returns the tokenized block as bytes, without the line end."""
+        line = filter_line(line)
+        if line and line[0] == '$':
+            self.reset() # '$F' commands start and end stored jobs, which are tokenized on their own.
+        if not line or line[0] == '$':
+            return line.encode('ascii')
+        # Words are parsed first, so a malformed line is sent unchanged and the references kept.
+        words = []
+        pos = 0
+        while pos < len(line):
+            letter = line[pos]
+            if not ('A' <= letter <= 'Z'): return line.encode('ascii')
+            number = read_number(line, pos+1)
+            if number is None: return line.encode('ascii')
+            words.append((letter, number, line[pos:number[4]]))
+            pos = number[4]
+        out = []
+        for letter, number, text in words:
+            out += self.word(letter, number, text)
+        return bytes(bytearray(out))
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='Convert a g-code file to tokenized g-code for Grbl.')
+    parser.add_argument('gcode_file', type=argparse.FileType('r'),
+            help='g-code filename to convert')
+    parser.add_argument('output_file',
+            help='tokenized output filename')
+    args = parser.parse_args()
+
+    tokenizer = Tokenizer()
+    text_bytes = 0
+    token_bytes = 0
+    with open(args.output_file, 'wb') as out:
+        for line in args.gcode_file:
+            block = tokenizer.block(line)
+            if not block: continue # Nothing for Grbl to run.
+            text_bytes += len(filter_line(line)) + 1
+            token_bytes += len(block) + 1
+            out.write(block + b'\n')
+    sys.stderr.write('%d bytes of filtered text -> %d bytes tokenized (%.2fx)\n' %
+                     (text_bytes, token_bytes, float(text_bytes)/max(token_bytes, 1)))
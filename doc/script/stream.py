@@ -61,7 +61,15 @@ parser.add_argument('-q','--quiet',action='store_true', default=False,
         help='suppress output text')
 parser.add_argument('-s','--settings',action='store_true', default=False, 
         help='settings write mode')        
+parser.add_argument('-t','--tokenize',action='store_true', default=False,
+        help='send g-code blocks tokenized (see gcode_tokenize.py)')
+parser.add_argument('-b','--batch',type=int, default=0,
+        help='ask grbl to acknowledge lines in batches of up to BATCH ($A=BATCH)')
 args = parser.parse_args()
+tokenizer = None
+if args.tokenize :
+    from gcode_tokenize import Tokenizer
+    tokenizer = Tokenizer()
 
 # Periodic timer to query for status reports
 # TODO: Need to track down why this doesn't restart consistently before a release.
@@ -86,6 +94,11 @@ s.write("\r\n\r\n")
 time.sleep(2)
 s.flushInput()
 
+if args.batch > 1 :
+    # Batched acknowledgements: one 'ok:N' for N lines, errors as 'error:CODE:LINE'.
+    s.write('$A=' + str(args.batch) + '\n')
+    while s.readline().strip()[:2] != 'ok' : pass
+
 # Stream g-code to grbl
 l_count = 0
 if settings_mode:
@@ -113,17 +126,22 @@ else:
         l_count += 1 # Iterate line counter
         # l_block = re.sub('\s|\(.*?\)','',line).upper() # Strip comments/spaces/new line and capitalize
         l_block = line.strip()
+        if tokenizer: l_block = tokenizer.block(l_block) # Fewer characters in grbl serial read buffer
         c_line.append(len(l_block)+1) # Track number of characters in grbl serial read buffer
         grbl_out = '' 
         while sum(c_line) >= RX_BUFFER_SIZE-1 | s.inWaiting() :
             out_temp = s.readline().strip() # Wait for grbl response
+            if tokenizer and (out_temp.startswith('error') or out_temp.startswith('ALARM') or out_temp.startswith('Grbl')) :
+                tokenizer.reset() # Grbl dropped its axis references. Send absolute words again.
             if out_temp.find('ok') < 0 and out_temp.find('error') < 0 :
                 print "  Debug: ",out_temp # Debug response
             else :
                 grbl_out += out_temp;
-                g_count += 1 # Iterate g-code counter
+                n_acked = 1
+                if out_temp.startswith('ok:') : n_acked = int(out_temp[3:]) # Batched 'ok:N' acknowledges N blocks
+                g_count += n_acked # Iterate g-code counter
                 grbl_out += str(g_count); # Add line finished indicator
-                del c_line[0] # Delete the block character count corresponding to the last 'ok'
+                del c_line[0:n_acked] # Delete the block character counts corresponding to the last response
         if verbose: print "SND: " + str(l_count) + " : " + l_block,
         s.write(l_block + '\n') # Send g-code block to grbl
         if verbose : print "BUF:",str(sum(c_line)),"REC:",grbl_out
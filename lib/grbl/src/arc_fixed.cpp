@@ -0,0 +1,127 @@
+/*
+  arc_fixed.c - fixed-point CORDIC arc interpolation kernel
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "grbl.hpp"
+
+#ifdef ARC_FIXED_POINT_KERNEL
+
+#define ARC_FIXED_CORDIC_ITERATIONS 32
+#define ARC_FIXED_CORDIC_FRAC 40 // CORDIC works in Q40 on int64 for guard bits.
+
+// atan(2^-i) in binary angle units, 2^40 per turn.
+static const int64_t arc_fixed_atan[ARC_FIXED_CORDIC_ITERATIONS] = {
+  137438953472LL, 81134951838LL, 42869480287LL, 21761217566LL,
+  10922836750LL, 5466743129LL, 2734038620LL, 1367102738LL,
+  683561799LL, 341782203LL, 170891265LL, 85445653LL,
+  42722829LL, 21361415LL, 10680707LL, 5340354LL,
+  2670177LL, 1335088LL, 667544LL, 333772LL,
+  166886LL, 83443LL, 41722LL, 20861LL,
+  10430LL, 5215LL, 2608LL, 1304LL,
+  652LL, 326LL, 163LL, 81LL
+};
+#define ARC_FIXED_CORDIC_GAIN_INV 667681663043LL // prod(1/sqrt(1+2^-2i)) in Q40
+#define ARC_FIXED_TURN_PER_RADIAN 174992710548LL // 2^40/(2*pi), rounded. Below 2^38.
+
+
+// Rotation-mode CORDIC. The angle is first reduced to the nearest quarter turn, so CORDIC only
+// covers +/-45 degrees. 32 iterations leave a residual angle below atan(2^-31).
+void arc_fixed_sincos(int64_t angle, int32_t *cos_q, int32_t *sin_q)
+{
+  angle &= (ARC_FIXED_TURN-1);
+  int64_t quadrant = (angle + (ARC_FIXED_TURN >> 3)) >> (ARC_FIXED_ANGLE_BITS-2);
+  int64_t z = angle - (quadrant << (ARC_FIXED_ANGLE_BITS-2));
+  int64_t x = ARC_FIXED_CORDIC_GAIN_INV;
+  int64_t y = 0;
+  int64_t x_next;
+  uint8_t i;
+  for (i=0; i<ARC_FIXED_CORDIC_ITERATIONS; i++) {
+    if (z >= 0) {
+      x_next = x - (y >> i);
+      y += (x >> i);
+      z -= arc_fixed_atan[i];
+    } else {
+      x_next = x + (y >> i);
+      y -= (x >> i);
+      z += arc_fixed_atan[i];
+    }
+    x = x_next;
+  }
+  // Round Q40 to Q30.
+  int32_t c = (int32_t)((x + (1LL << (ARC_FIXED_CORDIC_FRAC-ARC_FIXED_Q-1))) >> (ARC_FIXED_CORDIC_FRAC-ARC_FIXED_Q));
+  int32_t s = (int32_t)((y + (1LL << (ARC_FIXED_CORDIC_FRAC-ARC_FIXED_Q-1))) >> (ARC_FIXED_CORDIC_FRAC-ARC_FIXED_Q));
+  switch (quadrant & 3) {
+    case 0: *cos_q = c; *sin_q = s; break;
+    case 1: *cos_q = -s; *sin_q = c; break;
+    case 2: *cos_q = -c; *sin_q = -s; break;
+    default: *cos_q = s; *sin_q = -c; break;
+  }
+}
+
+
+// Rotates (r0,r1) by (cos_q,sin_q), rounding to nearest. 32x32->64 products map to mul/mulh on rv32.
+static void arc_fixed_apply(int32_t r0, int32_t r1, int32_t cos_q, int32_t sin_q, int32_t *out0, int32_t *out1)
+{
+  int64_t a0 = (int64_t)r0*cos_q - (int64_t)r1*sin_q;
+  int64_t a1 = (int64_t)r0*sin_q + (int64_t)r1*cos_q;
+  *out0 = (int32_t)((a0 + (1LL << (ARC_FIXED_Q-1))) >> ARC_FIXED_Q);
+  *out1 = (int32_t)((a1 + (1LL << (ARC_FIXED_Q-1))) >> ARC_FIXED_Q);
+}
+
+
+void arc_fixed_init(arc_fixed_t *arc, float r_axis0, float r_axis1, float angular_travel, uint16_t segments)
+{
+  // Scale so the larger component is below 2^30. The rotated vector stays below 2^30.5.
+  int shift;
+  float r_max = max(fabs(r_axis0), fabs(r_axis1));
+  if (r_max > 0.0) { frexp(r_max, &shift); shift = ARC_FIXED_Q - shift; }
+  else { shift = 0; }
+  arc->r0_init = (int32_t)lround(ldexp(r_axis0, shift));
+  arc->r1_init = (int32_t)lround(ldexp(r_axis1, shift));
+  arc->r0 = arc->r0_init;
+  arc->r1 = arc->r1_init;
+  arc->scale_inv = ldexp(1.0, -shift);
+
+  // Travel in binary angle units, converted from the exact 24-bit float mantissa by an integer
+  // multiply, so the conversion adds no float rounding. |travel| <= one turn plus epsilon, so the
+  // exponent is at most 3 and the 24+38-bit product fits int64.
+  int exponent;
+  int64_t mantissa = (int64_t)ldexp(frexp(angular_travel, &exponent), 24);
+  int shift_right = 24 - exponent;
+  if (shift_right >= 62) { arc->travel = 0; } // Far below one binary angle unit.
+  else { arc->travel = (mantissa*ARC_FIXED_TURN_PER_RADIAN + (1LL << (shift_right-1))) >> shift_right; }
+  arc->segments = segments;
+  if (segments) { arc_fixed_sincos(arc->travel/segments, &arc->cos_T, &arc->sin_T); }
+  else { arc->cos_T = ARC_FIXED_ONE; arc->sin_T = 0; }
+}
+
+
+void arc_fixed_rotate(arc_fixed_t *arc)
+{
+  arc_fixed_apply(arc->r0, arc->r1, arc->cos_T, arc->sin_T, &arc->r0, &arc->r1);
+}
+
+
+// Segment angle is travel*i/segments in 64-bit integers, so no angle error builds up along the arc.
+void arc_fixed_correct(arc_fixed_t *arc, uint16_t i)
+{
+  int32_t cos_Ti, sin_Ti;
+  arc_fixed_sincos((arc->travel*i)/arc->segments, &cos_Ti, &sin_Ti);
+  arc_fixed_apply(arc->r0_init, arc->r1_init, cos_Ti, sin_Ti, &arc->r0, &arc->r1);
+}
+
+#endif
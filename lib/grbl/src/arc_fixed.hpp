@@ -0,0 +1,68 @@
+/*
+  arc_fixed.h - fixed-point CORDIC arc interpolation kernel
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef arc_fixed_h
+#define arc_fixed_h
+
+#include <stdint.h>
+
+// Angles are binary angles with ARC_FIXED_TURN units per full turn, so they wrap for free.
+// sin/cos results are signed Q30 fractions.
+#define ARC_FIXED_ANGLE_BITS 40
+#define ARC_FIXED_TURN (1LL << ARC_FIXED_ANGLE_BITS)
+#define ARC_FIXED_Q 30
+#define ARC_FIXED_ONE (1L << ARC_FIXED_Q)
+
+// Fixed-point arc state. The radius vector is stored as int32 scaled by 2^shift, with shift picked
+// per arc so the vector uses the full 31-bit range. One LSB is therefore at most radius*2^-29.5.
+//
+// Error bound, in LSB of the scaled radius vector, per radius component:
+//   arc_fixed_init():    angular travel converted in integers, <= 0.5 binary angle unit (2^-40 turn)
+//                        plus 2.5e-12 of the travel from the rounded radian constant. On the
+//                        2^30.5 vector that is < 0.05 LSB at any segment angle travel*i/segments.
+//   arc_fixed_sincos():  <= 2 LSB of Q30 (CORDIC residual angle + rounding).
+//   arc_fixed_rotate():  <= 6 LSB per call (coefficient error on a 2^30.5 vector + rounding).
+//   arc_fixed_correct(): <= 6 LSB, independent of the segment index.
+// So a segment is never more than (N_ARC_CORRECTION+1)*6 LSB off the exact circle, i.e. well
+// under 1e-7 of the radius for the default N_ARC_CORRECTION. See test/arc_fixed_test.cpp.
+typedef struct {
+  int32_t r0;            // Radius vector, scaled by 2^shift.
+  int32_t r1;
+  int32_t r0_init;       // Initial radius vector. Used for exact correction.
+  int32_t r1_init;
+  int32_t cos_T;         // Per-segment rotation, Q30.
+  int32_t sin_T;
+  int64_t travel;        // Total angular travel in binary angle units. Signed.
+  uint16_t segments;
+  float scale_inv;       // 2^-shift. Converts the radius vector back to mm.
+} arc_fixed_t;
+
+
+// Computes cos and sin of a binary angle (ARC_FIXED_TURN per turn) as Q30, by integer CORDIC.
+void arc_fixed_sincos(int64_t angle, int32_t *cos_q, int32_t *sin_q);
+
+// Sets up the fixed-point arc from the float radius vector and angular travel in radians.
+void arc_fixed_init(arc_fixed_t *arc, float r_axis0, float r_axis1, float angular_travel, uint16_t segments);
+
+// Advances the radius vector by one segment rotation.
+void arc_fixed_rotate(arc_fixed_t *arc);
+
+// Sets the radius vector exactly to segment i, from the initial radius vector.
+void arc_fixed_correct(arc_fixed_t *arc, uint16_t i);
+
+#endif
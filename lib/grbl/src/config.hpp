@@ -163,6 +163,31 @@
 // goes from 16 to 15 to make room for the additional line number data in the plan_block_t struct
 // #define USE_LINE_NUMBERS // Disabled by default. Uncomment to enable.
 
+// Accepts tokenized g-code words alongside text words. A tokenized word is a letter code byte and a
+// fixed-point value, with axis coordinates optionally relative to the previous one. Typical CAM
+// output shrinks by a third or more, and words are decoded without digit parsing. Programs are converted on the host by
+// doc/script/gcode_tokenize.py, and can be streamed or stored with $FW like text. Text g-code never
+// contains the token bytes (0x80 and up), so it is unaffected. The token bytes overlap the extended
+// real-time commands, which therefore work only in 'R' frames in framed mode. See gcode_token.h.
+#define ENABLE_GCODE_TOKENS // Default enabled. Comment to disable.
+
+// Enables the framed binary serial protocol, entered with $B. Lines are sent in CRC-checked frames
+// with sequence numbers, and acknowledged by ACK frames carrying their status instead of ok/error,
+// with up to SERIAL_FRAME_WINDOW frames in flight. Corrupted or lost frames are NAKed and sent
+// again, so line noise shows up as a retry instead of a wrong move. ASCII real-time commands still
+// work between frames. A reset returns to line mode. See serial_frame.h for the frame format and
+// doc/script/frame_stream.py for a host streamer.
+#define ENABLE_SERIAL_FRAMING // Default enabled. Comment to disable.
+#define SERIAL_FRAME_WINDOW 4 // Line frames in flight. Each takes LINE_BUFFER_SIZE bytes of RAM.
+
+// Enables $A=N, which makes Grbl acknowledge streamed lines in batches. The ok of up to N lines is
+// sent as one "ok:N" response, which saves transmit time on programs of short segments. Pending oks
+// are also sent as soon as Grbl runs out of lines or waits for the planner, so a character-counting
+// streamer never stalls. Errors are sent at once, as "error:CODE:LINE", where LINE counts the lines
+// from $A=N on. $A=0 or a reset returns to one ok per line. See doc/script/stream.py -b.
+#define ENABLE_ACK_BATCHING // Default enabled. Comment to disable.
+#define ACK_BATCH_MAX 16 // Largest N accepted by $A=N.
+
 // Upon a successful probe cycle, this option provides immediately feedback of the probe coordinates
 // through an automatically generated message. If disabled, users can still access the last probe
 // coordinates through Grbl '$#' print parameters.
@@ -173,6 +198,24 @@
 // NOTE: The M8 flood coolant control pin on analog pin 3 will still be functional regardless.
 // #define ENABLE_M7 // Disabled by default. Uncomment to enable.
 
+// Enables general purpose digital outputs controlled by M62/M63 (synchronized with motion) and
+// M64/M65 (immediate), each with a P word selecting the output number (0 to N_DIGITAL_OUTPUTS-1).
+// Synchronized outputs are carried through the planner and step segment buffers and switch at
+// the first step of the next motion block, without a buffer sync. As in LinuxCNC, if no motion
+// follows an M62/M63, the queued change does not take effect. Immediate outputs switch as soon
+// as the line is executed, while buffered motions continue. Pins are defined in cpu_map.h.
+#define ENABLE_DIGITAL_OUTPUTS // Default enabled. Comment to disable.
+// #define INVERT_DIGITAL_OUTPUT_PINS // Default disabled. Uncomment to enable.
+
+// Enables on-board job storage in the SPIFI flash area past the firmware image, so a g-code program
+// can be uploaded once and run without a host streaming it. $FW=NAME starts an upload, every following
+// line is stored instead of executed until $FE. $FR=NAME runs a stored job, its lines are fed to the
+// parser whenever no serial line is pending, and $FS stops it. While a job runs, the host may only
+// send $F commands, status queries ($, $$, $#, $G) and realtime commands. $F lists jobs, $FD=NAME
+// deletes one and $FX empties the store. Flash writes halt interrupts for up to a sector erase, so
+// uploads, deletes and formats are only accepted in IDLE. The flash area is defined in cpu_map.h.
+// #define ENABLE_JOB_STORE // Default disabled. Uncomment to enable.
+
 // This option causes the feed hold input to act as a safety door switch. A safety door, when triggered,
 // immediately forces a feed hold and then safely de-energizes the machine. Resuming is blocked until
 // the safety door is re-engaged. When it is, Grbl will re-energize the machine and then resume on the
@@ -292,6 +335,26 @@
 #define REPORT_WCO_REFRESH_BUSY_COUNT 30  // (2-255)
 #define REPORT_WCO_REFRESH_IDLE_COUNT 10  // (2-255) Must be less than or equal to the busy count
 
+// Adds a compact delta status report mode, enabled with bit 2 of $10 (add 4 to the value). Each report
+// has the state and only the fields that changed since the previous report, with the position as signed
+// motor step counts moved since then, as |D:dx,dy,dz. An empty |Pn: or |A: field means all cleared. Every
+// REPORT_DELTA_KEYFRAME_COUNT reports, and first after the mode is enabled or Grbl is reset, a keyframe
+// has every field as in a normal report, plus the position in motor steps as |St:x,y,z, which the
+// following deltas add to. Status reports must not be dropped by the host, since each delta builds on the
+// previous report.
+#define ENABLE_DELTA_STATUS_REPORT // Default enabled. Comment to disable.
+#define REPORT_DELTA_KEYFRAME_COUNT 50 // (1-255) Reports per keyframe.
+
+// Sends compact status reports on its own, at an interval set in milliseconds with $Q=ms ($Q=0 turns
+// them off, $Q prints the interval). A timer requests the report at the interval and the main loop
+// sends it only when a field changed since the last one sent. The WCO and override fields are included
+// only when they changed, so a host keeps its own copy of them. A report that does not fit in the free
+// serial TX buffer is skipped until the next interval, so auto-reports never wait for the serial port.
+// '?' still prints the full report. A reset turns auto-reports off.
+#define ENABLE_AUTO_REPORT // Default enabled. Comment to disable.
+#define AUTO_REPORT_INTERVAL_MIN 10    // Shortest interval in milliseconds accepted by $Q.
+#define AUTO_REPORT_INTERVAL_MAX 60000 // Longest interval in milliseconds accepted by $Q.
+
 // The temporal resolution of the acceleration management subsystem. A higher number gives smoother
 // acceleration, particularly noticeable on machines that run at very high feedrates, but may negatively
 // impact performance. The correct value for this parameter is machine dependent, so it's advised to
@@ -343,6 +406,22 @@
 // The hardware PWM output on pin D11 is required for variable spindle output voltages.
 #define VARIABLE_SPINDLE // Default enabled. Comment to disable.
 
+// Resolution of the variable spindle PWM duty cycle on the MIK32 (ELRON_ACE_UNO), in bits. The PWM runs
+// on a 32-bit timer at F_CPU/2^SPINDLE_PWM_BITS, i.e. 7.8kHz at 12 bits and 488Hz at 16 bits. Higher
+// resolution gives finer spindle speed and laser power steps, but a lower PWM frequency. Lasers and
+// spindle drives with a PWM input usually want 12 bits. SPINDLE_PWM_MIN_VALUE is in the same units.
+#define SPINDLE_PWM_BITS 12 // Integer (12-16). Default 12.
+
+// Outputs the variable spindle PWM on the MIK32 (ELRON_ACE_UNO) from TIMER32_2 on digital pin 11. In this
+// cpu map every timer channel pin is already taken, and pin 11 is the Z limit, so the output is opt-in and
+// requires DISABLE_Z_LIMIT_PIN. Without it, the spindle speed and laser power are still computed and
+// reported, but no pin carries the PWM.
+// #define ENABLE_SPINDLE_PWM_OUTPUT // Default disabled. Uncomment to enable.
+
+// Leaves the Z limit pin unconfigured and never reports a Z limit, so ENABLE_SPINDLE_PWM_OUTPUT can use
+// the pin. Z must then be removed from the homing cycles.
+// #define DISABLE_Z_LIMIT_PIN // Default disabled. Uncomment to enable.
+
 // Used by variable spindle output only. This forces the PWM output to a minimum duty cycle when enabled.
 // The PWM pin will still read 0V when the spindle is disabled. Most users will not need this option, but
 // it may be useful in certain scenarios. This minimum PWM settings coincides with the spindle rpm minimum
@@ -352,6 +431,7 @@
 // in mind that you will begin to lose PWM resolution with increased minimum PWM values, since you have less
 // and less range over the total 255 PWM levels to signal different spindle speeds.
 // NOTE: Compute duty cycle at the minimum PWM by this equation: (% duty cycle)=(SPINDLE_PWM_MIN_VALUE/255)*100
+// On the MIK32, replace 255 with 2^SPINDLE_PWM_BITS-1.
 // #define SPINDLE_PWM_MIN_VALUE 5 // Default disabled. Uncomment to enable. Must be greater than zero. Integer (1-255).
 
 // By default on a 328p(Uno), Grbl combines the variable spindle PWM and the enable into one pin to help
@@ -381,6 +461,12 @@
 // to help minimize transmission waiting within the serial write protocol.
 // #define REPORT_ECHO_LINE_RECEIVED // Default disabled. Uncomment to enable.
 
+// With this enabled, the build info ($I) is followed by diagnostic counter lines: '[SYNC:n]', the spindle
+// and coolant syncs the parser skipped as no-ops, and '[ARC:n,m]', the arcs set up and the line segments
+// generated for them since reset. Off by default, since GUIs parse the $I response and may not expect
+// the extra lines.
+// #define REPORT_DIAGNOSTIC_COUNTERS // Default disabled. Uncomment to enable.
+
 // Minimum planner junction speed. Sets the default minimum junction speed the planner plans to at
 // every buffer block junction, except for starting from rest and end of the buffer, which are always
 // zero. This value controls how fast the machine moves through junctions with no regard for acceleration
@@ -401,6 +487,23 @@
 // bogged down by too many trig calculations.
 #define N_ARC_CORRECTION 12 // Integer (1-255)
 
+// Chooses arc segment length from the speed the arc runs at, not only from the $12 arc tolerance.
+// Small arcs at high feed otherwise break into many tiny blocks the planner cannot accelerate
+// through. The arc speed is the programmed feed, limited by the centripetal acceleration of the
+// plane axes. Segments that would take less than ARC_MIN_SEGMENT_TIME are lengthened, but the chord
+// error never exceeds ARC_ADAPTIVE_TOLERANCE_SCALE times $12. Slow arcs are segmented as before.
+// With REPORT_DIAGNOSTIC_COUNTERS, $I reports arcs and generated segments as [ARC:arcs,segments] either way.
+// #define ARC_ADAPTIVE_SEGMENTS // Default disabled. Uncomment to enable.
+#define ARC_MIN_SEGMENT_TIME 0.005 // (sec) Float. Minimum segment duration at arc speed.
+#define ARC_ADAPTIVE_TOLERANCE_SCALE 4.0 // Float (>=1.0). Max chord error as multiple of $12.
+
+// Replaces the float arc rotation in mc_arc() with an integer kernel. The radius vector is kept in
+// 32-bit fixed point and rotated with exact Q30 sin/cos from an integer CORDIC, so no soft-float
+// multiplies, sin() or cos() run per segment, only the final conversion to mm. Exact correction
+// still happens every N_ARC_CORRECTION segments. The error bound is documented in arc_fixed.h and
+// checked against double precision by test/arc_fixed_test.cpp.
+// #define ARC_FIXED_POINT_KERNEL // Default disabled. Uncomment to enable.
+
 // The arc G2/3 g-code standard is problematic by definition. Radius-based arcs have horrible numerical
 // errors when arc at semi-circles(pi) or full-circles(2*pi). Offset-based arcs are much more accurate
 // but still have a problem when arcs are full-circles (2*pi). This define accounts for the floating
@@ -411,6 +514,10 @@
 // much greater than this. The default setting should capture most, if not all, full arc error situations.
 #define ARC_ANGULAR_TRAVEL_EPSILON 5E-7 // Float (radians)
 
+// Clearance used by the G73 and G83 peck drilling cycles. G73 backs off this far to break the chip,
+// and G83 rapids back down to this far above the previous peck depth. Same as the LinuxCNC default.
+#define CANNED_CYCLE_PECK_CLEARANCE 0.254 // (mm) Float. 0.010 inch.
+
 // Time delay increments performed during a dwell. The default value is set at 50ms, which provides
 // a maximum time delay of roughly 55 minutes, more than enough for most any application. Increasing
 // this delay will increase the maximum dwell time linearly, but also reduces the responsiveness of
@@ -440,6 +547,13 @@
 // new incoming motions as they are executed.
 // #define BLOCK_BUFFER_SIZE 16 // Uncomment to override default in planner.h.
 
+// Adds a small queue of parsed and error-checked motions between the g-code parser and the planner.
+// When the planner buffer is full, mc_line() queues the motion and returns, so the parser keeps
+// acknowledging and parsing lines (including arc segments) instead of blocking on one line. Each
+// queued motion uses about 30 bytes of RAM. Commands that sync the buffer also drain this queue.
+#define ENABLE_PARSE_AHEAD // Default enabled. Comment to disable.
+// #define PARSE_AHEAD_BUFFER_SIZE 8 // Uncomment to override default in motion_control.h.
+
 // Governs the size of the intermediary step segment buffer between the step execution algorithm
 // and the planner blocks. Each segment is set of steps executed at a constant velocity over a
 // fixed time defined by ACCELERATION_TICKS_PER_SECOND. They are computed such that the planner
@@ -511,9 +625,9 @@
 #define ENABLE_RESTORE_EEPROM_DEFAULT_SETTINGS // '$RST=$' Default enabled. Comment to disable.
 #define ENABLE_RESTORE_EEPROM_CLEAR_PARAMETERS // '$RST=#' Default enabled. Comment to disable.
 
-// Определяет данные EEPROM, которые восстанавливаются при изменении версии настроек и выполнении команды `$RST=*` . Всякий раз, когда
-// структура данных EEPROM или настройки Grbl меняются от версии к версии, Grbl автоматически
-// стирает и восстанавливает данные EEPROM. Этот макрос определяет, какие данные стираются и восстанавливаются. Это полезно
+// Определяет данные EEPROM, которые восстанавливаются при неизвестной версии настроек и выполнении команды `$RST=*` . Данные
+// прежних версий Grbl преобразует к новой структуре поле за полем (см. settings_migrate()), а стирает и
+// восстанавливает только данные версии, которую преобразовать не может. Этот макрос определяет, какие данные стираются и восстанавливаются. Это полезно
 // особенно для производителей, которым необходимо сохранять определенные данные. Например, строку BUILD_INFO можно
 // записать в EEPROM Arduino с помощью отдельной команды .Скетч INO для хранения данных о продукте. Изменение этого
 // макроса для исключения восстановления информации о сборке из EEPROM гарантирует сохранение этих данных после обновления прошивки. 
@@ -529,16 +643,10 @@
  // ПРИМЕЧАНИЕ. Чтобы записать эту строку отдельно, воспользуйтесь прилагаемым файлом примера grblWrite_BuildInfo.ino.
 //#define ENABLE_BUILD_INFO_WRITE_COMMAND // '$I=' Default enabled. Comment to disable.
 
-// Процессоры AVR требуют, чтобы все прерывания были отключены во время записи в EEPROM. Это включает в себя как
-// шаговый модуль ISRs и последовательный модуль связи ISRs. В случае длительной записи в EEPROM эта пауза ISR может привести к
-// приводит к потере позиции активного шага и потере данных последовательного приема. Эта конфигурация
-// опция приводит к полному опустошению буфера планировщика при каждой записи в EEPROM, чтобы предотвратить
-// возможность потери шагов.
-// ПРИМЕЧАНИЕ: Большинство команд записи в EEPROM неявно блокируются во время выполнения задания (все команды '$'). Однако команды 
-// набора координат в g-коде (G10,G28/30.1) не блокируются, поскольку они являются частью активной потоковой передачи
-// задание. На данный момент эта опция только принудительно синхронизирует буфер планировщика с этими командами g-кода.
-// одну из этих команд, прежде чем отправлять дополнительные данные, чтобы избежать этой проблемы.
-#define FORCE_BUFFER_SYNC_DURING_EEPROM_WRITE // По умолчанию включено. Коментарии отключены.
+// Команды '$', G10 и G28.1/G30.1 меняют только копию настроек в ОЗУ. В EEPROM изменения записываются,
+// когда станок стоит, или командой '$SAVE', поэтому буфер планировщика при записи в EEPROM больше не
+// синхронизируется (прежняя опция FORCE_BUFFER_SYNC_DURING_EEPROM_WRITE). Изменения, не записанные до
+// отключения питания, теряются.
 
 // In Grbl v0.9 and prior, there is an old outstanding bug where the `WPos:` work position reported
 // may not correlate to what is executing, because `WPos:` is based on the g-code parser state, which
@@ -593,6 +701,43 @@
 // to ensure the laser doesn't inadvertently remain powered while at a stop and cause a fire.
 #define DISABLE_LASER_DURING_HOLD // Default enabled. Comment to disable.
 
+// In laser mode (M4, $32=1), Grbl scales laser power with speed to keep the energy per mm constant.
+// By default the power of each step segment is set from the planned speed at the end of the segment.
+// But a segment is stepped at one constant rate, its average speed, so power runs ahead of the motion
+// while accelerating and lags behind it while decelerating. That is visible at corners, where the
+// speed ramps. This option sets the power from the step rate the segment is actually executed at,
+// including the partial step correction, so power follows the steps exactly.
+// NOTE: Power is still updated once per segment, every 1/ACCELERATION_TICKS_PER_SECOND seconds. Raise
+// ACCELERATION_TICKS_PER_SECOND for smoother power ramps, at some CPU cost.
+// #define LASER_POWER_FROM_STEP_RATE // Default disabled. Uncomment to enable.
+
+// Enables raster engraving from scanline frames in framed mode ($B, laser mode $32=1). A scanline
+// frame carries a short header (start, axis and direction, pixel pitch, feed and power) and one
+// power byte per pixel, instead of a g-code line per pixel run. Grbl plans the overscan ramps on
+// both ends, so the scan runs at constant speed, and the stepper interrupt changes the laser power
+// at each pixel boundary. Each scanline in the planner takes a slot of RASTER_SCANLINE_SLOTS,
+// holding a 16-bit PWM value per pixel. See raster.h for the frame format.
+#define ENABLE_RASTER // Default enabled. Comment to disable.
+#define RASTER_SCANLINE_SLOTS 4 // Scanlines queued ahead of the stepper. 2 to 16.
+
+// Enables spindle-synchronized motion for lathes: G33 threading moves and the G76 threading cycle.
+// Requires a once-per-revolution index pulse from the spindle on the pin set in cpu_map.h. The
+// index times are captured against a free-running 1MHz timer, which gives the spindle speed and,
+// interpolated between pulses, its position. Each G33 move waits for an index pulse before it
+// starts, so every pass of a thread starts at the same spindle angle, and the stepper then keeps
+// the cruise speed tied to the spindle position within SPINDLE_SYNC_MAX_CORRECTION of the
+// programmed rate. The spindle must be up to speed before G33, e.g. with a G4 dwell after M3.
+// Feed hold and feed override stop or break the synchronization, so they must not be used
+// while threading. The spindle falling below SPINDLE_SYNC_MIN_RPM during a thread is a feed hold.
+// #define ENABLE_SPINDLE_SYNC // Default disabled. Uncomment to enable.
+#define SPINDLE_SYNC_MAX_CORRECTION 0.05 // Largest speed correction, as a fraction of the rate. 0.0 to 0.5.
+#define SPINDLE_SYNC_MIN_RPM 30.0 // Slower index pulses than this are a stopped spindle. (rpm)
+
+// Generates the spindle index pulses from the programmed spindle speed instead of the index pin,
+// as if the spindle turned at exactly the speed Grbl commands. For testing spindle-synchronized
+// motion on the bench or without an encoder. Requires VARIABLE_SPINDLE.
+// #define SPINDLE_ENCODER_SIMULATED // Default disabled. Uncomment to enable.
+
 // Enables a piecewise linear model of the spindle PWM/speed output. Requires a solution by the
 // 'fit_nonlinear_spindle.py' script in the /doc/script folder of the repo. See file comments
 // on how to gather spindle data and run the script to generate a solution.
@@ -214,9 +214,35 @@ decltype(regs) regs_tmp;
   #define SPINDLE_ENABLE_BIT    GPIO_PIN_12 
   #define SPINDLE_DIRECTION_BIT GPIO_PIN_13
   
-  #define COOLANT_FLOOD_PORT  GPIO_1 
+  #define COOLANT_FLOOD_PORT  GPIO_1
   #define COOLANT_FLOOD_BIT   GPIO_PIN_2 // Цифровой пин 13
 
+  // Цифровые выходы общего назначения M62-M65 (пневмозажимы, клапаны, дозаторы).
+  #define N_DIGITAL_OUTPUTS     4
+  #define DIGITAL_OUTPUT_PORT   GPIO_1
+  #define DIGITAL_OUTPUT_0_BIT  GPIO_PIN_10
+  #define DIGITAL_OUTPUT_1_BIT  GPIO_PIN_11
+  #define DIGITAL_OUTPUT_2_BIT  GPIO_PIN_14
+  #define DIGITAL_OUTPUT_3_BIT  GPIO_PIN_15
+
+  // Хранилище заданий $F во внешней флеш-памяти SPIFI (8 МБ). Первые 2 МБ оставлены под прошивку.
+  #define JOB_STORE_MEMORY_BASE 0x80000000 // Адрес флеш-памяти в режиме отображения на память
+  #define JOB_STORE_FLASH_START 0x00200000
+  #define JOB_STORE_FLASH_SIZE  0x00600000
+
+  // Таймер автоотчётов о состоянии $Q. Без выводов, прерывание по переполнению.
+  #define AUTO_REPORT_TIMER           TIMER32_0
+  #define AUTO_REPORT_TIMER_EPIC_MASK HAL_EPIC_TIMER32_0_MASK
+  #define AUTO_REPORT_TIMER_IRQ()     EPIC_CHECK_TIMER32_0()
+
+  // Индексный датчик шпинделя (один импульс на оборот) для синхронного движения G33/G76.
+  // Время импульсов отсчитывает свободно бегущий таймер TIMER32_1 с частотой 1 МГц.
+  #define SPINDLE_INDEX_PORT      GPIO_1
+  #define SPINDLE_INDEX_BIT       GPIO_PIN_6 // Свободный вывод порта 1
+  #define SPINDLE_INDEX_BIT_LINE_IRQ  GPIO_MUX_LINE_6_PORT1_6
+  #define SPINDLE_INDEX_LINE_IRQ      GPIO_LINE_6
+  #define SPINDLE_ENCODER_TIMER   TIMER32_1
+
   #define CONTROL_PORT            GPIO_1
   #define FEED_HOLD_BIT           GPIO_PIN_7 // Аналоговый пин 1
   #define FEED_HOLD_BIT_LINE_IRQ  GPIO_MUX_LINE_3_PORT1_7
@@ -234,31 +260,27 @@ decltype(regs) regs_tmp;
   #define PROBE_BIT       GPIO_PIN_9  // Uno Analog Pin 5
   #define PROBE_MASK      (1<<PROBE_BIT)
 
-  // Запуск шпинделя с поддержкой ШИМ и шагового управления
+  // ШИМ шпинделя (лазера) на 32-битном таймере. Скважность с разрешением SPINDLE_PWM_BITS из config.h,
+  // частота ШИМ F_CPU/(SPINDLE_PWM_PRESCALER+1)/2^SPINDLE_PWM_BITS.
   // Start of PWM & Stepper Enabled Spindle
   #ifdef VARIABLE_SPINDLE
-    #define SPINDLE_PWM_MAX_VALUE     255 // Don't change. 328p fast PWM mode fixes top value as 255.
+    #define SPINDLE_PWM_MAX_VALUE     ((1UL << SPINDLE_PWM_BITS) - 1) // Вершина счёта таймера
     #ifndef SPINDLE_PWM_MIN_VALUE
       #define SPINDLE_PWM_MIN_VALUE   1   // Must be greater than zero.
     #endif
     #define SPINDLE_PWM_OFF_VALUE     0
     #define SPINDLE_PWM_RANGE         (SPINDLE_PWM_MAX_VALUE-SPINDLE_PWM_MIN_VALUE)
-    // Advanced Configuration Below You should not need to touch these variables
-    // #define PWM_MAX_VALUE    255.0
-    // #define TCCRA_REGISTER	 TCCR2A
-    // #define TCCRB_REGISTER	 TCCR2B
-    // #define OCR_REGISTER     OCR2A
-    
-    // #define COMB_BIT	     COM2A1
-    // #define WAVE0_REGISTER	 WGM20
-    // #define WAVE1_REGISTER	 WGM21
-    // #define WAVE2_REGISTER	 WGM22
-    // #define WAVE3_REGISTER	 WGM23
-        
-    // // NOTE: On the 328p, these must be the same as the SPINDLE_ENABLE settings.
-    // #define SPINDLE_PWM_DDR	  DDRB
-    // #define SPINDLE_PWM_PORT  PORTB
-    // #define SPINDLE_PWM_BIT	  1,1    // Uno Digital Pin 11
+    #define SPINDLE_PWM_PRESCALER     0
+
+    // Цифровой пин 11, как ШИМ шпинделя на Uno: канал TIMER32_CHANNEL_1 таймера TIMER32_2. Это пин концевика Z,
+    // а остальные выводы каналов таймеров заняты, поэтому выход ШИМ включается только вместе с
+    // DISABLE_Z_LIMIT_PIN (см. ENABLE_SPINDLE_PWM_OUTPUT в config.h).
+    #ifdef ENABLE_SPINDLE_PWM_OUTPUT
+      #define SPINDLE_PWM_TIMER         TIMER32_2
+      #define SPINDLE_PWM_CHANNEL       TIMER32_CHANNEL_1
+      #define SPINDLE_PWM_PORT          GPIO_1
+      #define SPINDLE_PWM_BIT           GPIO_PIN_1
+    #endif
   #endif // End of VARIABLE_SPINDLE
 
 #endif
@@ -0,0 +1,110 @@
+/*
+  digital_output.c - general purpose digital output methods (M62-M65)
+  Part of Grbl
+
+  Copyright (c) 2012-2016 Sungeun K. Jeon for Gnea Research LLC
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "grbl.hpp"
+
+#ifdef ENABLE_DIGITAL_OUTPUTS
+
+// Таблица пинов цифровых выходов. Индекс в таблице соответствует слову P в M62-M65.
+static const HAL_PinsTypeDef digital_output_pin[N_DIGITAL_OUTPUTS] = {
+  DIGITAL_OUTPUT_0_BIT,
+  DIGITAL_OUTPUT_1_BIT,
+  DIGITAL_OUTPUT_2_BIT,
+  DIGITAL_OUTPUT_3_BIT
+};
+
+// Shadow of the output pins. Written by the main program (M64/M65) and by the stepper ISR
+// (M62/M63), so reads never touch the GPIO registers.
+static volatile uint8_t digital_output_state;
+
+// Count of M64/M65 commands, and the count at the last one on each output. A block parsed before
+// an M64/M65 carries an older epoch and must not undo it when the block starts.
+static volatile uint16_t digital_output_epoch;
+static volatile uint16_t digital_output_immediate_epoch[N_DIGITAL_OUTPUTS];
+
+
+void digital_output_init()
+{
+  uint8_t idx;
+  for (idx=0; idx<N_DIGITAL_OUTPUTS; idx++) {
+    PinInitOutput(digital_output_pin[idx], DIGITAL_OUTPUT_PORT);
+  }
+  digital_output_state = 0xFF; // Force every pin to be written below.
+  digital_output_write(0, 0xFF);
+}
+
+
+uint8_t digital_output_get_state()
+{
+  return(digital_output_state);
+}
+
+
+// Called by the stepper ISR at the first step of a block carrying a synchronized M62/M63 change,
+// and by the parser for immediate M64/M65. Only pins whose state actually changes are written.
+void digital_output_write(uint8_t state, uint8_t mask)
+{
+  uint8_t changed = (state ^ digital_output_state) & mask;
+  if (!changed) { return; }
+  uint8_t idx;
+  for (idx=0; idx<N_DIGITAL_OUTPUTS; idx++) {
+    if (changed & bit(idx)) {
+      #ifdef INVERT_DIGITAL_OUTPUT_PINS
+        HAL_GPIO_WritePin(DIGITAL_OUTPUT_PORT, digital_output_pin[idx], (state & bit(idx)) ? GPIO_PIN_LOW : GPIO_PIN_HIGH);
+      #else
+        HAL_GPIO_WritePin(DIGITAL_OUTPUT_PORT, digital_output_pin[idx], (state & bit(idx)) ? GPIO_PIN_HIGH : GPIO_PIN_LOW);
+      #endif
+    }
+  }
+  digital_output_state ^= changed;
+}
+
+
+// G-code parser entry-point for M64/M65. Unlike coolant_sync(), no planner sync is performed,
+// so the output switches while buffered motions keep running. Blocked in check mode.
+void digital_output_set_immediate(uint8_t output, uint8_t enable)
+{
+  if (sys.state == STATE_CHECK_MODE) { return; }
+  HAL_IRQ_DisableInterrupts(); // Shadow and epochs are shared with the stepper ISR.
+  digital_output_epoch++;
+  digital_output_immediate_epoch[output] = digital_output_epoch;
+  digital_output_write((enable ? bit(output) : 0), bit(output));
+  HAL_IRQ_EnableInterrupts();
+}
+
+
+uint16_t digital_output_get_epoch()
+{
+  return(digital_output_epoch);
+}
+
+
+void digital_output_write_sync(uint8_t set, uint8_t clear, uint16_t epoch)
+{
+  uint8_t mask = set | clear;
+  uint8_t idx;
+  for (idx=0; idx<N_DIGITAL_OUTPUTS; idx++) {
+    // Wrap-safe compare. Blocks in the buffer never lag 32767 M64/M65 commands behind.
+    if ((int16_t)(epoch - digital_output_immediate_epoch[idx]) < 0) { mask &= ~bit(idx); }
+  }
+  digital_output_write(set, mask);
+}
+
+#endif
@@ -0,0 +1,45 @@
+/*
+  digital_output.h - general purpose digital output methods (M62-M65)
+  Part of Grbl
+
+  Copyright (c) 2012-2016 Sungeun K. Jeon for Gnea Research LLC
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef digital_output_h
+#define digital_output_h
+
+
+// Initializes digital output pins. Outputs are driven low (inactive) on power-up only.
+void digital_output_init();
+
+// Returns current digital output state as a bitmask. Bit n corresponds to M62-M65 P<n>.
+uint8_t digital_output_get_state();
+
+// Sets the outputs selected by mask to the corresponding bits of state. Leaves other outputs
+// untouched. Safe to call from the stepper ISR.
+void digital_output_write(uint8_t state, uint8_t mask);
+
+// G-code parser entry-point for the immediate M64/M65 outputs. Does not sync the planner.
+void digital_output_set_immediate(uint8_t output, uint8_t enable);
+
+// Returns the count of M64/M65 commands executed so far. Stamped on each planned block.
+uint16_t digital_output_get_epoch();
+
+// Stepper ISR entry-point for a block's M62/M63 changes. Outputs switched by M64/M65 after the
+// block was parsed (epoch) are left alone.
+void digital_output_write_sync(uint8_t set, uint8_t clear, uint16_t epoch);
+
+#endif
@@ -1,399 +1,630 @@
-// This file has been prepared for Doxygen automatic documentation generation.
-/**
- * @file eeprom.cpp
- * @brief EEPROM implementation for MIK32 platform (ELRON_ACE_UNO)
- */
-
-#include <cstdint>
-
-extern "C"{
-#include <mik32_hal_eeprom.h>
-#include <mik32_memory_map.h>
-}
-#include "grbl.hpp"
-
-// Настройки для АМУРА
-#define EEPROM_OP_TIMEOUT 100000
-#define EEPROM_PAGE_WORDS 32
-#define EEPROM_PAGE_COUNT 64
-
-// EEPROM handle
-static HAL_EEPROM_HandleTypeDef heeprom;
-static bool eeprom_initialized = false;
-
-/**
- * @brief Инициализация EEPROM.
- *
- * Эта функция инициализирует аппаратуру EEPROM и настраивает дескриптор
- * для платформы MIK32. Она устанавливает EEPROM в двухстадийном режиме
- * с включённой коррекцией ошибок и отключёнными прерываниями. После инициализации
- * вычисляются тайминги EEPROM для системной частоты 32 МГц.
- *
- * @note Эту функцию необходимо вызвать перед любыми другими операциями с EEPROM.
- *       При успехе она устанавливает глобальный флаг `eeprom_initialized` в true.
- */
-void eeprom_init()
-{
-	heeprom.Instance = EEPROM_REGS;
-	heeprom.Mode = HAL_EEPROM_MODE_TWO_STAGE;
-	heeprom.ErrorCorrection = HAL_EEPROM_ECC_ENABLE;
-	heeprom.EnableInterrupt = HAL_EEPROM_SERR_DISABLE;
-	
-    HAL_EEPROM_Init(&heeprom);
-    HAL_EEPROM_CalculateTimings(&heeprom, 32000000); // Настраиваем часы на 32MHz
-    eeprom_initialized = true;
-}
-
-
-/**
- * @brief Очистка страниц EEPROM.
- *
- * Эта функция очищает (стирает) указанное количество 32-битных слов, начиная с заданной страницы.
- * Если EEPROM не инициализирована, функция возвращает HAL_ERROR.
- * Функция проверяет корректность номера страницы и количества слов.
- * Если word_count равно 0, функция возвращает HAL_OK без выполнения операций.
- * Параметр data не используется, но требуется для совместимости с HAL.
- *
- * @param start_page Номер начальной страницы (0‑EEPROM_PAGE_COUNT-1).
- * @param word_count Количество 32-битных слов для очистки.
- * @return HAL_StatusTypeDef Статус выполнения операции (HAL_OK, HAL_ERROR).
- */
-HAL_StatusTypeDef eeprom_erase_from_page(
-    uint8_t start_page,
-    uint8_t word_count
-) {
-    return HAL_OK;
-    // if (!eeprom_initialized) {
-    //     return HAL_ERROR;
-    // }
-    
-    // // Проверка параметров
-    // if (start_page >= EEPROM_PAGE_COUNT) {
-    //     return HAL_ERROR; // Некорректный номер страницы
-    // }
-    
-    // if (word_count == 0) {
-    //     return HAL_OK; // Ничего не нужно записывать
-    // }
-    
-    // // Вызов стандартной функции очистки HAL
-    // return HAL_EEPROM_Erase(&heeprom, start_page, word_count, HAL_EEPROM_WRITE_SINGLE, EEPROM_OP_TIMEOUT);
-}
-
-/**
- * @brief Запись данных в EEPROM начиная с указанной страницы.
- *
- * Эта функция записывает массив 32-битных слов в EEPROM, начиная с указанной страницы.
- * Если EEPROM не инициализирована, функция возвращает HAL_ERROR.
- * Функция автоматически вычисляет адрес в байтах на основе номера страницы.
- * Используется режим записи HAL_EEPROM_WRITE_SINGLE.
- *
- * @param start_page Номер начальной страницы (0‑EEPROM_PAGE_COUNT-1).
- * @param data Указатель на массив данных для записи.
- * @param word_count Количество 32-битных слов для записи.
- * @return HAL_StatusTypeDef Статус выполнения операции (HAL_OK, HAL_ERROR, HAL_TIMEOUT).
- */
-HAL_StatusTypeDef eeprom_write_from_page(
-    uint8_t start_page,
-    uint32_t *data,
-    uint8_t word_count
-) {
-    if (!eeprom_initialized) {
-        return HAL_ERROR;
-    }
-    
-    // Проверка параметров
-    if (start_page >= EEPROM_PAGE_COUNT) {
-        return HAL_ERROR; // Некорректный номер страницы
-    }
-    
-    if (word_count == 0) {
-        return HAL_OK; // Ничего не нужно записывать
-    }
-    
-    // Вычисление начального адреса в байтах
-    uint16_t start_address = start_page * EEPROM_PAGE_WORDS * 4;
-    
-    // Проверка, не выходим ли мы за пределы EEPROM
-    uint16_t max_words = (EEPROM_PAGE_COUNT - start_page) * EEPROM_PAGE_WORDS;
-    if (word_count > max_words) {
-        word_count = max_words; // Ограничиваем количество слов
-    }
-    
-    // Вызов стандартной функции записи HAL
-    return HAL_EEPROM_Write(&heeprom, start_address, data, word_count, HAL_EEPROM_WRITE_SINGLE, EEPROM_OP_TIMEOUT);
-}
-
-/**
- * @brief Чтение страницы EEPROM.
- *
- * Эта функция читает одну страницу EEPROM (размером EEPROM_PAGE_WORDS слов) в буфер.
- * Если EEPROM не инициализирована, функция ничего не делает (буфер остаётся неизменным).
- * Если номер страницы некорректен, функция также ничего не делает.
- *
- * @param page_number Номер страницы (0..EEPROM_PAGE_COUNT-1)
- * @param data Указатель на буфер размером EEPROM_PAGE_WORDS слов (uint32_t) для сохранения данных
- */
-void read_eeprom_page(unsigned int page_number, uint32_t *data)
-{
-    if (!eeprom_initialized) {
-        return;
-    }
-    
-    // Проверка параметров
-    if (page_number >= EEPROM_PAGE_COUNT) {
-        return; // Некорректный номер страницы
-    }
-    
-    // Вычисление начального адреса в байтах
-    uint16_t start_address = page_number * EEPROM_PAGE_WORDS * 4;
-    
-    // Чтение всей страницы за один вызов HAL_EEPROM_Read
-    if (HAL_EEPROM_Read(&heeprom, start_address, data, EEPROM_PAGE_WORDS, EEPROM_OP_TIMEOUT) != HAL_OK) {
-        // При ошибке чтения заполняем буфер нулями
-        for (unsigned int i = 0; i < EEPROM_PAGE_WORDS; ++i) {
-            data[i] = 0;
-        }
-        return;
-    }
-}
-
-// Extensions added as part of Grbl
-
-/**
- * @brief Копирование данных в EEPROM с контрольной суммой.
- *
- * Эта функция копирует `size` байт из оперативной памяти `source` в EEPROM,
- * начиная со страницы `destination`. Во время копирования вычисляется 8‑битная
- * циклическая контрольная сумма (вращение влево и сложение). После данных
- * контрольная сумма сохраняется в следующий байт EEPROM.
- *
- * @param destination Начальная страница EEPROM для записи данных (0..EEPROM_PAGE_COUNT-1).
- * @param count_page  Количество выделенных страниц для записи.
- * @param source Указатель на исходные данные в ОЗУ.
- * @param offset смещение начала размещения исходных данных в странице 
- * @param size Количество байт для копирования.
- */
-void memcpy_to_eeprom_with_checksum(unsigned int destination, unsigned int count_page, char *source, unsigned int offset, unsigned int size) {
-
-    // Закомменировал, пока не работает.
-   // Проверка на нулевой размер
-    // if (size == 0) {
-    //     return;
-    // }
-
-    // // Проверка, что EEPROM инициализирована
-    // if (!eeprom_initialized) {
-    //     return;
-    // }
-
-    // // Проверка, что начальная страница допустима
-    // if (destination >= EEPROM_PAGE_COUNT) {
-    //     return;
-    // }
-
-    // // Проверка, что выделено хотя бы одна страница
-    // if (count_page == 0) {
-    //     return;
-    // }
-
-    // // Вычисляем общий размер данных с контрольной суммой
-    // unsigned int total_size = size + 1; // данные + контрольная сумма
-    
-    // // Вычисляем размер страницы в байтах
-    // unsigned int page_size_bytes = EEPROM_PAGE_WORDS * 4;
-    
-    // // Проверка, что не выходим за пределы EEPROM
-    // if (destination + count_page > EEPROM_PAGE_COUNT) {
-    //     return;
-    // }
-
-    // // Проверка, что offset находится в пределах выделенных страниц
-    // if (offset >= page_size_bytes * count_page) {
-    //     return; // Некорректное смещение
-    // }
-    
-    // // Максимальный размер данных, который можно записать в выделенные страницы с учетом offset
-    // unsigned int max_data_size = count_page * page_size_bytes - offset - 1; // минус 1 байт для контрольной суммы
-    
-    // // Проверка, что данные помещаются в выделенные страницы
-    // if (size > max_data_size) {
-    //     // Данные слишком большие для выделенного пространства
-    //     return;
-    // }
-
-    // // Данные начинаются с указанного смещения внутри начальной страницы
-    // unsigned int start_page = destination;
-    // // offset_in_page теперь равен переданному параметру offset
-    
-    // // Вычисляем количество затронутых страниц (данные могут занимать несколько страниц) с учетом offset
-    // unsigned int needed_pages = (offset + total_size + page_size_bytes - 1) / page_size_bytes; // округление вверх
-    
-    // // Ограничиваем needed_pages количеством выделенных страниц
-    // if (needed_pages > count_page) {
-    //     needed_pages = count_page;
-    // }
-    
-    // // Статический буфер для затронутых страниц (в словах)
-    // uint32_t buffer[needed_pages * EEPROM_PAGE_WORDS] = {0};
-
-
-    // // 1. Чтение данных из EEPROM во временный буфер с использованием read_eeprom_page
-    // for (unsigned int page = 0; page < needed_pages; ++page) {
-    //     unsigned int global_page = start_page + page;
-    //     read_eeprom_page(global_page, buffer + page * EEPROM_PAGE_WORDS);
-    // }
-
-    // // Вспомогательный байтовый буфер для работы с отдельными байтами
-    // char *byte_buffer = (char*)buffer;
-
-    // // 2. Модификация буфера новыми данными и вычисление контрольной суммы
-    // uint8_t checksum = 0;
-    // for (unsigned int i = 0; i < size; ++i) {
-    //     uint8_t byte = static_cast<uint8_t>(source[i]);
-        
-    //     // Циклический сдвиг влево на 1 бит (вращение)
-    //     checksum = (checksum << 1) | (checksum >> 7);
-    //     // Сложение с байтом (по модулю 256)
-    //     checksum += byte;
-
-    //     // Замена байта в буфере
-    //     unsigned int buffer_index = offset + i;
-    //     // Проверка границ буфера (на всякий случай)
-    //     if (buffer_index < needed_pages * page_size_bytes) {
-    //         byte_buffer[buffer_index] = byte;
-    //     }
-    // }
-
-    // // 3. Запись контрольной суммы в буфер
-    // unsigned int checksum_index = offset + size;
-    // if (checksum_index < needed_pages * page_size_bytes) {
-    //     byte_buffer[checksum_index] = checksum;
-    // }
-
-    // HAL_StatusTypeDef result;
-
-    // // 4. Запись буфера обратно в EEPROM по одной странице за проход
-    // for (unsigned int page = 0; page < needed_pages; ++page) {
-    //    unsigned int global_page = start_page + page;
-    //    uint32_t *page_data = buffer + page * EEPROM_PAGE_WORDS;
-    //    result = eeprom_write_from_page(global_page, page_data, EEPROM_PAGE_WORDS);
-    //    if (result == HAL_OK)
-    //    {
-    //     delay_ms(1);
-    //    }
-    // }
-}
-
-/**
- * @brief Копирование данных из EEPROM с проверкой контрольной суммы.
- *
- * @param destination Указатель на буфер назначения в ОЗУ.
- * @param source_page Начальная страница EEPROM.
- * @param count_page  Количество страниц для чтения.
- * @param offset  Смещение для чтения.
- * @param size Количество байт для чтения.
- * @return 1 (истина), если контрольная сумма совпадает, иначе 0 (ложь).
- */
-int memcpy_from_eeprom_with_checksum(char *destination, unsigned int source_page, unsigned int count_page, unsigned int offset, unsigned int size) {
-    
-    // Временная заглушка
-    return 0;
-
-    //Проверка на нулевой размер
-    if (size == 0) {
-        return 0;
-    }
-
-    // Проверка, что EEPROM инициализирована
-    if (!eeprom_initialized) {
-        return 0;
-    }
-
-    // Проверка, что начальная страница допустима
-    if (source_page >= EEPROM_PAGE_COUNT) {
-        return 0;
-    }
-
-    // Проверка, что выделено хотя бы одна страница
-    if (count_page == 0) {
-        return 0;
-    }
-
-    // Вычисляем общий размер данных с контрольной суммой
-    unsigned int total_size = size + 1; // данные + контрольная сумма
-    
-    // Вычисляем размер страницы в байтах
-    unsigned int page_size_bytes = EEPROM_PAGE_WORDS * 4;
-    
-    // Проверка, что не выходим за пределы EEPROM
-    if (source_page + count_page > EEPROM_PAGE_COUNT) {
-        return 0;
-    }
-
-    // Проверка, что offset находится в пределах страниц
-    if (offset >= count_page * page_size_bytes) {
-        return 0; // Некорректное смещение
-    }
-    
-    // Максимальный размер данных, который можно прочитать из выделенных страниц с учетом offset
-    unsigned int max_data_size = count_page * page_size_bytes - offset - 1; // минус 1 байт для контрольной суммы
-    
-    // Проверка, что данные помещаются в выделенные страницы
-    if (size > max_data_size) {
-        // Данные слишком большие для выделенного пространства
-        return 0;
-    }
-
-    // Вычисляем количество затронутых страниц (данные могут занимать несколько страниц) с учетом offset
-    unsigned int needed_pages = (offset + total_size + page_size_bytes - 1) / page_size_bytes; // округление вверх
-    
-    // Ограничиваем needed_pages количеством выделенных страниц
-    if (needed_pages > count_page) {
-        needed_pages = count_page;
-    }
-
-
-    // Статический буфер для затронутых страниц (в словах)
-    uint32_t buffer[needed_pages * EEPROM_PAGE_WORDS] = {0};
-
-    // 1. Чтение данных из EEPROM во временный буфер с использованием read_eeprom_page
-    for (unsigned int page = 0; page < needed_pages; ++page) {
-        unsigned int global_page = source_page + page;
-        read_eeprom_page(global_page, buffer + page * EEPROM_PAGE_WORDS);
-    }
-
-    // Вспомогательный байтовый буфер для работы с отдельными байтами
-    char *byte_buffer = (char*)buffer;
-
-    // 2. Извлечение данных из буфера и вычисление контрольной суммы
-    uint8_t checksum = 0;
-    for (unsigned int i = 0; i < size; ++i) {
-        unsigned int buffer_index = offset + i;
-        // Проверка границ буфера (на всякий случай)
-        if (buffer_index >= needed_pages * page_size_bytes) {
-            return 0; // Ошибка: выход за границы буфера
-        }
-        uint8_t byte = static_cast<uint8_t>(byte_buffer[buffer_index]);
-        
-        // Циклический сдвиг влево на 1 бит (вращение)
-        checksum = (checksum << 1) | (checksum >> 7);
-        // Сложение с байтом (по модулю 256)
-        checksum += byte;
-
-        // Копирование байта в destination
-        destination[i] = byte;
-    }
-
-    // 3. Чтение сохранённой контрольной суммы из буфера
-    unsigned int checksum_index = offset + size;
-    if (checksum_index >= needed_pages * page_size_bytes) {
-        return 0; // Ошибка: контрольная сумма вне буфера
-    }
-    uint8_t stored_checksum = static_cast<uint8_t>(byte_buffer[checksum_index]);
-
-    // 4. Сравнение контрольных сумм
-    return (checksum == stored_checksum) ? 1 : 0;
-
-}
-// end of file
+// This file has been prepared for Doxygen automatic documentation generation.
+/**
+ * @file eeprom.cpp
+ * @brief EEPROM implementation for MIK32 platform (ELRON_ACE_UNO)
+ */
+
+#include "grbl.hpp"
+
+// Настройки для АМУРА
+#define EEPROM_OP_TIMEOUT 100000
+
+// Метки заголовков страницы и записи журнала. Не равны ни 0x00, ни 0xFF, поэтому стёртое слово
+// (любой полярности) не принимается за заголовок.
+#define EEPROM_PAGE_TAG     0xA6
+#define EEPROM_PAGE_TAG_V1  0xA5 // Страница прежних версий, без меток фиксации: записи применяются сразу
+#define EEPROM_RECORD_TAG   0x5A
+#define EEPROM_NO_PAGE      0xFF
+#define EEPROM_NO_RECORD    0xFFFF // Слово хранилища без записи в журнале
+
+// Метка фиксации — запись с номером слова EEPROM_COMMIT_KEY | n, где n — число записей группы перед
+// ней, и CRC-32 этих записей в значении. Записи группы применяются только вместе с её меткой.
+#define EEPROM_COMMIT_KEY   0xF000
+#define EEPROM_COMMIT_COUNT 0x0FFF
+
+#if EEPROM_PAGE_RECORDS > 16
+  #error "EEPROM_PAGE_RECORDS must fit the 4-bit slot of a record position."
+#endif
+
+// EEPROM handle
+static HAL_EEPROM_HandleTypeDef heeprom;
+static bool eeprom_initialized = false;
+
+// Образ хранилища в ОЗУ и положение (страница и слот) последней зафиксированной записи каждого
+// слова. Образ — основная копия данных: чтения идут из него, а изменённые слова отмечаются в
+// store_dirty и записываются в журнал позже.
+static uint32_t store_image[EEPROM_STORE_WORDS];
+static uint16_t store_owner[EEPROM_STORE_WORDS];
+static uint32_t store_dirty[(EEPROM_STORE_WORDS+31)/32];
+static uint16_t store_dirty_count;
+
+// Журнал занимает store_pages страниц кольца от store_head до store_tail. Запись дописывается в
+// слот store_slot страницы store_tail с порядковым номером store_seq.
+static uint8_t store_head;
+static uint8_t store_tail;
+static uint8_t store_pages;
+static uint8_t store_slot;
+static uint32_t store_seq;
+
+// Записи открытой группы и их CRC-32, для метки фиксации.
+static uint16_t store_group_count;
+static uint32_t store_group_crc;
+
+/**
+ * @brief Инициализация EEPROM.
+ *
+ * Эта функция инициализирует аппаратуру EEPROM и настраивает дескриптор
+ * для платформы MIK32. Она устанавливает EEPROM в двухстадийном режиме
+ * с включённой коррекцией ошибок и отключёнными прерываниями. После инициализации
+ * вычисляются тайминги EEPROM для системной частоты 32 МГц.
+ *
+ * @note Эту функцию необходимо вызвать перед любыми другими операциями с EEPROM.
+ *       При успехе она устанавливает глобальный флаг `eeprom_initialized` в true.
+ */
+void eeprom_init()
+{
+	heeprom.Instance = EEPROM_REGS;
+	heeprom.Mode = HAL_EEPROM_MODE_TWO_STAGE;
+	heeprom.ErrorCorrection = HAL_EEPROM_ECC_ENABLE;
+	heeprom.EnableInterrupt = HAL_EEPROM_SERR_DISABLE;
+	
+    HAL_EEPROM_Init(&heeprom);
+    HAL_EEPROM_CalculateTimings(&heeprom, 32000000); // Настраиваем часы на 32MHz
+    eeprom_initialized = true;
+}
+
+
+/**
+ * @brief Адрес слова страницы журнала в байтах.
+ *
+ * @param page Страница от начала кольца журнала (0..EEPROM_STORE_PAGES-1).
+ * @param word Слово в странице (0..EEPROM_PAGE_WORDS-1).
+ */
+static uint16_t eeprom_store_address(uint8_t page, uint8_t word)
+{
+  return(((EEPROM_STORE_FIRST_PAGE + page)*EEPROM_PAGE_WORDS + word)*4);
+}
+
+
+/**
+ * @brief Чтение страницы журнала.
+ *
+ * При ошибке чтения буфер заполняется нулями, то есть страница считается стёртой.
+ *
+ * @param page Страница от начала кольца журнала.
+ * @param data Буфер на EEPROM_PAGE_WORDS слов.
+ */
+static void eeprom_store_read_page(uint8_t page, uint32_t *data)
+{
+  if (!eeprom_initialized || (HAL_EEPROM_Read(&heeprom, eeprom_store_address(page, 0), data, EEPROM_PAGE_WORDS, EEPROM_OP_TIMEOUT) != HAL_OK)) {
+    memset(data, 0, EEPROM_PAGE_WORDS*sizeof(uint32_t));
+  }
+}
+
+
+/**
+ * @brief Программирование слов страницы журнала.
+ *
+ * Слова должны быть стёрты. Остальные слова страницы не изменяются, поэтому запись в журнал —
+ * это программирование только её слов, без перезаписи страницы.
+ */
+static void eeprom_store_program(uint8_t page, uint8_t word, uint32_t *data, uint8_t word_count)
+{
+  if (!eeprom_initialized) { return; }
+  HAL_EEPROM_Write(&heeprom, eeprom_store_address(page, word), data, word_count, HAL_EEPROM_WRITE_SINGLE, EEPROM_OP_TIMEOUT);
+}
+
+
+/**
+ * @brief Стирание страницы журнала.
+ */
+static void eeprom_store_erase(uint8_t page)
+{
+  if (!eeprom_initialized) { return; }
+  HAL_EEPROM_Erase(&heeprom, eeprom_store_address(page, 0), EEPROM_PAGE_WORDS, HAL_EEPROM_WRITE_SINGLE, EEPROM_OP_TIMEOUT);
+}
+
+
+// Стёртое слово. Полярность стирания не важна: метки заголовков не совпадают ни с одной.
+static uint8_t eeprom_word_is_erased(uint32_t word) { return((word == 0) || (word == 0xFFFFFFFF)); }
+
+static uint8_t eeprom_page_is_valid(uint32_t header)
+{
+  return(((header >> 24) == EEPROM_PAGE_TAG) || ((header >> 24) == EEPROM_PAGE_TAG_V1));
+}
+
+// Положение записи: страница от начала кольца и слот в ней.
+static uint16_t eeprom_record_position(uint8_t page, uint8_t slot) { return(((uint16_t)page << 4) | slot); }
+
+
+/**
+ * @brief Контрольная сумма записи.
+ *
+ * 8‑битная циклическая контрольная сумма (вращение влево и сложение) по номеру слова и значению.
+ * Запись, программирование которой было прервано, не проходит проверку и пропускается. Данные
+ * целиком защищены CRC-32 блоков (см. eeprom_store_check_block()), а эта сумма только отделяет
+ * записанные записи от прерванных и сохраняет формат журнала прежних версий.
+ */
+static uint8_t eeprom_record_checksum(uint16_t key, uint32_t value)
+{
+  uint8_t bytes[6] = { (uint8_t)key, (uint8_t)(key >> 8), (uint8_t)value, (uint8_t)(value >> 8),
+                       (uint8_t)(value >> 16), (uint8_t)(value >> 24) };
+  uint8_t checksum = 0;
+  for (uint8_t i = 0; i < sizeof(bytes); i++) {
+    checksum = (checksum << 1) | (checksum >> 7);
+    checksum += bytes[i];
+  }
+  return(checksum);
+}
+
+
+static uint32_t eeprom_record_header(uint16_t key, uint32_t value)
+{
+  return(((uint32_t)EEPROM_RECORD_TAG << 24) | ((uint32_t)eeprom_record_checksum(key, value) << 16) | key);
+}
+
+
+/**
+ * @brief Сброс журнала в памяти: пустой журнал, все слова хранилища равны нулю.
+ */
+static void eeprom_store_clear()
+{
+  memset(store_image, 0, sizeof(store_image));
+  memset(store_owner, 0xFF, sizeof(store_owner)); // EEPROM_NO_RECORD
+  memset(store_dirty, 0, sizeof(store_dirty));
+  store_dirty_count = 0;
+  store_head = 0;
+  store_tail = EEPROM_STORE_PAGES-1;
+  store_pages = 0;
+  store_slot = EEPROM_PAGE_RECORDS; // Первая запись открывает страницу 0.
+  store_seq = 0;
+  store_group_count = 0;
+  store_group_crc = 0xFFFFFFFF;
+}
+
+
+static uint32_t eeprom_crc32_update(uint32_t crc, const uint8_t *data, uint16_t length);
+
+
+/**
+ * @brief Проход по журналу от самой старой страницы до самой новой.
+ *
+ * Записи группы применяются к образу, когда встречается её метка фиксации и CRC-32 группы совпадает,
+ * записи страниц прежних версий — сразу, каждая как отдельная фиксация. Записи после последней
+ * метки остались от прерванной фиксации и не применяются, а следующая группа начинается с новой
+ * страницы, чтобы они не попали ни в одну группу. Заодно находятся начало журнала и место для
+ * следующей записи.
+ *
+ * @param key Первое слово, которое применяется. Слова [key, key+word_count) сначала обнуляются.
+ * @param word_count Количество применяемых слов.
+ * @param commit_limit Сколько фиксаций применить. Остальные пропускаются.
+ * @param crc_words Если не 0, после каждой фиксации проверяется CRC-32 блока из crc_words слов
+ *        от key.
+ * @return Количество фиксаций, или, если задан crc_words, номер последней фиксации (от 1), после
+ *         которой CRC-32 блока совпадала, или 0.
+ */
+static uint16_t eeprom_store_scan(uint16_t key, uint16_t word_count, uint16_t commit_limit, uint16_t crc_words)
+{
+  memset(&store_image[key], 0, word_count*sizeof(uint32_t));
+  memset(&store_owner[key], 0xFF, word_count*sizeof(uint16_t));
+  store_pages = 0;
+  uint16_t commits = 0;
+  uint16_t valid = 0;
+  uint16_t pending = 0; // Записи после последней метки фиксации
+  uint8_t legacy = false;
+  uint32_t data[EEPROM_PAGE_WORDS];
+  uint32_t group_data[EEPROM_PAGE_WORDS];
+  uint8_t slot = 0;
+  for (uint8_t n = 1; n <= EEPROM_STORE_PAGES; n++) {
+    // Страницы журнала идут по кольцу подряд и заканчиваются самой новой.
+    uint8_t page = (store_tail + n) % EEPROM_STORE_PAGES;
+    eeprom_store_read_page(page, data);
+    if (!eeprom_page_is_valid(data[0])) { continue; }
+    if (store_pages == 0) { store_head = page; }
+    store_pages++;
+    legacy = ((data[0] >> 24) == EEPROM_PAGE_TAG_V1);
+    for (slot = 0; slot < EEPROM_PAGE_RECORDS; slot++) {
+      uint32_t header = data[1 + 2*slot];
+      if (eeprom_word_is_erased(header)) { break; } // Конец записей страницы
+      uint16_t record_key = header & 0xFFFF;
+      uint32_t value = data[2 + 2*slot];
+      if (header != eeprom_record_header(record_key, value)) { pending++; continue; } // Прерванная запись
+      uint8_t touched = false;
+      if (legacy) {
+        if (record_key >= EEPROM_STORE_WORDS) { continue; }
+        if ((++commits <= commit_limit) && ((uint16_t)(record_key - key) < word_count)) {
+          store_image[record_key] = value;
+          store_owner[record_key] = eeprom_record_position(page, slot);
+          touched = true;
+        }
+      } else if ((record_key & ~EEPROM_COMMIT_COUNT) != EEPROM_COMMIT_KEY) {
+        pending++;
+        continue;
+      } else {
+        // Метка фиксации. Записи группы — count слотов перед ней. Все страницы группы, кроме
+        // последней, заполнены, так как группа начинается с новой страницы после прерванной.
+        uint16_t count = record_key & EEPROM_COMMIT_COUNT;
+        int16_t first = (int16_t)((store_pages-1)*EEPROM_PAGE_RECORDS + slot) - count;
+        uint8_t complete = (first >= 0); // Начало группы могло уйти при уплотнении.
+        if (!complete) { first = 0; }
+        pending = 0;
+        if (++commits > commit_limit) { continue; }
+        // Первый проход проверяет CRC-32 группы, второй применяет её записи.
+        for (uint8_t apply = !complete; apply < 2; apply++) {
+          uint32_t crc = 0xFFFFFFFF;
+          uint8_t group_page = EEPROM_NO_PAGE;
+          for (int16_t pos = first; pos < (int16_t)((store_pages-1)*EEPROM_PAGE_RECORDS + slot); pos++) {
+            uint8_t idx = pos / EEPROM_PAGE_RECORDS;
+            uint8_t record_slot = pos % EEPROM_PAGE_RECORDS;
+            uint32_t *record_data = data;
+            if (idx != store_pages-1) {
+              if (idx != group_page) {
+                eeprom_store_read_page((store_head + idx) % EEPROM_STORE_PAGES, group_data);
+                group_page = idx;
+              }
+              record_data = group_data;
+            }
+            uint32_t *record = &record_data[1 + 2*record_slot];
+            if (!apply) {
+              crc = eeprom_crc32_update(crc, (const uint8_t *)record, 2*sizeof(uint32_t));
+              continue;
+            }
+            uint16_t group_key = record[0] & 0xFFFF;
+            if ((record[0] != eeprom_record_header(group_key, record[1])) || ((uint16_t)(group_key - key) >= word_count)) { continue; }
+            store_image[group_key] = record[1];
+            store_owner[group_key] = eeprom_record_position((store_head + idx) % EEPROM_STORE_PAGES, record_slot);
+            touched = true;
+          }
+          if (!apply && (~crc != value)) { break; } // Повреждённая группа не применяется.
+        }
+      }
+      if (touched && crc_words && (store_image[key + crc_words] == eeprom_crc32((const uint8_t *)&store_image[key], crc_words*sizeof(uint32_t)))) {
+        valid = commits;
+      }
+    }
+    store_slot = slot;
+  }
+  // Прерванная фиксация или страница прежних версий: следующая группа начинается с новой страницы.
+  if (pending || legacy) { store_slot = EEPROM_PAGE_RECORDS; }
+  return(crc_words ? valid : commits);
+}
+
+
+/**
+ * @brief Восстановление образа хранилища из журнала.
+ *
+ * Сначала читаются заголовки страниц, чтобы найти самую новую страницу журнала. Затем страницы
+ * читаются подряд по кольцу, от самой старой до самой новой, и зафиксированные группы записей
+ * применяются к образу по порядку, так что последняя запись слова перекрывает предыдущие.
+ *
+ * @return true, если журнал найден. Иначе EEPROM стирается и возвращается false.
+ */
+uint8_t eeprom_store_load()
+{
+  eeprom_store_clear();
+
+  // Самая новая страница — с наибольшим порядковым номером (24 бита, по модулю).
+  uint8_t page;
+  uint8_t newest = EEPROM_NO_PAGE;
+  uint32_t newest_seq = 0;
+  for (page = 0; page < EEPROM_STORE_PAGES; page++) {
+    uint32_t header = 0;
+    if (!eeprom_initialized || (HAL_EEPROM_Read(&heeprom, eeprom_store_address(page, 0), &header, 1, EEPROM_OP_TIMEOUT) != HAL_OK)) { continue; }
+    if (!eeprom_page_is_valid(header)) { continue; }
+    uint32_t seq = header & 0xFFFFFF;
+    if ((newest == EEPROM_NO_PAGE) || ((int32_t)((seq - newest_seq) << 8) > 0)) {
+      newest = page;
+      newest_seq = seq;
+    }
+  }
+  if (newest == EEPROM_NO_PAGE) {
+    eeprom_store_format();
+    return(false);
+  }
+
+  store_tail = newest;
+  store_seq = newest_seq;
+  eeprom_store_scan(0, EEPROM_STORE_WORDS, 0xFFFF, 0);
+  return(true);
+}
+
+
+/**
+ * @brief Стирание всей EEPROM журнала.
+ */
+void eeprom_store_format()
+{
+  for (uint8_t page = 0; page < EEPROM_STORE_PAGES; page++) { eeprom_store_erase(page); }
+  eeprom_store_clear();
+}
+
+
+/**
+ * @brief Открытие следующей страницы кольца для записей.
+ *
+ * Страница, не стёртая полностью (например, стирание было прервано), сначала стирается.
+ * Вызывающий проверяет, что в кольце есть свободная страница.
+ */
+static void eeprom_store_open_page()
+{
+  uint8_t page = (store_tail + 1) % EEPROM_STORE_PAGES;
+  uint32_t data[EEPROM_PAGE_WORDS];
+  eeprom_store_read_page(page, data);
+  for (uint8_t i = 0; i < EEPROM_PAGE_WORDS; i++) {
+    if (!eeprom_word_is_erased(data[i])) {
+      eeprom_store_erase(page);
+      break;
+    }
+  }
+  if (store_pages == 0) { store_head = page; }
+  store_seq = (store_seq + 1) & 0xFFFFFF;
+  uint32_t header = ((uint32_t)EEPROM_PAGE_TAG << 24) | store_seq;
+  eeprom_store_program(page, 0, &header, 1);
+  store_tail = page;
+  store_pages++;
+  store_slot = 0;
+}
+
+
+static uint8_t eeprom_store_is_dirty(uint16_t key) { return((store_dirty[key >> 5] >> (key & 31)) & 1); }
+
+/**
+ * @brief Отметка изменённого слова для следующей фиксации.
+ */
+static void eeprom_store_mark(uint16_t key)
+{
+  if (!eeprom_store_is_dirty(key)) {
+    store_dirty[key >> 5] |= (uint32_t)1 << (key & 31);
+    store_dirty_count++;
+  }
+}
+
+/**
+ * @brief Снятие отметки изменённого слова.
+ */
+static void eeprom_store_clean(uint16_t key)
+{
+  if (eeprom_store_is_dirty(key)) {
+    store_dirty[key >> 5] &= ~((uint32_t)1 << (key & 31));
+    store_dirty_count--;
+  }
+}
+
+
+/**
+ * @brief Дописывание записи в журнал.
+ *
+ * @return Слот записи в странице store_tail.
+ */
+static uint8_t eeprom_store_program_record(uint16_t key, uint32_t value)
+{
+  if (store_slot == EEPROM_PAGE_RECORDS) { eeprom_store_open_page(); }
+  uint32_t record[2] = { eeprom_record_header(key, value), value };
+  eeprom_store_program(store_tail, 1 + 2*store_slot, record, 2);
+  store_group_count++;
+  store_group_crc = eeprom_crc32_update(store_group_crc, (const uint8_t *)record, sizeof(record));
+  return(store_slot++);
+}
+
+
+/**
+ * @brief Дописывание записи слова в открытую группу.
+ */
+static void eeprom_store_append(uint16_t key, uint32_t value)
+{
+  uint8_t slot = eeprom_store_program_record(key, value);
+  store_image[key] = value;
+  store_owner[key] = eeprom_record_position(store_tail, slot);
+}
+
+
+/**
+ * @brief Закрытие группы записей меткой фиксации.
+ *
+ * До метки записи группы не применяются при восстановлении, поэтому прерванная фиксация не
+ * оставляет в хранилище часть изменений.
+ */
+static void eeprom_store_close_group()
+{
+  uint16_t count = store_group_count;
+  if (count == 0) { return; }
+  eeprom_store_program_record(EEPROM_COMMIT_KEY | count, ~store_group_crc);
+  store_group_count = 0;
+  store_group_crc = 0xFFFFFFFF;
+}
+
+
+/**
+ * @brief Уплотнение самой старой страницы журнала.
+ *
+ * Записи, которые ещё действительны (последние зафиксированные для своего слова), переносятся в
+ * конец журнала отдельной группой, после чего страница стирается. Переносится зафиксированное
+ * значение, а не значение из образа, так что изменение, ждущее фиксации, не попадает в журнал
+ * раньше остальных изменений своей группы. Нулевые значения не переносятся: без записи слово и так
+ * равно нулю, а более старых страниц уже нет. Перенос с меткой занимает не больше двух страниц,
+ * поэтому перед вызовом в кольце должно быть две свободные страницы.
+ */
+static void eeprom_store_reclaim()
+{
+  if (store_pages <= 1) { return; } // Самая старая страница — текущая.
+  uint8_t page = store_head;
+  uint32_t data[EEPROM_PAGE_WORDS];
+  eeprom_store_read_page(page, data);
+  for (uint8_t slot = 0; slot < EEPROM_PAGE_RECORDS; slot++) {
+    uint32_t header = data[1 + 2*slot];
+    if (eeprom_word_is_erased(header)) { break; }
+    uint16_t key = header & 0xFFFF;
+    if ((key >= EEPROM_STORE_WORDS) || (store_owner[key] != eeprom_record_position(page, slot))) { continue; }
+    uint32_t value = data[2 + 2*slot];
+    if (value == 0) { store_owner[key] = EEPROM_NO_RECORD; continue; }
+    uint8_t moved = eeprom_store_program_record(key, value); // Образ не меняется: в нём может быть новое значение.
+    store_owner[key] = eeprom_record_position(store_tail, moved);
+  }
+  eeprom_store_close_group(); // Перенесённые записи фиксируются до стирания страницы.
+  eeprom_store_erase(page);
+  store_head = (page + 1) % EEPROM_STORE_PAGES;
+  store_pages--;
+}
+
+
+static uint8_t eeprom_store_free_pages() { return(EEPROM_STORE_PAGES - store_pages); }
+
+
+/**
+ * @brief Запись слова хранилища в образ.
+ *
+ * Неизменённое слово не отмечается. Изменённое записывается в журнал при следующей фиксации.
+ */
+static void eeprom_store_write(uint16_t key, uint32_t value)
+{
+  if (store_image[key] == value) { return; }
+  store_image[key] = value;
+  eeprom_store_mark(key);
+}
+
+
+// CRC-32 (полином 0xEDB88320, отражённый), по четыре бита за шаг.
+static const uint32_t eeprom_crc_table[16] = {
+  0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+  0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+/**
+ * @brief Продолжение CRC-32 по следующим байтам, без начального значения и финальной инверсии.
+ */
+static uint32_t eeprom_crc32_update(uint32_t crc, const uint8_t *data, uint16_t length)
+{
+  while (length--) {
+    crc ^= *data++;
+    crc = (crc >> 4) ^ eeprom_crc_table[crc & 0x0F];
+    crc = (crc >> 4) ^ eeprom_crc_table[crc & 0x0F];
+  }
+  return(crc);
+}
+
+
+/**
+ * @brief CRC-32 данных (как в zip и IEEE 802.3).
+ */
+uint32_t eeprom_crc32(const uint8_t *data, uint16_t length)
+{
+  return(~eeprom_crc32_update(0xFFFFFFFF, data, length));
+}
+
+
+static uint32_t eeprom_store_block_crc(uint16_t key, uint16_t word_count)
+{
+  return(eeprom_crc32((const uint8_t *)&store_image[key], word_count*sizeof(uint32_t)));
+}
+
+
+/**
+ * @brief Запись блока данных в хранилище.
+ *
+ * За словами блока записывается их CRC-32.
+ *
+ * @param key Первое слово хранилища.
+ * @param word_count Количество слов блока без CRC. Байты после size заполняются нулями.
+ * @param data Данные в ОЗУ.
+ * @param size Количество байт данных (не больше word_count*4).
+ */
+void eeprom_store_write_block(uint16_t key, uint16_t word_count, const void *data, uint16_t size)
+{
+  const uint8_t *bytes = (const uint8_t *)data;
+  for (uint16_t i = 0; i < word_count; i++) {
+    uint32_t value = 0;
+    if (size > 4*i) { memcpy(&value, bytes + 4*i, min(size - 4*i, 4)); }
+    eeprom_store_write(key + i, value);
+  }
+  eeprom_store_write(key + word_count, eeprom_store_block_crc(key, word_count));
+}
+
+
+/**
+ * @brief Проверка CRC-32 блока в образе хранилища.
+ *
+ * @return true, если CRC-32 слов блока совпадает с записанной за ними.
+ */
+uint8_t eeprom_store_check_block(uint16_t key, uint16_t word_count)
+{
+  return(store_image[key + word_count] == eeprom_store_block_crc(key, word_count));
+}
+
+
+/**
+ * @brief Восстановление последней копии блока с совпадающей CRC-32 из журнала.
+ *
+ * Журнал проходится дважды, применяя только слова блока: сначала находится последняя фиксация,
+ * после которой CRC-32 блока совпадала, затем блок собирается заново до неё. Восстановленные слова
+ * отмечаются и записываются при следующей фиксации. Доступны только копии, ещё не вытесненные из
+ * журнала уплотнением.
+ *
+ * @return true, если такая копия найдена. Иначе блок остаётся как был.
+ */
+uint8_t eeprom_store_recover_block(uint16_t key, uint16_t word_count)
+{
+  uint16_t commit = eeprom_store_scan(key, word_count+1, 0xFFFF, word_count);
+  if (commit == 0) { return(false); }
+  eeprom_store_scan(key, word_count+1, commit, 0);
+  for (uint16_t i = 0; i <= word_count; i++) { eeprom_store_mark(key + i); }
+  return(true);
+}
+
+
+/**
+ * @brief Чтение блока данных из образа хранилища в ОЗУ.
+ */
+void eeprom_store_read_block(uint16_t key, void *data, uint16_t size)
+{
+  memcpy(data, &store_image[key], size);
+}
+
+
+/**
+ * @brief Страницы, которые откроет дописывание records записей.
+ */
+static uint8_t eeprom_store_pages_needed(uint16_t records)
+{
+  uint8_t room = EEPROM_PAGE_RECORDS - store_slot;
+  if (records <= room) { return(0); }
+  return((records - room + EEPROM_PAGE_RECORDS-1) / EEPROM_PAGE_RECORDS);
+}
+
+
+/**
+ * @brief Фиксация изменённых слов в журнале.
+ *
+ * Каждое изменённое слово дописывается одной записью со значением из образа, и группа
+ * закрывается меткой фиксации с CRC-32 её записей. Место под группу освобождается заранее:
+ * уплотнение посреди группы стёрло бы страницу, перенесённые записи которой ещё не зафиксированы.
+ * После фиксации в кольце остаются две свободные страницы, чтобы уплотнению всегда было куда писать.
+ */
+void eeprom_store_commit()
+{
+  if (store_dirty_count == 0) { return; }
+  while ((eeprom_store_free_pages() < eeprom_store_pages_needed(store_dirty_count + 1) + 2) && (store_pages > 1)) {
+    eeprom_store_reclaim();
+  }
+  for (uint16_t key = 0; (key < EEPROM_STORE_WORDS) && store_dirty_count; key++) {
+    if (!eeprom_store_is_dirty(key)) { continue; }
+    eeprom_store_clean(key);
+    eeprom_store_append(key, store_image[key]);
+  }
+  eeprom_store_close_group();
+}
+
+
+uint8_t eeprom_store_dirty() { return(store_dirty_count != 0); }
+
+
+/**
+ * @brief Фоновое уплотнение журнала.
+ *
+ * Уплотняет не больше одной страницы за вызов, пока свободных страниц меньше
+ * EEPROM_STORE_RESERVE_PAGES.
+ */
+void eeprom_store_compact()
+{
+  if (eeprom_store_free_pages() < EEPROM_STORE_RESERVE_PAGES) { eeprom_store_reclaim(); }
+}
+// end of file
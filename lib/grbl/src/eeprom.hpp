@@ -21,34 +21,63 @@
 #ifndef eeprom_h
 #define eeprom_h
 
-#ifdef ESP8266
-//extern "C" {
-  #include <EEPROM.h>
-//}
-#else
-// For MIK32 platform
-extern "C" {
-#include <mik32_hal_eeprom.h>
-}
-#endif
+// EEPROM MIK32: 64 pages of 32 words.
+#define EEPROM_PAGE_WORDS 32
+#define EEPROM_PAGE_COUNT 64
+
+// Persistent data is kept as a log of records over all EEPROM pages, so each page is erased in
+// turn. A record holds one word of the store, numbered 0 to EEPROM_STORE_WORDS-1 (see settings.h),
+// and takes two words: a header with the word number and a checksum, then the value. The records
+// of a commit are followed by a commit record holding their count and CRC-32, and only apply with
+// it, so a commit cut short by a power loss leaves the store as it was. A page starts with a header
+// word holding a sequence number, which orders the pages of the log.
+#define EEPROM_STORE_FIRST_PAGE 0
+#define EEPROM_STORE_PAGES EEPROM_PAGE_COUNT
+#define EEPROM_PAGE_RECORDS ((EEPROM_PAGE_WORDS-1)/2) // Records per page, after the page header.
+
+// Erased pages kept ahead of the log. While idle, the oldest page is compacted until there are
+// this many, so a commit only has to erase a page itself after many changes in a row.
+#define EEPROM_STORE_RESERVE_PAGES 8
+
 
 void eeprom_init();
-unsigned char eeprom_get_char(unsigned int addr);
-//void eeprom_put_char(unsigned int addr, unsigned char new_value);
-HAL_StatusTypeDef eeprom_write_from_page(
-    uint8_t start_page,
-    uint32_t *data,
-    uint8_t word_count
-);
-
-HAL_StatusTypeDef eeprom_erase_from_page(
-    uint8_t start_page,
-    uint8_t word_count
-);
-
-void read_eeprom_page(unsigned int page_number, uint32_t *data);
-
-void memcpy_to_eeprom_with_checksum(unsigned int destination, unsigned int count_page, char *source, unsigned int offset, unsigned int size);
-int memcpy_from_eeprom_with_checksum(char *destination, unsigned int source_page, unsigned int count_page, unsigned int offset, unsigned int size);
+
+// Rebuilds the store from the log in one scan of the EEPROM. Words without a record read as zero.
+// Returns false and erases the EEPROM, if no log was found.
+uint8_t eeprom_store_load();
+
+// Erases the EEPROM. All words of the store read as zero.
+void eeprom_store_format();
+
+// Writes size bytes of data to the store, starting at word key and zero-filled to word_count
+// words, followed by their CRC-32 in word key+word_count. Only the RAM copy is written, which is
+// what reads return. The changed words are marked for the next commit.
+void eeprom_store_write_block(uint16_t key, uint16_t word_count, const void *data, uint16_t size);
+
+// Returns true, if the CRC-32 of word_count words from word key matches the one stored after them.
+uint8_t eeprom_store_check_block(uint16_t key, uint16_t word_count);
+
+// Restores the block of word_count words from word key, and its CRC-32, to their last copy in the
+// log whose CRC-32 matched, and marks them for the next commit. Returns false and leaves the block
+// as it was, if the log holds no such copy.
+uint8_t eeprom_store_recover_block(uint16_t key, uint16_t word_count);
+
+// Returns the CRC-32 (IEEE 802.3, as in zip) of length bytes.
+uint32_t eeprom_crc32(const uint8_t *data, uint16_t length);
+
+// Programs the words changed since the last commit, one record each, and a commit record. A word
+// changed many times in between takes one record. Called while idle or by '$SAVE', as programming
+// stalls the CPU.
+void eeprom_store_commit();
+
+// Returns true, if words were changed since the last commit.
+uint8_t eeprom_store_dirty();
+
+// Reads size bytes from the store, starting at word key.
+void eeprom_store_read_block(uint16_t key, void *data, uint16_t size);
+
+// Compacts the oldest page of the log, if fewer than EEPROM_STORE_RESERVE_PAGES are erased. Called
+// while idle, as erasing a page stalls the CPU.
+void eeprom_store_compact();
 
 #endif
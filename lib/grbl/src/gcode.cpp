@@ -26,6 +26,8 @@
 // value when converting a float (7.2 digit precision)s to an integer.
 #define MAX_LINE_NUMBER 10000000
 #define MAX_TOOL_NUMBER 255 // Limited by max unsigned 8-bit value
+#define MAX_L_VALUE 255 // Limited by max unsigned 8-bit value
+#define MAX_H_VALUE 255 // Limited by max unsigned 8-bit value
 
 #define AXIS_COMMAND_NONE 0
 #define AXIS_COMMAND_NON_MODAL 1
@@ -35,13 +37,17 @@
 // Declare gc extern struct
 parser_state_t gc_state;
 parser_block_t gc_block;
+uint16_t gc_sync_elided; // Spindle/coolant syncs skipped as no-ops. See REPORT_DIAGNOSTIC_COUNTERS. Wraps around.
 
 #define FAIL(status) return(status);
 
 
 void gc_init()
 {
-  memset(&gc_state, 0, sizeof(parser_state_t));
+  memset(&gc_state, 0, sizeof(parser_state_t)); // Outputs are retained through a reset, pending M62/M63 are not.
+  #ifdef ENABLE_GCODE_TOKENS
+    gc_token_reset(); // The host starts over with absolute words.
+  #endif
 
   // Load default G54 coordinate system.
   if (!(settings_read_coord_data(gc_state.modal.coord_select,gc_state.coord_system))) {
@@ -78,14 +84,18 @@ uint8_t gc_execute_line(char *line, uint8_t client)
   uint8_t axis_command = AXIS_COMMAND_NONE;
   uint8_t axis_0, axis_1, axis_linear;
   uint8_t coord_select = 0; // Tracks G10 P coordinate selection for execution
+  #ifdef ENABLE_DIGITAL_OUTPUTS
+    uint8_t digital_out_command = DIGITAL_OUTPUT_NO_ACTION; // Tracks M62-M65 for execution
+    uint8_t digital_out_index = 0;
+  #endif
 
   // Initialize bitflag tracking variables for axis indices compatible operations.
   uint8_t axis_words = 0; // XYZ tracking
   uint8_t ijk_words = 0; // IJK tracking
 
   // Initialize command and value words and parser flags variables.
-  uint16_t command_words = 0; // Tracks G and M command words. Also used for modal group violations.
-  uint16_t value_words = 0; // Tracks value words.
+  uint32_t command_words = 0; // Tracks G and M command words. Also used for modal group violations.
+  uint32_t value_words = 0; // Tracks value words.
   uint8_t gc_parser_flags = GC_PARSER_NONE;
 
   // Determine if the line is a jogging motion or a normal g-code block.
@@ -118,9 +128,17 @@ uint8_t gc_execute_line(char *line, uint8_t client)
     ///delay(0);
     // Import the next g-code word, expecting a letter followed by a value. Otherwise, error out.
     letter = line[char_counter];
-    if((letter < 'A') || (letter > 'Z')) { FAIL(STATUS_EXPECTED_COMMAND_LETTER); } // [Expected word letter]
-    char_counter++;
-    if (!read_float(line, &char_counter, &value)) { FAIL(STATUS_BAD_NUMBER_FORMAT); } // [Expected word value]
+    #ifdef ENABLE_GCODE_TOKENS
+      if ((uint8_t)letter >= GC_TOKEN_WORD) {
+        // Tokenized word. Decodes to the same letter and value as the text word it was made from.
+        if (!gc_token_read_word(line, &char_counter, &letter, &value)) { FAIL(STATUS_BAD_NUMBER_FORMAT); }
+      } else
+    #endif
+    {
+      if((letter < 'A') || (letter > 'Z')) { FAIL(STATUS_EXPECTED_COMMAND_LETTER); } // [Expected word letter]
+      char_counter++;
+      if (!read_float(line, &char_counter, &value)) { FAIL(STATUS_BAD_NUMBER_FORMAT); } // [Expected word value]
+    }
 
     // Convert values to smaller uint8 significand and mantissa values for parsing this word.
     // NOTE: Mantissa is multiplied by 100 to catch non-integer command values. This is more
@@ -160,8 +178,11 @@ uint8_t gc_execute_line(char *line, uint8_t client)
               mantissa = 0; // Set to zero to indicate valid non-integer G command.
             }
             break;
-          case 0: case 1: case 2: case 3: case 38:
-            // Check for G0/1/2/3/38 being called with G10/28/30/92 on same block.
+          #ifdef ENABLE_SPINDLE_SYNC
+            case 33: case 76:
+          #endif
+          case 0: case 1: case 2: case 3: case 5: case 38: case 73: case 81: case 82: case 83:
+            // Check for G0/1/2/3/5/33/38/73/76/81-83 being called with G10/28/30/92 on same block.
             // * G43.1 is also an axis command but is not explicitly defined this way.
             if (axis_command) { FAIL(STATUS_GCODE_AXIS_COMMAND_CONFLICT); } // [Axis word/command conflict]
             axis_command = AXIS_COMMAND_MOTION_MODE;
@@ -175,6 +196,9 @@ uint8_t gc_execute_line(char *line, uint8_t client)
               }
               gc_block.modal.motion += (mantissa/10)+100;
               mantissa = 0; // Set to zero to indicate valid non-integer G command.
+            } else if ((int_value == 5) && (mantissa == 10)) {
+              gc_block.modal.motion = MOTION_MODE_QUADRATIC_SPLINE; // G5.1
+              mantissa = 0; // Set to zero to indicate valid non-integer G command.
             }
             break;
           case 17: case 18: case 19:
@@ -230,6 +254,10 @@ uint8_t gc_execute_line(char *line, uint8_t client)
             if (mantissa != 0) { FAIL(STATUS_GCODE_UNSUPPORTED_COMMAND); } // [G61.1 not supported]
             // gc_block.modal.control = CONTROL_MODE_EXACT_PATH; // G61
             break;
+          case 98: case 99:
+            word_bit = MODAL_GROUP_G10;
+            gc_block.modal.retract = int_value - 98;
+            break;
           default: FAIL(STATUS_GCODE_UNSUPPORTED_COMMAND); // [Unsupported G command]
         }
         if (mantissa > 0) { FAIL(STATUS_GCODE_COMMAND_VALUE_NOT_INTEGER); } // [Unsupported or invalid Gxx.x command]
@@ -280,6 +308,12 @@ uint8_t gc_execute_line(char *line, uint8_t client)
               gc_block.modal.override = OVERRIDE_PARKING_MOTION;
               break;
           #endif
+          #ifdef ENABLE_DIGITAL_OUTPUTS
+            case 62: case 63: case 64: case 65:
+              word_bit = MODAL_GROUP_M10;
+              digital_out_command = int_value;
+              break;
+          #endif
           // Avoid problems executing 3D printer's code
           // default: FAIL(STATUS_GCODE_UNSUPPORTED_COMMAND); // [Unsupported M command]
         }
@@ -303,15 +337,26 @@ uint8_t gc_execute_line(char *line, uint8_t client)
           // case 'D': word_bit = WORD_D; gc_block.values.xyz[D_AXIS] = value; axis_words |= (1<<D_AXIS); break;
           // case 'E': word_bit = WORD_E; gc_block.values.xyz[E_AXIS] = value; axis_words |= (1<<E_AXIS); break;
            case 'F': word_bit = WORD_F; gc_block.values.f = value; break;
-          // case 'H': // Not supported
+          #ifdef ENABLE_SPINDLE_SYNC
+            case 'H': word_bit = WORD_H;
+              if (value > MAX_H_VALUE) { FAIL(STATUS_GCODE_MAX_VALUE_EXCEEDED); } // [H wraps in uint8_t]
+              gc_block.values.h = int_value;
+              break;
+          #else
+            // case 'H': // Not supported
+          #endif
           case 'I': word_bit = WORD_I; gc_block.values.ijk[X_AXIS] = value; ijk_words |= (1<<X_AXIS); break;
           case 'J': word_bit = WORD_J; gc_block.values.ijk[Y_AXIS] = value; ijk_words |= (1<<Y_AXIS); break;
           case 'K': word_bit = WORD_K; gc_block.values.ijk[Z_AXIS] = value; ijk_words |= (1<<Z_AXIS); break;
-          case 'L': word_bit = WORD_L; gc_block.values.l = int_value; break;
+          case 'L': word_bit = WORD_L;
+            if (value < 0.0) { FAIL(STATUS_NEGATIVE_VALUE); } // [L is negative]
+            if (value > MAX_L_VALUE) { FAIL(STATUS_GCODE_MAX_VALUE_EXCEEDED); } // [L wraps in uint8_t]
+            gc_block.values.l = int_value;
+            break;
           case 'N': word_bit = WORD_N; gc_block.values.n = trunc(value); break;
           case 'P': word_bit = WORD_P; gc_block.values.p = value; break;
           // NOTE: For certain commands, P value must be an integer, but none of these commands are supported.
-          // case 'Q': // Not supported
+          case 'Q': word_bit = WORD_Q; gc_block.values.q = value; break;
           case 'R': word_bit = WORD_R; gc_block.values.r = value; break;
           case 'S': word_bit = WORD_S; gc_block.values.s = value; break;
           case 'T': word_bit = WORD_T;
@@ -326,9 +371,10 @@ uint8_t gc_execute_line(char *line, uint8_t client)
 
         // NOTE: Variable 'word_bit' is always assigned, if the non-command letter is valid.
         if (bit_istrue(value_words,bit(word_bit))) { FAIL(STATUS_GCODE_WORD_REPEATED); } // [Word repeated]
-        // Check for invalid negative values for words F, N, P, T, and S.
-        // NOTE: Negative value check is done here simply for code-efficiency.
-        if ( bit(word_bit) & (bit(WORD_F)|bit(WORD_N)|bit(WORD_P)|bit(WORD_T)|bit(WORD_S)) ) {
+        // Check for invalid negative values for words F, H, N, T, and S.
+        // NOTE: Negative value check is done here simply for code-efficiency. P may be negative for
+        // G5, so it is checked by the commands that use it as a count, index or time.
+        if ( bit(word_bit) & (bit(WORD_F)|bit(WORD_H)|bit(WORD_N)|bit(WORD_T)|bit(WORD_S)) ) {
           if (value < 0.0) { FAIL(STATUS_NEGATIVE_VALUE); } // [Word value cannot be negative]
         }
         value_words |= bit(word_bit); // Flag to indicate parameter assigned.
@@ -441,15 +487,30 @@ uint8_t gc_execute_line(char *line, uint8_t client)
   #ifdef ENABLE_PARKING_OVERRIDE_CONTROL
     if (bit_istrue(command_words,bit(MODAL_GROUP_M9))) { // Already set as enabled in parser.
       if (bit_istrue(value_words,bit(WORD_P))) {
+        if (gc_block.values.p < 0.0) { FAIL(STATUS_NEGATIVE_VALUE); }
         if (gc_block.values.p == 0.0) { gc_block.modal.override = OVERRIDE_DISABLED; }
         bit_false(value_words,bit(WORD_P));
       }
     }
   #endif
 
-  // [10. Dwell ]: P value missing. P is negative (done.) NOTE: See below.
+  // [9a. Digital output control ]: Grbl-only. P value missing. P is not an integer or exceeds the
+  //   number of outputs. P is negative. NOTE: Like M56, consumes the P word in this block.
+  #ifdef ENABLE_DIGITAL_OUTPUTS
+    if (bit_istrue(command_words,bit(MODAL_GROUP_M10))) {
+      if (bit_isfalse(value_words,bit(WORD_P))) { FAIL(STATUS_GCODE_VALUE_WORD_MISSING); } // [P word missing]
+      if (gc_block.values.p < 0.0) { FAIL(STATUS_NEGATIVE_VALUE); }
+      if (gc_block.values.p != trunc(gc_block.values.p)) { FAIL(STATUS_GCODE_COMMAND_VALUE_NOT_INTEGER); }
+      if (gc_block.values.p >= N_DIGITAL_OUTPUTS) { FAIL(STATUS_GCODE_MAX_VALUE_EXCEEDED); } // [Output not defined]
+      digital_out_index = trunc(gc_block.values.p);
+      bit_false(value_words,bit(WORD_P));
+    }
+  #endif
+
+  // [10. Dwell ]: P value missing. P is negative. NOTE: See below.
   if (gc_block.non_modal_command == NON_MODAL_DWELL) {
     if (bit_isfalse(value_words,bit(WORD_P))) { FAIL(STATUS_GCODE_VALUE_WORD_MISSING); } // [P word missing]
+    if (gc_block.values.p < 0.0) { FAIL(STATUS_NEGATIVE_VALUE); }
     bit_false(value_words,bit(WORD_P));
   }
 
@@ -481,6 +542,7 @@ uint8_t gc_execute_line(char *line, uint8_t client)
       }
     }
   }
+  float canned_depth = gc_block.values.xyz[axis_linear]; // Canned cycle Z as programmed. See [20].
 
   // [13. Cutter radius compensation ]: G41/42 NOT SUPPORTED. Error, if enabled while G53 is active.
   // [G40 Errors]: G2/3 arc is programmed after a G40. The linear move after disabling is less than tool diameter.
@@ -499,10 +561,8 @@ uint8_t gc_execute_line(char *line, uint8_t client)
   }
 
   // [15. Coordinate system selection ]: *N/A. Error, if cutter radius comp is active.
-  // TODO: An EEPROM read of the coordinate data may require a buffer sync when the cycle
-  // is active. The read pauses the processor temporarily and may cause a rare crash. For
-  // future versions on processors with enough memory, all coordinate data should be stored
-  // in memory and written to EEPROM only when there is not a cycle active.
+  // NOTE: Coordinate data is read from the RAM copy of the EEPROM store and written to the
+  // EEPROM only when there is not a cycle active, so no buffer sync is needed.
   float block_coord_system[N_AXIS];
   memcpy(block_coord_system,gc_state.coord_system,sizeof(gc_state.coord_system));
   if ( bit_istrue(command_words,bit(MODAL_GROUP_G12)) ) { // Check if called in block
@@ -514,7 +574,7 @@ uint8_t gc_execute_line(char *line, uint8_t client)
 
   // [16. Set path control mode ]: N/A. Only G61. G61.1 and G64 NOT SUPPORTED.
   // [17. Set distance mode ]: N/A. Only G91.1. G90.1 NOT SUPPORTED.
-  // [18. Set retract mode ]: NOT SUPPORTED.
+  // [18. Set retract mode ]: N/A.
 
   // [19. Remaining non-modal actions ]: Check go to predefined position, set G10, or set axis offsets.
   // NOTE: We need to separate the non-modal commands that are axis word-using (G10/G28/G30/G92), as these
@@ -523,11 +583,12 @@ uint8_t gc_execute_line(char *line, uint8_t client)
   // all the current coordinate system and G92 offsets.
   switch (gc_block.non_modal_command) {
     case NON_MODAL_SET_COORDINATE_DATA:
-      // [G10 Errors]: L missing and is not 2 or 20. P word missing. (Negative P value done.)
+      // [G10 Errors]: L missing and is not 2 or 20. P word missing. Negative P value.
       // [G10 L2 Errors]: R word NOT SUPPORTED. P value not 0 to nCoordSys(max 9). Axis words missing.
       // [G10 L20 Errors]: P must be 0 to nCoordSys(max 9). Axis words missing.
       if (!axis_words) { FAIL(STATUS_GCODE_NO_AXIS_WORDS) }; // [No axis words]
       if (bit_isfalse(value_words,((1<<WORD_P)|(1<<WORD_L)))) { FAIL(STATUS_GCODE_VALUE_WORD_MISSING); } // [P/L word missing]
+      if (gc_block.values.p < 0.0) { FAIL(STATUS_NEGATIVE_VALUE); }
       coord_select = trunc(gc_block.values.p); // Convert p value to int.
       if (coord_select > N_COORDINATE_SYSTEM) { FAIL(STATUS_GCODE_UNSUPPORTED_COORD_SYS); } // [Greater than N sys]
       if (gc_block.values.l != 20) {
@@ -662,8 +723,10 @@ uint8_t gc_execute_line(char *line, uint8_t client)
     // All remaining motion modes (all but G0 and G80), require a valid feed rate value. In units per mm mode,
     // the value must be positive. In inverse time mode, a positive value must be passed with each block.
     } else {
-      // Check if feed rate is defined for the motion modes that require it.
-      if (gc_block.values.f == 0.0) { FAIL(STATUS_GCODE_UNDEFINED_FEED_RATE); } // [Feed rate undefined]
+      // Check if feed rate is defined for the motion modes that require it. Spindle-synchronized
+      // motions take their rate from the spindle speed.
+      if ((gc_block.values.f == 0.0) && (gc_block.modal.motion != MOTION_MODE_SPINDLE_SYNC) &&
+          (gc_block.modal.motion != MOTION_MODE_THREADING_CYCLE)) { FAIL(STATUS_GCODE_UNDEFINED_FEED_RATE); } // [Feed rate undefined]
 
       switch (gc_block.modal.motion) {
         case MOTION_MODE_LINEAR:
@@ -820,6 +883,138 @@ uint8_t gc_execute_line(char *line, uint8_t client)
           if (!axis_words) { FAIL(STATUS_GCODE_NO_AXIS_WORDS); } // [No axis words]
           if (isequal_position_vector(gc_state.position, gc_block.values.xyz)) { FAIL(STATUS_GCODE_INVALID_TARGET); } // [Invalid target]
           break;
+        case MOTION_MODE_CUBIC_SPLINE: case MOTION_MODE_QUADRATIC_SPLINE:
+          // [G5/G5.1 Errors]: Feed rate undefined. Plane is not G17. Axis words other than X,Y. No axis words.
+          // [G5 Errors]: P or Q missing. Only one of I,J. I,J missing and the previous motion was not G5.
+          // [G5.1 Errors]: I and J missing or both zero.
+          // NOTE: Control points are converted to absolute work positions and stored in IJK (first)
+          //   and P,Q (second, G5 only) for mc_spline. G5.1 is converted to the equivalent cubic.
+          if (gc_block.modal.plane_select != PLANE_SELECT_XY) { FAIL(STATUS_GCODE_UNSUPPORTED_COMMAND); } // [Not G17]
+          if (!axis_words) { FAIL(STATUS_GCODE_NO_AXIS_WORDS); } // [No axis words]
+          if (axis_words & ~(bit(X_AXIS)|bit(Y_AXIS))) { FAIL(STATUS_GCODE_AXIS_WORDS_EXIST); } // [Only X,Y allowed]
+          if (ijk_words & bit(Z_AXIS)) { FAIL(STATUS_GCODE_UNUSED_WORDS); } // [K not used]
+          if (gc_block.modal.units == UNITS_MODE_INCHES) {
+            gc_block.values.ijk[X_AXIS] *= MM_PER_INCH;
+            gc_block.values.ijk[Y_AXIS] *= MM_PER_INCH;
+            gc_block.values.p *= MM_PER_INCH;
+            gc_block.values.q *= MM_PER_INCH;
+          }
+          if (gc_block.modal.motion == MOTION_MODE_CUBIC_SPLINE) {
+            if ((value_words & (bit(WORD_P)|bit(WORD_Q))) != (bit(WORD_P)|bit(WORD_Q))) { FAIL(STATUS_GCODE_VALUE_WORD_MISSING); } // [P,Q missing]
+            if (ijk_words == 0) {
+              if (gc_state.modal.motion != MOTION_MODE_CUBIC_SPLINE) { FAIL(STATUS_GCODE_VALUE_WORD_MISSING); } // [I,J missing]
+              gc_block.values.ijk[X_AXIS] = -gc_state.spline_pq[X_AXIS];
+              gc_block.values.ijk[Y_AXIS] = -gc_state.spline_pq[Y_AXIS];
+            } else if (ijk_words != (bit(X_AXIS)|bit(Y_AXIS))) { FAIL(STATUS_GCODE_VALUE_WORD_MISSING); } // [Only one of I,J]
+            bit_false(value_words,(bit(WORD_I)|bit(WORD_J)|bit(WORD_P)|bit(WORD_Q)));
+          } else {
+            if (gc_block.values.ijk[X_AXIS] == 0.0 && gc_block.values.ijk[Y_AXIS] == 0.0) { FAIL(STATUS_GCODE_NO_OFFSETS_IN_PLANE); } // [No control point]
+            bit_false(value_words,(bit(WORD_I)|bit(WORD_J)));
+          }
+          break;
+        case MOTION_MODE_DRILL: case MOTION_MODE_DRILL_DWELL:
+        case MOTION_MODE_PECK_DRILL: case MOTION_MODE_PECK_CHIP_BREAK:
+          {
+          // [G73/G81-83 Errors]: Feed rate undefined. G93 active. No axis words. Axis words other than the plane
+          //   axes and linear axis. R or Z (linear axis) missing and not kept from the last canned cycle. Z not
+          //   below R. L is zero. G73/G83: Q missing or not positive. G82: P is negative.
+          // NOTE: As in LinuxCNC, R, Z, Q and P are kept while canned cycles stay active. In G91, R is relative
+          //   to the start position and Z to the R level. The hole bottom replaces the linear axis target and
+          //   the R level is stored in IJK, which canned cycles do not use otherwise.
+          uint8_t canned_kept = ((gc_state.modal.motion == MOTION_MODE_PECK_CHIP_BREAK) ||
+              ((gc_state.modal.motion >= MOTION_MODE_DRILL) && (gc_state.modal.motion <= MOTION_MODE_PECK_DRILL)));
+          if (gc_block.modal.feed_rate == FEED_RATE_MODE_INVERSE_TIME) { FAIL(STATUS_GCODE_UNSUPPORTED_COMMAND); } // [G93 active]
+          if (!axis_words) { FAIL(STATUS_GCODE_NO_AXIS_WORDS); } // [No axis words]
+          if (axis_words & ~(bit(axis_0)|bit(axis_1)|bit(axis_linear))) { FAIL(STATUS_GCODE_AXIS_WORDS_EXIST); } // [Rotary axis words]
+          if (gc_block.modal.units == UNITS_MODE_INCHES) {
+            gc_block.values.r *= MM_PER_INCH;
+            gc_block.values.q *= MM_PER_INCH;
+          }
+          if (bit_isfalse(value_words,bit(WORD_R))) {
+            if (!canned_kept) { FAIL(STATUS_GCODE_VALUE_WORD_MISSING); } // [R missing]
+            gc_block.values.r = gc_state.canned_r;
+          }
+          if (bit_isfalse(axis_words,bit(axis_linear))) {
+            if (!canned_kept) { FAIL(STATUS_GCODE_VALUE_WORD_MISSING); } // [Z missing]
+            canned_depth = gc_state.canned_z;
+          }
+          if (bit_isfalse(value_words,bit(WORD_Q)) && canned_kept) { gc_block.values.q = gc_state.canned_q; }
+          if (bit_isfalse(value_words,bit(WORD_P)) && canned_kept) { gc_block.values.p = gc_state.canned_p; }
+          if (bit_isfalse(value_words,bit(WORD_L))) { gc_block.values.l = 1; }
+          if (gc_block.values.l == 0) { FAIL(STATUS_NEGATIVE_VALUE); } // [L is not positive]
+
+          if ((gc_block.modal.motion == MOTION_MODE_PECK_DRILL) || (gc_block.modal.motion == MOTION_MODE_PECK_CHIP_BREAK)) {
+            if (bit_isfalse(value_words,bit(WORD_Q)) && !canned_kept) { FAIL(STATUS_GCODE_VALUE_WORD_MISSING); } // [Q missing]
+            if (gc_block.values.q <= 0.0) { FAIL(STATUS_NEGATIVE_VALUE); } // [Q not positive]
+            bit_false(value_words,bit(WORD_Q));
+          } else if (gc_block.modal.motion == MOTION_MODE_DRILL_DWELL) {
+            if (gc_block.values.p < 0.0) { FAIL(STATUS_NEGATIVE_VALUE); }
+            bit_false(value_words,bit(WORD_P));
+          }
+
+          float r_level;
+          if (gc_block.modal.distance == DISTANCE_MODE_ABSOLUTE) {
+            float level_offset = block_coord_system[axis_linear] + gc_state.coord_offset[axis_linear];
+            if (axis_linear == TOOL_LENGTH_OFFSET_AXIS) { level_offset += gc_state.tool_length_offset; }
+            r_level = gc_block.values.r + level_offset;
+            gc_block.values.xyz[axis_linear] = canned_depth + level_offset;
+          } else {
+            r_level = gc_state.position[axis_linear] + gc_block.values.r;
+            gc_block.values.xyz[axis_linear] = r_level + canned_depth;
+          }
+          if (gc_block.values.xyz[axis_linear] >= r_level) { FAIL(STATUS_GCODE_INVALID_TARGET); } // [Z not below R]
+          gc_block.values.ijk[axis_linear] = r_level;
+          bit_false(value_words,(bit(WORD_R)|bit(WORD_L)));
+          }
+          break;
+        #ifdef ENABLE_SPINDLE_SYNC
+          case MOTION_MODE_SPINDLE_SYNC:
+            // [G33 Errors]: G93 active. No axis words. K missing or not positive. Spindle off.
+            // NOTE: K is the travel per spindle revolution along the motion. The feed rate is set from
+            //   the spindle speed measured when the motion starts, so F is not used.
+            if (gc_block.modal.feed_rate == FEED_RATE_MODE_INVERSE_TIME) { FAIL(STATUS_GCODE_UNSUPPORTED_COMMAND); } // [G93 active]
+            if (!axis_words) { FAIL(STATUS_GCODE_NO_AXIS_WORDS); } // [No axis words]
+            if (bit_isfalse(value_words,bit(WORD_K))) { FAIL(STATUS_GCODE_VALUE_WORD_MISSING); } // [K missing]
+            if (gc_block.values.ijk[Z_AXIS] <= 0.0) { FAIL(STATUS_NEGATIVE_VALUE); } // [K not positive]
+            if (gc_block.modal.spindle == SPINDLE_DISABLE) { FAIL(STATUS_GCODE_SPINDLE_NOT_ON); } // [Spindle off]
+            if (gc_block.modal.units == UNITS_MODE_INCHES) { gc_block.values.ijk[Z_AXIS] *= MM_PER_INCH; }
+            bit_false(value_words,bit(WORD_K));
+            break;
+          case MOTION_MODE_THREADING_CYCLE:
+            {
+            // [G76 Errors]: G93 active. Z missing or at the current position. Axis words other than Z.
+            //   P, I, J or K missing. P, J or K not positive. I zero. R below 1. Q not 0 to 60 degrees.
+            //   More than THREADING_CYCLE_MAX_PASSES passes. Spindle off.
+            // NOTE: As in LinuxCNC, the drive line is the current X, from the current Z to the Z word.
+            //   P is the pitch, I the offset of the thread peak from the drive line (negative for
+            //   external threads), J the depth of the first pass and K the full thread depth. Pass n
+            //   cuts J*n^(1/R) deep, up to K, and is followed by H spring passes at full depth. Q is
+            //   the compound infeed angle. Tapers (E and L) are not supported.
+            if (gc_block.modal.feed_rate == FEED_RATE_MODE_INVERSE_TIME) { FAIL(STATUS_GCODE_UNSUPPORTED_COMMAND); } // [G93 active]
+            if (bit_isfalse(axis_words,bit(Z_AXIS))) { FAIL(STATUS_GCODE_NO_AXIS_WORDS); } // [Z missing]
+            if (axis_words & ~bit(Z_AXIS)) { FAIL(STATUS_GCODE_AXIS_WORDS_EXIST); } // [Axis words other than Z]
+            if (gc_block.values.xyz[Z_AXIS] == gc_state.position[Z_AXIS]) { FAIL(STATUS_GCODE_INVALID_TARGET); } // [No thread length]
+            uint32_t thread_words = (bit(WORD_P)|bit(WORD_I)|bit(WORD_J)|bit(WORD_K));
+            if ((value_words & thread_words) != thread_words) { FAIL(STATUS_GCODE_VALUE_WORD_MISSING); } // [P, I, J or K missing]
+            if ((gc_block.values.p <= 0.0) || (gc_block.values.ijk[Y_AXIS] <= 0.0) || (gc_block.values.ijk[Z_AXIS] <= 0.0)) {
+              FAIL(STATUS_NEGATIVE_VALUE); // [P, J or K not positive]
+            }
+            if (gc_block.values.ijk[X_AXIS] == 0.0) { FAIL(STATUS_GCODE_INVALID_TARGET); } // [I zero]
+            if (bit_isfalse(value_words,bit(WORD_R))) { gc_block.values.r = 1.0; }
+            if (gc_block.values.r < 1.0) { FAIL(STATUS_BAD_NUMBER_FORMAT); } // [R below 1]
+            if ((gc_block.values.q < 0.0) || (gc_block.values.q > 60.0)) { FAIL(STATUS_BAD_NUMBER_FORMAT); } // [Q not 0 to 60]
+            if (ceil(pow(gc_block.values.ijk[Z_AXIS]/gc_block.values.ijk[Y_AXIS], gc_block.values.r)) > THREADING_CYCLE_MAX_PASSES) {
+              FAIL(STATUS_GCODE_MAX_VALUE_EXCEEDED); // [Too many passes]
+            }
+            if (gc_block.modal.spindle == SPINDLE_DISABLE) { FAIL(STATUS_GCODE_SPINDLE_NOT_ON); } // [Spindle off]
+            if (gc_block.modal.units == UNITS_MODE_INCHES) {
+              gc_block.values.p *= MM_PER_INCH;
+              for (idx=0; idx<N_AXIS; idx++) { gc_block.values.ijk[idx] *= MM_PER_INCH; }
+            }
+            bit_false(value_words,(thread_words|bit(WORD_R)|bit(WORD_Q)|bit(WORD_H)));
+            }
+            break;
+        #endif
       }
     }
   }
@@ -916,16 +1111,21 @@ uint8_t gc_execute_line(char *line, uint8_t client)
   pl_data->feed_rate = gc_state.feed_rate; // Record data for planner use.
 
   // [4. Set spindle speed ]:
+  // NOTE: A buffer sync is skipped when it cannot change the spindle output: when the spindle state
+  // also changes in this block, [7] applies the new speed in its own single sync. Without a variable
+  // spindle, the speed has no output at all and is only tracked.
   if ((gc_state.spindle_speed != gc_block.values.s) || bit_istrue(gc_parser_flags,GC_PARSER_LASER_FORCE_SYNC)) {
     if (gc_state.modal.spindle != SPINDLE_DISABLE) {
       #ifdef VARIABLE_SPINDLE
-        if (bit_isfalse(gc_parser_flags,GC_PARSER_LASER_ISMOTION)) {
+        if (gc_state.modal.spindle != gc_block.modal.spindle) {
+          gc_sync_elided++;
+        } else if (bit_isfalse(gc_parser_flags,GC_PARSER_LASER_ISMOTION)) {
           if (bit_istrue(gc_parser_flags,GC_PARSER_LASER_DISABLE)) {
              spindle_sync(gc_state.modal.spindle, 0.0);
           } else { spindle_sync(gc_state.modal.spindle, gc_block.values.s); }
         }
       #else
-        spindle_sync(gc_state.modal.spindle, 0.0);
+        gc_sync_elided++;
       #endif
     }
     gc_state.spindle_speed = gc_block.values.s; // Update spindle speed state.
@@ -947,6 +1147,8 @@ uint8_t gc_execute_line(char *line, uint8_t client)
     // rather than gc_state, is used to manage laser state for non-laser motions.
     spindle_sync(gc_block.modal.spindle, pl_data->spindle_speed);
     gc_state.modal.spindle = gc_block.modal.spindle;
+  } else if (bit_istrue(command_words,bit(MODAL_GROUP_M7))) {
+    gc_sync_elided++; // Repeated M3/M4/M5. Spindle already in the requested state.
   }
   pl_data->condition |= gc_state.modal.spindle; // Set condition flag for planner use.
 
@@ -956,6 +1158,8 @@ uint8_t gc_execute_line(char *line, uint8_t client)
     // can exist at the same time, while coolant disable clears all states.
     coolant_sync(gc_block.modal.coolant);
     gc_state.modal.coolant = gc_block.modal.coolant;
+  } else if (bit_istrue(command_words,bit(MODAL_GROUP_M8))) {
+    gc_sync_elided++; // Repeated M7/M8/M9. Coolant already in the requested state.
   }
   pl_data->condition |= gc_state.modal.coolant; // Set condition flag for planner use.
 
@@ -967,6 +1171,32 @@ uint8_t gc_execute_line(char *line, uint8_t client)
     }
   #endif
 
+  // [9a. Digital output control ]: M62/M63 are recorded in the planner data and switch at the first
+  // step of the next motion block. Blocks carry only the outputs set or cleared by M62/M63, so the
+  // state of the others is never written. M64/M65 switch now, without waiting on the planner buffer,
+  // and win over any M62/M63 on the same output parsed before them.
+  #ifdef ENABLE_DIGITAL_OUTPUTS
+    switch (digital_out_command) {
+      case DIGITAL_OUTPUT_SYNC_ON:
+        gc_state.digital_out_set |= bit(digital_out_index);
+        gc_state.digital_out_clear &= ~bit(digital_out_index);
+        break;
+      case DIGITAL_OUTPUT_SYNC_OFF:
+        gc_state.digital_out_set &= ~bit(digital_out_index);
+        gc_state.digital_out_clear |= bit(digital_out_index);
+        break;
+      case DIGITAL_OUTPUT_IMMEDIATE_ON: case DIGITAL_OUTPUT_IMMEDIATE_OFF:
+        gc_state.digital_out_set &= ~bit(digital_out_index);
+        gc_state.digital_out_clear &= ~bit(digital_out_index);
+        digital_output_set_immediate(digital_out_index, (digital_out_command == DIGITAL_OUTPUT_IMMEDIATE_ON));
+        break;
+    }
+    // Record data for planner use.
+    pl_data->digital_out_set = gc_state.digital_out_set;
+    pl_data->digital_out_clear = gc_state.digital_out_clear;
+    pl_data->digital_out_epoch = digital_output_get_epoch();
+  #endif
+
   // [10. Dwell ]:
   if (gc_block.non_modal_command == NON_MODAL_DWELL) { mc_dwell(gc_block.values.p); }
 
@@ -1007,7 +1237,8 @@ uint8_t gc_execute_line(char *line, uint8_t client)
   // [17. Set distance mode ]:
   gc_state.modal.distance = gc_block.modal.distance;
 
-  // [18. Set retract mode ]: NOT SUPPORTED
+  // [18. Set retract mode ]:
+  gc_state.modal.retract = gc_block.modal.retract;
 
 
   // [19. Перейдите в заданную позицию, установите G10 или задайте смещения осей]:
@@ -1016,8 +1247,8 @@ uint8_t gc_execute_line(char *line, uint8_t client)
      // Используется для установки смещений инструмента и управления системами координат
      // Эта команда позволяет программисту определять такие параметры, как значения коррекции инструмента или опорные точки для систем координат заготовки.
     case NON_MODAL_SET_COORDINATE_DATA:
-      // Нужно ли эти данные записывать? Возможно это может привести к быстрому истиранию памяти. Временно закомментировал.
-      //settings_write_coord_data(coord_select,gc_block.values.ijk);
+      // Журнал настроек распределяет записи по всем страницам EEPROM и пишет только изменённые слова.
+      settings_write_coord_data(coord_select,gc_block.values.ijk);
       // Update system coordinate system if currently active.
       if (gc_state.modal.coord_select == coord_select) {
         memcpy(gc_state.coord_system,gc_block.values.ijk,N_AXIS*sizeof(float));
@@ -1066,6 +1297,58 @@ uint8_t gc_execute_line(char *line, uint8_t client)
       } else if ((gc_state.modal.motion == MOTION_MODE_CW_ARC) || (gc_state.modal.motion == MOTION_MODE_CCW_ARC)) {
         mc_arc(gc_block.values.xyz, pl_data, gc_state.position, gc_block.values.ijk, gc_block.values.r,
             axis_0, axis_1, axis_linear, bit_istrue(gc_parser_flags,GC_PARSER_ARC_IS_CLOCKWISE));
+      } else if ((gc_state.modal.motion == MOTION_MODE_CUBIC_SPLINE) || (gc_state.modal.motion == MOTION_MODE_QUADRATIC_SPLINE)) {
+        // Control points relative to the current (first) and target (second) positions.
+        float control_1[2], control_2[2];
+        control_1[X_AXIS] = gc_state.position[X_AXIS] + gc_block.values.ijk[X_AXIS];
+        control_1[Y_AXIS] = gc_state.position[Y_AXIS] + gc_block.values.ijk[Y_AXIS];
+        if (gc_state.modal.motion == MOTION_MODE_CUBIC_SPLINE) {
+          control_2[X_AXIS] = gc_block.values.xyz[X_AXIS] + gc_block.values.p;
+          control_2[Y_AXIS] = gc_block.values.xyz[Y_AXIS] + gc_block.values.q;
+          gc_state.spline_pq[X_AXIS] = gc_block.values.p;
+          gc_state.spline_pq[Y_AXIS] = gc_block.values.q;
+        } else {
+          // Degree elevation of the quadratic: cubic control points 2/3 of the way to its control point.
+          control_2[X_AXIS] = gc_block.values.xyz[X_AXIS] + (2.0/3.0)*(control_1[X_AXIS]-gc_block.values.xyz[X_AXIS]);
+          control_2[Y_AXIS] = gc_block.values.xyz[Y_AXIS] + (2.0/3.0)*(control_1[Y_AXIS]-gc_block.values.xyz[Y_AXIS]);
+          control_1[X_AXIS] = gc_state.position[X_AXIS] + (2.0/3.0)*gc_block.values.ijk[X_AXIS];
+          control_1[Y_AXIS] = gc_state.position[Y_AXIS] + (2.0/3.0)*gc_block.values.ijk[Y_AXIS];
+        }
+        mc_spline(gc_block.values.xyz, pl_data, gc_state.position, control_1, control_2);
+      } else if ((gc_state.modal.motion == MOTION_MODE_PECK_CHIP_BREAK) ||
+          ((gc_state.modal.motion >= MOTION_MODE_DRILL) && (gc_state.modal.motion <= MOTION_MODE_PECK_DRILL))) {
+        // Canned cycle. Keep R, Z, Q and P for the following blocks.
+        gc_state.canned_r = gc_block.values.r;
+        gc_state.canned_z = canned_depth;
+        gc_state.canned_q = gc_block.values.q;
+        gc_state.canned_p = gc_block.values.p;
+        float r_level = gc_block.values.ijk[axis_linear];
+        float clear_level = r_level; // G99
+        if (gc_state.modal.retract == RETRACT_MODE_OLD_Z) { clear_level = max(gc_state.position[axis_linear], r_level); }
+        // L repeats drill the same hole in G90, or step by the programmed plane increment in G91.
+        float step_0 = gc_block.values.xyz[axis_0] - gc_state.position[axis_0];
+        float step_1 = gc_block.values.xyz[axis_1] - gc_state.position[axis_1];
+        uint8_t repeat = gc_block.values.l;
+        while (1) {
+          mc_canned_cycle(gc_block.values.xyz, pl_data, gc_state.position, r_level, clear_level,
+              gc_block.values.q, gc_block.values.p, axis_linear, gc_state.modal.motion);
+          if ((--repeat == 0) || sys.abort) { break; }
+          if (gc_block.modal.distance == DISTANCE_MODE_INCREMENTAL) {
+            gc_block.values.xyz[axis_0] += step_0;
+            gc_block.values.xyz[axis_1] += step_1;
+          }
+        }
+        gc_update_pos = GC_UPDATE_POS_NONE; // Updated by mc_canned_cycle() to the last hole at the return level.
+      #ifdef ENABLE_SPINDLE_SYNC
+        } else if (gc_state.modal.motion == MOTION_MODE_SPINDLE_SYNC) {
+          pl_data->feed_per_rev = gc_block.values.ijk[Z_AXIS];
+          mc_thread(gc_block.values.xyz, pl_data);
+        } else if (gc_state.modal.motion == MOTION_MODE_THREADING_CYCLE) {
+          mc_threading_cycle(gc_block.values.xyz[Z_AXIS], pl_data, gc_state.position, gc_block.values.p,
+              gc_block.values.ijk[X_AXIS], gc_block.values.ijk[Y_AXIS], gc_block.values.ijk[Z_AXIS],
+              gc_block.values.r, gc_block.values.q, gc_block.values.h);
+          gc_update_pos = GC_UPDATE_POS_NONE; // Ends back at the start, where the position still is.
+      #endif
       } else {
         // NOTE: gc_block.values.xyz is returned from mc_probe_cycle with the updated position value. So
         // upon a successful probing cycle, the machine position and the returned value should be the same.
@@ -1145,7 +1428,7 @@ uint8_t gc_execute_line(char *line, uint8_t client)
 /*
   Not supported:
 
-  - Canned cycles
+  - Canned cycles other than G73, G81, G82 and G83
   - Tool radius compensation
   - A,B,C-axes
   - Evaluation of expressions
@@ -1156,13 +1439,12 @@ uint8_t gc_execute_line(char *line, uint8_t client)
 
    (*) Indicates optional parameter, enabled through config.h and re-compile
    group 0 = {G92.2, G92.3} (Non modal: Cancel and re-enable G92 offsets)
-   group 1 = {G81 - G89} (Motion modes: Canned cycles)
+   group 1 = {G84 - G89} (Motion modes: Canned cycles)
    group 4 = {M1} (Optional stop, ignored)
    group 6 = {M6} (Tool change)
    group 7 = {G41, G42} cutter radius compensation (G40 is supported)
    group 8 = {G43} tool length offset (G43.1/G49 are supported)
    group 8 = {M7*} enable mist coolant (* Compile-option)
    group 9 = {M48, M49, M56*} enable/disable override switches (* Compile-option)
-   group 10 = {G98, G99} return mode canned cycles
    group 13 = {G61.1, G64} path control mode (G61 is supported)
 */
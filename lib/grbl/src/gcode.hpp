@@ -30,7 +30,7 @@
 // and are similar/identical to other g-code interpreters by manufacturers (Haas,Fanuc,Mazak,etc).
 // NOTE: Modal group define values must be sequential and starting from zero.
 #define MODAL_GROUP_G0 0 // [G4,G10,G28,G28.1,G30,G30.1,G53,G92,G92.1] Non-modal
-#define MODAL_GROUP_G1 1 // [G0,G1,G2,G3,G38.2,G38.3,G38.4,G38.5,G80] Motion
+#define MODAL_GROUP_G1 1 // [G0,G1,G2,G3,G5,G5.1,G38.2,G38.3,G38.4,G38.5,G73,G80,G81,G82,G83] Motion
 #define MODAL_GROUP_G2 2 // [G17,G18,G19] Plane selection
 #define MODAL_GROUP_G3 3 // [G90,G91] Distance mode
 #define MODAL_GROUP_G4 4 // [G91.1] Arc IJK distance mode
@@ -45,6 +45,8 @@
 #define MODAL_GROUP_M7 12 // [M3,M4,M5] Spindle turning
 #define MODAL_GROUP_M8 13 // [M7,M8,M9] Coolant control
 #define MODAL_GROUP_M9 14 // [M56] Override control
+#define MODAL_GROUP_M10 15 // [M62,M63,M64,M65] Digital output control
+#define MODAL_GROUP_G10 16 // [G98,G99] Canned cycle return mode
 
 // Определение командных действий для внутримодальных групп типов выполнения (движение, остановка, немодальные). Используется
 // внутренним парсером для определения того, какую команду нужно выполнить. 
@@ -70,11 +72,19 @@
 #define MOTION_MODE_LINEAR 1 // G1 (Do not alter value)
 #define MOTION_MODE_CW_ARC 2  // G2 (Do not alter value)
 #define MOTION_MODE_CCW_ARC 3  // G3 (Do not alter value)
+#define MOTION_MODE_CUBIC_SPLINE 5 // G5 (Do not alter value)
+#define MOTION_MODE_QUADRATIC_SPLINE 106 // G5.1 (Do not alter value)
 #define MOTION_MODE_PROBE_TOWARD 140 // G38.2 (Do not alter value)
 #define MOTION_MODE_PROBE_TOWARD_NO_ERROR 141 // G38.3 (Do not alter value)
 #define MOTION_MODE_PROBE_AWAY 142 // G38.4 (Do not alter value)
 #define MOTION_MODE_PROBE_AWAY_NO_ERROR 143 // G38.5 (Do not alter value)
 #define MOTION_MODE_NONE 80 // G80 (Do not alter value)
+#define MOTION_MODE_PECK_CHIP_BREAK 73 // G73 (Do not alter value)
+#define MOTION_MODE_DRILL 81 // G81 (Do not alter value)
+#define MOTION_MODE_DRILL_DWELL 82 // G82 (Do not alter value)
+#define MOTION_MODE_PECK_DRILL 83 // G83 (Do not alter value)
+#define MOTION_MODE_SPINDLE_SYNC 33 // G33 (Do not alter value)
+#define MOTION_MODE_THREADING_CYCLE 76 // G76 (Do not alter value)
 
 // Modal Group G2: Plane select
 #define PLANE_SELECT_XY 0 // G17 (Default: Must be zero)
@@ -95,6 +105,10 @@
 #define PROGRAM_FLOW_COMPLETED_M2  2 // M2 (Do not alter value)
 #define PROGRAM_FLOW_COMPLETED_M30 30 // M30 (Do not alter value)
 
+// Modal Group G10: Canned cycle return mode
+#define RETRACT_MODE_OLD_Z 0 // G98 (Default: Must be zero)
+#define RETRACT_MODE_R 1 // G99 (Do not alter value)
+
 // Modal Group G5: Feed rate mode
 #define FEED_RATE_MODE_UNITS_PER_MIN  0 // G94 (Default: Must be zero)
 #define FEED_RATE_MODE_INVERSE_TIME   1 // G93 (Do not alter value)
@@ -132,6 +146,13 @@
   #define OVERRIDE_DISABLED  1 // Parking disabled.
 #endif
 
+// Modal Group M10: Digital output control. Non-modal, executed once per block.
+#define DIGITAL_OUTPUT_NO_ACTION 0 // (Default: Must be zero)
+#define DIGITAL_OUTPUT_SYNC_ON 62 // M62 (Do not alter value)
+#define DIGITAL_OUTPUT_SYNC_OFF 63 // M63 (Do not alter value)
+#define DIGITAL_OUTPUT_IMMEDIATE_ON 64 // M64 (Do not alter value)
+#define DIGITAL_OUTPUT_IMMEDIATE_OFF 65 // M65 (Do not alter value)
+
 // Modal Group G12: Active work coordinate system
 // N/A: Stores coordinate system value (54-59) to change to.
 
@@ -154,6 +175,8 @@
 #define WORD_C  15
 #define WORD_D  16
 #define WORD_E  17
+#define WORD_Q  18
+#define WORD_H  19
 
 // Define g-code parser position updating flags
 #define GC_UPDATE_POS_TARGET   0 // Must be zero
@@ -185,12 +208,13 @@
 
 // NOTE: When this struct is zeroed, the above defines set the defaults for the system.
 typedef struct {
-  uint8_t motion;          // {G0,G1,G2,G3,G38.2,G80}
+  uint8_t motion;          // {G0,G1,G2,G3,G5,G5.1,G33,G38.2,G73,G76,G80,G81,G82,G83}
   uint8_t feed_rate;       // {G93,G94}
   uint8_t units;           // {G20,G21}
   uint8_t distance;        // {G90,G91}
   // uint8_t distance_arc; // {G91.1} NOTE: Don't track. Only default supported.
   uint8_t plane_select;    // {G17,G18,G19}
+  uint8_t retract;         // {G98,G99}
   // uint8_t cutter_comp;  // {G40} NOTE: Don't track. Only default supported.
   uint8_t tool_length;     // {G43.1,G49}
   uint8_t coord_select;    // {G54,G55,G56,G57,G58,G59}
@@ -203,12 +227,13 @@ typedef struct {
 
 typedef struct {
   float f;         // Feed
+  uint8_t h;       // G76 spring passes
   float ijk[N_AXIS];    // I,J,K... Axis arc offsets
   uint8_t l;       // G10 or canned cycles parameters
   int32_t n;       // Line number
   float p;         // G10 or dwell parameters
-  // float q;      // G82 peck drilling
-  float r;         // Arc radius
+  float q;         // G5 spline second control point or canned cycle peck depth
+  float r;         // Arc radius or canned cycle R level
   float s;         // Spindle speed
   uint8_t t;       // Tool selection
   float xyz[N_AXIS];    // X,Y,Z... Translational axes
@@ -230,9 +255,23 @@ typedef struct {
   float coord_offset[N_AXIS];    // Retains the G92 coordinate offset (work coordinates) relative to
                                  // machine zero in mm. Non-persistent. Cleared upon reset and boot.
   float tool_length_offset;      // Tracks tool length offset value when enabled.
+  float spline_pq[2];            // P,Q of the last G5. Default I,J of a following G5 are -P,-Q.
+  float canned_r;                // R, Z (linear axis), Q and P of the last canned cycle. Used when
+  float canned_z;                // omitted while a canned cycle motion mode stays active. In mm,
+  float canned_q;                // as programmed, so incremental values stay incremental.
+  float canned_p;
+
+  #ifdef ENABLE_DIGITAL_OUTPUTS
+    uint8_t digital_out_set;     // Outputs whose last command was M62 (set) or M63 (clear). An M64/M65
+    uint8_t digital_out_clear;   // removes its output from both. Bitmasks.
+  #endif
 } parser_state_t;
 extern parser_state_t gc_state;
 
+// Count of spindle and coolant buffer syncs the parser skipped because they would not change any
+// output (repeated M3/M8 words, speed changes merged into a spindle state change). Shown by $I.
+extern uint16_t gc_sync_elided;
+
 
 typedef struct {
   uint8_t non_modal_command;
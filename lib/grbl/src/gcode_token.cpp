@@ -0,0 +1,98 @@
+/*
+  gcode_token.c - tokenized g-code word decoder
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "grbl.hpp"
+
+#ifdef ENABLE_GCODE_TOKENS
+
+static const char gc_token_axis_letter[N_AXIS] = { 'X', 'Y', 'Z', 'A' };
+static const int32_t gc_token_scale[GC_TOKEN_DECIMALS_MAX+1] = { 10000, 1000, 100, 10, 1 };
+
+// Last tokenized value of each axis in 1e-4 units. The reference for delta words.
+static int32_t gc_token_ref[N_AXIS];
+static uint8_t gc_token_ref_valid; // Bit per axis. Set by an absolute word, cleared by gc_token_reset().
+
+
+void gc_token_reset()
+{
+  memset(gc_token_ref, 0, sizeof(gc_token_ref));
+  gc_token_ref_valid = 0;
+}
+
+
+uint8_t gc_token_read_word(char *line, uint8_t *char_counter, char *letter, float *float_ptr)
+{
+  uint8_t *ptr = (uint8_t *)line + *char_counter;
+  uint8_t token = *ptr++;
+  uint8_t idx;
+
+  uint8_t axis = N_AXIS;
+  uint8_t decimals = 0;
+  if (token >= GC_TOKEN_DELTA) {
+    axis = (token - GC_TOKEN_DELTA) / (GC_TOKEN_DECIMALS_MAX+1);
+    decimals = (token - GC_TOKEN_DELTA) % (GC_TOKEN_DECIMALS_MAX+1);
+    if (axis >= N_AXIS) { return(false); }
+    *letter = gc_token_axis_letter[axis];
+  } else {
+    if (token >= GC_TOKEN_WORD + 26) { return(false); }
+    *letter = 'A' + (token - GC_TOKEN_WORD);
+    for (idx=0; idx<N_AXIS; idx++) {
+      if (gc_token_axis_letter[idx] == *letter) { axis = idx; }
+    }
+  }
+
+  uint32_t payload = 0;
+  uint8_t count = 0;
+  while ((*ptr & 0xC0) == GC_TOKEN_PAYLOAD) {
+    if (payload >> 26) { return(false); } // More than 32 bits.
+    payload = (payload << 6) | (*ptr++ & 0x3F);
+    count++;
+  }
+  if (!count) { return(false); }
+
+  if (token < GC_TOKEN_DELTA) {
+    decimals = payload & 0x07;
+    if (decimals > GC_TOKEN_DECIMALS_MAX) { return(false); }
+    payload >>= 3;
+  }
+  int64_t value = (int64_t)(payload >> 1);
+  if (payload & 1) { value = -value - 1; }
+
+  int32_t scale = gc_token_scale[decimals];
+  int64_t fixed = value * scale;
+  if (token >= GC_TOKEN_DELTA) {
+    // The encoder only sends a delta when the reference has no more decimals than the word.
+    if (bit_isfalse(gc_token_ref_valid, bit(axis))) { return(false); }
+    fixed += gc_token_ref[axis];
+    if (fixed % scale) { return(false); }
+    value = fixed / scale;
+  }
+  if ((value > GC_TOKEN_INTVAL_MAX) || (value < -GC_TOKEN_INTVAL_MAX)) { return(false); }
+  if ((fixed > INT32_MAX) || (fixed < INT32_MIN)) { return(false); }
+  if (axis < N_AXIS) {
+    gc_token_ref[axis] = fixed;
+    bit_true(gc_token_ref_valid, bit(axis));
+  }
+
+  float fval = decimal_to_float((value < 0) ? -value : value, -decimals);
+  *float_ptr = (value < 0) ? -fval : fval;
+  *char_counter = ptr - (uint8_t *)line;
+  return(true);
+}
+
+#endif
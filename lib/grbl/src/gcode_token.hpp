@@ -0,0 +1,56 @@
+/*
+  gcode_token.h - tokenized g-code word decoder
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef gcode_token_h
+#define gcode_token_h
+
+#include <stdint.h>
+
+// Tokenized g-code. A block may mix text words and tokenized words. A tokenized word is one token
+// byte followed by 1 to 6 payload bytes:
+//   0xC0+n        Word with letter 'A'+n. The payload is (zigzag(v) << 3) | d.
+//   0xE0+axis*5+d X, Y, Z or A word. The payload is zigzag(v), relative to the previous tokenized
+//                 value of that axis.
+//   0x80-0xBF     Payload, 6 bits per byte, most significant first. Ends at the first other byte.
+// The value is v*10^-d, where d (0-4) is the number of decimals written in the text word. The
+// decoder converts v and d to float exactly as read_float() converts the digits of the text word,
+// so both give the same parser_block_t.
+// All bytes are 0x80 or more, so tokenized blocks pass the serial line filter unchanged and never
+// contain '\n' or 0xFF, and can be stored in the job store. See doc/script/gcode_tokenize.py.
+// NOTE: Payload bytes overlap Grbl's extended real-time commands (0x84, 0x85, 0x90-0x9E, 0xA0, 0xA1).
+// Tokens only survive because no live receive path executes those in a line: the line-mode UART
+// interrupt in main.cpp passes every byte 0x80 and up into the line, and framed mode takes extended
+// real-time commands in 'R' frames only. serial_poll_rx() does execute them, so it must not be used
+// to receive tokenized g-code. Keep this in mind when adding real-time commands to either path.
+#define GC_TOKEN_PAYLOAD      0x80
+#define GC_TOKEN_WORD         0xC0
+#define GC_TOKEN_DELTA        0xE0 // Up to 0xF3.
+#define GC_TOKEN_DECIMALS_MAX 4
+#define GC_TOKEN_INTVAL_MAX   99999999 // Digits kept by read_float().
+
+// Reads the tokenized word at line[char_counter], returns its letter and value, and advances
+// char_counter past it. Returns false if the word is malformed or out of range.
+uint8_t gc_token_read_word(char *line, uint8_t *char_counter, char *letter, float *float_ptr);
+
+// Forgets the axis references, so a delta word fails until an absolute word of its axis. The host
+// advances its references on every block it sends, but Grbl only on the words it decodes, so they
+// are reset by gc_init() and after every rejected line. The host resets its own on any error, alarm
+// or reset, and on '$' lines, which may start or end a stored job that is tokenized on its own.
+void gc_token_reset();
+
+#endif
@@ -30,6 +30,7 @@
 #define LINE_FLAG_COMMENT_PARENTHESES bit(1)
 #define LINE_FLAG_COMMENT_SEMICOLON bit(2)
 #define LINE_FLAG_LINE_READ bit(3)
+#define LINE_FLAG_LINE_STARTED bit(4) // Часть следующей строки уже принята.
 
 extern "C" {
     #include "mik32_hal_pcc.h"
@@ -67,9 +68,13 @@ extern "C" {
 #include "cpu_map.hpp"
 #include "planner.hpp"
 #include "coolant_control.hpp"
+#include "digital_output.hpp"
 #include "eeprom.hpp"
 #include "gcode.hpp"
+#include "gcode_token.hpp"
 #include "limits.hpp"
+#include "arc_fixed.hpp"
+#include "step_count.hpp"
 #include "motion_control.hpp"
 #include "planner.hpp"
 #include "print.hpp"
@@ -77,6 +82,8 @@ extern "C" {
 #include "protocol.hpp"
 #include "report.hpp"
 #include "serial.hpp"
+#include "serial_frame.hpp"
+#include "raster.hpp"
 #ifdef ENABLE_WIFI
   #include "wifi.hpp"
   #ifdef ENABLE_WEBSOCKET
@@ -88,8 +95,10 @@ extern "C" {
   #endif
 #endif
 #include "spindle_control.hpp"
+#include "spindle_encoder.hpp"
 #include "stepper.hpp"
 #include "jog.hpp"
+#include "job_store.hpp"
 
 // ---------------------------------------------------------------------------------------
 // COMPILE-TIME ERROR CHECKING OF DEFINE VALUES:
@@ -122,6 +131,86 @@ extern "C" {
   #endif
 #endif
 
+#if defined(ENABLE_DIGITAL_OUTPUTS)
+  #if !defined(N_DIGITAL_OUTPUTS)
+    #error "ENABLE_DIGITAL_OUTPUTS requires digital output pins defined in cpu_map.h."
+  #endif
+  #if (N_DIGITAL_OUTPUTS != 4)
+    #error "N_DIGITAL_OUTPUTS must match the pin table in digital_output.c."
+  #endif
+#endif
+
+#if defined(ENABLE_SERIAL_FRAMING) && ((SERIAL_FRAME_WINDOW < 1) || (SERIAL_FRAME_WINDOW > 64))
+  #error "SERIAL_FRAME_WINDOW must be 1 to 64."
+#endif
+
+#if defined(ENABLE_ACK_BATCHING) && ((ACK_BATCH_MAX < 1) || (ACK_BATCH_MAX > 255))
+  #error "ACK_BATCH_MAX must be 1 to 255."
+#endif
+
+#if defined(ENABLE_AUTO_REPORT) && ((AUTO_REPORT_INTERVAL_MIN < 1) || (AUTO_REPORT_INTERVAL_MAX > 65535) || (AUTO_REPORT_INTERVAL_MIN > AUTO_REPORT_INTERVAL_MAX))
+  #error "AUTO_REPORT_INTERVAL_MIN and _MAX must be 1 to 65535 ms."
+#endif
+
+#if defined(ENABLE_DELTA_STATUS_REPORT) && ((REPORT_DELTA_KEYFRAME_COUNT < 1) || (REPORT_DELTA_KEYFRAME_COUNT > 255))
+  #error "REPORT_DELTA_KEYFRAME_COUNT must be 1 to 255."
+#endif
+
+#if defined(ENABLE_RASTER)
+  #if !defined(ENABLE_SERIAL_FRAMING) || !defined(VARIABLE_SPINDLE)
+    #error "ENABLE_RASTER requires ENABLE_SERIAL_FRAMING and VARIABLE_SPINDLE."
+  #endif
+  #if (RASTER_SCANLINE_SLOTS < 2) || (RASTER_SCANLINE_SLOTS > 16)
+    #error "RASTER_SCANLINE_SLOTS must be 2 to 16."
+  #endif
+#endif
+
+#if defined(ENABLE_SPINDLE_SYNC)
+  #if !defined(SPINDLE_ENCODER_TIMER)
+    #error "ENABLE_SPINDLE_SYNC requires a spindle encoder timer defined in cpu_map.h."
+  #endif
+  #if !defined(SPINDLE_ENCODER_SIMULATED) && !defined(SPINDLE_INDEX_LINE_IRQ)
+    #error "ENABLE_SPINDLE_SYNC requires a spindle index pin defined in cpu_map.h or SPINDLE_ENCODER_SIMULATED."
+  #endif
+#endif
+
+#if defined(SPINDLE_ENCODER_SIMULATED) && !defined(VARIABLE_SPINDLE)
+  #error "SPINDLE_ENCODER_SIMULATED requires VARIABLE_SPINDLE."
+#endif
+
+#if defined(ENABLE_JOB_STORE) && !defined(JOB_STORE_FLASH_SIZE)
+  #error "ENABLE_JOB_STORE requires a job store flash area defined in cpu_map.h."
+#endif
+
+#if defined(ELRON_ACE_UNO) && defined(VARIABLE_SPINDLE) && ((SPINDLE_PWM_BITS < 12) || (SPINDLE_PWM_BITS > 16))
+  #error "SPINDLE_PWM_BITS must be 12 to 16."
+#endif
+
+#if defined(ENABLE_SPINDLE_PWM_OUTPUT)
+  #if !defined(ELRON_ACE_UNO) || !defined(VARIABLE_SPINDLE)
+    #error "ENABLE_SPINDLE_PWM_OUTPUT requires ELRON_ACE_UNO and VARIABLE_SPINDLE."
+  #endif
+  #if !defined(DISABLE_Z_LIMIT_PIN)
+    #error "ENABLE_SPINDLE_PWM_OUTPUT drives the Z limit pin. Enable DISABLE_Z_LIMIT_PIN."
+  #endif
+#endif
+
+#if defined(DISABLE_Z_LIMIT_PIN)
+  #if ((HOMING_CYCLE_0) & (1<<Z_AXIS))
+    #error "DISABLE_Z_LIMIT_PIN requires Z removed from the homing cycles."
+  #endif
+  #if defined(HOMING_CYCLE_1)
+    #if ((HOMING_CYCLE_1) & (1<<Z_AXIS))
+      #error "DISABLE_Z_LIMIT_PIN requires Z removed from the homing cycles."
+    #endif
+  #endif
+  #if defined(HOMING_CYCLE_2)
+    #if ((HOMING_CYCLE_2) & (1<<Z_AXIS))
+      #error "DISABLE_Z_LIMIT_PIN requires Z removed from the homing cycles."
+    #endif
+  #endif
+#endif
+
 #if defined(SPINDLE_PWM_MIN_VALUE)
   #if !(SPINDLE_PWM_MIN_VALUE > 0)
     #error "SPINDLE_PWM_MIN_VALUE must be greater than zero."
@@ -0,0 +1,383 @@
+/*
+  job_store.c - on-board g-code job storage in SPIFI flash
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "grbl.hpp"
+
+#ifdef ENABLE_JOB_STORE
+
+#include <stddef.h>
+extern "C" {
+  #include <mik32_hal_spifi.h>
+}
+
+#define JOB_MAGIC 0x314A4F42 // "BOJ1"
+#define JOB_ERASED 0xFFFFFFFF
+#define JOB_FLASH_PAGE_SIZE 256
+#define JOB_FLASH_SECTOR_SIZE 4096
+#define JOB_READ_BLOCK_SIZE 128
+#define JOB_BLOCK_EMPTY 0xFFFFFFFF
+
+// SPIFI controller command register fields and flash opcodes (W25 series).
+#define JOB_SPIFI_CMD_OPCODE(x)    ((uint32_t)(x) << 24)
+#define JOB_SPIFI_CMD_FRAME_OPCODE (1UL << 21) // Opcode only.
+#define JOB_SPIFI_CMD_FRAME_ADDR3  (4UL << 21) // Opcode and 3 address bytes.
+#define JOB_SPIFI_CMD_DOUT         (1UL << 15)
+#define JOB_SPIFI_CMD_POLL         (1UL << 14) // Repeat until status bit DATALEN[2:0] equals DATALEN[3].
+#define JOB_SPIFI_STAT_CMD         (1UL << 1)
+#define JOB_SPIFI_STAT_RESET       (1UL << 4)
+#define JOB_FLASH_WRITE_ENABLE  0x06
+#define JOB_FLASH_READ_STATUS   0x05
+#define JOB_FLASH_PAGE_PROGRAM  0x02
+#define JOB_FLASH_SECTOR_ERASE  0x20
+
+// The firmware executes in place from the same flash, so anything that runs while the SPIFI is
+// out of memory mode must be in RAM, with interrupts off, since the ISRs are in flash too.
+#define JOB_RAM_FUNC __attribute__((section(".ram_text"), noinline))
+
+static uint8_t job_state;
+static uint32_t job_log_end;        // Offset of the first free page. Always erased.
+
+static uint32_t job_write_start;    // Header offset of the job being uploaded.
+static uint32_t job_write_pos;      // Offset of the next byte to store.
+static char job_write_name[JOB_NAME_LENGTH];
+static uint8_t job_page[JOB_FLASH_PAGE_SIZE] __attribute__((aligned(4))); // Page being filled.
+
+// Prefetching reader. The current block is read from, while job_store_prefetch() fills the other
+// one with the following block, so lines are copied from RAM when the main loop asks for them.
+static uint32_t job_read_pos;
+static uint32_t job_read_end;
+static uint8_t job_block[2][JOB_READ_BLOCK_SIZE];
+static uint32_t job_block_offset[2];
+static uint8_t job_block_current;
+
+
+static JOB_RAM_FUNC void job_spifi_command(uint32_t cmd, uint32_t address)
+{
+  SPIFI_CONFIG->ADDR = address;
+  SPIFI_CONFIG->CMD = cmd;
+  while (SPIFI_CONFIG->STAT & JOB_SPIFI_STAT_CMD) { }
+}
+
+
+// Runs one erase or program command with the SPIFI out of memory mode, and waits for the flash to
+// finish before going back to execute in place. data is NULL for an erase.
+static JOB_RAM_FUNC void job_spifi_write(uint8_t opcode, uint32_t address, const uint8_t *data, uint16_t length)
+{
+  uint32_t mstatus;
+  __asm__ volatile ("csrrci %0, mstatus, 8" : "=r"(mstatus)); // Disable interrupts.
+  uint32_t mcmd = SPIFI_CONFIG->MCMD;
+  SPIFI_CONFIG->STAT |= JOB_SPIFI_STAT_RESET; // Leave memory mode.
+  while (SPIFI_CONFIG->STAT & JOB_SPIFI_STAT_RESET) { }
+
+  job_spifi_command(JOB_SPIFI_CMD_OPCODE(JOB_FLASH_WRITE_ENABLE) | JOB_SPIFI_CMD_FRAME_OPCODE, 0);
+  SPIFI_CONFIG->ADDR = address;
+  SPIFI_CONFIG->CMD = JOB_SPIFI_CMD_OPCODE(opcode) | JOB_SPIFI_CMD_FRAME_ADDR3 | JOB_SPIFI_CMD_DOUT | length;
+  uint16_t i;
+  for (i=0; i<length; i++) { SPIFI_CONFIG->DATA8 = data[i]; }
+  while (SPIFI_CONFIG->STAT & JOB_SPIFI_STAT_CMD) { }
+
+  // Poll the busy bit (status bit 0) until it reads 0.
+  job_spifi_command(JOB_SPIFI_CMD_OPCODE(JOB_FLASH_READ_STATUS) | JOB_SPIFI_CMD_FRAME_OPCODE | JOB_SPIFI_CMD_POLL, 0);
+  (void)SPIFI_CONFIG->DATA8;
+
+  SPIFI_CONFIG->MCMD = mcmd; // Back to memory mode.
+  if (mstatus & 8) { __asm__ volatile ("csrsi mstatus, 8"); }
+}
+
+
+static void job_flash_read(uint32_t offset, void *data, uint16_t length)
+{
+  memcpy(data, (const uint8_t *)(JOB_STORE_MEMORY_BASE + JOB_STORE_FLASH_START + offset), length);
+}
+
+static void job_flash_program(uint32_t offset, const void *data, uint16_t length)
+{
+  job_spifi_write(JOB_FLASH_PAGE_PROGRAM, JOB_STORE_FLASH_START + offset, (const uint8_t *)data, length);
+}
+
+static void job_flash_erase_sector(uint32_t offset)
+{
+  job_spifi_write(JOB_FLASH_SECTOR_ERASE, JOB_STORE_FLASH_START + offset, NULL, 0);
+}
+
+static uint32_t job_page_align(uint32_t offset)
+{
+  return((offset + (JOB_FLASH_PAGE_SIZE-1)) & ~(uint32_t)(JOB_FLASH_PAGE_SIZE-1));
+}
+
+
+// Programs the page being filled. A sector is erased when its first page is written, except the
+// first page of a job, which is at the log end and already erased.
+static void job_flush_page(uint32_t page)
+{
+  if (((page % JOB_FLASH_SECTOR_SIZE) == 0) && (page != job_write_start)) { job_flash_erase_sector(page); }
+  job_flash_program(page, job_page, JOB_FLASH_PAGE_SIZE);
+  memset(job_page, 0xFF, JOB_FLASH_PAGE_SIZE);
+}
+
+
+// Moves the log end past a job, and erases the next sector if the log end starts one.
+static void job_set_log_end(uint32_t offset)
+{
+  job_log_end = job_page_align(offset);
+  if (((job_log_end % JOB_FLASH_SECTOR_SIZE) == 0) && (job_log_end < JOB_STORE_FLASH_SIZE)) {
+    job_flash_erase_sector(job_log_end);
+  }
+}
+
+
+// Returns the header offset of the live job with the given name, or JOB_ERASED if there is none.
+static uint32_t job_find(char *name)
+{
+  job_header_t header;
+  uint32_t offset = 0;
+  uint32_t found = JOB_ERASED;
+  while (offset < job_log_end) {
+    job_flash_read(offset, &header, sizeof(job_header_t));
+    if ((header.live == JOB_ERASED) && (strncmp(header.name, name, JOB_NAME_LENGTH) == 0)) { found = offset; }
+    offset = job_page_align(offset + sizeof(job_header_t) + header.length);
+  }
+  return(found);
+}
+
+
+void job_store_init()
+{
+  // Keep the job area out of the SPIFI cache, so reads after programming are never stale.
+  SPIFI_CONFIG->CLIMIT = JOB_STORE_MEMORY_BASE + JOB_STORE_FLASH_START;
+  memset(job_page, 0xFF, JOB_FLASH_PAGE_SIZE);
+
+  job_header_t header;
+  uint32_t offset = 0;
+  while (offset < JOB_STORE_FLASH_SIZE) {
+    job_flash_read(offset, &header, sizeof(job_header_t));
+    if (header.magic != JOB_MAGIC) { break; }
+    if (header.length == JOB_ERASED) {
+      // Upload cut off by a power loss. It is always the last job. Stored lines never contain 0xFF,
+      // so the first erased byte ends the data. Close the job as deleted, and erase past it.
+      uint32_t end = offset + sizeof(job_header_t);
+      uint8_t c = 0;
+      while (end < JOB_STORE_FLASH_SIZE) {
+        job_flash_read(end, &c, 1);
+        if (c == 0xFF) { break; }
+        end++;
+      }
+      uint32_t closed[2] = { end - offset - (uint32_t)sizeof(job_header_t), 0 };
+      job_flash_program(offset + 4, closed, sizeof(closed));
+      job_set_log_end(end);
+      job_state = JOB_STORE_IDLE;
+      return;
+    }
+    offset = job_page_align(offset + sizeof(job_header_t) + header.length);
+  }
+  job_log_end = offset;
+  job_state = JOB_STORE_IDLE;
+}
+
+
+uint8_t job_store_state() { return(job_state); }
+
+
+static uint8_t job_store_open(char *name)
+{
+  if (job_state != JOB_STORE_IDLE) { return(STATUS_JOB_STORE_BUSY); }
+  uint8_t len = strlen(name);
+  if ((len == 0) || (len >= JOB_NAME_LENGTH)) { return(STATUS_INVALID_STATEMENT); }
+  if (job_log_end + JOB_FLASH_PAGE_SIZE > JOB_STORE_FLASH_SIZE) { return(STATUS_JOB_STORE_FULL); }
+
+  job_header_t *header = (job_header_t *)job_page;
+  memset(job_page, 0xFF, JOB_FLASH_PAGE_SIZE);
+  header->magic = JOB_MAGIC;
+  memset(job_write_name, 0, JOB_NAME_LENGTH);
+  memcpy(job_write_name, name, len);
+  memcpy(header->name, job_write_name, JOB_NAME_LENGTH);
+  job_write_start = job_log_end;
+  job_write_pos = job_log_end + sizeof(job_header_t);
+  job_state = JOB_STORE_UPLOAD;
+  return(STATUS_OK);
+}
+
+
+uint8_t job_store_write_line(char *line)
+{
+  if (line[0] == 0) { return(STATUS_OK); } // Nothing to run in an empty line.
+  uint8_t len = strlen(line);
+  if (job_write_pos + len + 1 > JOB_STORE_FLASH_SIZE) {
+    job_store_stop();
+    return(STATUS_JOB_STORE_FULL);
+  }
+  line[len] = '\n'; // Stored terminator. Overwrites the string terminator.
+  uint8_t i;
+  for (i=0; i<=len; i++) {
+    job_page[job_write_pos % JOB_FLASH_PAGE_SIZE] = line[i];
+    job_write_pos++;
+    if ((job_write_pos % JOB_FLASH_PAGE_SIZE) == 0) { job_flush_page(job_write_pos - JOB_FLASH_PAGE_SIZE); }
+  }
+  line[len] = 0;
+  return(STATUS_OK);
+}
+
+
+// Flushes the open job and programs its length, and its live word if it is not kept.
+static void job_finish_upload(uint8_t keep)
+{
+  if (job_write_pos % JOB_FLASH_PAGE_SIZE) {
+    job_flush_page(job_write_pos & ~(uint32_t)(JOB_FLASH_PAGE_SIZE-1));
+  }
+  uint32_t closed[2] = { job_write_pos - job_write_start - (uint32_t)sizeof(job_header_t), 0 };
+  job_flash_program(job_write_start + 4, closed, keep ? 4 : 8);
+  job_set_log_end(job_write_pos);
+  job_state = JOB_STORE_IDLE;
+}
+
+
+uint8_t job_store_close()
+{
+  if (job_state != JOB_STORE_UPLOAD) { return(STATUS_INVALID_STATEMENT); }
+  // A job uploaded under an existing name replaces it. The open job is past the log end, so
+  // job_find() only sees the old one.
+  uint32_t old = job_find(job_write_name);
+  job_finish_upload(true);
+  if (old != JOB_ERASED) {
+    uint32_t dead = 0;
+    job_flash_program(old + offsetof(job_header_t, live), &dead, 4);
+  }
+  return(STATUS_OK);
+}
+
+
+void job_store_stop()
+{
+  if (job_state == JOB_STORE_UPLOAD) { job_finish_upload(false); }
+  job_state = JOB_STORE_IDLE;
+}
+
+
+// Copies a block of the running job into a reader buffer.
+static void job_fill_block(uint8_t idx, uint32_t offset)
+{
+  uint32_t len = min((uint32_t)JOB_READ_BLOCK_SIZE, job_read_end - offset);
+  job_flash_read(offset, job_block[idx], len);
+  job_block_offset[idx] = offset;
+}
+
+
+void job_store_prefetch()
+{
+  if ((job_state != JOB_STORE_RUN) || (job_block_offset[job_block_current] == JOB_BLOCK_EMPTY)) { return; }
+  uint32_t next = job_block_offset[job_block_current] + JOB_READ_BLOCK_SIZE;
+  uint8_t spare = job_block_current ^ 1;
+  if ((next < job_read_end) && (job_block_offset[spare] != next)) { job_fill_block(spare, next); }
+}
+
+
+uint8_t job_store_read_line(char *line)
+{
+  if (job_read_pos >= job_read_end) { return(false); }
+  uint8_t count = 0;
+  while (job_read_pos < job_read_end) {
+    uint32_t block = job_read_pos - (job_read_pos % JOB_READ_BLOCK_SIZE);
+    if (job_block_offset[job_block_current] != block) {
+      job_block_current ^= 1;
+      if (job_block_offset[job_block_current] != block) { job_fill_block(job_block_current, block); } // Prefetch missed.
+    }
+    char c = job_block[job_block_current][job_read_pos % JOB_READ_BLOCK_SIZE];
+    job_read_pos++;
+    if (c == '\n') { break; }
+    if (count < (LINE_BUFFER_SIZE-1)) { line[count++] = c; }
+  }
+  line[count] = 0;
+  return(true);
+}
+
+
+static uint8_t job_store_run(char *name)
+{
+  if (job_state != JOB_STORE_IDLE) { return(STATUS_JOB_STORE_BUSY); }
+  if (sys.state != STATE_IDLE) { return(STATUS_IDLE_ERROR); }
+  uint32_t offset = job_find(name);
+  if (offset == JOB_ERASED) { return(STATUS_JOB_NOT_FOUND); }
+  uint32_t length;
+  job_flash_read(offset + offsetof(job_header_t, length), &length, 4);
+  job_read_pos = offset + sizeof(job_header_t);
+  job_read_end = job_read_pos + length;
+  // Blocks are aligned to the block size in store offsets, so the first one may start before the job.
+  job_block_current = 0;
+  job_block_offset[0] = JOB_BLOCK_EMPTY;
+  job_block_offset[1] = JOB_BLOCK_EMPTY;
+  job_state = JOB_STORE_RUN;
+  return(STATUS_OK);
+}
+
+
+static void job_store_list(uint8_t client)
+{
+  job_header_t header;
+  uint32_t offset = 0;
+  while (offset < job_log_end) {
+    job_flash_read(offset, &header, sizeof(job_header_t));
+    if (header.live == JOB_ERASED) {
+      header.name[JOB_NAME_LENGTH-1] = 0;
+      grbl_sendf(client, "[JOB:%s,%lu]\r\n", header.name, (unsigned long)header.length);
+    }
+    offset = job_page_align(offset + sizeof(job_header_t) + header.length);
+  }
+  grbl_sendf(client, "[FREE:%lu]\r\n", (unsigned long)(JOB_STORE_FLASH_SIZE - job_log_end));
+}
+
+
+// $F command set. $F lists jobs, $FW=NAME starts an upload ended by $FE, $FR=NAME runs a job,
+// $FD=NAME deletes one, $FS stops the running job and $FX empties the store.
+uint8_t job_store_execute_line(char *line, uint8_t client)
+{
+  switch (line[2]) {
+    case 0: job_store_list(client); return(STATUS_OK);
+    case 'S':
+      if (line[3] != 0) { return(STATUS_INVALID_STATEMENT); }
+      if (job_state == JOB_STORE_RUN) {
+        job_store_stop();
+        report_feedback_message(MESSAGE_JOB_STOPPED);
+      }
+      return(STATUS_OK);
+  }
+  // Everything else writes flash or starts motion. Flash writes stop interrupts, so IDLE only.
+  if (sys.state != STATE_IDLE) { return(STATUS_IDLE_ERROR); }
+  if (job_state != JOB_STORE_IDLE) { return(STATUS_JOB_STORE_BUSY); }
+  if (line[2] == 'X') {
+    if (line[3] != 0) { return(STATUS_INVALID_STATEMENT); }
+    job_flash_erase_sector(0);
+    job_log_end = 0;
+    return(STATUS_OK);
+  }
+  if (line[3] != '=') { return(STATUS_INVALID_STATEMENT); }
+  char *name = &line[4];
+  switch (line[2]) {
+    case 'W': return(job_store_open(name));
+    case 'R': return(job_store_run(name));
+    case 'D': {
+      uint32_t offset = job_find(name);
+      if (offset == JOB_ERASED) { return(STATUS_JOB_NOT_FOUND); }
+      uint32_t dead = 0;
+      job_flash_program(offset + offsetof(job_header_t, live), &dead, 4);
+      return(STATUS_OK);
+    }
+  }
+  return(STATUS_INVALID_STATEMENT);
+}
+
+#endif
@@ -0,0 +1,66 @@
+/*
+  job_store.h - on-board g-code job storage in SPIFI flash
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef job_store_h
+#define job_store_h
+
+// Job store states.
+#define JOB_STORE_IDLE    0
+#define JOB_STORE_UPLOAD  1 // Received lines are appended to the open job, until $FE.
+#define JOB_STORE_RUN     2 // Lines are read from the running job when no serial line is pending.
+
+#define JOB_NAME_LENGTH 16 // Including the terminator.
+
+// Store layout: an append-only log of jobs, each starting on a flash page with a job_header_t and
+// followed by its lines, '\n' terminated. Deleting a job only clears its live word. Space is given
+// back by $FX, which empties the whole store. Lines are stored as filtered by the serial receiver,
+// so they never contain 0xFF, which marks erased flash.
+typedef struct {
+  uint32_t magic;
+  uint32_t length;        // Bytes of line data. Erased (0xFFFFFFFF) until the upload is closed.
+  uint32_t live;          // Erased while the job exists. Programmed to zero by $FD.
+  uint32_t reserved;
+  char name[JOB_NAME_LENGTH];
+} job_header_t;
+
+
+// Scans the store and closes a job left open by a power loss. Power-up only.
+void job_store_init();
+
+// Returns the job store state.
+uint8_t job_store_state();
+
+// Executes a $F job store command. Called by system_execute_line().
+uint8_t job_store_execute_line(char *line, uint8_t client);
+
+// Appends one received line to the job being uploaded.
+uint8_t job_store_write_line(char *line);
+
+// Closes the job being uploaded. Called on $FE.
+uint8_t job_store_close();
+
+// Reads the next line of the running job into line. Returns false at the end of the job.
+uint8_t job_store_read_line(char *line);
+
+// Refills the job reader's spare block ahead of use. Called while the main loop waits.
+void job_store_prefetch();
+
+// Stops a running job and discards an unfinished upload. Called on reset and on job line errors.
+void job_store_stop();
+
+#endif
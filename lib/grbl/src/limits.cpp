@@ -52,7 +52,9 @@ void limits_init()
     // Y_LIMIT
     PinInitInputIRQ(Y_LIMIT_BIT, LIMIT_BIT_PORT, pull, (HAL_GPIO_Line_Config)Y_LIMIT_LINE_IRQ);
     // Z_LIMIT
-    PinInitInputIRQ(Z_LIMIT_BIT, LIMIT_BIT_PORT, pull, (HAL_GPIO_Line_Config)Z_LIMIT_LINE_IRQ);
+    #ifndef DISABLE_Z_LIMIT_PIN
+      PinInitInputIRQ(Z_LIMIT_BIT, LIMIT_BIT_PORT, pull, (HAL_GPIO_Line_Config)Z_LIMIT_LINE_IRQ);
+    #endif
     // A_LIMIT
     PinInitInputIRQ(A_LIMIT_BIT, LIMIT_BIT_PORT, pull, (HAL_GPIO_Line_Config)A_LIMIT_LINE_IRQ);
   #endif
@@ -84,7 +86,9 @@ uint8_t limits_get_state()
     // Для ELRON_ACE_UNO читаем состояние пинов напрямую
     if (HAL_GPIO_ReadPin(LIMIT_BIT_PORT, X_LIMIT_BIT) == GPIO_PIN_LOW) limit_state |= bit(X_AXIS);
     if (HAL_GPIO_ReadPin(LIMIT_BIT_PORT, Y_LIMIT_BIT) == GPIO_PIN_LOW) limit_state |= bit(Y_AXIS);
-    if (HAL_GPIO_ReadPin(LIMIT_BIT_PORT, Z_LIMIT_BIT) == GPIO_PIN_LOW) limit_state |= bit(Z_AXIS);
+    #ifndef DISABLE_Z_LIMIT_PIN
+      if (HAL_GPIO_ReadPin(LIMIT_BIT_PORT, Z_LIMIT_BIT) == GPIO_PIN_LOW) limit_state |= bit(Z_AXIS);
+    #endif
   #else
     uint8_t pin = (LIMIT_PORT_INPUTS & LIMIT_MASK);
     #ifdef INVERT_LIMIT_PIN_MASK
@@ -124,12 +128,19 @@ void pin_limit_vect() {
     // Для ELRON_ACE_UNO читаем состояние пинов напрямую
     if (HAL_GPIO_ReadPin(LIMIT_BIT_PORT, X_LIMIT_BIT) == GPIO_PIN_LOW) limit_state |= bit(X_AXIS);
     if (HAL_GPIO_ReadPin(LIMIT_BIT_PORT, Y_LIMIT_BIT) == GPIO_PIN_LOW) limit_state |= bit(Y_AXIS);
-    if (HAL_GPIO_ReadPin(LIMIT_BIT_PORT, Z_LIMIT_BIT) == GPIO_PIN_LOW) limit_state |= bit(Z_AXIS);
+    #ifndef DISABLE_Z_LIMIT_PIN
+      if (HAL_GPIO_ReadPin(LIMIT_BIT_PORT, Z_LIMIT_BIT) == GPIO_PIN_LOW) limit_state |= bit(Z_AXIS);
+    #endif
     
     // Сброс прерываний для всех линий концевиков
-    ClearGPIOInterruptLines((1 << (X_LIMIT_LINE_IRQ >> GPIO_IRQ_LINE_S)) |
-                               (1 << (Y_LIMIT_LINE_IRQ >> GPIO_IRQ_LINE_S)) |
-                               (1 << (Z_LIMIT_LINE_IRQ >> GPIO_IRQ_LINE_S)));
+    #ifndef DISABLE_Z_LIMIT_PIN
+      ClearGPIOInterruptLines((1 << (X_LIMIT_LINE_IRQ >> GPIO_IRQ_LINE_S)) |
+                                 (1 << (Y_LIMIT_LINE_IRQ >> GPIO_IRQ_LINE_S)) |
+                                 (1 << (Z_LIMIT_LINE_IRQ >> GPIO_IRQ_LINE_S)));
+    #else
+      ClearGPIOInterruptLines((1 << (X_LIMIT_LINE_IRQ >> GPIO_IRQ_LINE_S)) |
+                                 (1 << (Y_LIMIT_LINE_IRQ >> GPIO_IRQ_LINE_S)));
+    #endif
   #else
     if (!limit_input_pivot && !LIMIT_PORT_INPUTS) {
       cli();
@@ -260,6 +271,7 @@ void limits_go_home(uint8_t cycle_mask)
         axislock |= step_pin[idx];
       }
     }
+    st_publish_position(); // Homed axes were zeroed above.
     homing_rate *= sqrt(n_active_axis); // [sqrt(N_AXIS)] Adjust so individual axes all move at homing rate.
     sys.homing_axis_lock = axislock;
 
@@ -371,6 +383,7 @@ void limits_go_home(uint8_t cycle_mask)
 
     }
   }
+  st_publish_position();
   sys.step_control = STEP_CONTROL_NORMAL_OP; // Return step control to normal operation.
 }
 
@@ -21,6 +21,85 @@
 
 #include "grbl.hpp"
 
+#ifdef ENABLE_PARSE_AHEAD
+  // Parse-ahead queue of motions that passed all parser and soft limit checks, but did not fit in
+  // the full planner buffer. Lets the parser acknowledge and parse further lines while the planner
+  // is backed up. Drained in order by mc_queue_service() from the realtime checkpoints.
+  typedef struct {
+    float target[N_AXIS];
+    plan_line_data_t pl_data;
+    uint8_t wait_spindle_sync; // Laser empty block waiting for the buffer to run empty. See mc_line().
+  } mc_queue_t;
+  static mc_queue_t mc_queue[PARSE_AHEAD_BUFFER_SIZE];
+  static uint8_t mc_queue_tail;
+  static uint8_t mc_queue_head;
+  static uint8_t mc_queue_count;
+#endif
+
+// Resumable arc generator. mc_arc() only sets up the arc, and the line segments are produced by
+// mc_queue_service() as planner buffer space frees up, so the main loop keeps reading lines and
+// sending reports during long arcs. Holds copies of everything it needs, since the parser's
+// planner data and position are gone once gc_execute_line() returns.
+typedef struct {
+  float target[N_AXIS];
+  float position[N_AXIS];        // Last generated segment end point.
+  plan_line_data_t pl_data;
+  float center_axis0;
+  float center_axis1;
+  #ifdef ARC_FIXED_POINT_KERNEL
+    arc_fixed_t fixed;           // Radius vector and rotation in fixed point. See arc_fixed.c.
+  #else
+    float r_axis0;               // Radius vector from center to current location
+    float r_axis1;
+    float offset_axis0;          // Initial offset. Used for exact arc correction.
+    float offset_axis1;
+    float theta_per_segment;
+    float cos_T;
+    float sin_T;
+  #endif
+  float linear_per_segment;
+  uint16_t segment;              // Index of the next segment to generate.
+  uint16_t segments;
+  uint8_t count;                 // Segments since last exact correction.
+  uint8_t axis_0;
+  uint8_t axis_1;
+  uint8_t axis_linear;
+  uint8_t active;                // Arc has segments not yet sent to mc_line().
+  uint8_t busy;                  // Set while generating. Segments call back into mc_line().
+} mc_arc_t;
+static mc_arc_t mc_arc_gen;
+
+// Resumable G5/G5.1 spline generator. Same scheme as mc_arc_gen. The cubic Bezier is kept in power
+// basis, B(t) = ((a*t + b)*t + c)*t + p0, per plane axis, so B''(t) = 6*a*t + 2*b is linear in t.
+typedef struct {
+  float target[N_AXIS];
+  float position[N_AXIS];        // Last generated segment end point.
+  plan_line_data_t pl_data;
+  float a[2];
+  float b[2];
+  float c[2];
+  float p0[2];
+  float t;                       // Curve parameter of position.
+  uint8_t active;                // Spline has segments not yet sent to mc_line().
+  uint8_t busy;                  // Set while generating. Segments call back into mc_line().
+} mc_spline_t;
+static mc_spline_t mc_spline_gen;
+
+// Magnitude of B''(t) in the XY plane.
+static float mc_spline_d2(mc_spline_t *spline, float t)
+{
+  return(hypot_f(6.0*spline->a[X_AXIS]*t + 2.0*spline->b[X_AXIS], 6.0*spline->a[Y_AXIS]*t + 2.0*spline->b[Y_AXIS]));
+}
+
+// Returns true while an arc or spline has segments left and is not generating them right now.
+static uint8_t mc_curve_pending()
+{
+  return((mc_arc_gen.active && !mc_arc_gen.busy) || (mc_spline_gen.active && !mc_spline_gen.busy));
+}
+
+uint16_t mc_arc_count;          // Arcs set up since reset. See REPORT_DIAGNOSTIC_COUNTERS.
+uint32_t mc_arc_segment_count;
+
 
 // Execute linear motion in absolute millimeter coordinates. Feed rate given in millimeters/second
 // unless invert_feed_rate is true. Then the feed_rate means that the motion should be completed in
@@ -41,6 +120,14 @@ void mc_line(float *target, plan_line_data_t *pl_data)
   // If in check gcode mode, prevent motion by blocking planner. Soft limits still work.
   if (sys.state == STATE_CHECK_MODE) { return; }
 
+  // Any new motion goes after the remaining segments of an arc or spline still being generated.
+  while (mc_curve_pending()) {
+    protocol_auto_cycle_start();
+    protocol_execute_realtime(); // Check for any run-time commands. Generates arc segments.
+    if (sys.abort) { return; } // Bail, if system abort.
+    delay(0);
+  }
+
   // NOTE: Backlash compensation may be installed here. It will need direction info to track when
   // to insert a backlash line motion(s) before the intended line motion and will require its own
   // plan_check_full_buffer() and check for system abort loop. Also for position reporting
@@ -55,6 +142,26 @@ void mc_line(float *target, plan_line_data_t *pl_data)
   // doesn't update the machine position values. Since the position values used by the g-code
   // parser and planner are separate from the system machine positions, this is doable.
 
+  #ifdef ENABLE_PARSE_AHEAD
+    // Queue behind any earlier motions still waiting, or when the planner buffer is full. The parser
+    // only blocks here once the parse-ahead queue is also full.
+    if (mc_queue_count || plan_check_full_buffer()) {
+      while (mc_queue_count == PARSE_AHEAD_BUFFER_SIZE) {
+        protocol_auto_cycle_start(); // Auto-cycle start when buffer is full.
+        protocol_execute_realtime(); // Check for any run-time commands. Drains the queue.
+        if (sys.abort) { return; } // Bail, if system abort.
+        delay(0);
+      }
+      mc_queue_t *entry = &mc_queue[mc_queue_head];
+      memcpy(entry->target, target, sizeof(entry->target));
+      memcpy(&entry->pl_data, pl_data, sizeof(plan_line_data_t));
+      entry->wait_spindle_sync = false;
+      if (++mc_queue_head == PARSE_AHEAD_BUFFER_SIZE) { mc_queue_head = 0; }
+      mc_queue_count++;
+      protocol_auto_cycle_start();
+      return;
+    }
+  #else
   // If the buffer is full: good! That means we are well ahead of the robot.
   // Remain in this loop until there is room in the buffer.
   do {
@@ -64,6 +171,7 @@ void mc_line(float *target, plan_line_data_t *pl_data)
     else { break; }
     delay(0);
   } while (1);
+  #endif
 
   // Plan and queue motion into planner buffer
   if (plan_buffer_line(target, pl_data) == PLAN_EMPTY_BLOCK) {
@@ -78,6 +186,170 @@ void mc_line(float *target, plan_line_data_t *pl_data)
 }
 
 
+// Generates the next arc segment, or the final segment to the exact target.
+static void mc_arc_next_segment()
+{
+  mc_arc_t *arc = &mc_arc_gen;
+  if (arc->segment < arc->segments) {
+    #ifdef ARC_FIXED_POINT_KERNEL
+      // Same correction schedule as the float kernel, with integer rotation and CORDIC sin/cos.
+      if (arc->count < N_ARC_CORRECTION) {
+        arc_fixed_rotate(&arc->fixed);
+        arc->count++;
+      } else {
+        arc_fixed_correct(&arc->fixed, arc->segment);
+        arc->count = 0;
+      }
+
+      // Update arc_target location
+      arc->position[arc->axis_0] = arc->center_axis0 + arc->fixed.r0*arc->fixed.scale_inv;
+      arc->position[arc->axis_1] = arc->center_axis1 + arc->fixed.r1*arc->fixed.scale_inv;
+    #else
+    if (arc->count < N_ARC_CORRECTION) {
+      // Apply vector rotation matrix. ~40 usec
+      float r_axisi = arc->r_axis0*arc->sin_T + arc->r_axis1*arc->cos_T;
+      arc->r_axis0 = arc->r_axis0*arc->cos_T - arc->r_axis1*arc->sin_T;
+      arc->r_axis1 = r_axisi;
+      arc->count++;
+    } else {
+      // Arc correction to radius vector. Computed only every N_ARC_CORRECTION increments. ~375 usec
+      // Compute exact location by applying transformation matrix from initial radius vector(=-offset).
+      float cos_Ti = cos(arc->segment*arc->theta_per_segment);
+      float sin_Ti = sin(arc->segment*arc->theta_per_segment);
+      arc->r_axis0 = -arc->offset_axis0*cos_Ti + arc->offset_axis1*sin_Ti;
+      arc->r_axis1 = -arc->offset_axis0*sin_Ti - arc->offset_axis1*cos_Ti;
+      arc->count = 0;
+    }
+
+    // Update arc_target location
+    arc->position[arc->axis_0] = arc->center_axis0 + arc->r_axis0;
+    arc->position[arc->axis_1] = arc->center_axis1 + arc->r_axis1;
+    #endif
+    arc->position[arc->axis_linear] += arc->linear_per_segment;
+    arc->segment++;
+
+    mc_line(arc->position, &arc->pl_data);
+  } else {
+    // Ensure last segment arrives at target location.
+    arc->active = false;
+    mc_line(arc->target, &arc->pl_data);
+  }
+}
+
+
+// Generates the next spline segment. The parameter step h is the largest that keeps the chord within
+// settings.arc_tolerance of the curve: deviation <= h^2/8 * max|B''| over the step. B'' is linear, so
+// its maximum is at one end of the step, and re-checking the far end once gives a safe step.
+static void mc_spline_next_segment()
+{
+  mc_spline_t *spline = &mc_spline_gen;
+  float t = spline->t;
+  float h = 1.0 - t;
+  float d2 = max(mc_spline_d2(spline, t), mc_spline_d2(spline, 1.0));
+  if (d2 > 0.0) {
+    h = min(h, sqrt(8.0*settings.arc_tolerance/d2));
+    d2 = mc_spline_d2(spline, t+h);
+    if (d2 > 0.0) { h = min(h, sqrt(8.0*settings.arc_tolerance/d2)); }
+    h = max(h, SPLINE_MIN_STEP);
+  }
+  t += h;
+  if (t < 1.0 - 0.5*SPLINE_MIN_STEP) {
+    uint8_t idx;
+    for (idx=0; idx<2; idx++) {
+      spline->position[idx] = ((spline->a[idx]*t + spline->b[idx])*t + spline->c[idx])*t + spline->p0[idx];
+    }
+    spline->t = t;
+    mc_line(spline->position, &spline->pl_data);
+  } else {
+    // Ensure last segment arrives at target location.
+    spline->active = false;
+    mc_line(spline->target, &spline->pl_data);
+  }
+}
+
+
+// Moves parse-ahead queued motions into the planner buffer and then generates pending arc segments,
+// as planner buffer space frees up. Called from the realtime checkpoints in protocol_execute_realtime().
+// Soft limits and check mode for queued motions were handled in mc_line().
+void mc_queue_service()
+{
+  uint8_t planned = false;
+  #ifdef ENABLE_PARSE_AHEAD
+    while (mc_queue_count) {
+      mc_queue_t *entry = &mc_queue[mc_queue_tail];
+      if (entry->wait_spindle_sync) {
+        // Same as the spindle_sync() in mc_line(), without blocking: wait for the buffer to empty.
+        if (plan_get_current_block() || (sys.state == STATE_CYCLE)) { return; }
+        spindle_set_state(PL_COND_FLAG_SPINDLE_CW, entry->pl_data.spindle_speed);
+      } else {
+        if (plan_check_full_buffer()) { return; }
+        if (plan_buffer_line(entry->target, &entry->pl_data) == PLAN_EMPTY_BLOCK) {
+          if (bit_istrue(settings.flags,BITFLAG_LASER_MODE) && (entry->pl_data.condition & PL_COND_FLAG_SPINDLE_CW)) {
+            entry->wait_spindle_sync = true;
+            continue;
+          }
+        }
+        planned = true;
+      }
+      if (++mc_queue_tail == PARSE_AHEAD_BUFFER_SIZE) { mc_queue_tail = 0; }
+      mc_queue_count--;
+    }
+  #endif
+
+  // Arc segments go through mc_line() for soft limit checks. Queue is empty and the planner has
+  // room here, so mc_line() plans them directly and never blocks.
+  if (mc_arc_gen.active && !mc_arc_gen.busy) {
+    mc_arc_gen.busy = true;
+    while (mc_arc_gen.active && !plan_check_full_buffer()) {
+      mc_arc_next_segment();
+      if (sys.abort) { break; }
+      planned = true;
+    }
+    mc_arc_gen.busy = false;
+  }
+  if (mc_spline_gen.active && !mc_spline_gen.busy) {
+    mc_spline_gen.busy = true;
+    while (mc_spline_gen.active && !plan_check_full_buffer()) {
+      mc_spline_next_segment();
+      if (sys.abort) { break; }
+      planned = true;
+    }
+    mc_spline_gen.busy = false;
+  }
+
+  // Motions planned while idle, i.e. from within a buffer sync, need a cycle start to run.
+  if (planned && (sys.state == STATE_IDLE)) { protocol_auto_cycle_start(); }
+}
+
+
+// Returns the number of parsed motions not yet in the planner buffer. A pending arc or spline counts
+// as one, except while its own segments are being planned.
+uint8_t mc_queue_pending()
+{
+  uint8_t pending = mc_curve_pending();
+  #ifdef ENABLE_PARSE_AHEAD
+    pending += mc_queue_count;
+  #endif
+  return(pending);
+}
+
+
+// Discards all queued motions and any arc or spline being generated. Called with plan_reset() wherever the
+// planner buffer is flushed.
+void mc_queue_reset()
+{
+  #ifdef ENABLE_PARSE_AHEAD
+    mc_queue_tail = 0;
+    mc_queue_head = 0;
+    mc_queue_count = 0;
+  #endif
+  mc_arc_gen.active = false;
+  mc_arc_gen.busy = false;
+  mc_spline_gen.active = false;
+  mc_spline_gen.busy = false;
+}
+
+
 // Execute an arc in offset mode format. position == current xyz, target == target xyz,
 // offset == offset from current xyz, axis_X defines circle plane in tool space, axis_linear is
 // the direction of helical travel, radius == circle radius, isclockwise boolean. Used
@@ -107,20 +379,56 @@ void mc_arc(float *target, plan_line_data_t *pl_data, float *position, float *of
   // (2x) settings.arc_tolerance. For 99% of users, this is just fine. If a different arc segment fit
   // is desired, i.e. least-squares, midpoint on arc, just change the mm_per_arc_segment calculation.
   // For the intended uses of Grbl, this value shouldn't exceed 2000 for the strictest of cases.
+  #ifdef ARC_ADAPTIVE_SEGMENTS
+    // Pick the segment length from the speed the arc can actually run at, rather than the chord
+    // tolerance alone. Speed is the programmed feed, limited by centripetal acceleration v^2/r of the
+    // slower plane axis. Segments shorter than ARC_MIN_SEGMENT_TIME at that speed are lengthened,
+    // up to the chord length allowed by ARC_ADAPTIVE_TOLERANCE_SCALE times the $12 tolerance.
+    // NOTE: Units are mm/min and mm/min^2, so sqrt(a*r) is in mm/min without conversion.
+    float arc_length = fabs(angular_travel*radius);
+    float feed_rate = pl_data->feed_rate;
+    if (pl_data->condition & PL_COND_FLAG_INVERSE_TIME) { feed_rate *= arc_length; } // 1/min to mm/min
+    float arc_speed = min(feed_rate, sqrt(min(settings.acceleration[axis_0],settings.acceleration[axis_1])*radius));
+    float mm_per_arc_segment = 2*sqrt(settings.arc_tolerance*(2*radius - settings.arc_tolerance));
+    float mm_per_arc_segment_time = arc_speed*(ARC_MIN_SEGMENT_TIME/60.0);
+    if (mm_per_arc_segment_time > mm_per_arc_segment) {
+      float tolerance_max = min(ARC_ADAPTIVE_TOLERANCE_SCALE*settings.arc_tolerance, radius);
+      mm_per_arc_segment = min(mm_per_arc_segment_time, 2*sqrt(tolerance_max*(2*radius - tolerance_max)));
+    }
+    uint16_t segments = floor(arc_length/mm_per_arc_segment);
+  #else
   uint16_t segments = floor(fabs(0.5*angular_travel*radius)/
                           sqrt(settings.arc_tolerance*(2*radius - settings.arc_tolerance)) );
+  #endif
+  mc_arc_count++;
+  mc_arc_segment_count += segments+1; // Includes final segment to target.
+
+  // Wait for a previous arc or spline to finish generating before reusing the generator.
+  while (mc_arc_gen.active || mc_spline_gen.active) {
+    protocol_auto_cycle_start();
+    protocol_execute_realtime(); // Check for any run-time commands. Generates arc segments.
+    if (sys.abort) { return; } // Bail, if system abort.
+    delay(0);
+  }
+
+  mc_arc_t *arc = &mc_arc_gen;
+  memcpy(arc->target, target, sizeof(arc->target));
+  memcpy(arc->position, position, sizeof(arc->position));
+  memcpy(&arc->pl_data, pl_data, sizeof(plan_line_data_t));
+  arc->segments = 0;
+  arc->segment = 1; // Increment (segments-1). Final segment goes to target.
+  arc->count = 0;
 
   if (segments) {
     // Multiply inverse feed_rate to compensate for the fact that this movement is approximated
     // by a number of discrete segments. The inverse feed_rate should be correct for the sum of
     // all segments.
-    if (pl_data->condition & PL_COND_FLAG_INVERSE_TIME) {
-      pl_data->feed_rate *= segments;
-      bit_false(pl_data->condition,PL_COND_FLAG_INVERSE_TIME); // Force as feed absolute mode over arc segments.
+    if (arc->pl_data.condition & PL_COND_FLAG_INVERSE_TIME) {
+      arc->pl_data.feed_rate *= segments;
+      bit_false(arc->pl_data.condition,PL_COND_FLAG_INVERSE_TIME); // Force as feed absolute mode over arc segments.
     }
 
-    float theta_per_segment = angular_travel/segments;
-    float linear_per_segment = (target[axis_linear] - position[axis_linear])/segments;
+    arc->linear_per_segment = (target[axis_linear] - position[axis_linear])/segments;
 
     /* Vector rotation by transformation matrix: r is the original vector, r_T is the rotated vector,
        and phi is the angle of rotation. Solution approach by Jens Geisler.
@@ -146,52 +454,224 @@ void mc_arc(float *target, plan_line_data_t *pl_data, float *position, float *of
        without the initial overhead of computing cos() or sin(). By the time the arc needs to be applied
        a correction, the planner should have caught up to the lag caused by the initial mc_arc overhead.
        This is important when there are successive arc motions.
+
+       The rotation state is kept in mc_arc_gen between segments, so the exact correction every
+       N_ARC_CORRECTION segments is unchanged by generating the arc lazily in mc_queue_service().
     */
+    #ifdef ARC_FIXED_POINT_KERNEL
+      // Integer kernel: exact per-segment rotation from CORDIC instead of the small angle
+      // approximation. Avoids soft-float multiplies and sin()/cos() on rv32imc.
+      arc_fixed_init(&arc->fixed, r_axis0, r_axis1, angular_travel, segments);
+    #else
+    arc->theta_per_segment = angular_travel/segments;
     // Computes: cos_T = 1 - theta_per_segment^2/2, sin_T = theta_per_segment - theta_per_segment^3/6) in ~52usec
-    float cos_T = 2.0 - theta_per_segment*theta_per_segment;
-    float sin_T = theta_per_segment*0.16666667*(cos_T + 4.0);
-    cos_T *= 0.5;
-
-    float sin_Ti;
-    float cos_Ti;
-    float r_axisi;
-    uint16_t i;
-    uint8_t count = 0;
-
-    for (i = 1; i<segments; i++) { // Increment (segments-1).
-      if (count < N_ARC_CORRECTION) {
-        // Apply vector rotation matrix. ~40 usec
-        r_axisi = r_axis0*sin_T + r_axis1*cos_T;
-        r_axis0 = r_axis0*cos_T - r_axis1*sin_T;
-        r_axis1 = r_axisi;
-        count++;
-      } else {
-        // Arc correction to radius vector. Computed only every N_ARC_CORRECTION increments. ~375 usec
-        // Compute exact location by applying transformation matrix from initial radius vector(=-offset).
-        cos_Ti = cos(i*theta_per_segment);
-        sin_Ti = sin(i*theta_per_segment);
-        r_axis0 = -offset[axis_0]*cos_Ti + offset[axis_1]*sin_Ti;
-        r_axis1 = -offset[axis_0]*sin_Ti - offset[axis_1]*cos_Ti;
-        count = 0;
-      }
+    arc->cos_T = 2.0 - arc->theta_per_segment*arc->theta_per_segment;
+    arc->sin_T = arc->theta_per_segment*0.16666667*(arc->cos_T + 4.0);
+    arc->cos_T *= 0.5;
+
+    arc->r_axis0 = r_axis0;
+    arc->r_axis1 = r_axis1;
+    arc->offset_axis0 = offset[axis_0];
+    arc->offset_axis1 = offset[axis_1];
+    #endif
+
+    arc->center_axis0 = center_axis0;
+    arc->center_axis1 = center_axis1;
+    arc->axis_0 = axis_0;
+    arc->axis_1 = axis_1;
+    arc->axis_linear = axis_linear;
+    arc->segments = segments;
+  }
+  arc->active = true;
+
+  if (sys.state == STATE_CHECK_MODE) {
+    // Nothing is planned in check mode, but soft limits are still checked for every segment.
+    while (arc->active) { mc_arc_next_segment(); if (sys.abort) { return; } }
+  } else {
+    mc_queue_service(); // Plan the first segments right away, if the planner has room.
+  }
+}
 
-      // Update arc_target location
-      position[axis_0] = center_axis0 + r_axis0;
-      position[axis_1] = center_axis1 + r_axis1;
-      position[axis_linear] += linear_per_segment;
 
+// Execute a G5 cubic spline in the XY plane from position to target, with absolute Bezier control
+// points control_1 and control_2. G5.1 quadratics are converted to cubics by the parser. Segments
+// are generated lazily like arcs, with the chord tolerance of settings.arc_tolerance.
+void mc_spline(float *target, plan_line_data_t *pl_data, float *position, float *control_1, float *control_2)
+{
+  // Wait for a previous arc or spline to finish generating before reusing the generator.
+  while (mc_arc_gen.active || mc_spline_gen.active) {
+    protocol_auto_cycle_start();
+    protocol_execute_realtime(); // Check for any run-time commands. Generates segments.
+    if (sys.abort) { return; } // Bail, if system abort.
+    delay(0);
+  }
+
+  mc_spline_t *spline = &mc_spline_gen;
+  memcpy(spline->target, target, sizeof(spline->target));
+  memcpy(spline->position, target, sizeof(spline->position)); // Axes other than X,Y are already at target.
+  memcpy(&spline->pl_data, pl_data, sizeof(plan_line_data_t));
+  uint8_t idx;
+  for (idx=0; idx<2; idx++) {
+    float p0 = position[idx];
+    spline->a[idx] = target[idx] - 3.0*control_2[idx] + 3.0*control_1[idx] - p0;
+    spline->b[idx] = 3.0*(control_2[idx] - 2.0*control_1[idx] + p0);
+    spline->c[idx] = 3.0*(control_1[idx] - p0);
+    spline->p0[idx] = p0;
+  }
+  // Length estimate: mean of the chord and the control polygon.
+  float length = 0.5*(hypot_f(target[X_AXIS]-position[X_AXIS], target[Y_AXIS]-position[Y_AXIS]) +
+                      hypot_f(control_1[X_AXIS]-position[X_AXIS], control_1[Y_AXIS]-position[Y_AXIS]) +
+                      hypot_f(control_2[X_AXIS]-control_1[X_AXIS], control_2[Y_AXIS]-control_1[Y_AXIS]) +
+                      hypot_f(target[X_AXIS]-control_2[X_AXIS], target[Y_AXIS]-control_2[Y_AXIS]));
+  // Inverse time is for the whole curve. Segments run at the equivalent feed in mm/min.
+  if (spline->pl_data.condition & PL_COND_FLAG_INVERSE_TIME) {
+    spline->pl_data.feed_rate *= length;
+    bit_false(spline->pl_data.condition,PL_COND_FLAG_INVERSE_TIME);
+  }
+  spline->t = 0.0;
+  spline->active = true;
+
+  if (sys.state == STATE_CHECK_MODE) {
+    // Nothing is planned in check mode, but soft limits are still checked for every segment.
+    while (spline->active) { mc_spline_next_segment(); if (sys.abort) { return; } }
+  } else {
+    mc_queue_service(); // Plan the first segments right away, if the planner has room.
+  }
+}
+
+
+// Execute one hole of a G73, G81, G82 or G83 canned cycle. target == hole position with the bottom
+// of the hole on axis_linear, position == current xyz, updated to the hole at clear_level when done.
+// r_level and clear_level are the R plane and the G98/G99 return level on axis_linear. peck is the
+// G73/G83 Q increment and dwell the G82 P time in seconds. All moves are planned here, so a drilling
+// program needs one short line per hole.
+void mc_canned_cycle(float *target, plan_line_data_t *pl_data, float *position, float r_level,
+  float clear_level, float peck, float dwell, uint8_t axis_linear, uint8_t cycle)
+{
+  plan_line_data_t rapid_data;
+  memcpy(&rapid_data, pl_data, sizeof(plan_line_data_t));
+  rapid_data.condition |= PL_COND_FLAG_RAPID_MOTION;
+  float bottom = target[axis_linear];
+  uint8_t idx;
+
+  // Preliminary motion: up to the R plane if below it, then over to the hole.
+  if (position[axis_linear] < r_level) {
+    position[axis_linear] = r_level;
+    mc_line(position, &rapid_data);
+  }
+  for (idx=0; idx<N_AXIS; idx++) {
+    if (idx != axis_linear) { position[idx] = target[idx]; }
+  }
+  mc_line(position, &rapid_data);
+  position[axis_linear] = r_level;
+  mc_line(position, &rapid_data);
+
+  if ((cycle == MOTION_MODE_PECK_DRILL) || (cycle == MOTION_MODE_PECK_CHIP_BREAK)) {
+    float depth = r_level; // Deepest point drilled so far.
+    while (depth > bottom) {
+      if (sys.abort) { return; } // Bail, if system abort.
+      depth = max(depth - peck, bottom);
+      position[axis_linear] = depth;
       mc_line(position, pl_data);
+      if (depth > bottom) {
+        if (cycle == MOTION_MODE_PECK_DRILL) {
+          // Clear the chips out of the hole and come back down to just above the last depth.
+          position[axis_linear] = r_level;
+          mc_line(position, &rapid_data);
+          position[axis_linear] = min(depth + CANNED_CYCLE_PECK_CLEARANCE, r_level);
+          mc_line(position, &rapid_data);
+        } else {
+          // Back off slightly to break the chip. The next peck feeds through the clearance.
+          position[axis_linear] = min(depth + CANNED_CYCLE_PECK_CLEARANCE, r_level);
+          mc_line(position, &rapid_data);
+        }
+      }
+    }
+  } else {
+    position[axis_linear] = bottom;
+    mc_line(position, pl_data);
+    if (cycle == MOTION_MODE_DRILL_DWELL) { mc_dwell(dwell); }
+  }
+
+  // Return to the G98 initial level or the G99 R plane.
+  position[axis_linear] = clear_level;
+  mc_line(position, &rapid_data);
+}
+
+
+#ifdef ENABLE_SPINDLE_SYNC
+// Execute a G33 spindle-synchronized motion. The feed rate is that of the spindle speed when the
+// motion starts. The stepper keeps the cruise tied to the spindle position from the index pulse.
+void mc_thread(float *target, plan_line_data_t *pl_data)
+{
+  pl_data->condition |= PL_COND_FLAG_NO_FEED_OVERRIDE;
+  if (sys.state == STATE_CHECK_MODE) { mc_line(target, pl_data); return; } // Soft limits only.
 
-      // Bail mid-circle on system abort. Runtime command check already performed by mc_line.
-      if (sys.abort) { return; }
-      delay(0);
+  // Start from a stop, so the motion can be started on the index pulse.
+  protocol_buffer_synchronize();
+  if (sys.abort) { return; } // Bail, if system abort.
+  float rpm = spindle_encoder_rpm();
+  if (rpm > 0.0) {
+    pl_data->feed_rate = pl_data->feed_per_rev*rpm;
+    spindle_encoder_sync_clear(); // Not synchronized until the index pulse it starts on.
+    mc_line(target, pl_data);
+    // Prepare the first segments while waiting, so the motion starts right after the index pulse.
+    st_prep_buffer();
+    if (spindle_encoder_wait_index()) {
+      system_set_exec_state_flag(EXEC_CYCLE_START);
+      protocol_execute_realtime();
+      return;
     }
+    if (sys.abort) { return; }
   }
-  // Ensure last segment arrives at target location.
-  mc_line(target, pl_data);
+  // Spindle not turning. Discard the motion and stop, as in any failed cycle.
+  system_set_exec_alarm(EXEC_ALARM_SPINDLE_SYNC);
+  mc_reset();
+  protocol_execute_realtime();
 }
 
 
+void mc_threading_cycle(float z_end, plan_line_data_t *pl_data, float *position, float pitch,
+  float peak, float first_depth, float depth, float degression, float angle, uint8_t spring_passes)
+{
+  plan_line_data_t rapid_data;
+  memcpy(&rapid_data, pl_data, sizeof(plan_line_data_t));
+  rapid_data.condition |= PL_COND_FLAG_RAPID_MOTION;
+  pl_data->feed_per_rev = pitch;
+  float target[N_AXIS];
+  memcpy(target, position, sizeof(target));
+  float infeed = (peak < 0.0) ? -1.0 : 1.0; // Into the work. Down in X for external threads.
+  float z_retract = (z_end < position[Z_AXIS]) ? 1.0 : -1.0; // Back along the thread.
+  float compound = tan(angle*(M_PI/180.0));
+  float cut = 0.0;
+  uint16_t pass = 0;
+
+  while (1) {
+    if (sys.abort) { return; } // Bail, if system abort.
+    if (cut < depth) {
+      pass++;
+      cut = min(first_depth*pow((float)pass, 1.0/degression), depth);
+    } else if (spring_passes) {
+      spring_passes--;
+    } else {
+      break;
+    }
+    // With a compound angle, each pass starts further back by its depth, so it cuts on one flank.
+    target[Z_AXIS] = position[Z_AXIS] + z_retract*cut*compound;
+    mc_line(target, &rapid_data);
+    target[X_AXIS] = position[X_AXIS] + peak + infeed*cut;
+    mc_line(target, &rapid_data);
+    target[Z_AXIS] = z_end;
+    mc_thread(target, pl_data);
+    target[X_AXIS] = position[X_AXIS];
+    mc_line(target, &rapid_data);
+    target[Z_AXIS] = position[Z_AXIS];
+    mc_line(target, &rapid_data);
+  }
+}
+#endif
+
+
 // Execute dwell in seconds.
 void mc_dwell(float seconds)
 {
@@ -296,7 +776,11 @@ uint8_t mc_probe_cycle(float *target, plan_line_data_t *pl_data, uint8_t parser_
 
   // Set state variables and error out, if the probe failed and cycle with error is enabled.
   if (sys_probe_state == PROBE_ACTIVE) {
-    if (is_no_error) { memcpy(sys_probe_position, sys_position, sizeof(sys_position)); }
+    if (is_no_error) {
+      st_snapshot_t snapshot;
+      st_get_snapshot(&snapshot); // Published by st_go_idle() when the probing motion ended.
+      memcpy(sys_probe_position, snapshot.position, sizeof(snapshot.position));
+    }
     else { system_set_exec_alarm(EXEC_ALARM_PROBE_FAIL_CONTACT); }
   } else {
     sys.probe_succeeded = true; // Indicate to system the probing cycle completed successfully.
@@ -308,6 +792,7 @@ uint8_t mc_probe_cycle(float *target, plan_line_data_t *pl_data, uint8_t parser_
   // Reset the stepper and planner buffers to remove the remainder of the probe motion.
   st_reset(); // Reset step segment buffer.
   plan_reset(); // Reset planner buffer. Zero planner positions. Ensure probing motion is cleared.
+  mc_queue_reset();
   plan_sync_position(); // Sync planner position to current machine position.
 
   #ifdef MESSAGE_PROBE_COORDINATES
@@ -32,19 +32,68 @@
 #define HOMING_CYCLE_Y    bit(Y_AXIS)
 #define HOMING_CYCLE_Z    bit(Z_AXIS)
 
+// Number of parsed motions that may wait for room in the planner buffer.
+#ifndef PARSE_AHEAD_BUFFER_SIZE
+  #define PARSE_AHEAD_BUFFER_SIZE 8
+#endif
+
+// Smallest curve parameter step of a G5 spline segment. Bounds the segment count near cusps.
+#define SPLINE_MIN_STEP 0.0001
+
+// Most cutting passes of a G76 threading cycle, spring passes excluded.
+#define THREADING_CYCLE_MAX_PASSES 100
+
+
+// Number of arcs set up and line segments generated for them since reset. Shown by $I.
+extern uint16_t mc_arc_count;
+extern uint32_t mc_arc_segment_count;
+
 
 // Execute linear motion in absolute millimeter coordinates. Feed rate given in millimeters/second
 // unless invert_feed_rate is true. Then the feed_rate means that the motion should be completed in
 // (1 minute)/feed_rate time.
 void mc_line(float *target, plan_line_data_t *pl_data);
 
+// Moves parse-ahead queued motions and pending arc and spline segments into the planner buffer, as space allows.
+void mc_queue_service();
+
+// Returns the number of parsed motions not yet in the planner buffer.
+uint8_t mc_queue_pending();
+
+// Discards all parse-ahead queued motions and any arc or spline being generated.
+void mc_queue_reset();
+
 // Execute an arc in offset mode format. position == current xyz, target == target xyz,
 // offset == offset from current xyz, axis_XXX defines circle plane in tool space, axis_linear is
 // the direction of helical travel, radius == circle radius, is_clockwise_arc boolean. Used
-// for vector transformation direction.
+// for vector transformation direction. Returns after setting up the arc. Segments are generated
+// by mc_queue_service() as the planner buffer drains.
 void mc_arc(float *target, plan_line_data_t *pl_data, float *position, float *offset, float radius,
   uint8_t axis_0, uint8_t axis_1, uint8_t axis_linear, uint8_t is_clockwise_arc);
 
+// Execute a G5 cubic spline in the XY plane. position == current xyz, target == target xyz,
+// control_1 and control_2 are the absolute XY Bezier control points. Returns after setting up the
+// spline. Segments are generated by mc_queue_service() like arcs.
+void mc_spline(float *target, plan_line_data_t *pl_data, float *position, float *control_1, float *control_2);
+
+// Execute one hole of a G73, G81, G82 or G83 canned cycle. Plans the whole drilling sequence from
+// position to the bottom of the hole at target and back up to clear_level. Updates position.
+void mc_canned_cycle(float *target, plan_line_data_t *pl_data, float *position, float r_level,
+  float clear_level, float peck, float dwell, uint8_t axis_linear, uint8_t cycle);
+
+#ifdef ENABLE_SPINDLE_SYNC
+// Execute a G33 spindle-synchronized motion, with pl_data->feed_per_rev set. Waits for the motions
+// before it to finish, then starts the motion on a spindle index pulse. Alarm, if the spindle is
+// not turning.
+void mc_thread(float *target, plan_line_data_t *pl_data);
+
+// Execute a G76 threading cycle from position, the start of the drive line, to z_end. Plans a
+// G33 pass for each depth and returns to position after each. See [G76 Errors] in gcode.c for
+// the parameters.
+void mc_threading_cycle(float z_end, plan_line_data_t *pl_data, float *position, float pitch,
+  float peak, float first_depth, float depth, float degression, float angle, uint8_t spring_passes);
+#endif
+
 // Dwell for a specific number of seconds
 void mc_dwell(float seconds);
 
@@ -74,6 +74,32 @@ void delay(uint8_t ms){
   delay_ms(ms);
 }
 
+// Converts an integer and a decimal exponent into floating point, rounding exactly as read_float().
+// Shared with the tokenized g-code decoder, so a token yields the same float as its text.
+float decimal_to_float(uint32_t intval, int8_t exp)
+{
+  float fval;
+  fval = (float)intval;
+
+  // Apply decimal. Should perform no more than two floating point multiplications for the
+  // expected range of E0 to E-4.
+  if (fval != 0) {
+    while (exp <= -2) {
+      fval *= 0.01;
+      exp += 2;
+    }
+    if (exp < 0) {
+      fval *= 0.1;
+    } else if (exp > 0) {
+      do {
+        fval *= 10.0;
+      } while (--exp > 0);
+    }
+  }
+  return(fval);
+}
+
+
 // Extracts a floating point value from a string. The following code is based loosely on
 // the avr-libc strtod() function by Michael Stumpf and Dmitry Xmelkov and many freely
 // available conversion method examples, but has been highly optimized for Grbl. For known
@@ -124,25 +150,7 @@ uint8_t read_float(char *line, uint8_t *char_counter, float *float_ptr)
   // Return if no digits have been read.
   if (!ndigit) { return(false); };
 
-  // Convert integer into floating point.
-  float fval;
-  fval = (float)intval;
-
-  // Apply decimal. Should perform no more than two floating point multiplications for the
-  // expected range of E0 to E-4.
-  if (fval != 0) {
-    while (exp <= -2) {
-      fval *= 0.01;
-      exp += 2;
-    }
-    if (exp < 0) {
-      fval *= 0.1;
-    } else if (exp > 0) {
-      do {
-        fval *= 10.0;
-      } while (--exp > 0);
-    }
-  }
+  float fval = decimal_to_float(intval, exp);
 
   // Assign floating point value with correct sign.
   if (isnegative) {
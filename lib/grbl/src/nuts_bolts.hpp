@@ -74,6 +74,9 @@ void delay(uint8_t);
 // a pointer to the result variable. Returns true when it succeeds
 uint8_t read_float(char *line, uint8_t *char_counter, float *float_ptr);
 
+// Returns intval*10^exp, with the same rounding as read_float().
+float decimal_to_float(uint32_t intval, int8_t exp);
+
 // Non-blocking delay function used for general operation and suspend features.
 void delay_sec(float seconds, uint8_t mode);
 
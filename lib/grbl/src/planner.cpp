@@ -324,6 +324,17 @@ uint8_t plan_buffer_line(float *target, plan_line_data_t *pl_data)
   #ifdef USE_LINE_NUMBERS
     block->line_number = pl_data->line_number;
   #endif
+  #ifdef ENABLE_DIGITAL_OUTPUTS
+    block->digital_out_set = pl_data->digital_out_set;
+    block->digital_out_clear = pl_data->digital_out_clear;
+    block->digital_out_epoch = pl_data->digital_out_epoch;
+  #endif
+  #ifdef ENABLE_RASTER
+    block->raster_slot = pl_data->raster_slot;
+  #endif
+  #ifdef ENABLE_SPINDLE_SYNC
+    block->feed_per_rev = pl_data->feed_per_rev;
+  #endif
 
   // Compute and store initial move distance data.
   int32_t target_steps[N_AXIS], position_steps[N_AXIS];
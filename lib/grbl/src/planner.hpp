@@ -83,6 +83,19 @@ typedef struct {
     // Stored spindle speed data used by spindle overrides and resuming methods.
     float spindle_speed;    // Block spindle speed. Copied from pl_line_data.
   #endif
+
+  #ifdef ENABLE_DIGITAL_OUTPUTS
+    uint8_t digital_out_set;    // Synchronized M62/M63 output changes at block start. Copied from pl_line_data.
+    uint8_t digital_out_clear;
+    uint16_t digital_out_epoch;
+  #endif
+
+  #ifdef ENABLE_RASTER
+    uint8_t raster_slot;    // Scanline pixels stepped through by this block. Copied from pl_line_data.
+  #endif
+  #ifdef ENABLE_SPINDLE_SYNC
+    float feed_per_rev;     // Travel per spindle revolution of a G33 block, or zero. (mm/rev)
+  #endif
 } plan_block_t;
 
 
@@ -94,6 +107,17 @@ typedef struct {
   #ifdef USE_LINE_NUMBERS
     int32_t line_number;    // Desired line number to report when executing.
   #endif
+  #ifdef ENABLE_DIGITAL_OUTPUTS
+    uint8_t digital_out_set;    // Outputs M62 sets and M63 clears when the block starts.
+    uint8_t digital_out_clear;
+    uint16_t digital_out_epoch; // M64/M65 count when parsed. See digital_output_write_sync().
+  #endif
+  #ifdef ENABLE_RASTER
+    uint8_t raster_slot;    // Raster scanline slot, or RASTER_SLOT_NONE (zero). See raster.h.
+  #endif
+  #ifdef ENABLE_SPINDLE_SYNC
+    float feed_per_rev;     // Spindle-synchronized travel per revolution (mm/rev). Zero for other motions.
+  #endif
 } plan_line_data_t;
 
 
@@ -22,16 +22,17 @@
 #include "grbl.hpp"
 
 
+// Выводит строку через буфер передачи, в одном порядке с serial_write().
 void printString(const char *s)
 {
-  xprintf(s);
+  while (*s) { serial_write(*s++); }
 }
 
 
 // Печатает строку, хранящуюся в PGM-памяти
 void printPgmString(const char *s)
 {
-  xprintf(s);
+  while (*s) { serial_write(*s++); }
 }
 
 
@@ -122,46 +123,61 @@ void printInteger(long n)
 }
 
 
-// Преобразует float в строку, немедленно конвертируя в long integer, который содержит
-// больше цифр, чем float. Количество десятичных знаков, отслеживаемое счётчиком,
-// может быть задано пользователем. Затем целое число эффективно преобразуется в строку.
-// ПРИМЕЧАНИЕ: Целочисленные операции '%' и '/' на AVR очень эффективны. Техники ускорения
-// с помощью битовых сдвигов на самом деле немного медленнее. Узнали это на горьком опыте.
-void printFloat(float n, uint8_t decimal_places)
-{
-  if (n < 0) {
-    serial_write('-');
-    n = -n;
-  }
+const float print_pow10[PRINT_DECIMALS_MAX+1] = { 1.0, 10.0, 100.0, 1000.0, 10000.0 };
 
-  uint8_t decimals = decimal_places;
-  while (decimals >= 2) { // Быстрое преобразование значений, ожидаемых от E0 до E-4.
-    n *= 100;
-    decimals -= 2;
-  }
-  if (decimals) { n *= 10; }
-  n += 0.5; // Добавляет коэффициент округления. Обеспечивает перенос по всему значению.
 
-  // Генерирует цифры в обратном порядке и сохраняет в строку.
-  unsigned char buf[13];
+// Записывает n*10^-decimal_places десятичным текстом в buf без завершающего нуля и возвращает
+// число символов. Только целочисленные операции: деление на константу 10 компилятор заменяет
+// умножением.
+uint8_t print_fixed_to_buffer(char *buf, uint32_t n, uint8_t decimal_places)
+{
+  // Генерирует цифры в обратном порядке.
+  char digits[13];
   uint8_t i = 0;
-  uint32_t a = (long)n;
-  while(a > 0) {
-    buf[i++] = (a % 10) + '0'; // Получает цифру
-    a /= 10;
+  while (n > 0) {
+    digits[i++] = (n % 10) + '0';
+    n /= 10;
   }
   while (i < decimal_places) {
-     buf[i++] = '0'; // Заполняет нулями до десятичной точки для (n < 1)
+    digits[i++] = '0'; // Заполняет нулями до десятичной точки для (n < 1)
   }
   if (i == decimal_places) { // Заполняет ведущий ноль, если нужно.
-    buf[i++] = '0';
+    digits[i++] = '0';
   }
-
-  // Печатает сгенерированную строку.
+  uint8_t length = 0;
   for (; i > 0; i--) {
-    if (i == decimal_places) { serial_write('.'); } // Вставляет десятичную точку в нужное место.
-    serial_write(buf[i-1]);
+    if (i == decimal_places) { buf[length++] = '.'; } // Вставляет десятичную точку в нужное место.
+    buf[length++] = digits[i-1];
   }
+  return(length);
+}
+
+
+// Записывает значение, уже умноженное на 10^decimal_places, округлив половину от нуля.
+// Возвращает число символов, не больше PRINT_FLOAT_SIZE.
+uint8_t print_scaled_to_buffer(char *buf, float n, uint8_t decimal_places)
+{
+  uint8_t length = 0;
+  if (n < 0) {
+    buf[length++] = '-';
+    n = -n;
+  }
+  n += 0.5; // Добавляет коэффициент округления. Обеспечивает перенос по всему значению.
+  // Значения вне uint32 ограничиваются, а не переполняются. Координаты Grbl до них не доходят.
+  uint32_t a = (n < 4.0e9) ? (uint32_t)n : 4000000000UL;
+  return(length + print_fixed_to_buffer(&buf[length], a, decimal_places));
+}
+
+
+// Преобразует float в строку одним умножением на степень десяти и округлением до целого,
+// а затем выводит целое число. Количество десятичных знаков задаётся пользователем, не больше
+// PRINT_DECIMALS_MAX.
+void printFloat(float n, uint8_t decimal_places)
+{
+  char buf[PRINT_FLOAT_SIZE];
+  uint8_t length = print_scaled_to_buffer(buf, n * print_pow10[decimal_places], decimal_places);
+  uint8_t i;
+  for (i=0; i<length; i++) { serial_write(buf[i]); }
 }
 
 
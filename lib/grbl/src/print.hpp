@@ -37,8 +37,20 @@ void print_uint8_base10(uint8_t n);
 // Prints an uint8 variable in base 2 with desired number of desired digits.
 void print_uint8_base2_ndigit(uint8_t n, uint8_t digits);
 
+#define PRINT_DECIMALS_MAX 4  // Most decimal places printFloat() takes.
+#define PRINT_FLOAT_SIZE   13 // Longest printed float: sign, 10 digits and point, plus one spare.
+
+extern const float print_pow10[PRINT_DECIMALS_MAX+1]; // 10^0 to 10^PRINT_DECIMALS_MAX.
+
 void printFloat(float n, uint8_t decimal_places);
 
+// Writes n*10^-decimal_places as decimal text to buf, unterminated. Returns the character count.
+uint8_t print_fixed_to_buffer(char *buf, uint32_t n, uint8_t decimal_places);
+
+// Writes a value already scaled by 10^decimal_places, rounded half away from zero as printFloat()
+// rounds, to buf, unterminated. Returns the character count, at most PRINT_FLOAT_SIZE.
+uint8_t print_scaled_to_buffer(char *buf, float n, uint8_t decimal_places);
+
 // Floating value printing handlers for special variables types used in Grbl.
 //  - CoordValue: Handles all position or coordinate values in inches or mm reporting.
 //  - RateValue: Handles feed rate and current velocity in inches or mm reporting.
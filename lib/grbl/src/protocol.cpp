@@ -24,6 +24,125 @@
 
 static void protocol_exec_rt_suspend();
 
+#ifdef ENABLE_JOB_STORE
+  static char job_line[LINE_BUFFER_SIZE]; // Строка задания из флеш-памяти. Отдельно от строки приёмника UART.
+#endif
+
+
+// Направить и выполнить одну строку форматированного ввода. Возвращает статус выполнения.
+static uint8_t protocol_execute_line(char *line, uint8_t client)
+{
+  if (line[0] == 0) {
+    // Пустая строка или строка комментария. Для целей синхронизации.
+    return(STATUS_OK);
+  } else if (line[0] == '$') {
+    // Системная команда Grbl '$'
+    return(system_execute_line(line, client));
+  } else if (sys.state & (STATE_ALARM | STATE_JOG)) {
+    // Всё остальное — gcode. Блокировать, если в режиме тревоги или JOG.
+    return(STATUS_SYSTEM_GC_LOCK);
+  }
+  // Разобрать и выполнить g-code блок.
+  return(gc_execute_line(line, client));
+}
+
+
+// Ответить на строку из порта: ok/error, или пачкой ok:N после $A=N.
+static void protocol_report_line_status(uint8_t status_code, uint8_t client)
+{
+  #ifdef ENABLE_ACK_BATCHING
+    report_line_status(status_code, client);
+  #else
+    report_status_message(status_code, client);
+  #endif
+}
+
+
+#ifdef ENABLE_JOB_STORE
+// Системные команды, которые хост может посылать во время выполнения задания: управление
+// хранилищем $F… и запросы, которые только выводят состояние ($, $$, $#, $G). Остальные меняют
+// настройки, режимы или запускают движение и допускаются только вне задания.
+static uint8_t protocol_job_run_allows(char *line)
+{
+  if ((line[1] == 'F') || (line[1] == 0)) { return(true); }
+  if (line[2] != 0) { return(false); }
+  return((line[1] == '$') || (line[1] == '#') || (line[1] == 'G'));
+}
+#endif
+
+
+#ifdef ENABLE_GCODE_TOKENS
+// Хост сдвигает опорные значения осей для слов-приращений по каждой отправленной строке, а Grbl —
+// только по разобранным словам. Поэтому после отклонённой строки они сбрасываются, и слово-приращение
+// отклоняется, пока хост снова не пришлёт абсолютное. Строки хоста не трогают опорные значения
+// выполняемого задания.
+static void protocol_token_reject()
+{
+  #ifdef ENABLE_JOB_STORE
+    if (job_store_state() == JOB_STORE_RUN) { return; }
+  #endif
+  gc_token_reset();
+}
+#endif
+
+
+// Направить строку от хоста. Во время загрузки задания строка сохраняется.
+static uint8_t protocol_dispatch_host_line(char *line, uint8_t client)
+{
+  #ifdef ENABLE_JOB_STORE
+    if (job_store_state() == JOB_STORE_UPLOAD) {
+      // Идёт загрузка задания: строки сохраняются во флеш-память, а не выполняются, до $FE.
+      if (strcmp(line, "$FE") == 0) { return(job_store_close()); }
+      return(job_store_write_line(line));
+    } else if (job_store_state() == JOB_STORE_RUN) {
+      // Во время выполнения задания g-код от хоста не принимается, а из системных команд — только
+      // $F… и запросы состояния. Команды реального времени обрабатываются раньше, при приёме.
+      if (line[0] != '$') { return(STATUS_JOB_STORE_BUSY); }
+      if (!protocol_job_run_allows(line)) { return(STATUS_IDLE_ERROR); }
+    }
+  #endif
+  return(protocol_execute_line(line, client));
+}
+
+
+// Выполнить строку от хоста, из порта или из кадра. Возвращает статус выполнения.
+static uint8_t protocol_execute_host_line(char *line, uint8_t client)
+{
+  #if defined(ENABLE_GCODE_TOKENS) && defined(ENABLE_JOB_STORE)
+    uint8_t job_state = job_store_state();
+  #endif
+  uint8_t status_code = protocol_dispatch_host_line(line, client);
+  #ifdef ENABLE_GCODE_TOKENS
+    if (status_code != STATUS_OK) { protocol_token_reject(); }
+    #ifdef ENABLE_JOB_STORE
+      // Задание кодируется отдельно от потока хоста: начало и конец загрузки или выполнения сбрасывают опорные значения.
+      if (job_store_state() != job_state) { gc_token_reset(); }
+    #endif
+  #endif
+  return(status_code);
+}
+
+
+#ifdef ENABLE_SERIAL_FRAMING
+// Выполнить кадр из очереди: строку или строку растра.
+static uint8_t protocol_execute_frame(char *payload, uint8_t type, uint16_t length)
+{
+  if (type == FRAME_TYPE_SCANLINE) {
+    #ifdef ENABLE_RASTER
+      #ifdef ENABLE_JOB_STORE
+        // Строки растра не сохраняются в задание и не смешиваются с его выполнением.
+        if (job_store_state() != JOB_STORE_IDLE) { return(STATUS_JOB_STORE_BUSY); }
+      #endif
+      if (sys.state & (STATE_ALARM | STATE_JOG)) { return(STATUS_SYSTEM_GC_LOCK); } // Как для g-code.
+      return(raster_execute_scanline((uint8_t *)payload, length));
+    #else
+      return(STATUS_GCODE_UNSUPPORTED_COMMAND);
+    #endif
+  }
+  return(protocol_execute_host_line(payload, CLIENT_SERIAL));
+}
+#endif
+
 
 /*
   ГЛАВНЫЙ ЦИКЛ GRBL:
@@ -66,6 +185,12 @@ void protocol_main_loop(char* line, uint8_t* line_flags)
 
   uint8_t char_counter = 0;
   uint8_t client = CLIENT_SERIAL;
+  #ifdef ENABLE_SERIAL_FRAMING
+    char *frame_line;
+    uint8_t frame_seq;
+    uint8_t frame_type;
+    uint16_t frame_length;
+  #endif
   for (;;) {
     // Обработать одну строку входящих последовательных данных, по мере их поступления.
     // Выполняет начальную фильтрацию: удаляет пробелы и комментарии, приводит буквы к верхнему регистру.
@@ -81,25 +206,56 @@ void protocol_main_loop(char* line, uint8_t* line_flags)
           // Направить и выполнить одну строку форматированного ввода и сообщить статус выполнения.
           if (*line_flags & LINE_FLAG_OVERFLOW) {
             // Сообщить об ошибке переполнения строки.
-            report_status_message(STATUS_OVERFLOW, client);
-          } else if (line[0] == 0) {
-            // Пустая строка или строка комментария. Для целей синхронизации.
-            report_status_message(STATUS_OK, client);
-          } else if (line[0] == '$') {
-            // Системная команда Grbl '$'
-            report_status_message(system_execute_line(line, client), client);
-          } else if (sys.state & (STATE_ALARM | STATE_JOG)) {
-            // Всё остальное — gcode. Блокировать, если в режиме тревоги или JOG.
-            report_status_message(STATUS_SYSTEM_GC_LOCK, client);
+            #ifdef ENABLE_GCODE_TOKENS
+              protocol_token_reject();
+            #endif
+            protocol_report_line_status(STATUS_OVERFLOW, client);
           } else {
-            // Разобрать и выполнить g-code блок.
-            report_status_message(gc_execute_line(line, client), client);
+            protocol_report_line_status(protocol_execute_host_line(line, client), client);
           }
           char_counter = 0;
         // else {
         // }
         delay(0);
     }
+    #ifdef ENABLE_SERIAL_FRAMING
+      else if ((frame_line = frame_read_line(&frame_seq, &frame_type, &frame_length)) != NULL) {
+        // Строка из кадра. Статус возвращается кадром ACK вместо ok/error.
+        frame_send_ack(frame_seq, protocol_execute_frame(frame_line, frame_type, frame_length));
+      }
+    #endif
+    #ifdef ENABLE_JOB_STORE
+      else if (job_store_state() == JOB_STORE_RUN) {
+        // Нет строки из порта: выполнить следующую строку сохранённого задания. Ответ ok на каждую
+        // строку не отправляется, сообщаются только ошибки, которые останавливают задание.
+        if (job_store_read_line(job_line)) {
+          uint8_t status_code = protocol_execute_line(job_line, CLIENT_SERIAL);
+          if (status_code != STATUS_OK) {
+            report_status_message(status_code, CLIENT_SERIAL);
+            job_store_stop();
+            #ifdef ENABLE_GCODE_TOKENS
+              gc_token_reset(); // Опорные значения задания не относятся к потоку хоста.
+            #endif
+            report_feedback_message(MESSAGE_JOB_STOPPED);
+          }
+        } else {
+          job_store_stop();
+          #ifdef ENABLE_GCODE_TOKENS
+            gc_token_reset();
+          #endif
+          report_feedback_message(MESSAGE_JOB_DONE);
+        }
+      }
+      job_store_prefetch(); // Подготовить следующий блок задания, пока ждём.
+    #endif
+    #ifdef ENABLE_SERIAL_FRAMING
+      frame_service(); // Отправить NAK и повторные ACK, запрошенные приёмником кадров.
+    #endif
+    #ifdef ENABLE_ACK_BATCHING
+      // Строк больше нет, и следующая не принимается: отправить накопленные ok, чтобы хост,
+      // считающий символы в буфере, не ждал их.
+      if (!(*line_flags & (LINE_FLAG_LINE_READ | LINE_FLAG_LINE_STARTED))) { report_ack_flush(); }
+    #endif
 
     // Если в буфере последовательного порта больше нет символов для обработки и выполнения,
     // это означает, что поток g-code либо заполнил буфер планировщика, либо завершён.
@@ -108,6 +264,14 @@ void protocol_main_loop(char* line, uint8_t* line_flags)
 
     protocol_execute_realtime();  // Точка проверки команд реального времени.
     if (sys.abort) { return; } // Выход в main() для сброса системы.
+
+    // Настройки меняются только в ОЗУ. Программирование и стирание EEPROM останавливают процессор,
+    // поэтому изменения записываются, когда станок стоит и следующая строка не принимается. Так
+    // пачка команд '$' записывается одной фиксацией.
+    if (((sys.state == STATE_IDLE) || (sys.state == STATE_ALARM)) && !(*line_flags & (LINE_FLAG_LINE_READ | LINE_FLAG_LINE_STARTED))) {
+      eeprom_store_commit();
+      eeprom_store_compact();
+    }
     delay(0);
   }
 
@@ -122,11 +286,14 @@ void protocol_buffer_synchronize()
 {
   // Если система в очереди, убедиться, что цикл возобновится, если установлен флаг автозапуска.
   protocol_auto_cycle_start();
+  #ifdef ENABLE_ACK_BATCHING
+    report_ack_flush(); // Ожидание может быть долгим. Хост не должен ждать ok уже выполненных строк.
+  #endif
   do {
     protocol_execute_realtime();   // Проверить и выполнить команды реального времени
     if (sys.abort) { return; } // Проверить системное прерывание
     delay(0);
-  } while (plan_get_current_block() || (sys.state == STATE_CYCLE));
+  } while (plan_get_current_block() || (sys.state == STATE_CYCLE) || mc_queue_pending());
 }
 
 
@@ -161,8 +328,19 @@ void protocol_auto_cycle_start()
 // концевыми выключателями или главной программой.
 void protocol_execute_realtime()
 {
+  #ifdef ENABLE_ACK_BATCHING
+    // Буфер планировщика заполнен: разбор ждёт места. Отправить накопленные ok, чтобы хост
+    // продолжал заполнять буфер приёма, пока Grbl ждёт.
+    if (plan_check_full_buffer()) { report_ack_flush(); }
+  #endif
   protocol_exec_rt_system();
   if (sys.suspend) { protocol_exec_rt_suspend(); }
+  // Подать в планировщик разобранные заранее перемещения и сегменты дуги. Не во время поиска нуля,
+  // парковки и сброса. STATE_IDLE равен нулю, поэтому проверяется отдельно.
+  if (!sys.abort && !sys.suspend &&
+      ((sys.state == STATE_IDLE) || (sys.state & (STATE_CYCLE | STATE_HOLD | STATE_JOG)))) {
+    mc_queue_service();
+  }
 }
 
 // Выполняет команды реального времени, когда это необходимо. Эта функция в основном работает
@@ -350,6 +528,7 @@ void protocol_exec_rt_system()
         if (sys.suspend & SUSPEND_JOG_CANCEL) {   // Для отмены JOG очистить буферы и синхронизировать позиции.
           sys.step_control = STEP_CONTROL_NORMAL_OP;
           plan_reset();
+          mc_queue_reset();
           st_reset();
           gc_sync_position();
           plan_sync_position();
@@ -464,6 +643,10 @@ void protocol_exec_rt_system()
     st_prep_buffer();
   }
 
+  #ifdef ENABLE_AUTO_REPORT
+    report_auto_service(); // После подготовки сегментов, чтобы отчёт не задерживал движение.
+  #endif
+
 }
 
 
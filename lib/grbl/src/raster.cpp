@@ -0,0 +1,185 @@
+/*
+  raster.c - raster engraving from binary scanline frames
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "grbl.hpp"
+
+#ifdef ENABLE_RASTER
+
+// Pixel PWM values of the scanlines in the planner. Filled by the main loop at raster_head, and
+// released in order by the stepper interrupt at raster_tail, once their last pixel is done. Both
+// are slot indices, and raster_count the slots in use, so any slot count works.
+static uint16_t raster_pwm[RASTER_SCANLINE_SLOTS][RASTER_PIXELS_MAX];
+static uint16_t raster_pixels[RASTER_SCANLINE_SLOTS];
+static uint8_t raster_head;
+static volatile uint8_t raster_tail;
+static volatile uint8_t raster_count;
+
+// Scan end of the last frame, in machine coordinates, when it had RASTER_FLAG_CONTINUED.
+static uint8_t raster_continued;
+static uint8_t raster_continued_flags;
+static float raster_end[N_AXIS];
+
+
+void raster_reset()
+{
+  raster_head = 0;
+  raster_tail = 0;
+  raster_count = 0;
+  raster_continued = false;
+}
+
+
+uint16_t raster_slot_pixels(uint8_t slot) { return(raster_pixels[slot-1]); }
+
+uint16_t *raster_slot_pwm(uint8_t slot) { return(raster_pwm[slot-1]); }
+
+void raster_slot_done()
+{
+  if (++raster_tail == RASTER_SCANLINE_SLOTS) { raster_tail = 0; }
+  raster_count--;
+}
+
+
+static float raster_read_float(uint8_t *data)
+{
+  float value;
+  memcpy(&value, data, sizeof(float)); // Unaligned in the frame.
+  return(value);
+}
+
+
+// Waits for a free slot and fills it with the PWM values of the pixels. Returns the slot number.
+static uint8_t raster_queue_pixels(uint8_t *pixel, uint16_t pixels, float power)
+{
+  while (raster_count == RASTER_SCANLINE_SLOTS) {
+    protocol_auto_cycle_start(); // Slots are freed only as scanlines are executed.
+    protocol_execute_realtime();
+    if (sys.abort) { return(RASTER_SLOT_NONE); } // Bail, if system abort.
+    delay(0);
+  }
+  uint8_t idx = raster_head;
+  float power_per_value = power*(0.010*sys.spindle_speed_ovr)/255.0; // Spindle override, as when executed.
+  uint16_t n;
+  for (n=0; n<pixels; n++) { raster_pwm[idx][n] = spindle_rpm_to_pwm(pixel[n]*power_per_value); }
+  raster_pixels[idx] = pixels;
+  if (++raster_head == RASTER_SCANLINE_SLOTS) { raster_head = 0; }
+  HAL_IRQ_DisableInterrupts(); // raster_count is shared with the stepper ISR.
+  raster_count++;
+  HAL_IRQ_EnableInterrupts();
+  return(idx+1);
+}
+
+
+uint8_t raster_execute_scanline(uint8_t *data, uint16_t length)
+{
+  if (bit_isfalse(settings.flags, BITFLAG_LASER_MODE)) { return(STATUS_RASTER_LASER_MODE); }
+  if ((length <= RASTER_HEADER_SIZE) || (length > (RASTER_HEADER_SIZE+RASTER_PIXELS_MAX))) {
+    return(STATUS_RASTER_INVALID_SCANLINE);
+  }
+  uint8_t flags = data[0];
+  uint8_t axis = (flags & RASTER_FLAG_AXIS_Y) ? Y_AXIS : X_AXIS;
+  float direction = (flags & RASTER_FLAG_REVERSE) ? -1.0 : 1.0;
+  float start_x = raster_read_float(&data[1]);
+  float start_y = raster_read_float(&data[5]);
+  float pitch = raster_read_float(&data[9]);
+  float feed_rate = raster_read_float(&data[13]);
+  float power = raster_read_float(&data[17]);
+  uint16_t pixels = length-RASTER_HEADER_SIZE;
+  // Comparisons are written to fail on NaN. A pixel must be at least one step, so that every pixel
+  // is burnt.
+  if (!isfinite(start_x) || !isfinite(start_y) || !(feed_rate > 0.0) || !(power >= 0.0) ||
+      !(pitch*settings.steps_per_mm[axis] >= 1.0)) {
+    return(STATUS_RASTER_INVALID_SCANLINE);
+  }
+
+  // A continuation starts at the end of the previous frame, if nothing has moved the parser since.
+  uint8_t continued = false;
+  if (raster_continued) {
+    raster_continued = false;
+    if (((flags ^ raster_continued_flags) & (RASTER_FLAG_AXIS_Y | RASTER_FLAG_REVERSE)) == 0 &&
+        (memcmp(raster_end, gc_state.position, sizeof(raster_end)) == 0)) {
+      continued = true;
+    }
+  }
+  float start[N_AXIS];
+  memcpy(start, gc_state.position, sizeof(start));
+  if (!continued) {
+    start[X_AXIS] = start_x + gc_state.coord_system[X_AXIS] + gc_state.coord_offset[X_AXIS];
+    start[Y_AXIS] = start_y + gc_state.coord_system[Y_AXIS] + gc_state.coord_offset[Y_AXIS];
+  }
+  float end[N_AXIS];
+  memcpy(end, start, sizeof(end));
+  end[axis] += direction*(pixels*pitch);
+  if (lround(start[axis]*settings.steps_per_mm[axis]) == lround(end[axis]*settings.steps_per_mm[axis])) {
+    return(STATUS_RASTER_INVALID_SCANLINE); // Would be an empty block, which never releases its slot.
+  }
+  // Distance to reach the feed rate from a stop at the axis acceleration, v^2/(2a).
+  float overscan = (feed_rate*feed_rate)/(2.0*settings.acceleration[axis]);
+
+  // The laser is driven as in M4, whatever the spindle state: rate adjusted, so it is off at S0 on
+  // the overscan and when the motion stops. Coolant and outputs stay as the parser has them.
+  plan_line_data_t plan_data;
+  plan_line_data_t *pl_data = &plan_data;
+  memset(pl_data,0,sizeof(plan_line_data_t));
+  pl_data->condition = (PL_COND_FLAG_SPINDLE_CCW | gc_state.modal.coolant);
+  #ifdef USE_LINE_NUMBERS
+    pl_data->line_number = gc_state.line_number;
+  #endif
+
+  float target[N_AXIS];
+  if (!continued) {
+    // Rapid to the overscan start, then ramp up to the feed rate before the first pixel.
+    memcpy(target, start, sizeof(target));
+    target[axis] -= direction*overscan;
+    pl_data->condition |= PL_COND_FLAG_RAPID_MOTION;
+    mc_line(target, pl_data);
+    pl_data->condition &= ~PL_COND_FLAG_RAPID_MOTION;
+    pl_data->feed_rate = feed_rate;
+    pl_data->condition |= PL_COND_FLAG_NO_FEED_OVERRIDE;
+    mc_line(start, pl_data);
+  }
+
+  // The scan. Its pixels are stepped through by the stepper interrupt. In check mode the motions are
+  // only checked against the soft limits, and no slot is taken.
+  pl_data->feed_rate = feed_rate;
+  pl_data->condition |= PL_COND_FLAG_NO_FEED_OVERRIDE;
+  pl_data->spindle_speed = power;
+  if (sys.state != STATE_CHECK_MODE) {
+    pl_data->raster_slot = raster_queue_pixels(&data[RASTER_HEADER_SIZE], pixels, power);
+    if (sys.abort) { return(STATUS_OK); }
+  }
+  mc_line(end, pl_data);
+
+  if (flags & RASTER_FLAG_CONTINUED) {
+    raster_continued = true;
+    raster_continued_flags = flags;
+    memcpy(raster_end, end, sizeof(raster_end));
+    memcpy(gc_state.position, end, sizeof(end));
+  } else {
+    // Ramp down past the last pixel.
+    memcpy(target, end, sizeof(target));
+    target[axis] += direction*overscan;
+    pl_data->spindle_speed = 0.0;
+    pl_data->raster_slot = RASTER_SLOT_NONE;
+    mc_line(target, pl_data);
+    memcpy(gc_state.position, target, sizeof(target));
+  }
+  return(STATUS_OK);
+}
+
+#endif
@@ -0,0 +1,65 @@
+/*
+  raster.h - raster engraving from binary scanline frames
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef raster_h
+#define raster_h
+
+// Scanline frame payload (FRAME_TYPE_SCANLINE). Floats are IEEE single precision, little-endian.
+//   byte  0      Flags. See below.
+//   bytes 1-4    X of the scan start, in mm work coordinates.
+//   bytes 5-8    Y of the scan start.
+//   bytes 9-12   Pixel pitch along the scan axis, in mm. At least one step.
+//   bytes 13-16  Feed rate, in mm/min.
+//   bytes 17-20  Power of pixel value 255, in spindle speed units (S). Pixel p is burnt at power*p/255.
+//   bytes 21-    Pixel values, one byte each in scan order. 1 to RASTER_PIXELS_MAX pixels.
+// The scan starts at the edge of the first pixel and runs pixels*pitch mm along the scan axis, at the
+// feed rate. Grbl adds the overscan at both ends, the distance to reach the feed rate from a stop: a
+// rapid to the overscan start, a ramp up to the scan start and a ramp down past the scan end, all
+// with the laser off. So the overscan must fit within the soft limits. Units are always mm, whatever
+// G20/G21, and the other axes stay where they are. Feed override does not apply to scanlines. Spindle
+// override does, at its value when the frame is executed.
+#define RASTER_HEADER_SIZE 21
+#define RASTER_PIXELS_MAX  (LINE_BUFFER_SIZE-1-RASTER_HEADER_SIZE)
+
+#define RASTER_FLAG_AXIS_Y    bit(0) // Scan along Y. Otherwise along X.
+#define RASTER_FLAG_REVERSE   bit(1) // Scan in the negative direction.
+#define RASTER_FLAG_CONTINUED bit(2) // The scan goes on in the next frame, with no overscan between.
+// A scanline longer than one frame is sent as frames with RASTER_FLAG_CONTINUED, except the last.
+// The next frame then starts where the previous one ended, and its start point is ignored. Its
+// flags must give the same axis and direction. Continuation frames must arrive in time, otherwise
+// the planner stops at the end of the last queued frame. Pixel power is scaled down with the speed,
+// as in M4, but the stop still shows in the burn.
+
+#define RASTER_SLOT_NONE 0 // Raster slot of ordinary motions, so zeroed planner data is not raster.
+
+
+// Plans the motions of a scanline frame and queues its pixels. Returns a status code.
+uint8_t raster_execute_scanline(uint8_t *data, uint16_t length);
+
+// Releases all queued scanlines. Called on reset, along with the planner buffer.
+void raster_reset();
+
+// Stepper interface. Each scanline in the planner carries a slot, 1 to RASTER_SCANLINE_SLOTS,
+// holding the PWM output value of each pixel.
+uint16_t raster_slot_pixels(uint8_t slot);
+uint16_t *raster_slot_pwm(uint8_t slot);
+
+// Releases the slot of the oldest scanline. Called by the stepper interrupt after its last pixel.
+void raster_slot_done();
+
+#endif
@@ -236,25 +236,141 @@ void grbl_msg_sendf(uint8_t client, uint8_t level, const char *format, ...) {
 
 // Internal report utilities to reduce flash with repetitive tasks turned into functions.
 
-// formats axis values into a string and returns that string in rpt
-static void report_util_axis_values(float *axis_value, char *rpt) {
+// Bounded append writer. Reports are built in one pass into a local buffer and sent with one
+// grbl_send(). Characters past the end of the buffer are dropped, so an oversized report is cut
+// short instead of overrunning the stack.
+typedef struct {
+  char *cursor; // Next free character.
+  char *end;    // Last character of the buffer, kept for the terminating 0.
+} report_buffer_t;
+
+static void report_buffer_init(report_buffer_t *rb, char *buf, uint16_t size)
+{
+  rb->cursor = buf;
+  rb->end = buf + size - 1;
+}
+
+// Terminates the string. The buffer is then ready for grbl_send().
+static void report_buffer_finish(report_buffer_t *rb) { *rb->cursor = 0; }
+
+static void report_buffer_char(report_buffer_t *rb, char c)
+{
+  if (rb->cursor < rb->end) { *rb->cursor++ = c; }
+}
+
+static void report_buffer_string(report_buffer_t *rb, const char *s)
+{
+  while (*s && (rb->cursor < rb->end)) { *rb->cursor++ = *s++; }
+}
+
+static void report_buffer_chars(report_buffer_t *rb, const char *s, uint8_t length)
+{
+  while (length-- && (rb->cursor < rb->end)) { *rb->cursor++ = *s++; }
+}
+
+static void report_buffer_uint32(report_buffer_t *rb, uint32_t n)
+{
+  char number[PRINT_FLOAT_SIZE];
+  report_buffer_chars(rb, number, print_fixed_to_buffer(number, n, 0));
+}
+
+static void report_buffer_int32(report_buffer_t *rb, int32_t n)
+{
+  if (n < 0) {
+    report_buffer_char(rb, '-');
+    report_buffer_uint32(rb, -(uint32_t)n);
+  } else {
+    report_buffer_uint32(rb, n);
+  }
+}
+
+// Writes the N_AXIS step counts, comma separated.
+static void report_buffer_steps(report_buffer_t *rb, const int32_t *steps)
+{
   uint8_t idx;
-  float unit_conv = 1.0; // unit conversion multiplier..default is mm
+  for (idx=0; idx<N_AXIS; idx++) {
+    report_buffer_int32(rb, steps[idx]);
+    if (idx < (N_AXIS-1)) { report_buffer_char(rb, ','); }
+  }
+}
 
+// Writes a value already scaled to units of 10^-decimal_places, rounded as printFloat() rounds.
+static void report_buffer_scaled(report_buffer_t *rb, float n, uint8_t decimal_places)
+{
+  char number[PRINT_FLOAT_SIZE];
+  report_buffer_chars(rb, number, print_scaled_to_buffer(number, n, decimal_places));
+}
+
+static void report_buffer_float(report_buffer_t *rb, float n, uint8_t decimal_places)
+{
+  report_buffer_scaled(rb, n * print_pow10[decimal_places], decimal_places);
+}
+
+// Coordinates are reported with N_DECIMAL_COORDVALUE_INCH or _MM digits after the point. Returns
+// that count and the report units per mm in *units_per_mm.
+static uint8_t report_coord_units(float *units_per_mm)
+{
   if (bit_istrue(settings.flags,BITFLAG_REPORT_INCHES)) {
-    unit_conv = 1.0 / MM_PER_INCH;
+    *units_per_mm = print_pow10[N_DECIMAL_COORDVALUE_INCH] * INCH_PER_MM;
+    return(N_DECIMAL_COORDVALUE_INCH);
   }
+  *units_per_mm = print_pow10[N_DECIMAL_COORDVALUE_MM];
+  return(N_DECIMAL_COORDVALUE_MM);
+}
 
+// Writes the N_AXIS values, comma separated, in the report units.
+static void report_buffer_axis_values(report_buffer_t *rb, float *axis_value)
+{
+  float units_per_mm;
+  uint8_t decimals = report_coord_units(&units_per_mm);
+  uint8_t idx;
   for (idx=0; idx<N_AXIS; idx++) {
-    if (bit_istrue(settings.flags,BITFLAG_REPORT_INCHES)) {
-      printFloat(axis_value[idx] * unit_conv,4);
-    } else {
-      printFloat(axis_value[idx] * unit_conv,3);
-    }
+    report_buffer_scaled(rb, axis_value[idx] * units_per_mm, decimals);
+    if (idx < (N_AXIS-1)) { report_buffer_char(rb, ','); }
+  }
+}
 
-    if (idx < (N_AXIS-1)) {
-      grbl_send(CLIENT_SERIAL,","); 
-    }
+// Report units per step of each axis. A step count becomes the report's integer digits with one
+// multiply, instead of a divide by steps/mm and a multiply per decimal pair. Recomputed when the
+// steps/mm or the report units change.
+static float report_step_units[N_AXIS];
+static float report_step_units_spm[N_AXIS]; // steps_per_mm the scales were computed from.
+static uint8_t report_step_units_inches = 0xFF; // Report units they were computed for. None yet.
+
+static uint8_t report_update_step_units(float *units_per_mm)
+{
+  uint8_t decimals = report_coord_units(units_per_mm);
+  uint8_t inches = bit_istrue(settings.flags,BITFLAG_REPORT_INCHES);
+  if ((inches != report_step_units_inches) ||
+      memcmp(report_step_units_spm, settings.steps_per_mm, sizeof(report_step_units_spm))) {
+    uint8_t idx;
+    for (idx=0; idx<N_AXIS; idx++) { report_step_units[idx] = *units_per_mm / settings.steps_per_mm[idx]; }
+    memcpy(report_step_units_spm, settings.steps_per_mm, sizeof(report_step_units_spm));
+    report_step_units_inches = inches;
+  }
+  return(decimals);
+}
+
+// Writes the machine position of a step vector, less offset (mm) when offset isn't NULL, as
+// N_AXIS comma separated values in the report units.
+static void report_buffer_axis_steps(report_buffer_t *rb, int32_t *steps, float *offset)
+{
+  float units_per_mm;
+  uint8_t decimals = report_update_step_units(&units_per_mm);
+  uint8_t idx;
+  for (idx=0; idx<N_AXIS; idx++) {
+    int32_t axis_steps;
+    #ifdef COREXY
+      if (idx==X_AXIS) { axis_steps = system_convert_corexy_to_x_axis_steps(steps); }
+      else if (idx==Y_AXIS) { axis_steps = system_convert_corexy_to_y_axis_steps(steps); }
+      else { axis_steps = steps[idx]; }
+    #else
+      axis_steps = steps[idx];
+    #endif
+    float n = axis_steps * report_step_units[idx];
+    if (offset) { n -= offset[idx] * units_per_mm; }
+    report_buffer_scaled(rb, n, decimals);
+    if (idx < (N_AXIS-1)) { report_buffer_char(rb, ','); }
   }
 }
 
@@ -274,6 +390,56 @@ void report_status_message(uint8_t status_code, uint8_t client)
   }
 }
 
+
+#ifdef ENABLE_ACK_BATCHING
+static uint8_t ack_batch;         // Lines per ok:N. Zero for one plain ok per line.
+static uint8_t ack_batch_next;    // Set by $A=N. Takes effect after the ok of the $A line itself.
+static uint8_t ack_pending;       // Lines executed and not acknowledged yet.
+static uint32_t ack_line_count;   // Lines acknowledged since $A=N. Numbers the error responses.
+
+void report_ack_init()
+{
+  ack_batch = 0;
+  ack_batch_next = 0;
+  ack_pending = 0;
+}
+
+void report_ack_request(uint8_t count)
+{
+  ack_batch_next = (count > 1) ? count : 0; // $A=1 is the same as one ok per line.
+}
+
+void report_ack_flush()
+{
+  if (ack_pending) {
+    grbl_sendf(CLIENT_SERIAL, "ok:%d\r\n", ack_pending);
+    ack_pending = 0;
+  }
+}
+
+// Responds to a streamed line, in batches when negotiated with $A=N. Replaces
+// report_status_message() for the serial line stream.
+void report_line_status(uint8_t status_code, uint8_t client)
+{
+  if (ack_batch) {
+    ack_line_count++;
+    if (status_code == STATUS_OK) {
+      if (++ack_pending >= ack_batch) { report_ack_flush(); }
+    } else {
+      report_ack_flush(); // Keep responses in line order.
+      grbl_sendf(client, "error:%d:%lu\r\n", status_code, (unsigned long)ack_line_count);
+    }
+  } else {
+    report_status_message(status_code, client);
+  }
+  if (ack_batch_next != ack_batch) {
+    report_ack_flush();
+    ack_batch = ack_batch_next;
+    ack_line_count = 0;
+  }
+}
+#endif
+
 // Prints alarm messages.
 void report_alarm_message(uint8_t alarm_code)
 {
@@ -312,6 +478,10 @@ void report_feedback_message(uint8_t message_code)
       grbl_msg_sendf(CLIENT_SERIAL, MSG_LEVEL_INFO, "Restoring spindle");; break;
     case MESSAGE_SLEEP_MODE:
       grbl_msg_sendf(CLIENT_SERIAL, MSG_LEVEL_INFO, "Sleeping"); break;
+    case MESSAGE_JOB_DONE:
+      grbl_msg_sendf(CLIENT_SERIAL, MSG_LEVEL_INFO, "Job done"); break;
+    case MESSAGE_JOB_STOPPED:
+      grbl_msg_sendf(CLIENT_SERIAL, MSG_LEVEL_INFO, "Job stopped"); break;
   }
 }
 
@@ -323,7 +493,7 @@ void report_init_message(uint8_t client)
 
 // Grbl help message
 void report_grbl_help(uint8_t client) {
-  grbl_send(client,"[HLP:$$ $+ $# $G $I $N $x=val $Nx=line $J=line $SLP $C $X $H ~ ! ? ctrl-x]\r\n");
+  grbl_send(client,"[HLP:$$ $+ $# $G $I $N $x=val $Nx=line $J=line $SLP $SAVE $C $X $H ~ ! ? ctrl-x]\r\n");
 }
 
 // Grbl global settings print out.
@@ -388,21 +558,19 @@ void report_grbl_settings(uint8_t client) {
 void report_probe_parameters(uint8_t client)
 {
   // Report in terms of machine position.
-  float print_position[N_AXIS];
   char probe_rpt[120];	// the probe report we are building here
-  char temp[60];
+  report_buffer_t rb;
+  report_buffer_init(&rb, probe_rpt, sizeof(probe_rpt));
 
-  strcpy(probe_rpt, "[PRB:"); // initialize the string with the first characters
-
-  // get the machine position and put them into a string and append to the probe report
-  system_convert_array_steps_to_mpos(print_position,sys_probe_position);
-  report_util_axis_values(print_position, temp);
-  strcat(probe_rpt, temp);
+  report_buffer_string(&rb, "[PRB:");
+  report_buffer_axis_steps(&rb, sys_probe_position, NULL);
 
   // add the success indicator and add closing characters
-  xsprintf(temp, ":%d]\r\n", sys.probe_succeeded);
-  strcat(probe_rpt, temp);
+  report_buffer_char(&rb, ':');
+  report_buffer_uint32(&rb, sys.probe_succeeded);
+  report_buffer_string(&rb, "]\r\n");
 
+  report_buffer_finish(&rb);
   grbl_send(client, probe_rpt); // send the report
 }
 
@@ -411,43 +579,36 @@ void report_ngc_parameters(uint8_t client)
 {
   float coord_data[N_AXIS];
   uint8_t coord_select;
-  char temp[100];
   char ngc_rpt[1000];
+  report_buffer_t rb;
+  report_buffer_init(&rb, ngc_rpt, sizeof(ngc_rpt));
 
-  ngc_rpt[0] = '\0';
   for (coord_select = 0; coord_select <= SETTING_INDEX_NCOORD; coord_select++) {
     ///delay(0);
     if (!(settings_read_coord_data(coord_select,coord_data))) {
       report_status_message(STATUS_SETTING_READ_FAIL, client);
       return;
     }
-	strcat(ngc_rpt, "[G");
+    report_buffer_string(&rb, "[G");
     switch (coord_select) {
-      case 6: strcat(ngc_rpt, "28"); break;
-      case 7: strcat(ngc_rpt, "30"); break;
-      default:
-        xsprintf(temp, "%d", coord_select+54);
-        strcat(ngc_rpt, temp);
-        break; // G54-G59
+      case 6: report_buffer_string(&rb, "28"); break;
+      case 7: report_buffer_string(&rb, "30"); break;
+      default: report_buffer_uint32(&rb, coord_select+54); break; // G54-G59
     }
-    strcat(ngc_rpt, ":");
-    report_util_axis_values(coord_data, temp);
-    strcat(ngc_rpt, temp);
-    strcat(ngc_rpt, "]\r\n");
+    report_buffer_char(&rb, ':');
+    report_buffer_axis_values(&rb, coord_data);
+    report_buffer_string(&rb, "]\r\n");
   }
 
-  strcat(ngc_rpt, "[G92:"); // Print G92,G92.1 which are not persistent in memory
-  report_util_axis_values(gc_state.coord_offset, temp);
-  strcat(ngc_rpt, temp);
-  strcat(ngc_rpt, "]\r\n");
-  strcat(ngc_rpt, "[TLO:"); // Print tool length offset value
-
-  if (bit_istrue(settings.flags,BITFLAG_REPORT_INCHES)) {
-    printFloat(gc_state.tool_length_offset * INCH_PER_MM,3); grbl_send(client,"]\r\n");
-  } else {
-    printFloat(gc_state.tool_length_offset,3); grbl_send(client,"]\r\n");
-  }
-  strcat(ngc_rpt, temp);
+  report_buffer_string(&rb, "[G92:"); // Print G92,G92.1 which are not persistent in memory
+  report_buffer_axis_values(&rb, gc_state.coord_offset);
+  report_buffer_string(&rb, "]\r\n");
+  report_buffer_string(&rb, "[TLO:"); // Print tool length offset value
+  float units_per_mm;
+  uint8_t decimals = report_coord_units(&units_per_mm);
+  report_buffer_scaled(&rb, gc_state.tool_length_offset * units_per_mm, decimals);
+  report_buffer_string(&rb, "]\r\n");
+  report_buffer_finish(&rb);
   grbl_send(client, ngc_rpt);
   report_probe_parameters(client);
 }
@@ -463,6 +624,8 @@ void report_gcode_modes(uint8_t client)
 
   if (gc_state.modal.motion >= MOTION_MODE_PROBE_TOWARD) {
     xsprintf(temp, "38.%d", gc_state.modal.motion - (MOTION_MODE_PROBE_TOWARD-2));
+  } else if (gc_state.modal.motion == MOTION_MODE_QUADRATIC_SPLINE) {
+    strcpy(temp, "5.1");
   } else {
     xsprintf(temp, "%d", gc_state.modal.motion);
   }
@@ -483,6 +646,9 @@ void report_gcode_modes(uint8_t client)
   xsprintf(temp, " G%d", 94-gc_state.modal.feed_rate);
   strcat(modes_rpt, temp);
 
+  xsprintf(temp, " G%d", 98+gc_state.modal.retract);
+  strcat(modes_rpt, temp);
+
   if (gc_state.modal.program_flow) {
     switch (gc_state.modal.program_flow) {
       case PROGRAM_FLOW_PAUSED: strcat(modes_rpt, " M0"); break;
@@ -605,9 +771,7 @@ void report_build_info(char *line, uint8_t client)
   #ifndef ENABLE_BUILD_INFO_WRITE_COMMAND // NOTE: Shown when disabled.
     strcat(build_info,"I");
   #endif
-  #ifndef FORCE_BUFFER_SYNC_DURING_EEPROM_WRITE // NOTE: Shown when disabled.
-    strcat(build_info,"E");
-  #endif
+  strcat(build_info,"E"); // NOTE: EEPROM writes are deferred and never sync the planner buffer.
   #ifndef FORCE_BUFFER_SYNC_DURING_WCO_CHANGE // NOTE: Shown when disabled.
     strcat(build_info,"W");
   #endif
@@ -617,6 +781,11 @@ void report_build_info(char *line, uint8_t client)
   strcat(build_info,"]\r\n");
   grbl_send(client, build_info); // ok to send to all
 
+  #ifdef REPORT_DIAGNOSTIC_COUNTERS
+    grbl_sendf(client, "[SYNC:%u]\r\n", gc_sync_elided); // Redundant spindle/coolant syncs skipped.
+    grbl_sendf(client, "[ARC:%u,%lu]\r\n", mc_arc_count, mc_arc_segment_count); // Arcs, segments generated.
+  #endif
+
   #ifdef LIMITS_TWO_SWITCHES_ON_AXES
     strcat(build_info,"L");
   #endif
@@ -631,81 +800,146 @@ void report_echo_line_received(char *line, uint8_t client)
 }
 
 
- // Prints real-time data. This function grabs a real-time snapshot of the stepper subprogram
+#define REPORT_STATUS_SIZE 240 // Longest report with every field and 4 axes fits.
+
+// Status report formats built by report_build_status().
+#define REPORT_FORMAT_FULL     0 // Reply to '?'. WCO and overrides refreshed by the report counters.
+#define REPORT_FORMAT_CHANGED  1 // Auto-report. WCO and overrides only when changed since last sent.
+#define REPORT_FORMAT_KEYFRAME 2 // Delta mode. Every field, and the position in steps.
+#define REPORT_FORMAT_DELTA    3 // Delta mode. Changed fields only, position as step deltas.
+
+// Pn and A field letters as bits, in report order.
+#define REPORT_PIN_PROBE        bit(0)
+#define REPORT_PIN_LIMIT(axis)  (bit(1) << (axis)) // X, Y, Z, A
+#define REPORT_PIN_DOOR         bit(5)
+#define REPORT_PIN_RESET        bit(6)
+#define REPORT_PIN_FEED_HOLD    bit(7)
+#define REPORT_PIN_CYCLE_START  bit(8)
+#define REPORT_ACCESSORY_CW     bit(0)
+#define REPORT_ACCESSORY_CCW    bit(1)
+#define REPORT_ACCESSORY_FLOOD  bit(2)
+#define REPORT_ACCESSORY_MIST   bit(3)
+
+// Status report fields as sent. Reports built against the last ones sent include changed fields only.
+typedef struct {
+  char state[8];            // State text, as "Hold:0".
+  int32_t position[N_AXIS]; // Steps
+  float wco[N_AXIS];
+  uint32_t line_number;
+  uint32_t rate;            // FS field in units of its last digit.
+  uint32_t spindle_speed;
+  uint16_t buffer[2];       // Free planner blocks and serial RX bytes.
+  uint16_t pins;            // REPORT_PIN bits.
+  uint8_t ovr[3];           // Feed, rapid and spindle overrides.
+  uint8_t accessory;        // REPORT_ACCESSORY bits.
+} report_fields_t;
+
+static void report_buffer_pins(report_buffer_t *rb, uint16_t pins)
+{
+  static const char letters[] = "PXYZADRHS";
+  uint8_t idx;
+  for (idx=0; letters[idx]; idx++) {
+    if (pins & bit(idx)) { report_buffer_char(rb, letters[idx]); }
+  }
+}
+
+static void report_buffer_accessory(report_buffer_t *rb, uint8_t accessory)
+{
+  static const char letters[] = "SCFM";
+  uint8_t idx;
+  for (idx=0; letters[idx]; idx++) {
+    if (accessory & bit(idx)) { report_buffer_char(rb, letters[idx]); }
+  }
+}
+
+#define report_field_changed(field) (!last || memcmp(&last->field, &now->field, sizeof(now->field)))
+
+ // Builds the real-time status report. This function grabs a real-time snapshot of the stepper subprogram
  // and the actual location of the CNC machine. Users may change the following function to their
  // specific needs, but the desired real-time data report must be as short as possible. This is
  // requires as it minimizes the computational overhead and allows grbl to keep running smoothly,
  // especially during g-code programs with fast, short line segments and high frequency reports (5-20Hz).
-void report_realtime_status(uint8_t client)
+ // The fields are returned in now. For the CHANGED and DELTA formats, last is the fields as last
+ // sent. Returns true if any field differs from last, always for the FULL and KEYFRAME formats.
+static uint8_t report_build_status(report_buffer_t *rb, uint8_t client, uint8_t format,
+                                   const report_fields_t *last, report_fields_t *now)
 {
   uint8_t idx;
-  int32_t current_position[N_AXIS]; // Copy current state of the system position variable
-  memcpy(current_position,sys_position,sizeof(sys_position));
-  float print_position[N_AXIS];
-  char status[200];
-  char temp[80];
-
-  system_convert_array_steps_to_mpos(print_position,current_position);
+  uint8_t delta = (format == REPORT_FORMAT_DELTA);
+  memset(now, 0, sizeof(report_fields_t));
+  st_snapshot_t snapshot; // Position, rate and line number as of the same segment.
+  st_get_snapshot(&snapshot);
+  memcpy(now->position,snapshot.position,sizeof(snapshot.position));
 
   // Report current machine state and sub-states
-  strcpy(status, "<");
+  report_buffer_char(rb, '<');
+  char *state = rb->cursor;
   switch (sys.state) {
-    case STATE_IDLE: strcat(status, "Idle"); break;
-    case STATE_CYCLE: strcat(status, "Run"); break;
+    case STATE_IDLE: report_buffer_string(rb, "Idle"); break;
+    case STATE_CYCLE: report_buffer_string(rb, "Run"); break;
     case STATE_HOLD:
       if (!(sys.suspend & SUSPEND_JOG_CANCEL)) {
-        strcat(status, "Hold:");
-        if (sys.suspend & SUSPEND_HOLD_COMPLETE) { strcat(status, "0"); } // Ready to resume
-        else { strcat(status, "1"); } // Actively holding
+        report_buffer_string(rb, "Hold:");
+        if (sys.suspend & SUSPEND_HOLD_COMPLETE) { report_buffer_char(rb, '0'); } // Ready to resume
+        else { report_buffer_char(rb, '1'); } // Actively holding
         break;
       } // Continues to print jog state during jog cancel.
-    case STATE_JOG: strcat(status, "Jog"); break;
-    case STATE_HOMING: strcat(status, "Home"); break;
-    case STATE_ALARM: strcat(status, "Alarm"); break;
-    case STATE_CHECK_MODE: strcat(status, "Check"); break;
+    case STATE_JOG: report_buffer_string(rb, "Jog"); break;
+    case STATE_HOMING: report_buffer_string(rb, "Home"); break;
+    case STATE_ALARM: report_buffer_string(rb, "Alarm"); break;
+    case STATE_CHECK_MODE: report_buffer_string(rb, "Check"); break;
     case STATE_SAFETY_DOOR:
-      strcat(status, "Door:");
+      report_buffer_string(rb, "Door:");
       if (sys.suspend & SUSPEND_INITIATE_RESTORE) {
-        strcat(status, "3"); // Restoring
+        report_buffer_char(rb, '3'); // Restoring
       } else {
         if (sys.suspend & SUSPEND_RETRACT_COMPLETE) {
           if (sys.suspend & SUSPEND_SAFETY_DOOR_AJAR) {
-            strcat(status, "1"); // Door ajar
+            report_buffer_char(rb, '1'); // Door ajar
           } else {
-            strcat(status, "0");
+            report_buffer_char(rb, '0');
           } // Door closed and ready to resume
         } else {
-          strcat(status, "2"); // Retracting
+          report_buffer_char(rb, '2'); // Retracting
         }
       }
       break;
-    case STATE_SLEEP: strcat(status, "Sleep"); break;
+    case STATE_SLEEP: report_buffer_string(rb, "Sleep"); break;
   }
+  memcpy(now->state, state, rb->cursor - state);
+  uint8_t changed = report_field_changed(state);
 
-  float wco[N_AXIS];
-  if (bit_isfalse(settings.status_report_mask,BITFLAG_RT_STATUS_POSITION_TYPE) ||
-      (sys.report_wco_counter == 0) ) {
-    for (idx=0; idx< N_AXIS; idx++) {
-      // Apply work coordinate offsets and tool length offset to current position.
-      wco[idx] = gc_state.coord_system[idx]+gc_state.coord_offset[idx];
-      if (idx == TOOL_LENGTH_OFFSET_AXIS) { wco[idx] += gc_state.tool_length_offset; }
-      if (bit_isfalse(settings.status_report_mask,BITFLAG_RT_STATUS_POSITION_TYPE)) {
-        print_position[idx] -= wco[idx];
-      }
-    }
+  for (idx=0; idx< N_AXIS; idx++) {
+    // Apply work coordinate offsets and tool length offset to current position.
+    now->wco[idx] = gc_state.coord_system[idx]+gc_state.coord_offset[idx];
+    if (idx == TOOL_LENGTH_OFFSET_AXIS) { now->wco[idx] += gc_state.tool_length_offset; }
   }
-  // Report machine position
-  if (bit_istrue(settings.status_report_mask,BITFLAG_RT_STATUS_POSITION_TYPE)) {
-    strcat(status, "|MPos:");
+  changed |= report_field_changed(position);
+  if (delta) {
+    // Report motor steps moved since the last report.
+    if (report_field_changed(position)) {
+      int32_t steps[N_AXIS];
+      for (idx=0; idx< N_AXIS; idx++) { steps[idx] = now->position[idx] - last->position[idx]; }
+      report_buffer_string(rb, "|D:");
+      report_buffer_steps(rb, steps);
+    }
+  // Report machine position. Step counts are scaled straight to report units.
+  } else if (bit_istrue(settings.status_report_mask,BITFLAG_RT_STATUS_POSITION_TYPE)) {
+    report_buffer_string(rb, "|MPos:");
+    report_buffer_axis_steps(rb, now->position, NULL);
   } else {
+    report_buffer_string(rb, "|WPos:");
 	#ifdef FWD_KINEMATICS_REPORTING
+    float print_position[N_AXIS];
+    system_convert_array_steps_to_mpos(print_position,now->position);
+    for (idx=0; idx< N_AXIS; idx++) { print_position[idx] -= now->wco[idx]; }
 		forward_kinematics(print_position);
+    report_buffer_axis_values(rb, print_position);
+	#else
+    report_buffer_axis_steps(rb, now->position, now->wco);
 	#endif
-    strcat(status, "|WPos:");
   }
-  report_util_axis_values(print_position, temp);
-  strcat(status, temp);
-  
+
   int bufsize = 0;
   // Returns planner and serial read buffer states.
   #ifdef REPORT_FIELD_BUFFER_STATE
@@ -717,114 +951,286 @@ void report_realtime_status(uint8_t client)
     } else {
       bufsize = serial_get_rx_buffer_available(client);
     }
-    xsprintf(temp, "|Bf:%d,%d", plan_get_block_buffer_available(), bufsize);
-    strcat(status, temp);
+    now->buffer[0] = plan_get_block_buffer_available();
+    now->buffer[1] = bufsize;
+    if (!delta || report_field_changed(buffer)) {
+      report_buffer_string(rb, "|Bf:");
+      report_buffer_uint32(rb, now->buffer[0]);
+      report_buffer_char(rb, ',');
+      report_buffer_uint32(rb, now->buffer[1]);
+    }
+    changed |= report_field_changed(buffer);
   }
   #endif
 
   #ifdef USE_LINE_NUMBERS
     #ifdef REPORT_FIELD_LINE_NUMBERS
       // Report current line number
-      plan_block_t * cur_block = plan_get_current_block();
-      if (cur_block != NULL) {
-        uint32_t ln = cur_block->line_number;
-        if (ln > 0) {
-					xsprintf(temp, "|Ln:%d", ln);
-					strcat(status, temp);
-        }
+      if (plan_get_current_block() != NULL) { now->line_number = snapshot.line_number; }
+      // In delta mode a line number of 0 is sent too, as the field has no other way to clear.
+      if (delta ? report_field_changed(line_number) : (now->line_number > 0)) {
+        report_buffer_string(rb, "|Ln:");
+        report_buffer_uint32(rb, now->line_number);
       }
+      changed |= report_field_changed(line_number);
     #endif
   #endif
 
   // Report realtime feed speed
   #ifdef REPORT_FIELD_CURRENT_FEED_SPEED
+    float rate = snapshot.rate;
+    uint8_t rate_decimals = N_DECIMAL_RATEVALUE_MM;
+    if (bit_istrue(settings.flags,BITFLAG_REPORT_INCHES)) {
+      rate *= INCH_PER_MM;
+      rate_decimals = N_DECIMAL_RATEVALUE_INCH;
+    }
+    // Compared as printed, so rate noise below the last digit is no change.
+    now->rate = rate * print_pow10[rate_decimals] + 0.5;
     #ifdef VARIABLE_SPINDLE
-      if (bit_istrue(settings.flags,BITFLAG_REPORT_INCHES)) {
-        grbl_send(client,"|FS:"); printFloat(st_get_realtime_rate(),1); printFloat(sys.spindle_speed / MM_PER_INCH,0);  
-      } else {
-        grbl_send(client,"|FS:"); printFloat(st_get_realtime_rate(),0); printFloat(sys.spindle_speed / MM_PER_INCH,0);  
-      }
-      strcat(status, temp);
-    #else
-      if (bit_istrue(settings.flags,BITFLAG_REPORT_INCHES)) {
-        xsprintf(temp, "|F:%.1f", st_get_realtime_rate() / MM_PER_INCH);
-      } else {
-        xsprintf(temp, "|F:%.0f", st_get_realtime_rate());
-      }
-      strcat(status, temp);
+      now->spindle_speed = sys.spindle_speed * print_pow10[N_DECIMAL_RPMVALUE] + 0.5;
     #endif
+    if (!delta || report_field_changed(rate) || report_field_changed(spindle_speed)) {
+      #ifdef VARIABLE_SPINDLE
+        report_buffer_string(rb, "|FS:");
+      #else
+        report_buffer_string(rb, "|F:");
+      #endif
+      report_buffer_float(rb, rate, rate_decimals);
+      #ifdef VARIABLE_SPINDLE
+        report_buffer_char(rb, ',');
+        report_buffer_float(rb, sys.spindle_speed, N_DECIMAL_RPMVALUE);
+      #endif
+    }
+    changed |= report_field_changed(rate) | report_field_changed(spindle_speed);
   #endif
 
   #ifdef REPORT_FIELD_PIN_STATE
     uint8_t lim_pin_state = limits_get_state();
     uint8_t ctrl_pin_state = system_control_get_state();
-    uint8_t prb_pin_state = probe_get_state();
-    if (lim_pin_state | ctrl_pin_state | prb_pin_state) {
-      strcat(status, "|Pn:");
-      if (prb_pin_state) { strcat(status, "P"); }
-      if (lim_pin_state) {
-        if (bit_istrue(lim_pin_state,bit(X_AXIS))) { strcat(status, "X"); }
-        if (bit_istrue(lim_pin_state,bit(Y_AXIS))) { strcat(status, "Y"); }
-        if (bit_istrue(lim_pin_state,bit(Z_AXIS))) { strcat(status, "Z"); }
-        if (bit_istrue(lim_pin_state,bit(A_AXIS))) { strcat(status, "A"); }
-        // if (bit_istrue(lim_pin_state,bit(B_AXIS))) { strcat(status, "B"); }
-        // if (bit_istrue(lim_pin_state,bit(C_AXIS))) { strcat(status, "C"); }
-        // if (bit_istrue(lim_pin_state,bit(D_AXIS))) { strcat(status, "D"); }
-        // if (bit_istrue(lim_pin_state,bit(E_AXIS))) { strcat(status, "E"); }
-      }
-      if (ctrl_pin_state) {
-        #ifdef ENABLE_SAFETY_DOOR_INPUT_PIN
-          if (bit_istrue(ctrl_pin_state,CONTROL_PIN_INDEX_SAFETY_DOOR)) { strcat(status, "D"); }
-        #endif
-        if (bit_istrue(ctrl_pin_state,CONTROL_PIN_INDEX_RESET)) { strcat(status, "R"); }
-        if (bit_istrue(ctrl_pin_state,CONTROL_PIN_INDEX_FEED_HOLD)) { strcat(status, "H"); }
-        if (bit_istrue(ctrl_pin_state,CONTROL_PIN_INDEX_CYCLE_START)) { strcat(status, "S"); }
-      }
+    if (probe_get_state()) { now->pins |= REPORT_PIN_PROBE; }
+    for (idx=0; idx<4; idx++) { // X, Y, Z, A
+      if (bit_istrue(lim_pin_state,bit(idx))) { now->pins |= REPORT_PIN_LIMIT(idx); }
     }
+    #ifdef ENABLE_SAFETY_DOOR_INPUT_PIN
+      if (bit_istrue(ctrl_pin_state,CONTROL_PIN_INDEX_SAFETY_DOOR)) { now->pins |= REPORT_PIN_DOOR; }
+    #endif
+    if (bit_istrue(ctrl_pin_state,CONTROL_PIN_INDEX_RESET)) { now->pins |= REPORT_PIN_RESET; }
+    if (bit_istrue(ctrl_pin_state,CONTROL_PIN_INDEX_FEED_HOLD)) { now->pins |= REPORT_PIN_FEED_HOLD; }
+    if (bit_istrue(ctrl_pin_state,CONTROL_PIN_INDEX_CYCLE_START)) { now->pins |= REPORT_PIN_CYCLE_START; }
+    // In delta mode an empty Pn field reports that all pins were released.
+    if (delta ? report_field_changed(pins) : (now->pins != 0)) {
+      report_buffer_string(rb, "|Pn:");
+      report_buffer_pins(rb, now->pins);
+    }
+    changed |= report_field_changed(pins);
   #endif
 
+  // The absolute position the following step deltas add to.
+  if (format == REPORT_FORMAT_KEYFRAME) {
+    report_buffer_string(rb, "|St:");
+    report_buffer_steps(rb, now->position);
+  }
+
   #ifdef REPORT_FIELD_WORK_COORD_OFFSET
-    if (sys.report_wco_counter > 0) { sys.report_wco_counter--; }
-    else {
-      if (sys.state & (STATE_HOMING | STATE_CYCLE | STATE_HOLD | STATE_JOG | STATE_SAFETY_DOOR)) {
-        sys.report_wco_counter = (REPORT_WCO_REFRESH_BUSY_COUNT-1); // Reset counter for slow refresh
-      } else { sys.report_wco_counter = (REPORT_WCO_REFRESH_IDLE_COUNT-1); }
-      if (sys.report_ovr_counter == 0) { sys.report_ovr_counter = 1; } // Set override on next report.
-      strcat(status, "|WCO:");
-      report_util_axis_values(wco, temp);
-	  strcat(status, temp);
+    uint8_t report_wco = report_field_changed(wco);
+    changed |= report_wco;
+    if (format == REPORT_FORMAT_FULL) {
+      report_wco = false;
+      if (sys.report_wco_counter > 0) { sys.report_wco_counter--; }
+      else {
+        if (sys.state & (STATE_HOMING | STATE_CYCLE | STATE_HOLD | STATE_JOG | STATE_SAFETY_DOOR)) {
+          sys.report_wco_counter = (REPORT_WCO_REFRESH_BUSY_COUNT-1); // Reset counter for slow refresh
+        } else { sys.report_wco_counter = (REPORT_WCO_REFRESH_IDLE_COUNT-1); }
+        if (sys.report_ovr_counter == 0) { sys.report_ovr_counter = 1; } // Set override on next report.
+        report_wco = true;
+      }
+    }
+    if (report_wco) {
+      report_buffer_string(rb, "|WCO:");
+      report_buffer_axis_values(rb, now->wco);
     }
   #endif
 
   #ifdef REPORT_FIELD_OVERRIDES
-    if (sys.report_ovr_counter > 0) { sys.report_ovr_counter--; }
-    else {
-      if (sys.state & (STATE_HOMING | STATE_CYCLE | STATE_HOLD | STATE_JOG | STATE_SAFETY_DOOR)) {
-        sys.report_ovr_counter = (REPORT_OVR_REFRESH_BUSY_COUNT-1); // Reset counter for slow refresh
-      } else { sys.report_ovr_counter = (REPORT_OVR_REFRESH_IDLE_COUNT-1); }
-      xsprintf(temp, "|Ov:%d,%d,%d", sys.f_override, sys.r_override, sys.spindle_speed_ovr);
-      strcat(status, temp);
-
-      uint8_t sp_state = spindle_get_state();
-      uint8_t cl_state = coolant_get_state();
-      if (sp_state || cl_state) {
-        strcat(status, "|A:");
-        if (sp_state) { // != SPINDLE_STATE_DISABLE
-          if (sp_state == SPINDLE_STATE_CW) { strcat(status, "S"); } // CW
-          else { strcat(status, "C"); } // CCW
-        }
-        if (cl_state & COOLANT_STATE_FLOOD) { strcat(status, "F"); }
-        #ifdef COOLANT_MIST_PIN // TODO Deal with M8 - Flood
-          if (cl_state & COOLANT_STATE_MIST) { strcat(status, "M"); }
-        #endif
+    now->ovr[0] = sys.f_override;
+    now->ovr[1] = sys.r_override;
+    now->ovr[2] = sys.spindle_speed_ovr;
+    uint8_t sp_state = spindle_get_state();
+    uint8_t cl_state = coolant_get_state();
+    if (sp_state) { // != SPINDLE_STATE_DISABLE
+      if (sp_state == SPINDLE_STATE_CW) { now->accessory |= REPORT_ACCESSORY_CW; }
+      else { now->accessory |= REPORT_ACCESSORY_CCW; }
+    }
+    if (cl_state & COOLANT_STATE_FLOOD) { now->accessory |= REPORT_ACCESSORY_FLOOD; }
+    #ifdef COOLANT_MIST_PIN // TODO Deal with M8 - Flood
+      if (cl_state & COOLANT_STATE_MIST) { now->accessory |= REPORT_ACCESSORY_MIST; }
+    #endif
+    uint8_t report_ovr = report_field_changed(ovr);
+    uint8_t report_accessory = report_field_changed(accessory);
+    changed |= report_ovr | report_accessory;
+    if (format == REPORT_FORMAT_FULL) {
+      report_ovr = false;
+      report_accessory = false;
+      if (sys.report_ovr_counter > 0) { sys.report_ovr_counter--; }
+      else {
+        if (sys.state & (STATE_HOMING | STATE_CYCLE | STATE_HOLD | STATE_JOG | STATE_SAFETY_DOOR)) {
+          sys.report_ovr_counter = (REPORT_OVR_REFRESH_BUSY_COUNT-1); // Reset counter for slow refresh
+        } else { sys.report_ovr_counter = (REPORT_OVR_REFRESH_IDLE_COUNT-1); }
+        report_ovr = true;
       }
     }
+    if (!delta) {
+      // Outside delta mode the accessory field follows the overrides, and only when not empty.
+      report_ovr |= report_accessory;
+      report_accessory = report_ovr && now->accessory;
+    }
+    if (report_ovr) {
+      report_buffer_string(rb, "|Ov:");
+      report_buffer_uint32(rb, now->ovr[0]);
+      report_buffer_char(rb, ',');
+      report_buffer_uint32(rb, now->ovr[1]);
+      report_buffer_char(rb, ',');
+      report_buffer_uint32(rb, now->ovr[2]);
+    }
+    if (report_accessory) {
+      report_buffer_string(rb, "|A:");
+      report_buffer_accessory(rb, now->accessory);
+    }
   #endif
 
-  strcat(status, ">\r\n");
+  report_buffer_string(rb, ">\r\n");
+  report_buffer_finish(rb);
+  return(changed);
+}
+
+
+#ifdef ENABLE_DELTA_STATUS_REPORT
+static report_fields_t report_delta_fields; // Fields as last sent in delta mode.
+static uint8_t report_delta_counter;        // Delta reports left until the next keyframe.
+static uint8_t report_delta_active;         // A keyframe was sent since delta mode was enabled.
+
+void report_status_init() { report_delta_active = false; }
+
+// Returns the format of the next report. In delta mode, a keyframe or a delta report.
+static uint8_t report_delta_format(uint8_t format)
+{
+  if (bit_isfalse(settings.status_report_mask,BITFLAG_RT_STATUS_DELTA)) {
+    report_delta_active = false; // Enabling delta mode again starts with a keyframe.
+    return(format);
+  }
+  if (!report_delta_active || (report_delta_counter == 0)) { return(REPORT_FORMAT_KEYFRAME); }
+  return(REPORT_FORMAT_DELTA);
+}
+
+// Makes a sent delta mode report the base of the next one.
+static void report_delta_sent(uint8_t format, const report_fields_t *fields)
+{
+  report_delta_fields = *fields;
+  if (format == REPORT_FORMAT_KEYFRAME) {
+    report_delta_active = true;
+    report_delta_counter = REPORT_DELTA_KEYFRAME_COUNT-1;
+  } else {
+    report_delta_counter--;
+  }
+}
+#endif
+
+
+// Prints the real-time status report, requested with '?'.
+void report_realtime_status(uint8_t client)
+{
+  char status[REPORT_STATUS_SIZE];
+  report_buffer_t rb;
+  report_fields_t fields;
+  uint8_t format = REPORT_FORMAT_FULL;
+  const report_fields_t *last = NULL;
+  #ifdef ENABLE_DELTA_STATUS_REPORT
+    format = report_delta_format(format);
+    if (format == REPORT_FORMAT_DELTA) { last = &report_delta_fields; }
+  #endif
+  report_buffer_init(&rb, status, sizeof(status));
+  report_build_status(&rb, client, format, last, &fields);
   grbl_send(client, status);
+  #ifdef ENABLE_DELTA_STATUS_REPORT
+    if (format != REPORT_FORMAT_FULL) { report_delta_sent(format, &fields); }
+  #endif
 }
 
+
+#ifdef ENABLE_AUTO_REPORT
+static volatile uint8_t auto_report_due;      // Set by the timer interrupt.
+static uint16_t auto_report_interval;         // Milliseconds. Zero when off.
+static report_fields_t auto_report_fields;    // Fields as last auto-reported.
+static uint8_t auto_report_sent;              // auto_report_fields is valid.
+#ifdef ELRON_ACE_UNO
+  static TIMER32_HandleTypeDef auto_report_timer;
+#endif
+
+void report_auto_init() { report_auto_set_interval(0); }
+
+void report_auto_set_interval(uint16_t interval)
+{
+  auto_report_interval = interval;
+  auto_report_due = false;
+  auto_report_sent = false; // The next auto-report is sent in full.
+  #ifdef ELRON_ACE_UNO
+    if (auto_report_timer.Instance) { HAL_Timer32_Stop(&auto_report_timer); }
+    if (interval == 0) { return; }
+    auto_report_timer.Instance = AUTO_REPORT_TIMER;
+    auto_report_timer.Top = (F_CPU/1000)*(uint32_t)interval - 1;
+    auto_report_timer.State = TIMER32_STATE_DISABLE;
+    auto_report_timer.Clock.Source = TIMER32_SOURCE_PRESCALER;
+    auto_report_timer.Clock.Prescaler = 0;
+    auto_report_timer.InterruptMask = 0;
+    auto_report_timer.CountMode = TIMER32_COUNTMODE_FORWARD;
+    HAL_Timer32_Init(&auto_report_timer);
+    HAL_Timer32_InterruptMask_Set(&auto_report_timer, TIMER32_INT_OVERFLOW_M);
+    HAL_Timer32_Value_Clear(&auto_report_timer);
+    HAL_EPIC_MaskLevelSet(AUTO_REPORT_TIMER_EPIC_MASK);
+    HAL_Timer32_Start(&auto_report_timer);
+  #endif
+}
+
+uint16_t report_auto_get_interval() { return(auto_report_interval); }
+
+void report_auto_timer_isr()
+{
+  #ifdef ELRON_ACE_UNO
+    HAL_TIMER32_INTERRUPTFLAGS_CLEAR(&auto_report_timer);
+  #endif
+  auto_report_due = true;
+}
+
+void report_auto_service()
+{
+  if (!auto_report_due) { return; }
+  auto_report_due = false;
+  char status[REPORT_STATUS_SIZE];
+  report_buffer_t rb;
+  report_fields_t fields;
+  uint8_t format = REPORT_FORMAT_CHANGED;
+  const report_fields_t *last = auto_report_sent ? &auto_report_fields : NULL;
+  #ifdef ENABLE_DELTA_STATUS_REPORT
+    format = report_delta_format(format);
+    if (format == REPORT_FORMAT_DELTA) { last = &report_delta_fields; }
+    else if (format == REPORT_FORMAT_KEYFRAME) { last = NULL; }
+  #endif
+  report_buffer_init(&rb, status, sizeof(status));
+  if (!report_build_status(&rb, CLIENT_SERIAL, format, last, &fields)) { return; } // Nothing changed.
+  // Never wait for the serial port. The report goes out whole at a later tick instead.
+  if (serial_get_tx_buffer_available() < (uint16_t)(rb.cursor - status)) { return; }
+  grbl_send(CLIENT_SERIAL, status);
+  #ifdef ENABLE_DELTA_STATUS_REPORT
+    if (format != REPORT_FORMAT_CHANGED) {
+      report_delta_sent(format, &fields);
+      return;
+    }
+  #endif
+  auto_report_fields = fields;
+  auto_report_sent = true;
+}
+#endif
+
 #ifdef DEBUG
   void report_realtime_debug()
   {
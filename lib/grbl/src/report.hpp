@@ -59,6 +59,12 @@
 #define STATUS_GCODE_UNUSED_WORDS 36
 #define STATUS_GCODE_G43_DYNAMIC_AXIS_ERROR 37
 #define STATUS_GCODE_MAX_VALUE_EXCEEDED 38
+#define STATUS_JOB_STORE_FULL 39
+#define STATUS_JOB_NOT_FOUND 40
+#define STATUS_JOB_STORE_BUSY 41
+#define STATUS_RASTER_INVALID_SCANLINE 42
+#define STATUS_RASTER_LASER_MODE 43
+#define STATUS_GCODE_SPINDLE_NOT_ON 44
 
 // Define Grbl alarm codes. Valid values (1-255). 0 is reserved.
 #define ALARM_HARD_LIMIT_ERROR      EXEC_ALARM_HARD_LIMIT
@@ -70,6 +76,7 @@
 #define ALARM_HOMING_FAIL_DOOR      EXEC_ALARM_HOMING_FAIL_DOOR
 #define ALARM_HOMING_FAIL_PULLOFF   EXEC_ALARM_HOMING_FAIL_PULLOFF
 #define ALARM_HOMING_FAIL_APPROACH  EXEC_ALARM_HOMING_FAIL_APPROACH
+#define ALARM_SPINDLE_SYNC          EXEC_ALARM_SPINDLE_SYNC
 
 // Define Grbl feedback message codes. Valid values (0-255).
 #define MESSAGE_CRITICAL_EVENT 1
@@ -83,6 +90,8 @@
 #define MESSAGE_RESTORE_DEFAULTS 9
 #define MESSAGE_SPINDLE_RESTORE 10
 #define MESSAGE_SLEEP_MODE 11
+#define MESSAGE_JOB_DONE 12
+#define MESSAGE_JOB_STOPPED 13
 
 #define CLIENT_SERIAL     1
 #define CLIENT_WEBSOCKET  2
@@ -104,6 +113,41 @@ void grbl_sendf(uint8_t client, const char *format, ...);
 // Prints system status messages.
 void report_status_message(uint8_t status_code, uint8_t client);
 
+#ifdef ENABLE_ACK_BATCHING
+  // Returns to one ok per line and drops pending oks. Called on reset.
+  void report_ack_init();
+
+  // Sets the lines per ok:N response. Applied after the response to the current line.
+  void report_ack_request(uint8_t count);
+
+  // Sends the oks of executed lines still pending, as one ok:N.
+  void report_ack_flush();
+
+  // Prints the response to a streamed line, batched when enabled by $A=N.
+  void report_line_status(uint8_t status_code, uint8_t client);
+#endif
+
+#ifdef ENABLE_DELTA_STATUS_REPORT
+  // Makes the next status report a keyframe. Called on reset.
+  void report_status_init();
+#endif
+
+#ifdef ENABLE_AUTO_REPORT
+  // Turns auto-reports off. Called on reset.
+  void report_auto_init();
+
+  // Sets the auto-report interval in milliseconds, zero for off, and restarts the timer. Set by $Q=ms.
+  void report_auto_set_interval(uint16_t interval);
+
+  uint16_t report_auto_get_interval();
+
+  // Requests the next auto-report. Called by the auto-report timer interrupt.
+  void report_auto_timer_isr();
+
+  // Sends a requested auto-report if a field changed and it fits in the serial TX buffer.
+  void report_auto_service();
+#endif
+
 // Prints system alarm messages.
 void report_alarm_message(uint8_t alarm_code);
 
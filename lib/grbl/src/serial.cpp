@@ -29,6 +29,10 @@ uint8_t serial_rx_buffer[CLIENT_COUNT][RX_RING_BUFFER];
 uint8_t serial_rx_buffer_head[CLIENT_COUNT] = {0};
 volatile uint8_t serial_rx_buffer_tail[CLIENT_COUNT] = {0};
 
+uint8_t serial_tx_buffer[TX_RING_BUFFER];
+volatile uint16_t serial_tx_buffer_head = 0;
+volatile uint16_t serial_tx_buffer_tail = 0;
+
 // Ticker serial_poll_task;
 
 // Returns the number of bytes available in the RX serial buffer.
@@ -51,12 +55,53 @@ void serial_init()
 
 
 
+// Returns the number of bytes free in the TX serial buffer.
+uint16_t serial_get_tx_buffer_available()
+{
+  uint16_t ttail = serial_tx_buffer_tail; // Copy to limit multiple calls to volatile
+  if (serial_tx_buffer_head >= ttail) { return(TX_BUFFER_SIZE - (serial_tx_buffer_head-ttail)); }
+  return((ttail-serial_tx_buffer_head-1));
+}
+
+
 // Writes one byte to the TX serial buffer. Called by main program.
 void serial_write(uint8_t data) {
+  // Calculate next head
+  uint16_t next_head = serial_tx_buffer_head + 1;
+  if (next_head == TX_RING_BUFFER) { next_head = 0; }
+
+  // Wait until there is space in the buffer
+  while (next_head == serial_tx_buffer_tail) {
+    // TODO: Restructure st_prep_buffer() calls to be executed here during a long print.
+    if (sys_rt_exec_state & EXEC_RESET) { return; } // Only check for abort to avoid an endless loop.
+  }
 
-  UART_WriteByte(UART_0, data);
-	UART_WaitTransmission(UART_0);
+  // Store data and advance head
+  serial_tx_buffer[serial_tx_buffer_head] = data;
+  serial_tx_buffer_head = next_head;
 
+  // Enable Data Register Empty Interrupt to make sure tx-streaming is running
+  UART_0->CONTROL1 |= UART_CONTROL1_TXEIE_M;
+}
+
+
+// Data Register Empty Interrupt handler. Called by trap_handler() while the transmitter is empty.
+void serial_tx_isr()
+{
+  uint16_t tail = serial_tx_buffer_tail; // Temporary serial_tx_buffer_tail (to optimize for volatile)
+  if (tail == serial_tx_buffer_head) {
+    // Nothing left to send. Turn off Data Register Empty Interrupt to stop tx-streaming.
+    UART_0->CONTROL1 &= ~UART_CONTROL1_TXEIE_M;
+    return;
+  }
+
+  // Send a byte from the buffer
+  UART_0->TXDATA = serial_tx_buffer[tail];
+
+  // Update tail position
+  tail++;
+  if (tail == TX_RING_BUFFER) { tail = 0; }
+  serial_tx_buffer_tail = tail;
 }
 
 // Fetches the first byte in the serial read buffer. Called by main program.
@@ -72,42 +117,11 @@ uint16_t serial_read(uint8_t client)
   
 }
 
-void serial_poll_rx()
+// Executes a real-time command character. Returns false if data is an ordinary line character.
+// Unknown extended ASCII characters are consumed and thrown away.
+uint8_t serial_execute_realtime(uint8_t data, uint8_t client)
 {
-  uint16_t data = 0;
-  uint8_t next_head;
-  uint8_t client = CLIENT_SERIAL;  // who sent the data
-  uint8_t client_idx = 0;  // index of data buffer
-
-  while (!UART_IsRxFifoEmpty(UART_0)
-  #if (defined ENABLE_WIFI) && (defined ENABLE_WEBSOCKET)
-    || Serial2Socket.available() > 0
-  #endif
-  #if (defined ENABLE_WIFI) && (defined ENABLE_TELNET)
-    || telnetServer.available() > 0
-  #endif
-    ) {
-    if (!UART_IsRxFifoEmpty(UART_0)) {
-      client = CLIENT_SERIAL;
-      data = UART_ReadByte(UART_0);
-    }
-    #if (defined ENABLE_WIFI) && (defined ENABLE_WEBSOCKET)
-    else if (Serial2Socket.available() > 0) {
-      client = CLIENT_WEBSOCKET;
-      data = Serial2Socket.read();
-    }
-    #endif
-    #if (defined ENABLE_WIFI) && (defined ENABLE_TELNET)
-    else if (telnetServer.available() > 0) {
-      client = CLIENT_TELNET;
-      data = telnetServer.read();
-    }
-    #endif
-    client_idx = client - 1;  // for zero based array
-
-    // Pick off realtime command characters directly from the serial stream. These characters are
-    // not passed into the main buffer, but these set system state flag bits for realtime execution.
-    switch (data) {
+  switch (data) {
     case CMD_RESET:         mc_reset(); break; // Call motion control reset routine.
     case CMD_STATUS_REPORT: report_realtime_status(client); break;
     case CMD_CYCLE_START:   system_set_exec_state_flag(EXEC_CYCLE_START); break; // Set as true
@@ -144,24 +158,71 @@ void serial_poll_rx()
           #endif
         }
         // Throw away any unfound extended-ASCII character by not passing it to the serial buffer.
-      } else { // Write character to buffer
-        // enter mutex
-        // Необходимо отключить прерывания!
-        HAL_IRQ_DisableInterrupts();
-        //cli();
-        next_head = serial_rx_buffer_head[client_idx] + 1;
-        if (next_head == RX_RING_BUFFER) { next_head = 0; }
-
-        // Write data to buffer unless it is full.
-        if (next_head != serial_rx_buffer_tail[client_idx]) {
-          serial_rx_buffer[client_idx][serial_rx_buffer_head[client_idx]] = data;
-          serial_rx_buffer_head[client_idx] = next_head;
-        }
-        // exit mutex
-        // Неоходимо включить прерывания.
-        HAL_IRQ_EnableInterrupts();
-        //sei();
+      } else {
+        return(false);
+      }
+  }
+  return(true);
+}
+
+void serial_poll_rx()
+{
+  uint16_t data = 0;
+  uint8_t next_head;
+  uint8_t client = CLIENT_SERIAL;  // who sent the data
+  uint8_t client_idx = 0;  // index of data buffer
+
+  while (!UART_IsRxFifoEmpty(UART_0)
+  #if (defined ENABLE_WIFI) && (defined ENABLE_WEBSOCKET)
+    || Serial2Socket.available() > 0
+  #endif
+  #if (defined ENABLE_WIFI) && (defined ENABLE_TELNET)
+    || telnetServer.available() > 0
+  #endif
+    ) {
+    if (!UART_IsRxFifoEmpty(UART_0)) {
+      client = CLIENT_SERIAL;
+      data = UART_ReadByte(UART_0);
+    }
+    #if (defined ENABLE_WIFI) && (defined ENABLE_WEBSOCKET)
+    else if (Serial2Socket.available() > 0) {
+      client = CLIENT_WEBSOCKET;
+      data = Serial2Socket.read();
+    }
+    #endif
+    #if (defined ENABLE_WIFI) && (defined ENABLE_TELNET)
+    else if (telnetServer.available() > 0) {
+      client = CLIENT_TELNET;
+      data = telnetServer.read();
+    }
+    #endif
+    client_idx = client - 1;  // for zero based array
+
+    // Pick off realtime command characters directly from the serial stream. These characters are
+    // not passed into the main buffer, but these set system state flag bits for realtime execution.
+    #ifdef ENABLE_SERIAL_FRAMING
+      if ((client == CLIENT_SERIAL) && frame_mode_active()) {
+        frame_receive_byte(data); // Frames and real-time characters between them.
+        continue;
+      }
+    #endif
+    if (!serial_execute_realtime(data, client)) { // Write character to buffer
+      // enter mutex
+      // Необходимо отключить прерывания!
+      HAL_IRQ_DisableInterrupts();
+      //cli();
+      next_head = serial_rx_buffer_head[client_idx] + 1;
+      if (next_head == RX_RING_BUFFER) { next_head = 0; }
+
+      // Write data to buffer unless it is full.
+      if (next_head != serial_rx_buffer_tail[client_idx]) {
+        serial_rx_buffer[client_idx][serial_rx_buffer_head[client_idx]] = data;
+        serial_rx_buffer_head[client_idx] = next_head;
       }
+      // exit mutex
+      // Неоходимо включить прерывания.
+      HAL_IRQ_EnableInterrupts();
+      //sei();
     }
   }
   UART_ClearRxFifo(UART_0);
@@ -37,9 +37,15 @@
 
 void serial_init();
 
-// Writes one byte to the TX serial buffer. Called by main program.
+// Writes one byte to the TX serial buffer. Called by main program. Waits only when the buffer is full.
 void serial_write(uint8_t data);
 
+// Returns the number of bytes free in the TX serial buffer.
+uint16_t serial_get_tx_buffer_available();
+
+// Sends the next buffered byte. Called by the UART interrupt when the transmitter is empty.
+void serial_tx_isr();
+
 // Fetches the first byte in the serial read buffer. Called by main program.
 uint16_t serial_read(uint8_t client);
 
@@ -52,5 +58,8 @@ uint8_t serial_get_rx_buffer_available(uint8_t client);
 // Serial rx "interrupt"
 void serial_poll_rx();
 
+// Executes a real-time command character. Returns false if data is an ordinary line character.
+uint8_t serial_execute_realtime(uint8_t data, uint8_t client);
+
 
 #endif
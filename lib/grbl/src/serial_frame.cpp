@@ -0,0 +1,320 @@
+/*
+  serial_frame.c - framed binary serial protocol with CRC and windowed acknowledgements
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "grbl.hpp"
+
+#ifdef ENABLE_SERIAL_FRAMING
+
+#define FRAME_HEADER_SIZE 2 // Type and sequence number.
+#define FRAME_CRC_SIZE    2
+#define FRAME_RX_SIZE     (FRAME_HEADER_SIZE + (LINE_BUFFER_SIZE-1) + FRAME_CRC_SIZE)
+
+// Receiver states.
+#define FRAME_RX_IDLE    0 // Between frames.
+#define FRAME_RX_BODY    1
+#define FRAME_RX_ESCAPE  2
+#define FRAME_RX_DISCARD 3 // Frame too long. Dropped up to its end.
+
+static volatile uint8_t frame_active;
+
+// Receiver. Runs in the serial receive interrupt.
+static uint8_t frame_rx[FRAME_RX_SIZE];
+static uint16_t frame_rx_count;
+static uint8_t frame_rx_state;
+static uint8_t frame_expected;  // Sequence number of the next line frame.
+static uint8_t frame_nak_sent;  // One NAK per loss, until the expected frame arrives.
+
+// Received line and scanline frames, queued by the interrupt and released by frame_send_ack().
+static char frame_queue[SERIAL_FRAME_WINDOW][LINE_BUFFER_SIZE];
+static uint8_t frame_queue_seq[SERIAL_FRAME_WINDOW];
+static uint8_t frame_queue_type[SERIAL_FRAME_WINDOW];
+static uint16_t frame_queue_length[SERIAL_FRAME_WINDOW]; // Scanline payloads may contain zeros.
+// Head and tail run over twice the window, so full and empty differ without a shared counter. The
+// interrupt only moves the head and the main loop only moves the tail.
+static volatile uint8_t frame_queue_head;
+static volatile uint8_t frame_queue_tail;
+
+// ACKs sent, kept to repeat them for repeated frames. A ring in send order, since seq % window
+// breaks where the 8-bit sequence number wraps for windows that do not divide 256.
+static uint8_t frame_status[SERIAL_FRAME_WINDOW];
+static uint8_t frame_status_slot; // Slot of the ACK for frame_ack_seq.
+static volatile uint8_t frame_ack_seq;
+static volatile uint8_t frame_ack_count;  // ACKs sent since frame_enter(), saturated at the window.
+
+// Requests from the interrupt to the main loop.
+static volatile uint8_t frame_nak_pending;
+static volatile uint8_t frame_resend_pending;
+static volatile uint8_t frame_resend_seq;  // Repeat ACKs from this sequence number to frame_ack_seq.
+
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF), four bits at a time.
+static const uint16_t frame_crc_table[16] = {
+  0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+  0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+static uint16_t frame_crc16(const uint8_t *data, uint16_t length)
+{
+  uint16_t crc = 0xFFFF;
+  while (length--) {
+    crc = (crc << 4) ^ frame_crc_table[(crc >> 12) ^ (*data >> 4)];
+    crc = (crc << 4) ^ frame_crc_table[(crc >> 12) ^ (*data & 0x0F)];
+    data++;
+  }
+  return(crc);
+}
+
+
+static uint8_t frame_needs_escape(uint8_t data)
+{
+  switch (data) {
+    case FRAME_START: case FRAME_END: case FRAME_ESCAPE:
+    case CMD_RESET: case CMD_STATUS_REPORT: case CMD_CYCLE_START: case CMD_FEED_HOLD:
+      return(true);
+  }
+  return(false);
+}
+
+static void frame_write_byte(uint8_t data)
+{
+  if (frame_needs_escape(data)) {
+    serial_write(FRAME_ESCAPE);
+    data ^= FRAME_ESCAPE_XOR;
+  }
+  serial_write(data);
+}
+
+static void frame_send(uint8_t type, uint8_t seq, uint8_t status_code, uint8_t has_status)
+{
+  uint8_t body[3] = { type, seq, status_code };
+  uint8_t length = has_status ? 3 : 2;
+  uint16_t crc = frame_crc16(body, length);
+  serial_write(FRAME_START);
+  uint8_t idx;
+  for (idx=0; idx<length; idx++) { frame_write_byte(body[idx]); }
+  frame_write_byte(crc >> 8);
+  frame_write_byte(crc & 0xFF);
+  serial_write(FRAME_END);
+}
+
+
+static uint8_t frame_queue_next(uint8_t index)
+{
+  if (++index == 2*SERIAL_FRAME_WINDOW) { index = 0; }
+  return(index);
+}
+
+static uint8_t frame_queue_slot(uint8_t index)
+{
+  if (index >= SERIAL_FRAME_WINDOW) { index -= SERIAL_FRAME_WINDOW; }
+  return(index);
+}
+
+static uint8_t frame_queue_count()
+{
+  uint8_t head = frame_queue_head;
+  uint8_t tail = frame_queue_tail;
+  if (head < tail) { head += 2*SERIAL_FRAME_WINDOW; }
+  return(head - tail);
+}
+
+// Status of an ACK still kept, i.e. (uint8_t)(frame_ack_seq - seq) < frame_ack_count.
+static uint8_t frame_status_get(uint8_t seq)
+{
+  uint8_t back = frame_ack_seq - seq;
+  uint8_t slot = frame_status_slot;
+  if (slot < back) { slot += SERIAL_FRAME_WINDOW; }
+  return(frame_status[slot - back]);
+}
+
+
+void frame_init()
+{
+  frame_active = false;
+  frame_rx_state = FRAME_RX_IDLE;
+  frame_queue_head = 0;
+  frame_queue_tail = 0;
+  frame_nak_pending = false;
+  frame_resend_pending = false;
+}
+
+
+void frame_enter()
+{
+  frame_init();
+  frame_expected = 0;
+  frame_nak_sent = false;
+  frame_ack_count = 0;
+  frame_status_slot = 0;
+  frame_active = true;
+}
+
+
+uint8_t frame_mode_active() { return(frame_active); }
+
+
+static void frame_request_nak()
+{
+  if (!frame_nak_sent) {
+    frame_nak_sent = true;
+    frame_nak_pending = true;
+  }
+}
+
+
+static void frame_receive_line(uint8_t type, uint8_t seq, uint8_t *payload, uint16_t length)
+{
+  if (seq == frame_expected) {
+    if (frame_queue_count() >= SERIAL_FRAME_WINDOW) {
+      frame_request_nak(); // Host overran the window.
+      return;
+    }
+    uint8_t slot = frame_queue_slot(frame_queue_head);
+    memcpy(frame_queue[slot], payload, length);
+    frame_queue[slot][length] = 0;
+    frame_queue_seq[slot] = seq;
+    frame_queue_type[slot] = type;
+    frame_queue_length[slot] = length;
+    frame_queue_head = frame_queue_next(frame_queue_head);
+    frame_expected++;
+    frame_nak_sent = false;
+  } else if ((uint8_t)(frame_expected - seq) <= SERIAL_FRAME_WINDOW) {
+    // Repeat of a frame already received. If it was executed, its ACK was lost, so send it again.
+    // Otherwise it is still queued and will be acknowledged when executed.
+    if ((uint8_t)(frame_ack_seq - seq) < frame_ack_count) {
+      if (!frame_resend_pending || ((uint8_t)(frame_ack_seq - seq) > (uint8_t)(frame_ack_seq - frame_resend_seq))) {
+        frame_resend_seq = seq;
+      }
+      frame_resend_pending = true;
+    }
+  } else {
+    frame_request_nak(); // A frame before this one was lost.
+  }
+}
+
+
+static void frame_dispatch()
+{
+  if (frame_rx_count < (FRAME_HEADER_SIZE + FRAME_CRC_SIZE)) {
+    frame_request_nak();
+    return;
+  }
+  uint16_t length = frame_rx_count - FRAME_CRC_SIZE;
+  uint16_t crc = ((uint16_t)frame_rx[length] << 8) | frame_rx[length+1];
+  if (frame_crc16(frame_rx, length) != crc) {
+    frame_request_nak();
+    return;
+  }
+  uint8_t *payload = &frame_rx[FRAME_HEADER_SIZE];
+  length -= FRAME_HEADER_SIZE;
+  switch (frame_rx[0]) {
+    case FRAME_TYPE_LINE: case FRAME_TYPE_SCANLINE: frame_receive_line(frame_rx[0], frame_rx[1], payload, length); break;
+    case FRAME_TYPE_REALTIME:
+      while (length--) {
+        // Status reports are printed by the main loop, so they never split an outgoing frame.
+        if (*payload == CMD_STATUS_REPORT) { system_set_exec_state_flag(EXEC_STATUS_REPORT); }
+        else { serial_execute_realtime(*payload, CLIENT_SERIAL); }
+        payload++;
+      }
+      break;
+    case FRAME_TYPE_EXIT: frame_active = false; break;
+  }
+}
+
+
+void frame_receive_byte(uint8_t data)
+{
+  if (data == FRAME_START) {
+    frame_rx_count = 0;
+    frame_rx_state = FRAME_RX_BODY;
+    return;
+  }
+  switch (frame_rx_state) {
+    case FRAME_RX_IDLE:
+      // Only ASCII real-time commands are accepted between frames. See serial_frame.h.
+      if (data == CMD_STATUS_REPORT) { system_set_exec_state_flag(EXEC_STATUS_REPORT); }
+      else if (data <= 0x7F) { serial_execute_realtime(data, CLIENT_SERIAL); }
+      return;
+    case FRAME_RX_DISCARD:
+      if (data == FRAME_END) {
+        frame_rx_state = FRAME_RX_IDLE;
+        frame_request_nak();
+      }
+      return;
+    case FRAME_RX_ESCAPE:
+      data ^= FRAME_ESCAPE_XOR;
+      frame_rx_state = FRAME_RX_BODY;
+      break;
+    default: // FRAME_RX_BODY
+      if (data == FRAME_ESCAPE) {
+        frame_rx_state = FRAME_RX_ESCAPE;
+        return;
+      }
+      if (data == FRAME_END) {
+        frame_rx_state = FRAME_RX_IDLE;
+        frame_dispatch();
+        return;
+      }
+  }
+  if (frame_rx_count < FRAME_RX_SIZE) { frame_rx[frame_rx_count++] = data; }
+  else { frame_rx_state = FRAME_RX_DISCARD; }
+}
+
+
+char *frame_read_line(uint8_t *seq, uint8_t *type, uint16_t *length)
+{
+  if (frame_queue_head == frame_queue_tail) { return(NULL); }
+  uint8_t slot = frame_queue_slot(frame_queue_tail);
+  *seq = frame_queue_seq[slot];
+  *type = frame_queue_type[slot];
+  *length = frame_queue_length[slot];
+  return(frame_queue[slot]);
+}
+
+
+void frame_send_ack(uint8_t seq, uint8_t status_code)
+{
+  if (++frame_status_slot == SERIAL_FRAME_WINDOW) { frame_status_slot = 0; }
+  frame_status[frame_status_slot] = status_code;
+  frame_ack_seq = seq;
+  if (frame_ack_count < SERIAL_FRAME_WINDOW) { frame_ack_count++; }
+  frame_queue_tail = frame_queue_next(frame_queue_tail);
+  frame_send(FRAME_TYPE_ACK, seq, status_code, true);
+}
+
+
+void frame_service()
+{
+  if (frame_nak_pending) {
+    frame_nak_pending = false;
+    frame_send(FRAME_TYPE_NAK, frame_expected, 0, false);
+  }
+  if (frame_resend_pending) {
+    HAL_IRQ_DisableInterrupts();
+    uint8_t seq = frame_resend_seq;
+    frame_resend_pending = false;
+    HAL_IRQ_EnableInterrupts();
+    while (1) {
+      frame_send(FRAME_TYPE_ACK, seq, frame_status_get(seq), true);
+      if (seq == frame_ack_seq) { break; }
+      seq++;
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,74 @@
+/*
+  serial_frame.h - framed binary serial protocol with CRC and windowed acknowledgements
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef serial_frame_h
+#define serial_frame_h
+
+// Frame bytes on the wire: FRAME_START, escaped body, FRAME_END. The body is type, sequence
+// number, payload and CRC-16/CCITT (big-endian) of the rest. Inside the body, FRAME_START,
+// FRAME_END, FRAME_ESCAPE and the ASCII real-time commands (ctrl-x ? ~ !) are sent as FRAME_ESCAPE
+// followed by the byte XOR FRAME_ESCAPE_XOR. So a raw ASCII real-time character is never part of
+// a frame, even when a frame start is lost to noise, and works between frames as in line mode.
+// Extended (0x80 and up) real-time commands must be sent in a real-time frame, since they collide
+// with tokenized g-code bytes. Grbl's text output never contains the frame bytes, so text reports
+// and frames share the transmit side.
+#define FRAME_START      0x02
+#define FRAME_END        0x03
+#define FRAME_ESCAPE     0x10
+#define FRAME_ESCAPE_XOR 0x20
+
+// Frame types. Host to Grbl:
+#define FRAME_TYPE_LINE     'L' // Payload is one filtered line, text or tokenized g-code or a '$' command.
+#define FRAME_TYPE_SCANLINE 'S' // Payload is a binary raster scanline. Sequenced and acknowledged like a line. See raster.h.
+#define FRAME_TYPE_REALTIME 'R' // Payload is real-time command characters. Executed on receipt, not sequenced.
+#define FRAME_TYPE_EXIT     'X' // Back to line mode.
+// Grbl to host:
+#define FRAME_TYPE_ACK      'A' // Line frame seq executed. Payload is its status code. Cumulative.
+#define FRAME_TYPE_NAK      'N' // Frame lost or corrupted. seq is the next line frame expected.
+
+// The host may have up to SERIAL_FRAME_WINDOW line and scanline frames unacknowledged. Grbl queues that many,
+// so the receive side never overflows. On a NAK, or when no ACK arrives in time, the host sends
+// every unacknowledged frame again, starting at the oldest (go-back-N). Repeats of frames that
+// were already received are dropped, and the ACKs of executed ones are sent again.
+
+
+// Leaves framed mode and clears the frame queue. Called on reset, so a reset returns to line mode.
+void frame_init();
+
+// Enters framed mode. Called by $B.
+void frame_enter();
+
+// Returns true while in framed mode.
+uint8_t frame_mode_active();
+
+// Handles one received byte in framed mode. Called by the serial receive interrupt.
+void frame_receive_byte(uint8_t data);
+
+// Returns the payload of the next queued line or scanline frame, 0-terminated, with its sequence
+// number, frame type and payload length, or NULL if none is queued. The payload stays queued until
+// frame_send_ack().
+char *frame_read_line(uint8_t *seq, uint8_t *type, uint16_t *length);
+
+// Sends the ACK of an executed line or scanline frame and releases its queue slot.
+void frame_send_ack(uint8_t seq, uint8_t status_code);
+
+// Sends NAKs and repeated ACKs requested by the receive interrupt. Called by the main loop, so
+// frames are never interleaved with other output.
+void frame_service();
+
+#endif
@@ -23,21 +23,29 @@
 
 settings_t settings;
 
+// Store words of a coordinate set and of a startup line.
+#define SETTINGS_KEY_COORD(n)    (EEPROM_KEY_PARAMETERS + (n)*SETTINGS_REGION_WORDS(sizeof(float)*N_AXIS))
+#define SETTINGS_KEY_STARTUP(n)  (EEPROM_KEY_STARTUP_BLOCK + (n)*SETTINGS_REGION_WORDS(LINE_BUFFER_SIZE))
+
+// Regions whose CRC-32 did not match at boot. Such a region reads as its default once, which is
+// then stored, as Grbl did on a checksum failure.
+#define REGION_FAIL_COORD(n)     (1 << (n))
+#define REGION_FAIL_STARTUP(n)   (1 << (SETTING_INDEX_NCOORD+1+(n)))
+#define REGION_FAIL_BUILD_INFO   (1 << (SETTING_INDEX_NCOORD+1+N_STARTUP_LINE))
+static uint16_t settings_region_fail;
+
 /**
  * @brief Сохраняет строку запуска в EEPROM.
  *
  * @param n Номер строки запуска (0 или 1).
  * @param line Указатель на строку для сохранения (должна быть длиной LINE_BUFFER_SIZE).
- * @note При определении FORCE_BUFFER_SYNC_DURING_EEPROM_WRITE синхронизирует буфер протокола.
+ * @note Как и все записи настроек, меняет только копию в ОЗУ. В EEPROM она записывается, когда
+ *       станок стоит, или командой '$SAVE', поэтому буфер планировщика не синхронизируется.
  */
 void settings_store_startup_line(uint8_t n, char *line)
 {
-  #ifdef FORCE_BUFFER_SYNC_DURING_EEPROM_WRITE
-    protocol_buffer_synchronize(); // A startup line may contain a motion and be executing.
-  #endif
-  uint32_t addr = n*(LINE_BUFFER_SIZE+1);
-  //uint32_t addr = n*(LINE_BUFFER_SIZE+1)+EEPROM_ADDR_STARTUP_BLOCK;
-  memcpy_to_eeprom_with_checksum(EEPROM_ADDR_STARTUP_BLOCK_PAGE, EEPROM_ADDR_STARTUP_BLOCK_COUNT_PAGE, (char*)line, addr, LINE_BUFFER_SIZE);
+  eeprom_store_write_block(SETTINGS_KEY_STARTUP(n), SETTINGS_WORDS(LINE_BUFFER_SIZE), line, strlen(line)+1);
+  bit_false(settings_region_fail, REGION_FAIL_STARTUP(n));
 }
 
 
@@ -49,7 +57,8 @@ void settings_store_startup_line(uint8_t n, char *line)
  */
 void settings_store_build_info(char *line)
 {
-  memcpy_to_eeprom_with_checksum(EEPROM_ADDR_BUILD_INFO, EEPROM_ADDR_BUILD_INFO_COUNT_PAGE, (char*)line, 0, LINE_BUFFER_SIZE);
+  eeprom_store_write_block(EEPROM_KEY_BUILD_INFO, SETTINGS_WORDS(LINE_BUFFER_SIZE), line, strlen(line)+1);
+  bit_false(settings_region_fail, REGION_FAIL_BUILD_INFO);
 }
 
 
@@ -58,28 +67,26 @@ void settings_store_build_info(char *line)
  *
  * @param coord_select Выбор координатной системы (0..SETTING_INDEX_NCOORD).
  * @param coord_data Указатель на массив значений координат (размер N_AXIS).
- * @note При определении FORCE_BUFFER_SYNC_DURING_EEPROM_WRITE синхронизирует буфер протокола.
+ * @note Вызывается из G10 и G28.1/G30.1 во время работы: движение не останавливается, так как
+ *       пишется только копия в ОЗУ.
  */
 void settings_write_coord_data(uint8_t coord_select, float *coord_data)
 {
-  #ifdef FORCE_BUFFER_SYNC_DURING_EEPROM_WRITE
-    protocol_buffer_synchronize();
-  #endif
-  uint32_t addr = coord_select*(sizeof(float)*N_AXIS+1);
-  //uint32_t addr = coord_select*(sizeof(float)*N_AXIS+1) + EEPROM_ADDR_PARAMETERS;
-  memcpy_to_eeprom_with_checksum(EEPROM_ADDR_PARAMETERS_PAGE, EEPROM_ADDR_PARAMETERS_COUNT_PAGE, (char*)coord_data, addr, sizeof(float)*N_AXIS);
+  eeprom_store_write_block(SETTINGS_KEY_COORD(coord_select), N_AXIS, coord_data, sizeof(float)*N_AXIS);
+  bit_false(settings_region_fail, REGION_FAIL_COORD(coord_select));
 }
 
 
 /**
  * @brief Сохраняет глобальные настройки Grbl и номер версии в EEPROM.
  *
- * @note Функция может быть вызвана только в состоянии IDLE.
+ * @note Записываются только изменённые слова настроек.
  */
 void write_global_settings()
 {
-  //eeprom_put_char(0, SETTINGS_VERSION);
-  memcpy_to_eeprom_with_checksum(EEPROM_ADDR_GLOBAL_PAGE, EEPROM_ADDR_GLOBAL_COUNT_PAGE, (char*)&settings, 0, sizeof(settings_t));
+  uint32_t version = SETTINGS_VERSION;
+  eeprom_store_write_block(EEPROM_KEY_VERSION, 1, &version, sizeof(version));
+  eeprom_store_write_block(EEPROM_KEY_GLOBAL, SETTINGS_WORDS(sizeof(settings_t)), &settings, sizeof(settings_t));
 }
 
 
@@ -91,7 +98,6 @@ void write_global_settings()
  */
 void settings_restore(uint8_t restore_flag) {
   if (restore_flag & SETTINGS_RESTORE_DEFAULTS) {
-    settings.settings_version = SETTINGS_VERSION;
     settings.pulse_microseconds = DEFAULT_STEP_PULSE_MICROSECONDS;
     settings.stepper_idle_lock_time = DEFAULT_STEPPER_IDLE_LOCK_TIME;
     settings.step_invert_mask = DEFAULT_STEPPING_INVERT_MASK;
@@ -164,22 +170,13 @@ void settings_restore(uint8_t restore_flag) {
   }
 
   if (restore_flag & SETTINGS_RESTORE_STARTUP_LINES) {
-    eeprom_erase_from_page(EEPROM_ADDR_STARTUP_BLOCK_PAGE, 64); // Очищаем две страницы полностью
-    // #if N_STARTUP_LINE > 0
-    //   eeprom_erase_from_page()
-    //   eeprom_put_char(EEPROM_ADDR_STARTUP_BLOCK, 0);
-    //   eeprom_put_char(EEPROM_ADDR_STARTUP_BLOCK+1, 0); // Checksum
-    // #endif
-    // #if N_STARTUP_LINE > 1
-    //   eeprom_put_char(EEPROM_ADDR_STARTUP_BLOCK+(LINE_BUFFER_SIZE+1), 0);
-    //   eeprom_put_char(EEPROM_ADDR_STARTUP_BLOCK+(LINE_BUFFER_SIZE+2), 0); // Checksum
-    // #endif
+    char empty_line = 0;
+    for (uint8_t n = 0; n < N_STARTUP_LINE; n++) { settings_store_startup_line(n, &empty_line); }
   }
 
   if (restore_flag & SETTINGS_RESTORE_BUILD_INFO) {
-    //eeprom_put_char(EEPROM_ADDR_BUILD_INFO , 0);
-    //eeprom_put_char(EEPROM_ADDR_BUILD_INFO+1 , 0); // Checksum
-    eeprom_erase_from_page(EEPROM_ADDR_BUILD_INFO_PAGE, 64); // Очищаем две страницы полностью
+    char empty_line = 0;
+    settings_store_build_info(&empty_line);
   }
 }
 
@@ -193,14 +190,14 @@ void settings_restore(uint8_t restore_flag) {
  */
 uint8_t settings_read_startup_line(uint8_t n, char *line)
 {
-  //uint32_t addr = n*(LINE_BUFFER_SIZE+1)+EEPROM_ADDR_STARTUP_BLOCK;
-  uint32_t addr = n*(LINE_BUFFER_SIZE+1);
-  if (!(memcpy_from_eeprom_with_checksum((char*)line, EEPROM_ADDR_STARTUP_BLOCK_PAGE, EEPROM_ADDR_STARTUP_BLOCK_COUNT_PAGE, addr, LINE_BUFFER_SIZE))) {
+  if (settings_region_fail & REGION_FAIL_STARTUP(n)) {
     // Reset line with default value
     line[0] = 0; // Empty line
     settings_store_startup_line(n, line);
     return(false);
   }
+  eeprom_store_read_block(SETTINGS_KEY_STARTUP(n), line, LINE_BUFFER_SIZE);
+  line[LINE_BUFFER_SIZE-1] = 0;
   return(true);
 }
 
@@ -213,12 +210,14 @@ uint8_t settings_read_startup_line(uint8_t n, char *line)
  */
 uint8_t settings_read_build_info(char *line)
 {
-  if (!(memcpy_from_eeprom_with_checksum((char*)line, EEPROM_ADDR_BUILD_INFO_PAGE, EEPROM_ADDR_BUILD_INFO_COUNT_PAGE, 0, LINE_BUFFER_SIZE))) {
+  if (settings_region_fail & REGION_FAIL_BUILD_INFO) {
     // Reset line with default value
     line[0] = 0; // Empty line
     settings_store_build_info(line);
     return(false);
   }
+  eeprom_store_read_block(EEPROM_KEY_BUILD_INFO, line, LINE_BUFFER_SIZE);
+  line[LINE_BUFFER_SIZE-1] = 0;
   return(true);
 }
 
@@ -232,38 +231,179 @@ uint8_t settings_read_build_info(char *line)
  */
 uint8_t settings_read_coord_data(uint8_t coord_select, float *coord_data)
 {
-  //uint32_t addr = coord_select*(sizeof(float)*N_AXIS+1) + EEPROM_ADDR_PARAMETERS;
-  uint32_t addr = coord_select*(sizeof(float)*N_AXIS+1);
-  if (!(memcpy_from_eeprom_with_checksum((char*)coord_data, EEPROM_ADDR_BUILD_INFO_PAGE, EEPROM_ADDR_BUILD_INFO_COUNT_PAGE, addr, sizeof(float)*N_AXIS))) {
+  if (settings_region_fail & REGION_FAIL_COORD(coord_select)) {
     // Reset with default zero vector
     clear_vector_float(coord_data);
     settings_write_coord_data(coord_select,coord_data);
     return(false);
   }
+  eeprom_store_read_block(SETTINGS_KEY_COORD(coord_select), coord_data, sizeof(float)*N_AXIS);
   return(true);
 }
 
 
+/**
+ * @brief Проверяет CRC-32 области хранилища.
+ *
+ * Если CRC-32 не совпадает, область восстанавливается из последней копии в журнале EEPROM, у
+ * которой она совпадала, и значения по умолчанию нужны, только если такой копии нет.
+ *
+ * @return true, если CRC-32 совпадает или область восстановлена.
+ */
+static uint8_t settings_check_region(uint16_t key, uint16_t word_count)
+{
+  return(eeprom_store_check_block(key, word_count) || eeprom_store_recover_block(key, word_count));
+}
+
+
 /**
  * @brief Читает глобальные настройки Grbl из EEPROM.
  *
- * @return true если чтение успешно и версия совпадает, false если данные повреждены или версия не совпадает.
+ * @return true если чтение успешно, false если CRC-32 настроек не совпадает и целой копии нет.
  */
 uint8_t read_global_settings() {
-    // Read settings-record and check checksum
-    if (!(memcpy_from_eeprom_with_checksum((char*)&settings, EEPROM_ADDR_GLOBAL_PAGE, EEPROM_ADDR_GLOBAL_COUNT_PAGE, 0, sizeof(settings_t)))) {
-      return(false);
-    }
-    else 
-      if (settings.settings_version != SETTINGS_VERSION) {
-        return(false);
-  } else {
-    return(false);
-  }
+  if (!settings_check_region(EEPROM_KEY_GLOBAL, SETTINGS_WORDS(sizeof(settings_t)))) { return(false); }
+  eeprom_store_read_block(EEPROM_KEY_GLOBAL, &settings, sizeof(settings_t));
   return(true);
 }
 
 
+/**
+ * @brief Проверяет CRC-32 координат, строк запуска и информации о сборке.
+ *
+ * Один проход по образу хранилища при запуске. Области с несовпавшей CRC-32, которые не удалось
+ * восстановить из журнала, отмечаются в settings_region_fail. Глобальные настройки проверяет
+ * read_global_settings().
+ */
+static void settings_verify()
+{
+  uint8_t n;
+  settings_region_fail = 0;
+  for (n = 0; n <= SETTING_INDEX_NCOORD; n++) {
+    if (!settings_check_region(SETTINGS_KEY_COORD(n), N_AXIS)) { bit_true(settings_region_fail, REGION_FAIL_COORD(n)); }
+  }
+  for (n = 0; n < N_STARTUP_LINE; n++) {
+    if (!settings_check_region(SETTINGS_KEY_STARTUP(n), SETTINGS_WORDS(LINE_BUFFER_SIZE))) { bit_true(settings_region_fail, REGION_FAIL_STARTUP(n)); }
+  }
+  if (!settings_check_region(EEPROM_KEY_BUILD_INFO, SETTINGS_WORDS(LINE_BUFFER_SIZE))) { bit_true(settings_region_fail, REGION_FAIL_BUILD_INFO); }
+}
+
+
+// Version 10 layout: the global settings from word 0, with the version in their last field, and
+// the other regions right after them, without the version word and CRC-32 words.
+typedef struct {
+  float steps_per_mm[N_AXIS];
+  float max_rate[N_AXIS];
+  float acceleration[N_AXIS];
+  float max_travel[N_AXIS];
+  uint8_t pulse_microseconds;
+  uint8_t step_invert_mask;
+  uint8_t dir_invert_mask;
+  uint8_t stepper_idle_lock_time;
+  uint8_t status_report_mask;
+  float junction_deviation;
+  float arc_tolerance;
+  float rpm_max;
+  float rpm_min;
+  uint8_t flags;
+  uint8_t homing_dir_mask;
+  float homing_feed_rate;
+  float homing_seek_rate;
+  uint16_t homing_debounce_delay;
+  float homing_pulloff;
+  uint8_t settings_version;
+} settings_v10_t;
+
+#define V10_KEY_GLOBAL         0
+#define V10_KEY_PARAMETERS     (V10_KEY_GLOBAL+SETTINGS_WORDS(sizeof(settings_v10_t)))
+#define V10_KEY_STARTUP_BLOCK  (V10_KEY_PARAMETERS+(SETTING_INDEX_NCOORD+1)*N_AXIS)
+#define V10_KEY_BUILD_INFO     (V10_KEY_STARTUP_BLOCK+N_STARTUP_LINE*SETTINGS_WORDS(LINE_BUFFER_SIZE))
+
+
+/**
+ * @brief Возвращает версию структуры данных в хранилище, или 0, если она неизвестна.
+ */
+static uint32_t settings_stored_version()
+{
+  uint32_t version;
+  if (settings_check_region(EEPROM_KEY_VERSION, 1)) {
+    eeprom_store_read_block(EEPROM_KEY_VERSION, &version, sizeof(version));
+    if ((version > 10) && (version <= SETTINGS_VERSION)) { return(version); }
+  }
+  // Version 10 had no version word, but kept the version in the last field of its settings.
+  settings_v10_t v10;
+  eeprom_store_read_block(V10_KEY_GLOBAL, &v10, sizeof(v10));
+  if (v10.settings_version == 10) { return(10); }
+  return(0);
+}
+
+
+/**
+ * @brief Преобразует данные версии 10 к версии 11.
+ *
+ * Каждая область в версии 11 начинается не раньше, чем в версии 10, поэтому области переносятся
+ * с последней, и ни одна не затирается до того, как прочитана. Глобальные настройки копируются
+ * поле за полем.
+ */
+static void settings_migrate_v10()
+{
+  char line[LINE_BUFFER_SIZE];
+  eeprom_store_read_block(V10_KEY_BUILD_INFO, line, LINE_BUFFER_SIZE);
+  line[LINE_BUFFER_SIZE-1] = 0;
+  settings_store_build_info(line);
+  uint8_t n;
+  for (n = N_STARTUP_LINE; n-- > 0; ) {
+    eeprom_store_read_block(V10_KEY_STARTUP_BLOCK + n*SETTINGS_WORDS(LINE_BUFFER_SIZE), line, LINE_BUFFER_SIZE);
+    line[LINE_BUFFER_SIZE-1] = 0;
+    settings_store_startup_line(n, line);
+  }
+  float coord_data[N_AXIS];
+  for (n = SETTING_INDEX_NCOORD+1; n-- > 0; ) {
+    eeprom_store_read_block(V10_KEY_PARAMETERS + n*N_AXIS, coord_data, sizeof(coord_data));
+    settings_write_coord_data(n, coord_data);
+  }
+
+  settings_v10_t v10;
+  eeprom_store_read_block(V10_KEY_GLOBAL, &v10, sizeof(v10));
+  memcpy(settings.steps_per_mm, v10.steps_per_mm, sizeof(settings.steps_per_mm));
+  memcpy(settings.max_rate, v10.max_rate, sizeof(settings.max_rate));
+  memcpy(settings.acceleration, v10.acceleration, sizeof(settings.acceleration));
+  memcpy(settings.max_travel, v10.max_travel, sizeof(settings.max_travel));
+  settings.pulse_microseconds = v10.pulse_microseconds;
+  settings.step_invert_mask = v10.step_invert_mask;
+  settings.dir_invert_mask = v10.dir_invert_mask;
+  settings.stepper_idle_lock_time = v10.stepper_idle_lock_time;
+  settings.status_report_mask = v10.status_report_mask;
+  settings.junction_deviation = v10.junction_deviation;
+  settings.arc_tolerance = v10.arc_tolerance;
+  settings.rpm_max = v10.rpm_max;
+  settings.rpm_min = v10.rpm_min;
+  settings.flags = v10.flags;
+  settings.homing_dir_mask = v10.homing_dir_mask;
+  settings.homing_feed_rate = v10.homing_feed_rate;
+  settings.homing_seek_rate = v10.homing_seek_rate;
+  settings.homing_debounce_delay = v10.homing_debounce_delay;
+  settings.homing_pulloff = v10.homing_pulloff;
+  write_global_settings();
+}
+
+
+/**
+ * @brief Преобразует данные прежней версии к текущей структуре.
+ *
+ * Каждое преобразование переводит данные на одну версию вперёд, так что данные нескольких версий
+ * назад проходят все преобразования по очереди.
+ *
+ * @return true, если данные текущей версии или преобразованы, false, если версия неизвестна.
+ */
+static uint8_t settings_migrate()
+{
+  uint32_t version = settings_stored_version();
+  if (version == 10) { settings_migrate_v10(); version = 11; }
+  return(version == SETTINGS_VERSION);
+}
+
+
 /**
  * @brief Вспомогательный метод для установки настроек из командной строки.
  *
@@ -387,15 +527,27 @@ uint8_t settings_store_global_setting(uint8_t parameter, float value) {
 /**
  * @brief Инициализирует настройки Grbl.
  *
- * @note Читает глобальные настройки из EEPROM; если чтение неудачно, восстанавливает настройки по умолчанию.
+ * @note Восстанавливает данные из журнала EEPROM, преобразует данные прежних версий и проверяет CRC-32
+ *       всех областей. Повреждённая область восстанавливается из последней целой копии в журнале, а
+ *       если её нет, глобальные настройки получают значения по умолчанию.
  */
 void settings_init()
 {
-  if(!read_global_settings()) {
+  eeprom_store_load(); // Rebuild the stored data from the EEPROM log.
+  if (!settings_migrate()) {
+    // Unknown or damaged layout. Nothing can be kept.
     report_status_message(STATUS_SETTING_READ_FAIL, CLIENT_SERIAL);
     settings_restore(SETTINGS_RESTORE_ALL); // Force restore all EEPROM data.
     report_grbl_settings(CLIENT_SERIAL); // only the serial could be working at this point
   }
+  settings_verify();
+  if (!read_global_settings()) {
+    // Only the global settings are damaged. Keep the coordinate data and startup lines.
+    report_status_message(STATUS_SETTING_READ_FAIL, CLIENT_SERIAL);
+    settings_restore(SETTINGS_RESTORE_DEFAULTS);
+    report_grbl_settings(CLIENT_SERIAL);
+  }
+  eeprom_store_commit(); // Nothing moves yet. Store the converted or restored data right away.
 }
 
 /**
@@ -25,9 +25,10 @@
 #include "grbl.hpp"
 
 
-// Version of the EEPROM data. Will be used to migrate existing data from older versions of Grbl
-// when firmware is upgraded. Always stored in byte 0 of eeprom
-#define SETTINGS_VERSION 10  // NOTE: Check settings_reset() when moving to next version.
+// Version of the EEPROM data layout, stored in word EEPROM_KEY_VERSION of the EEPROM store. Data of
+// older versions is converted field by field when firmware is upgraded. When moving to the next
+// version, keep the old layout and add its conversion to settings_migrate() in settings.c.
+#define SETTINGS_VERSION 11
 
 // Define bit flag masks for the boolean settings in settings.flag.
 #define BIT_REPORT_INCHES      0
@@ -51,6 +52,7 @@
 // Define status reporting boolean enable bit flags in settings.status_report_mask
 #define BITFLAG_RT_STATUS_POSITION_TYPE     bit(0)
 #define BITFLAG_RT_STATUS_BUFFER_STATE      bit(1)
+#define BITFLAG_RT_STATUS_DELTA             bit(2) // Delta reports. See ENABLE_DELTA_STATUS_REPORT.
 
 // Define settings restore bitflags.
 #define SETTINGS_RESTORE_DEFAULTS bit(0)
@@ -61,28 +63,6 @@
   #define SETTINGS_RESTORE_ALL 0xFF // All bitflags
 #endif
 
-// Определение значений адресов памяти EEPROM для настроек и параметров Grbl
-// ПРИМЕЧАНИЕ. Объем EEPROM в Atmega328p составляет 1 КБ.  Верхняя половина зарезервирована для параметров и 
-// стартового скрипта.  Нижняя половина содержит глобальные настройки и место для будущих 
-// разработок.
-// Тут указана карта расположения данных EEPROM для ESP32, в ней памяти больше чем АТмега 328P
-// Комментарий указан из оригинальной GBRL 
-// 1 страница 128 байт - 32 слова
-#define EEPROM_ADDR_GLOBAL         1U     
-#define EEPROM_ADDR_PARAMETERS     1024U   
-#define EEPROM_ADDR_STARTUP_BLOCK  1536U  
-#define EEPROM_ADDR_BUILD_INFO     1792U  
-
-#define EEPROM_ADDR_GLOBAL_PAGE         1   // Для амура 1-8 страницы
-#define EEPROM_ADDR_PARAMETERS_PAGE     9   // Для амура 9-12 страницу  
-#define EEPROM_ADDR_STARTUP_BLOCK_PAGE  13  // Для амура 13-14 страница
-#define EEPROM_ADDR_BUILD_INFO_PAGE     15  // Для амура 15-16 страница
-
-#define EEPROM_ADDR_GLOBAL_COUNT_PAGE         8   // Для амура 1-8 страницы
-#define EEPROM_ADDR_PARAMETERS_COUNT_PAGE     4   // Для амура 9-12 страницу  
-#define EEPROM_ADDR_STARTUP_BLOCK_COUNT_PAGE  2 // Для амура 13-14 страница
-#define EEPROM_ADDR_BUILD_INFO_COUNT_PAGE     2  // Для амура 15-16 страница
-
 // Define EEPROM address indexing for coordinate parameters
 #define N_COORDINATE_SYSTEM 6  // Number of supported work coordinate systems (from index 1)
 #define SETTING_INDEX_NCOORD N_COORDINATE_SYSTEM+1 // Total number of system stored (from index 0)
@@ -96,7 +76,7 @@
 #define AXIS_SETTINGS_START_VAL  100 // NOTE: Reserving settings values >= 100 for axis settings. Up to 255.
 #define AXIS_SETTINGS_INCREMENT  10  // Must be greater than the number of axis settings
 
-// Global persistent settings (Stored from byte EEPROM_ADDR_GLOBAL onwards)
+// Global persistent settings (Stored from word EEPROM_KEY_GLOBAL of the EEPROM store onwards)
 typedef struct {
   // Axis settings
   float steps_per_mm[N_AXIS];
@@ -123,12 +103,25 @@ typedef struct {
   float homing_seek_rate;
   uint16_t homing_debounce_delay;
   float homing_pulloff;
-  uint8_t settings_version;
 
 } settings_t;
 extern settings_t settings;
 
-// Initialize the configuration subsystem (load settings from EEPROM)
+// Words of the EEPROM store (see eeprom.h) holding the persistent data. Each region starts on a
+// word boundary, so a change rewrites only the words it touches, and is followed by a CRC-32 word.
+// The regions are the version, the global settings, each coordinate set, each startup line and the
+// build info.
+#define SETTINGS_WORDS(size)        (((size)+3)/4)
+#define SETTINGS_REGION_WORDS(size) (SETTINGS_WORDS(size)+1) // Data and CRC-32
+#define EEPROM_KEY_VERSION          0
+#define EEPROM_KEY_GLOBAL           (EEPROM_KEY_VERSION+SETTINGS_REGION_WORDS(sizeof(uint32_t)))
+#define EEPROM_KEY_PARAMETERS       (EEPROM_KEY_GLOBAL+SETTINGS_REGION_WORDS(sizeof(settings_t)))
+#define EEPROM_KEY_STARTUP_BLOCK    (EEPROM_KEY_PARAMETERS+(SETTING_INDEX_NCOORD+1)*SETTINGS_REGION_WORDS(sizeof(float)*N_AXIS))
+#define EEPROM_KEY_BUILD_INFO       (EEPROM_KEY_STARTUP_BLOCK+N_STARTUP_LINE*SETTINGS_REGION_WORDS(LINE_BUFFER_SIZE))
+#define EEPROM_STORE_WORDS          (EEPROM_KEY_BUILD_INFO+SETTINGS_REGION_WORDS(LINE_BUFFER_SIZE))
+
+// Initialize the configuration subsystem (load settings from EEPROM, convert older layouts and
+// verify the CRC-32 of every region)
 void settings_init();
 
 // Helper function to clear and restore EEPROM defaults
@@ -22,7 +22,71 @@
 #include "grbl.hpp"
 
 #ifdef VARIABLE_SPINDLE
-  static float pwm_gradient; // Precalulated value to speed up rpm to PWM conversions.
+  // RPM to PWM lookup table, built by spindle_init() from the rpm settings or the piecewise linear
+  // model, so the step segment generator only indexes and interpolates it. Entry i is the PWM value
+  // at spindle_rpm_min + i/spindle_lut_scale rpm. Entries never decrease.
+  #define SPINDLE_PWM_LUT_SIZE 128 // Intervals between entries. Max 255.
+  static uint16_t spindle_pwm_lut[SPINDLE_PWM_LUT_SIZE+1];
+  static float spindle_rpm_min;
+  static float spindle_rpm_max;
+  static float spindle_lut_scale; // Intervals per rpm.
+
+  #ifdef ENABLE_SPINDLE_PWM_OUTPUT
+    static TIMER32_HandleTypeDef spindle_pwm_timer;
+    static TIMER32_CHANNEL_HandleTypeDef spindle_pwm_channel;
+  #endif
+
+
+  #ifdef ENABLE_PIECEWISE_LINEAR_SPINDLE
+    // Evaluates the piecewise linear fit model. The model is fit to the 8-bit PWM of the 328p, so
+    // it is scaled to the PWM range here.
+    static float spindle_model_pwm(float rpm)
+    {
+      float pwm;
+      #if (N_PIECES > 3)
+        if (rpm > RPM_POINT34) { pwm = RPM_LINE_A4*rpm - RPM_LINE_B4; } else
+      #endif
+      #if (N_PIECES > 2)
+        if (rpm > RPM_POINT23) { pwm = RPM_LINE_A3*rpm - RPM_LINE_B3; } else
+      #endif
+      #if (N_PIECES > 1)
+        if (rpm > RPM_POINT12) { pwm = RPM_LINE_A2*rpm - RPM_LINE_B2; } else
+      #endif
+      { pwm = RPM_LINE_A1*rpm - RPM_LINE_B1; }
+      return(pwm*(SPINDLE_PWM_MAX_VALUE/255.0));
+    }
+  #else
+    // Linear spindle speed model from the $30/$31 rpm settings.
+    // NOTE: A nonlinear model could be installed here. It only runs when the table is built.
+    static float spindle_model_pwm(float rpm)
+    {
+      return((rpm-spindle_rpm_min)*(SPINDLE_PWM_RANGE/(spindle_rpm_max-spindle_rpm_min)) + SPINDLE_PWM_MIN_VALUE);
+    }
+  #endif
+
+
+  // Builds the RPM to PWM lookup table. Called by spindle_init() at startup and on $30/$31 changes.
+  static void spindle_build_pwm_lut()
+  {
+    #ifdef ENABLE_PIECEWISE_LINEAR_SPINDLE
+      spindle_rpm_min = RPM_MIN;
+      spindle_rpm_max = RPM_MAX;
+    #else
+      spindle_rpm_min = settings.rpm_min;
+      spindle_rpm_max = settings.rpm_max;
+    #endif
+    if (spindle_rpm_min >= spindle_rpm_max) { return; } // No PWM range. spindle_compute_pwm_value() is on/off.
+    spindle_lut_scale = SPINDLE_PWM_LUT_SIZE/(spindle_rpm_max-spindle_rpm_min);
+    float rpm_per_entry = (spindle_rpm_max-spindle_rpm_min)/SPINDLE_PWM_LUT_SIZE;
+    uint16_t pwm_value = SPINDLE_PWM_MIN_VALUE;
+    uint8_t idx;
+    for (idx=0; idx<=SPINDLE_PWM_LUT_SIZE; idx++) {
+      float pwm = floor(spindle_model_pwm(spindle_rpm_min + idx*rpm_per_entry) + 0.5);
+      if (pwm > SPINDLE_PWM_MAX_VALUE) { pwm = SPINDLE_PWM_MAX_VALUE; }
+      if (pwm > pwm_value) { pwm_value = pwm; } // Clamps to SPINDLE_PWM_MIN_VALUE and keeps it monotonic.
+      spindle_pwm_lut[idx] = pwm_value;
+    }
+  }
 #endif
 
 
@@ -44,13 +108,33 @@ void spindle_init()
       HAL_GPIO_Init(SPINDLE_ENABLE_PORT, &GPIO_InitStruct);
     #endif
     
+    #ifdef ENABLE_SPINDLE_PWM_OUTPUT
+      // ШИМ на канале 32-битного таймера. Вершина счёта SPINDLE_PWM_MAX_VALUE, поэтому значение ШИМ
+      // записывается в регистр сравнения канала без пересчёта. Вывод переводится в режим таймера
+      // при инициализации канала.
+      spindle_pwm_timer.Instance = SPINDLE_PWM_TIMER;
+      spindle_pwm_timer.Top = SPINDLE_PWM_MAX_VALUE;
+      spindle_pwm_timer.State = TIMER32_STATE_DISABLE;
+      spindle_pwm_timer.Clock.Source = TIMER32_SOURCE_PRESCALER;
+      spindle_pwm_timer.Clock.Prescaler = SPINDLE_PWM_PRESCALER;
+      spindle_pwm_timer.InterruptMask = 0;
+      spindle_pwm_timer.CountMode = TIMER32_COUNTMODE_FORWARD;
+      HAL_Timer32_Init(&spindle_pwm_timer);
+
+      spindle_pwm_channel.TimerInstance = SPINDLE_PWM_TIMER;
+      spindle_pwm_channel.ChannelIndex = SPINDLE_PWM_CHANNEL;
+      spindle_pwm_channel.PWM_Invert = TIMER32_CHANNEL_NON_INVERTED_PWM;
+      spindle_pwm_channel.Mode = TIMER32_CHANNEL_MODE_PWM;
+      spindle_pwm_channel.CaptureEdge = TIMER32_CHANNEL_CAPTUREEDGE_RISING;
+      spindle_pwm_channel.OCR = SPINDLE_PWM_OFF_VALUE;
+      spindle_pwm_channel.Noise = TIMER32_CHANNEL_FILTER_OFF;
+      HAL_Timer32_Channel_Init(&spindle_pwm_channel);
+      HAL_Timer32_Channel_Enable(&spindle_pwm_channel);
+      HAL_Timer32_Value_Clear(&spindle_pwm_timer);
+      HAL_Timer32_Start(&spindle_pwm_timer);
+    #endif
     #ifdef VARIABLE_SPINDLE
-      // Настройка PWM пина, если определен
-      #ifdef SPINDLE_PWM_BIT
-        GPIO_InitStruct.Pin = SPINDLE_PWM_BIT;
-        HAL_GPIO_Init(SPINDLE_PWM_PORT, &GPIO_InitStruct);
-      #endif
-      pwm_gradient = SPINDLE_PWM_RANGE/(settings.rpm_max-settings.rpm_min);
+      spindle_build_pwm_lut();
     #endif
   #else
     #ifdef VARIABLE_SPINDLE
@@ -66,7 +150,7 @@ void spindle_init()
         SPINDLE_DIRECTION_DDR |= (1<<SPINDLE_DIRECTION_BIT); // Configure as output pin.
       #endif
 
-      pwm_gradient = SPINDLE_PWM_RANGE/(settings.rpm_max-settings.rpm_min);
+      spindle_build_pwm_lut();
 
     #else
 
@@ -164,9 +248,8 @@ void spindle_stop()
 {
 #ifdef ELRON_ACE_UNO
   // Для ELRON_ACE_UNO используем HAL функции для отключения шпинделя
-  #ifdef VARIABLE_SPINDLE
-    // Отключение PWM (если используется) - здесь может потребоваться остановка таймера
-    // Пока просто выключаем enable пин
+  #ifdef ENABLE_SPINDLE_PWM_OUTPUT
+    HAL_Timer32_Channel_OCR_Set(&spindle_pwm_channel, SPINDLE_PWM_OFF_VALUE); // Скважность 0, на выходе 0В.
   #endif
   #ifdef USE_SPINDLE_DIR_AS_ENABLE_PIN
     #ifdef INVERT_SPINDLE_ENABLE_PIN
@@ -207,12 +290,12 @@ void spindle_stop()
 #ifdef VARIABLE_SPINDLE
   // Sets spindle speed PWM output and enable pin, if configured. Called by spindle_set_state()
   // and stepper ISR. Keep routine small and efficient.
-  void spindle_set_speed(uint8_t pwm_value)
+  void spindle_set_speed(uint16_t pwm_value)
   {
 #ifdef ELRON_ACE_UNO
-    // Для ELRON_ACE_UNO управление PWM через HAL (если реализовано)
-    // Здесь можно установить duty cycle на соответствующем таймере
-    // Временно просто управляем enable пином в зависимости от значения PWM
+    #ifdef ENABLE_SPINDLE_PWM_OUTPUT
+      HAL_Timer32_Channel_OCR_Set(&spindle_pwm_channel, pwm_value); // Скважность ШИМ
+    #endif
     #ifdef SPINDLE_ENABLE_OFF_WITH_ZERO_SPEED
       if (pwm_value == SPINDLE_PWM_OFF_VALUE) {
         spindle_stop();
@@ -224,11 +307,7 @@ void spindle_stop()
         #endif
       }
     #else
-      if (pwm_value == SPINDLE_PWM_OFF_VALUE) {
-        // Отключение PWM (остановка таймера)
-      } else {
-        // Включение PWM (запуск таймера с заданным duty cycle)
-      }
+      // Как на Uno, скорость задаёт только ШИМ. Пином enable управляет spindle_set_state().
     #endif
 #else
     //SPINDLE_OCR_REGISTER = pwm_value; // Set PWM output level.
@@ -254,79 +333,38 @@ void spindle_stop()
   }
 
 
-  #ifdef ENABLE_PIECEWISE_LINEAR_SPINDLE
-
-    // Called by spindle_set_state() and step segment generator. Keep routine small and efficient.
-    uint8_t spindle_compute_pwm_value(float rpm) // 328p PWM register is 8-bit.
-    {
-      uint8_t pwm_value;
-      rpm *= (0.010*sys.spindle_speed_ovr); // Scale by spindle speed override value.
-      // Calculate PWM register value based on rpm max/min settings and programmed rpm.
-      if ((settings.rpm_min >= settings.rpm_max) || (rpm >= RPM_MAX)) {
-        rpm = RPM_MAX;
-        pwm_value = SPINDLE_PWM_MAX_VALUE;
-      } else if (rpm <= RPM_MIN) {
-        if (rpm == 0.0) { // S0 disables spindle
-          pwm_value = SPINDLE_PWM_OFF_VALUE;
-        } else {
-          rpm = RPM_MIN;
-          pwm_value = SPINDLE_PWM_MIN_VALUE;
-        }
-      } else {
-        // Compute intermediate PWM value with linear spindle speed model via piecewise linear fit model.
-        #if (N_PIECES > 3)
-          if (rpm > RPM_POINT34) {
-            pwm_value = floor(RPM_LINE_A4*rpm - RPM_LINE_B4);
-          } else
-        #endif
-        #if (N_PIECES > 2)
-          if (rpm > RPM_POINT23) {
-            pwm_value = floor(RPM_LINE_A3*rpm - RPM_LINE_B3);
-          } else
-        #endif
-        #if (N_PIECES > 1)
-          if (rpm > RPM_POINT12) {
-            pwm_value = floor(RPM_LINE_A2*rpm - RPM_LINE_B2);
-          } else
-        #endif
-        {
-          pwm_value = floor(RPM_LINE_A1*rpm - RPM_LINE_B1);
-        }
-      }
-      sys.spindle_speed = rpm;
-      return(pwm_value);
+  // Looks up the PWM value in the table built by spindle_build_pwm_lut() and interpolates between
+  // its entries, so no model equations are evaluated per segment.
+  uint16_t spindle_rpm_to_pwm(float rpm)
+  {
+    // Calculate PWM register value based on rpm max/min settings and programmed rpm.
+    if ((spindle_rpm_min >= spindle_rpm_max) || (rpm >= spindle_rpm_max)) {
+      return(SPINDLE_PWM_MAX_VALUE); // No PWM range possible. Set simple on/off spindle control pin state.
+    }
+    if (rpm <= spindle_rpm_min) {
+      if (rpm == 0.0) { return(SPINDLE_PWM_OFF_VALUE); } // S0 disables spindle
+      return(SPINDLE_PWM_MIN_VALUE); // Set minimum PWM output
     }
+    float index = (rpm-spindle_rpm_min)*spindle_lut_scale;
+    uint8_t idx = index;
+    if (idx >= SPINDLE_PWM_LUT_SIZE) { return(spindle_pwm_lut[SPINDLE_PWM_LUT_SIZE]); } // Round-off at rpm max.
+    uint16_t pwm_value = spindle_pwm_lut[idx];
+    return(pwm_value + (uint16_t)((spindle_pwm_lut[idx+1]-pwm_value)*(index-idx)));
+  }
 
-  #else
 
-    // Called by spindle_set_state() and step segment generator. Keep routine small and efficient.
-    uint8_t spindle_compute_pwm_value(float rpm) // 328p PWM register is 8-bit.
-    {
-      uint8_t pwm_value;
-      rpm *= (0.010*sys.spindle_speed_ovr); // Scale by spindle speed override value.
-      // Calculate PWM register value based on rpm max/min settings and programmed rpm.
-      if ((settings.rpm_min >= settings.rpm_max) || (rpm >= settings.rpm_max)) {
-        // No PWM range possible. Set simple on/off spindle control pin state.
-        sys.spindle_speed = settings.rpm_max;
-        pwm_value = SPINDLE_PWM_MAX_VALUE;
-      } else if (rpm <= settings.rpm_min) {
-        if (rpm == 0.0) { // S0 disables spindle
-          sys.spindle_speed = 0.0;
-          pwm_value = SPINDLE_PWM_OFF_VALUE;
-        } else { // Set minimum PWM output
-          sys.spindle_speed = settings.rpm_min;
-          pwm_value = SPINDLE_PWM_MIN_VALUE;
-        }
-      } else {
-        // Compute intermediate PWM value with linear spindle speed model.
-        // NOTE: A nonlinear model could be installed here, if required, but keep it VERY light-weight.
-        sys.spindle_speed = rpm;
-        pwm_value = floor((rpm-settings.rpm_min)*pwm_gradient) + SPINDLE_PWM_MIN_VALUE;
-      }
-      return(pwm_value);
-    }
+  // Called by spindle_set_state() and step segment generator. Keep routine small and efficient.
+  uint16_t spindle_compute_pwm_value(float rpm)
+  {
+    rpm *= (0.010*sys.spindle_speed_ovr); // Scale by spindle speed override value.
+    // Record the rpm the PWM value stands for.
+    if ((spindle_rpm_min >= spindle_rpm_max) || (rpm >= spindle_rpm_max)) { sys.spindle_speed = spindle_rpm_max; }
+    else if (rpm > spindle_rpm_min) { sys.spindle_speed = rpm; }
+    else if (rpm == 0.0) { sys.spindle_speed = 0.0; }
+    else { sys.spindle_speed = spindle_rpm_min; }
+    return(spindle_rpm_to_pwm(rpm));
+  }
 
-  #endif
 #endif
 
 
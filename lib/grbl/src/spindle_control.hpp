@@ -48,11 +48,15 @@ uint8_t spindle_get_state();
   void spindle_set_state(uint8_t state, float rpm); 
   
   // Sets spindle PWM quickly for stepper ISR. Also called by spindle_set_state().
-  // NOTE: 328p PWM register is 8-bit.
-  void spindle_set_speed(uint8_t pwm_value);
+  // NOTE: 328p PWM register is 8-bit. The MIK32 PWM is SPINDLE_PWM_BITS wide.
+  void spindle_set_speed(uint16_t pwm_value);
   
-  // Computes 328p-specific PWM register value for the given RPM for quick updating.
-  uint8_t spindle_compute_pwm_value(float rpm);
+  // Computes the PWM register value for the given RPM by table lookup, for quick updating. Applies
+  // the spindle speed override and sets sys.spindle_speed.
+  uint16_t spindle_compute_pwm_value(float rpm);
+
+  // Table lookup only. No override, and sys is left alone. Used for raster pixel powers.
+  uint16_t spindle_rpm_to_pwm(float rpm);
   
 #else
   
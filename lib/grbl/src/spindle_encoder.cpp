@@ -0,0 +1,198 @@
+/*
+  spindle_encoder.c - spindle index pulse timing for spindle-synchronized motion
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "grbl.hpp"
+
+#ifdef ENABLE_SPINDLE_SYNC
+
+// Last index pulse, written by the index interrupt. The period is zero until two pulses less than
+// SPINDLE_INDEX_PERIOD_MAX apart have been seen.
+static volatile uint32_t index_count;
+static volatile uint32_t index_time;
+static volatile uint32_t index_period;
+
+// Index pulse synchronized motions are timed from.
+static uint32_t sync_count;
+static uint32_t sync_time;
+static uint8_t sync_ready;
+
+#ifdef ELRON_ACE_UNO
+  static TIMER32_HandleTypeDef spindle_encoder_timer;
+#endif
+#ifdef SPINDLE_ENCODER_SIMULATED
+  static uint8_t simulated_turning;
+#endif
+
+
+void spindle_encoder_init()
+{
+  index_count = 0;
+  index_time = 0;
+  index_period = 0;
+  sync_ready = false;
+  #ifdef SPINDLE_ENCODER_SIMULATED
+    simulated_turning = false;
+  #endif
+  #ifdef ELRON_ACE_UNO
+    // Free-running over the full 32 bits, so time differences wrap correctly.
+    spindle_encoder_timer.Instance = SPINDLE_ENCODER_TIMER;
+    spindle_encoder_timer.Top = 0xFFFFFFFF;
+    spindle_encoder_timer.State = TIMER32_STATE_DISABLE;
+    spindle_encoder_timer.Clock.Source = TIMER32_SOURCE_PRESCALER;
+    spindle_encoder_timer.Clock.Prescaler = (F_CPU/SPINDLE_ENCODER_FREQUENCY)-1;
+    spindle_encoder_timer.InterruptMask = 0;
+    spindle_encoder_timer.CountMode = TIMER32_COUNTMODE_FORWARD;
+    HAL_Timer32_Init(&spindle_encoder_timer);
+    HAL_Timer32_Value_Clear(&spindle_encoder_timer);
+    HAL_Timer32_Start(&spindle_encoder_timer);
+    #ifndef SPINDLE_ENCODER_SIMULATED
+      PinInitInputIRQ(SPINDLE_INDEX_BIT, SPINDLE_INDEX_PORT, HAL_GPIO_PULL_UP, (HAL_GPIO_Line_Config)SPINDLE_INDEX_LINE_IRQ);
+    #endif
+  #endif
+}
+
+
+uint32_t spindle_encoder_time()
+{
+  #ifdef ELRON_ACE_UNO
+    return(HAL_Timer32_Value_Get(&spindle_encoder_timer));
+  #else
+    return(0);
+  #endif
+}
+
+
+void spindle_encoder_index(uint32_t time)
+{
+  uint32_t period = time-index_time;
+  if ((index_count == 0) || (period > SPINDLE_INDEX_PERIOD_MAX)) { period = 0; } // Starting up.
+  index_period = period;
+  index_time = time;
+  index_count++;
+}
+
+
+#if defined(ELRON_ACE_UNO) && !defined(SPINDLE_ENCODER_SIMULATED)
+void spindle_encoder_index_isr()
+{
+  uint32_t time = spindle_encoder_time(); // First, so the time is not delayed by the rest.
+  ClearGPIOInterruptLines(1 << (SPINDLE_INDEX_LINE_IRQ >> GPIO_IRQ_LINE_S));
+  spindle_encoder_index(time);
+}
+#endif
+
+
+#ifdef SPINDLE_ENCODER_SIMULATED
+// Records the index pulses a spindle turning at the commanded speed would have given since the
+// last call. Called before each read, so no timer interrupt is needed.
+static void spindle_encoder_simulate()
+{
+  float rpm = 0.0;
+  if (spindle_get_state() != SPINDLE_STATE_DISABLE) { rpm = sys.spindle_speed; }
+  if (rpm < SPINDLE_SYNC_MIN_RPM) {
+    simulated_turning = false;
+    index_period = 0; // Stopped at once.
+    return;
+  }
+  uint32_t now = spindle_encoder_time();
+  uint32_t period = (uint32_t)((60.0*SPINDLE_ENCODER_FREQUENCY)/rpm);
+  if (!simulated_turning) {
+    // Started at full speed, with an index pulse one period ago.
+    simulated_turning = true;
+    index_time = now-period;
+    index_count++;
+  }
+  uint32_t elapsed = now-index_time;
+  if (elapsed >= period) {
+    uint32_t pulses = elapsed/period;
+    index_count += pulses-1; // Skipped pulses. Only the time of the last one is needed.
+    index_time += (pulses-1)*period;
+    spindle_encoder_index(index_time+period);
+  }
+}
+#endif
+
+
+// Reads the last index pulse. Read again, if an index pulse came in between.
+static uint32_t spindle_encoder_read(uint32_t *time, uint32_t *period)
+{
+  #ifdef SPINDLE_ENCODER_SIMULATED
+    spindle_encoder_simulate();
+  #endif
+  uint32_t count;
+  do {
+    count = index_count;
+    *time = index_time;
+    *period = index_period;
+  } while (count != index_count);
+  return(count);
+}
+
+
+// Returns true, if the index pulses are recent enough for a turning spindle.
+static uint8_t spindle_encoder_is_turning(uint32_t time, uint32_t period)
+{
+  if (period == 0) { return(false); }
+  return((spindle_encoder_time()-time) <= 2*period);
+}
+
+
+float spindle_encoder_rpm()
+{
+  uint32_t time, period;
+  spindle_encoder_read(&time, &period);
+  if (!spindle_encoder_is_turning(time, period)) { return(0.0); }
+  return((60.0*SPINDLE_ENCODER_FREQUENCY)/period);
+}
+
+
+void spindle_encoder_sync_clear() { sync_ready = false; }
+
+uint8_t spindle_encoder_sync_ready() { return(sync_ready); }
+
+
+uint8_t spindle_encoder_wait_index()
+{
+  uint32_t time, period;
+  uint32_t start_count = spindle_encoder_read(&time, &period);
+  uint32_t count;
+  do {
+    protocol_execute_realtime(); // Check for any run-time commands
+    if (sys.abort) { return(false); } // Bail, if system abort.
+    count = spindle_encoder_read(&time, &period);
+    if (!spindle_encoder_is_turning(time, period)) { return(false); }
+  } while (count == start_count);
+  sync_count = count;
+  sync_time = time;
+  sync_ready = true;
+  return(true);
+}
+
+
+float spindle_encoder_sync_revs(float minutes)
+{
+  uint32_t time, period;
+  uint32_t count = spindle_encoder_read(&time, &period);
+  float revs = (float)(int32_t)(count-sync_count);
+  if (period == 0) { return(revs); }
+  // Signed, as the time may be before the last index pulse.
+  int32_t since_index = (int32_t)(sync_time + (uint32_t)(minutes*(60.0*SPINDLE_ENCODER_FREQUENCY)) - time);
+  return(revs + (float)since_index/(float)period);
+}
+
+#endif
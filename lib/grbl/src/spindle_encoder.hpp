@@ -0,0 +1,61 @@
+/*
+  spindle_encoder.h - spindle index pulse timing for spindle-synchronized motion
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef spindle_encoder_h
+#define spindle_encoder_h
+
+// Count rate of the index pulse timer. Its 32-bit count wraps every 71 minutes, which the
+// unsigned time differences below handle.
+#define SPINDLE_ENCODER_FREQUENCY 1000000 // (Hz)
+
+// Longest index period of a turning spindle. Slower pulses are treated as a stopped spindle.
+#define SPINDLE_INDEX_PERIOD_MAX ((uint32_t)((60.0*SPINDLE_ENCODER_FREQUENCY)/SPINDLE_SYNC_MIN_RPM))
+
+
+// Starts the index pulse timer and the index pin interrupt. Forgets the index pulses so far.
+void spindle_encoder_init();
+
+// Returns the index pulse timer count.
+uint32_t spindle_encoder_time();
+
+// Index pin interrupt. Records the time of the pulse and clears the interrupt line.
+void spindle_encoder_index_isr();
+
+// Records an index pulse at the given timer count. Called by the interrupt, or by the simulated
+// encoder.
+void spindle_encoder_index(uint32_t time);
+
+// Returns the spindle speed measured over the last revolution, or zero if the spindle is stopped,
+// i.e. the last index pulse is more than two periods or SPINDLE_INDEX_PERIOD_MAX old.
+float spindle_encoder_rpm();
+
+// Forgets the index pulse synchronized motions are timed from.
+void spindle_encoder_sync_clear();
+
+// Waits for the next index pulse and makes it the one synchronized motions are timed from.
+// Returns false, if the spindle stopped or a reset was issued while waiting.
+uint8_t spindle_encoder_wait_index();
+
+// Returns true, once spindle_encoder_wait_index() has set the index pulse to time from.
+uint8_t spindle_encoder_sync_ready();
+
+// Returns the spindle revolutions from the synchronizing index pulse to the given time after it,
+// in minutes. Interpolated, or extrapolated, at the speed of the last revolution.
+float spindle_encoder_sync_revs(float minutes);
+
+#endif
@@ -0,0 +1,38 @@
+/*
+  step_count.c - exact integer step bookkeeping for the segment generator
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "grbl.hpp"
+
+
+uint32_t step_count_remaining(float step_dist_remaining, uint32_t steps_remaining)
+{
+  if (step_dist_remaining <= 0.0) { return(0); } // End of block.
+  float n_steps_remaining = ceil(step_dist_remaining);
+  // Compared as float, so a distance beyond the 32-bit range never wraps.
+  if (n_steps_remaining >= (float)steps_remaining) { return(steps_remaining); }
+  return((uint32_t)n_steps_remaining);
+}
+
+
+float step_count_partial(uint32_t n_steps_remaining, float step_dist_remaining)
+{
+  float partial = (float)n_steps_remaining - step_dist_remaining;
+  if (partial < 0.0) { return(0.0); } // Clamped to steps_remaining in step_count_remaining().
+  if (partial > 1.0) { return(1.0); }
+  return(partial);
+}
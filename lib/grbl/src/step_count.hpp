@@ -0,0 +1,47 @@
+/*
+  step_count.h - exact integer step bookkeeping for the segment generator
+  Part of Grbl
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef step_count_h
+#define step_count_h
+
+#include <stdint.h>
+
+// The segment generator cuts a block into segments at float distances from the end of the block,
+// but hands out whole steps. The steps not yet handed out are kept as an exact integer, starting at
+// the block's step_event_count, and every segment takes the difference to the steps remaining at
+// its end. So the steps of all segments always add up to step_event_count exactly, however long the
+// block. A float step count is only exact up to 2^24 steps (about 42 m at 400 step/mm), and lost
+// steps above that.
+//
+// The float distance only places the segment ends and times the steps. Near 2^24 steps and above, a
+// segment end may be placed up to a step or two off its exact distance, which the next segment takes
+// up. The end of the block, at zero distance, is always exact.
+
+
+// Returns the whole steps remaining at step_dist_remaining steps from the end of the block: the
+// distance rounded up, but never more than steps_remaining, the whole steps remaining before the
+// segment. So a segment never has a negative step count, even when float round-off puts its end
+// a little before the start of the block.
+uint32_t step_count_remaining(float step_dist_remaining, uint32_t steps_remaining);
+
+// Returns the fraction of a step, 0 up to 1, by which the whole steps remaining n_steps_remaining
+// are ahead of the exact distance step_dist_remaining. The segment generator carries its time into
+// the next segment.
+float step_count_partial(uint32_t n_steps_remaining, float step_dist_remaining);
+
+#endif
@@ -56,6 +56,18 @@
   #endif
 #endif
 
+// Bresenham step counts are scaled up when copied to the stepper, by MAX_AMASS_LEVEL with AMASS and
+// doubled without. Raster pixel counts are scaled the same.
+#ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+  #define ST_STEP_COUNT_SHIFT MAX_AMASS_LEVEL
+#else
+  #define ST_STEP_COUNT_SHIFT 1
+#endif
+
+// Raster pixel PWM values are scaled by the segment speed over the scan feed rate, in fixed point.
+#define RASTER_SCALE_SHIFT 15
+#define RASTER_SCALE_ONE   (1UL << RASTER_SCALE_SHIFT)
+
 
 // Stores the planner block Bresenham algorithm execution data for the segments in the segment
 // buffer. Normally, this buffer is partially in-use, but, for the worst case scenario, it will
@@ -70,6 +82,19 @@ typedef struct {
   #ifdef VARIABLE_SPINDLE
     uint8_t is_pwm_rate_adjusted; // Tracks motions that require constant laser power/rate
   #endif
+  #ifdef USE_LINE_NUMBERS
+    int32_t line_number;
+  #endif
+  #ifdef ENABLE_DIGITAL_OUTPUTS
+    uint8_t digital_out_set;  // Synchronized M62/M63 output changes, applied at the first step.
+    uint8_t digital_out_clear;
+    uint16_t digital_out_epoch;
+  #endif
+  #ifdef ENABLE_RASTER
+    uint8_t raster_slot;      // Scanline stepped through by this block, or RASTER_SLOT_NONE.
+    uint16_t raster_pixels;
+    uint32_t raster_count;    // Pixel count, scaled like the axis step counts.
+  #endif
 } st_block_t;
 static st_block_t st_block_buffer[SEGMENT_BUFFER_SIZE-1];
 
@@ -87,8 +112,12 @@ typedef struct {
     uint8_t prescaler;      // Without AMASS, a prescaler is required to adjust for slow timing.
   #endif
   #ifdef VARIABLE_SPINDLE
-    uint8_t spindle_pwm;
+    uint16_t spindle_pwm;
+  #endif
+  #ifdef ENABLE_RASTER
+    uint16_t raster_scale;  // Pixel PWM scale for the segment speed. RASTER_SCALE_ONE at the feed rate.
   #endif
+  float rate;               // Speed at the end of this segment (mm/min). Published for reports.
 } segment_t;
 static segment_t segment_buffer[SEGMENT_BUFFER_SIZE];
 
@@ -117,11 +146,24 @@ typedef struct {
 
   uint16_t step_count;       // Steps remaining in line segment motion
   uint8_t exec_block_index; // Tracks the current st_block index. Change indicates new block.
+  #ifdef ENABLE_RASTER
+    uint16_t *raster_pwm;     // Pixel PWM values of the executing scanline. NULL when done or none.
+    uint16_t raster_pixel;    // Pixel being burnt.
+    uint32_t counter_raster;  // Bresenham counter of the pixels, as for an extra axis.
+    uint32_t raster_increment;
+  #endif
   st_block_t *exec_block;   // Pointer to the block data for the segment being executed
   segment_t *exec_segment;  // Pointer to the segment being executed
 } stepper_t;
 static stepper_t st;
 
+// Published motion state, double buffered. The ISR writes the buffer readers are not using, then
+// advances the sequence number, whose low bit selects the current buffer. A reader copies the current
+// buffer and retries if the number changed meanwhile, since the ISR may then have started to write
+// the buffer it copied. Publishing happens once per segment, so a retry is rare.
+static volatile st_snapshot_t st_snapshot[2];
+static volatile uint8_t st_snapshot_seq;
+
 // Step segment ring buffer indices
 static volatile uint8_t segment_buffer_tail;
 static uint8_t segment_buffer_head;
@@ -146,13 +188,13 @@ typedef struct {
   uint8_t recalculate_flag;
 
   float dt_remainder;
-  float steps_remaining;
+  uint32_t steps_remaining; // Whole steps of the block not yet in a segment. See step_count.h.
   float step_per_mm;
   float req_mm_increment;
 
   #ifdef PARKING_ENABLE
     uint8_t last_st_block_index;
-    float last_steps_remaining;
+    uint32_t last_steps_remaining;
     float last_step_per_mm;
     float last_dt_remainder;
   #endif
@@ -168,7 +210,15 @@ typedef struct {
 
   #ifdef VARIABLE_SPINDLE
     float inv_rate;    // Used by PWM laser mode to speed up segment calculations.
-    uint8_t current_spindle_pwm;
+    uint16_t current_spindle_pwm;
+  #endif
+
+  #ifdef ENABLE_SPINDLE_SYNC
+    float sync_time;       // Profile time from the start of the block to the end of the segment buffer (min)
+    float sync_mm;         // Distance covered in that time (mm)
+    float sync_rate;       // Cruise speed the spindle position is tracked around (mm/min)
+    float sync_offset;     // Lag of the block behind the spindle position, set at the start of cruise (mm)
+    uint8_t sync_locked;
   #endif
 } st_prep_t;
 static st_prep_t prep;
@@ -249,6 +299,50 @@ void st_wake_up()
 }
 
 
+// Publishes sys_position and the given rate to the snapshot buffer readers are not using. Called by
+// the stepper ISR, or while it is stopped.
+static void st_publish_snapshot(float rate)
+{
+  volatile st_snapshot_t *snapshot = &st_snapshot[(st_snapshot_seq+1) & 1];
+  uint8_t idx;
+  for (idx=0; idx<N_AXIS; idx++) { snapshot->position[idx] = sys_position[idx]; }
+  snapshot->rate = rate;
+  #ifdef USE_LINE_NUMBERS
+    if (st.exec_block != NULL) { snapshot->line_number = st.exec_block->line_number; }
+    else { snapshot->line_number = 0; }
+  #endif
+  st_snapshot_seq++; // Readers switch to the new buffer.
+}
+
+
+#ifdef ENABLE_RASTER
+  // Returns the PWM value of the pixel being burnt, scaled to the speed of the executing segment.
+  // Scales the PWM value rather than the power, which is the same for a linear $30/$31 range from 0.
+  static uint16_t st_raster_pixel_pwm()
+  {
+    return(((uint32_t)st.raster_pwm[st.raster_pixel]*st.exec_segment->raster_scale) >> RASTER_SCALE_SHIFT);
+  }
+#endif
+
+
+void st_get_snapshot(st_snapshot_t *snapshot)
+{
+  uint8_t seq, idx;
+  do {
+    seq = st_snapshot_seq;
+    volatile st_snapshot_t *current = &st_snapshot[seq & 1];
+    for (idx=0; idx<N_AXIS; idx++) { snapshot->position[idx] = current->position[idx]; }
+    snapshot->rate = current->rate;
+    #ifdef USE_LINE_NUMBERS
+      snapshot->line_number = current->line_number;
+    #endif
+  } while (seq != st_snapshot_seq); // The ISR published while copying. Copy again.
+}
+
+
+void st_publish_position() { st_publish_snapshot(0.0f); }
+
+
 // Stepper shutdown
 void st_go_idle()
 {
@@ -284,6 +378,7 @@ void st_go_idle()
   // Для ELRON_ACE_UNO: отключить прерывание таймера через HAL
   // HAL_Timer16_DisableInterrupt(&htimer16);
 #endif
+  st_publish_snapshot(0.0f); // Position where the steppers stopped, with no rate.
 }
 
 
@@ -412,8 +507,26 @@ void TIMER1_COMPA_vect(void)
 
         // Initialize Bresenham line and distance counters
         st.counter_x = st.counter_y = st.counter_z = st.counter_a = st.counter_b = st.counter_c = st.counter_d = st.counter_e = (st.exec_block->step_event_count >> 1);
+
+        #ifdef ENABLE_RASTER
+          // The pixel counter starts at zero, not halfway, so pixel boundaries fall on the pitch
+          // from the scan start instead of half a pixel off.
+          st.raster_pixel = 0;
+          st.counter_raster = 0;
+          if (st.exec_block->raster_slot == RASTER_SLOT_NONE) { st.raster_pwm = NULL; }
+          else { st.raster_pwm = raster_slot_pwm(st.exec_block->raster_slot); }
+        #endif
+
+        #ifdef ENABLE_DIGITAL_OUTPUTS
+          // Apply the block's M62/M63 changes just prior to its first step.
+          if (st.exec_block->digital_out_set | st.exec_block->digital_out_clear) {
+            digital_output_write_sync(st.exec_block->digital_out_set, st.exec_block->digital_out_clear,
+                st.exec_block->digital_out_epoch);
+          }
+        #endif
       }
       st.dir_outbits = st.exec_block->direction_bits ^ dir_port_invert_mask;
+      st_publish_snapshot(st.exec_segment->rate); // Segment boundary. Position and rate agree.
 
       #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
         // With AMASS enabled, adjust Bresenham axis increment counters according to AMASS level.
@@ -425,10 +538,20 @@ void TIMER1_COMPA_vect(void)
 		    // st.steps[C_AXIS] = st.exec_block->steps[C_AXIS] >> st.exec_segment->amass_level;
 		    // st.steps[D_AXIS] = st.exec_block->steps[D_AXIS] >> st.exec_segment->amass_level;
 		    // st.steps[E_AXIS] = st.exec_block->steps[E_AXIS] >> st.exec_segment->amass_level;
+        #ifdef ENABLE_RASTER
+          st.raster_increment = st.exec_block->raster_count >> st.exec_segment->amass_level;
+        #endif
+      #elif defined(ENABLE_RASTER)
+        st.raster_increment = st.exec_block->raster_count;
       #endif
 
       #ifdef VARIABLE_SPINDLE
-        // Set real-time spindle output as segment is loaded, just prior to the first step.
+        // Set real-time spindle output as segment is loaded, just prior to the first step. Scanlines
+        // set the power of the pixel instead.
+        #ifdef ENABLE_RASTER
+          if (st.raster_pwm != NULL) { spindle_set_speed(st_raster_pixel_pwm()); }
+          else
+        #endif
         spindle_set_speed(st.exec_segment->spindle_pwm);
       #endif
 
@@ -544,6 +667,23 @@ void TIMER1_COMPA_vect(void)
   // During a homing cycle, lock out and prevent desired axes from moving.
   if (sys.state == STATE_HOMING) { st.step_outbits &= sys.homing_axis_lock; }
 
+  #ifdef ENABLE_RASTER
+    // Step through the scanline pixels with the motion. The pixel count never exceeds the step
+    // count, so at most one pixel boundary is passed per step, and the last one on the last step.
+    if (st.raster_pwm != NULL) {
+      st.counter_raster += st.raster_increment;
+      if (st.counter_raster >= st.exec_block->step_event_count) {
+        st.counter_raster -= st.exec_block->step_event_count;
+        if (++st.raster_pixel < st.exec_block->raster_pixels) { spindle_set_speed(st_raster_pixel_pwm()); }
+        else {
+          spindle_set_speed(SPINDLE_PWM_OFF_VALUE);
+          st.raster_pwm = NULL;
+          raster_slot_done();
+        }
+      }
+    }
+  #endif
+
   st.step_count--; // Decrement step events count
   if (st.step_count == 0) {
     // Segment is complete. Discard current segment and advance segment indexing.
@@ -647,6 +787,7 @@ void st_reset()
   // Для ELRON_ACE_UNO: установить таймер 0 через HAL
   // HAL_Timer0_SetCompare(...);
 #endif
+  st_publish_snapshot(0.0f);
 }
 
 
@@ -838,6 +979,15 @@ void st_prep_buffer()
         // segment buffer finishes the prepped block, but the stepper ISR is still executing it.
         st_prep_block = &st_block_buffer[prep.st_block_index];
         st_prep_block->direction_bits = pl_block->direction_bits;
+        #ifdef USE_LINE_NUMBERS
+          st_prep_block->line_number = pl_block->line_number;
+        #endif
+        #ifdef ENABLE_DIGITAL_OUTPUTS
+          // System motions (homing, parking) are planned with zeroed line data, so they change no outputs.
+          st_prep_block->digital_out_set = pl_block->digital_out_set;
+          st_prep_block->digital_out_clear = pl_block->digital_out_clear;
+          st_prep_block->digital_out_epoch = pl_block->digital_out_epoch;
+        #endif
         uint8_t idx;
         #ifndef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
           for (idx=0; idx<N_AXIS; idx++) { st_prep_block->steps[idx] = (pl_block->steps[idx] << 1); }
@@ -850,11 +1000,28 @@ void st_prep_buffer()
           st_prep_block->step_event_count = pl_block->step_event_count << MAX_AMASS_LEVEL;
         #endif
 
+        #ifdef ENABLE_RASTER
+          // Scanline pixels are stepped like an extra axis with one step per pixel. Clamped to the
+          // step count, so the last pixel always completes and releases the slot.
+          st_prep_block->raster_slot = pl_block->raster_slot;
+          if (pl_block->raster_slot != RASTER_SLOT_NONE) {
+            uint32_t pixels = raster_slot_pixels(pl_block->raster_slot);
+            if (pixels > pl_block->step_event_count) { pixels = pl_block->step_event_count; }
+            st_prep_block->raster_pixels = pixels;
+            st_prep_block->raster_count = pixels << ST_STEP_COUNT_SHIFT;
+          }
+        #endif
+
         // Initialize segment buffer data for generating the segments.
-        prep.steps_remaining = (float)pl_block->step_event_count;
-        prep.step_per_mm = prep.steps_remaining/pl_block->millimeters;
+        prep.steps_remaining = pl_block->step_event_count;
+        prep.step_per_mm = pl_block->step_event_count/pl_block->millimeters;
         prep.req_mm_increment = REQ_MM_INCREMENT_SCALAR/prep.step_per_mm;
         prep.dt_remainder = 0.0; // Reset for new segment block
+        #ifdef ENABLE_SPINDLE_SYNC
+          prep.sync_time = 0.0;
+          prep.sync_mm = 0.0;
+          prep.sync_locked = false;
+        #endif
 
         if ((sys.step_control & STEP_CONTROL_EXECUTE_HOLD) || (prep.recalculate_flag & PREP_FLAG_DECEL_OVERRIDE)) {
           // New block loaded mid-hold. Override planner block entry speed to enforce deceleration.
@@ -995,6 +1162,38 @@ void st_prep_buffer()
       the end of planner block (typical) or mid-block at the end of a forced deceleration,
       such as from a feed hold.
     */
+    #ifdef ENABLE_SPINDLE_SYNC
+      /* ---------------------------------------------------------------------------------
+        Spindle-synchronized cruise. The speed of each cruise segment is set so the block
+        reaches the spindle position at the end of the segment. The lag locked at the start
+        of cruise is that of a spindle turning at exactly the cruise speed, so the thread
+        keeps its angle to the index pulse on every pass and only deviations are corrected.
+      */
+      if ((pl_block->feed_per_rev > 0.0) && (prep.ramp_type == RAMP_CRUISE) && spindle_encoder_sync_ready() &&
+          bit_isfalse(sys.step_control,STEP_CONTROL_EXECUTE_HOLD)) {
+        if (spindle_encoder_rpm() == 0.0) {
+          system_set_exec_state_flag(EXEC_FEED_HOLD); // Spindle stopped. Stop the motion with it.
+        } else {
+          if (!prep.sync_locked) {
+            prep.sync_rate = prep.maximum_speed;
+            prep.sync_offset = prep.sync_rate*prep.sync_time - prep.sync_mm;
+            prep.sync_locked = true;
+          }
+          float speed = (pl_block->feed_per_rev*spindle_encoder_sync_revs(prep.sync_time+DT_SEGMENT)
+                         - prep.sync_offset - prep.sync_mm)/DT_SEGMENT;
+          float correction = SPINDLE_SYNC_MAX_CORRECTION*prep.sync_rate;
+          speed = min(max(speed, prep.sync_rate-correction), prep.sync_rate+correction);
+          // Move the start of the deceleration for the new speed, unless it is already due.
+          float decelerate_after = max(0.5*(speed*speed-prep.exit_speed*prep.exit_speed)/pl_block->acceleration, 0.0);
+          if (decelerate_after < pl_block->millimeters) {
+            prep.maximum_speed = speed;
+            prep.current_speed = speed;
+            prep.decelerate_after = decelerate_after;
+          }
+        }
+      }
+    #endif
+
     float dt_max = DT_SEGMENT; // Maximum segment time
     float dt = 0.0; // Initialize segment time
     float time_var = dt_max; // Time worker variable
@@ -1079,43 +1278,17 @@ void st_prep_buffer()
       }
     } while (mm_remaining > prep.mm_complete); // **Complete** Exit loop. Profile complete.
 
-    #ifdef VARIABLE_SPINDLE
-      /* -----------------------------------------------------------------------------------
-        Compute spindle speed PWM output for step segment
-      */
-
-      if (st_prep_block->is_pwm_rate_adjusted || (sys.step_control & STEP_CONTROL_UPDATE_SPINDLE_PWM)) {
-        if (pl_block->condition & (PL_COND_FLAG_SPINDLE_CW | PL_COND_FLAG_SPINDLE_CCW)) {
-          float rpm = pl_block->spindle_speed;
-          // NOTE: Feed and rapid overrides are independent of PWM value and do not alter laser power/rate.
-          if (st_prep_block->is_pwm_rate_adjusted) { rpm *= (prep.current_speed * prep.inv_rate); }
-          // If current_speed is zero, then may need to be rpm_min*(100/MAX_SPINDLE_SPEED_OVERRIDE)
-          // but this would be instantaneous only and during a motion. May not matter at all.
-          prep.current_spindle_pwm = spindle_compute_pwm_value(rpm);
-        } else {
-          sys.spindle_speed = 0.0;
-          prep.current_spindle_pwm = 0; //SPINDLE_PWM_OFF_VALUE;
-        }
-        bit_false(sys.step_control,STEP_CONTROL_UPDATE_SPINDLE_PWM);
-      }
-      prep_segment->spindle_pwm = prep.current_spindle_pwm; // Reload segment PWM value
-
-    #endif
-
     /* -----------------------------------------------------------------------------------
        Compute segment step rate, steps to execute, and apply necessary rate corrections.
        NOTE: Steps are computed by direct scalar conversion of the millimeter distance
        remaining in the block, rather than incrementally tallying the steps executed per
        segment. This helps in removing floating point round-off issues of several additions.
-       However, since floats have only 7.2 significant digits, long moves with extremely
-       high step counts can exceed the precision of floats, which can lead to lost steps.
-       Fortunately, this scenario is highly unlikely and unrealistic in CNC machines
-       supported by Grbl (i.e. exceeding 10 meters axis travel at 200 step/mm).
+       The steps remaining are kept as an exact integer, so long moves with step counts beyond
+       the precision of floats still execute every step. See step_count.h.
     */
     float step_dist_remaining = prep.step_per_mm*mm_remaining; // Convert mm_remaining to steps
-    float n_steps_remaining = ceil(step_dist_remaining); // Round-up current steps remaining
-    float last_n_steps_remaining = ceil(prep.steps_remaining); // Round-up last steps remaining
-    prep_segment->n_step = last_n_steps_remaining-n_steps_remaining; // Compute number of steps to execute.
+    uint32_t n_steps_remaining = step_count_remaining(step_dist_remaining, prep.steps_remaining); // Round-up current steps remaining
+    prep_segment->n_step = prep.steps_remaining-n_steps_remaining; // Compute number of steps to execute.
 
     // Bail if we are at the end of a feed hold and don't have a step to execute.
     if (prep_segment->n_step == 0) {
@@ -1138,8 +1311,58 @@ void st_prep_buffer()
     // adjusts the whole segment rate to keep step output exact. These rate adjustments are
     // typically very small and do not adversely effect performance, but ensures that Grbl
     // outputs the exact acceleration and velocity profiles as computed by the planner.
+    #ifdef ENABLE_SPINDLE_SYNC
+      // The steps of the segment take its profile time in total. The partial step only shifts them.
+      prep.sync_time += dt;
+      prep.sync_mm += pl_block->millimeters - mm_remaining;
+    #endif
+
     dt += prep.dt_remainder; // Apply previous segment partial step execute time
-    float inv_rate = dt/(last_n_steps_remaining - step_dist_remaining); // Compute adjusted step rate inverse
+    float step_partial = step_count_partial(n_steps_remaining, step_dist_remaining);
+    float inv_rate = dt/(prep_segment->n_step + step_partial); // Compute adjusted step rate inverse
+
+    #ifdef VARIABLE_SPINDLE
+      /* -----------------------------------------------------------------------------------
+        Compute spindle speed PWM output for step segment. Done once the step rate is known, so
+        the laser power can follow it.
+      */
+
+      float rate_scale = 1.0;
+      if (st_prep_block->is_pwm_rate_adjusted) {
+        #ifdef LASER_POWER_FROM_STEP_RATE
+          // Scale by the speed the segment is stepped at, 1/(inv_rate*step_per_mm), rather than the
+          // planned speed at its end. The ISR runs the whole segment at this one rate.
+          rate_scale = prep.inv_rate/(inv_rate*prep.step_per_mm);
+        #else
+          rate_scale = prep.current_speed*prep.inv_rate;
+        #endif
+      }
+      if (st_prep_block->is_pwm_rate_adjusted || (sys.step_control & STEP_CONTROL_UPDATE_SPINDLE_PWM)) {
+        if (pl_block->condition & (PL_COND_FLAG_SPINDLE_CW | PL_COND_FLAG_SPINDLE_CCW)) {
+          // NOTE: Feed and rapid overrides are independent of PWM value and do not alter laser power/rate.
+          float rpm = pl_block->spindle_speed*rate_scale;
+          // If current_speed is zero, then may need to be rpm_min*(100/MAX_SPINDLE_SPEED_OVERRIDE)
+          // but this would be instantaneous only and during a motion. May not matter at all.
+          prep.current_spindle_pwm = spindle_compute_pwm_value(rpm);
+        } else {
+          sys.spindle_speed = 0.0;
+          prep.current_spindle_pwm = 0; //SPINDLE_PWM_OFF_VALUE;
+        }
+        bit_false(sys.step_control,STEP_CONTROL_UPDATE_SPINDLE_PWM);
+        #ifdef ENABLE_RASTER
+          // Scanline power is set per pixel by the stepper interrupt. Keep it off here, so it does
+          // not carry over into following blocks that do not update it.
+          if (pl_block->raster_slot != RASTER_SLOT_NONE) { prep.current_spindle_pwm = SPINDLE_PWM_OFF_VALUE; }
+        #endif
+      }
+      prep_segment->spindle_pwm = prep.current_spindle_pwm; // Reload segment PWM value
+      #ifdef ENABLE_RASTER
+        // Pixel PWM values are computed for the scan feed rate. Scale them like the power above, so a
+        // scan slowed by a feed hold or a late continuation frame does not burn darker.
+        if (rate_scale < 1.0) { prep_segment->raster_scale = rate_scale*RASTER_SCALE_ONE; }
+        else { prep_segment->raster_scale = RASTER_SCALE_ONE; }
+      #endif
+    #endif
 
     // Compute CPU cycles per step for the prepped segment.
     uint32_t cycles = ceil( (TICKS_PER_MICROSECOND*1000000*60)*inv_rate ); // (cycles/step)
@@ -1175,6 +1398,8 @@ void st_prep_buffer()
       }
     #endif
 
+    prep_segment->rate = prep.current_speed;
+
     // Segment complete! Increment segment buffer indices, so stepper ISR can immediately execute it.
     segment_buffer_head = segment_next_head;
     if ( ++segment_next_head == SEGMENT_BUFFER_SIZE ) { segment_next_head = 0; }
@@ -1182,7 +1407,7 @@ void st_prep_buffer()
     // Update the appropriate planner and segment data.
     pl_block->millimeters = mm_remaining;
     prep.steps_remaining = n_steps_remaining;
-    prep.dt_remainder = (n_steps_remaining - step_dist_remaining)*inv_rate;
+    prep.dt_remainder = step_partial*inv_rate;
 
     // Check for exit conditions and flag to load next planner block.
     if (mm_remaining == prep.mm_complete) {
@@ -1210,14 +1435,10 @@ void st_prep_buffer()
 }
 
 
-// Called by realtime status reporting to fetch the current speed being executed. This value
-// however is not exactly the current speed, but the speed computed in the last step segment
-// in the segment buffer. It will always be behind by up to the number of segment blocks (-1)
-// divided by the ACCELERATION TICKS PER SECOND in seconds.
+// Called by realtime status reporting to fetch the current speed being executed. This is the
+// speed at the end of the segment the stepper ISR is executing, as published when it loaded the
+// segment, and zero when the steppers are idle.
 float st_get_realtime_rate()
 {
-  if (sys.state & (STATE_CYCLE | STATE_HOMING | STATE_HOLD | STATE_JOG | STATE_SAFETY_DOOR)){
-    return prep.current_speed;
-  }
-  return 0.0f;
+  return(st_snapshot[st_snapshot_seq & 1].rate);
 }
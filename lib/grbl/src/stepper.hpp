@@ -56,4 +56,21 @@ void st_update_plan_block_parameters();
 // Called by realtime status reporting if realtime rate reporting is enabled in config.h.
 float st_get_realtime_rate();
 
+// Motion state published by the stepper ISR each time it loads a segment, and when the steppers go
+// idle. Reports and probing read it with st_get_snapshot(), without disabling interrupts, instead of
+// the position counters the ISR is updating.
+typedef struct {
+  int32_t position[N_AXIS]; // Machine position (steps) at the start of the executing segment.
+  float rate;               // Planned speed at the end of the executing segment (mm/min). Zero when idle.
+  #ifdef USE_LINE_NUMBERS
+    int32_t line_number;    // Line number of the executing block.
+  #endif
+} st_snapshot_t;
+
+// Copies the last published motion state.
+void st_get_snapshot(st_snapshot_t *snapshot);
+
+// Publishes sys_position after the main program sets it with the steppers idle, as homing does.
+void st_publish_position();
+
 #endif
@@ -167,6 +167,25 @@ uint8_t system_execute_line(char *line, uint8_t client)
       if(line[2] != '=') { return(STATUS_INVALID_STATEMENT); }
       return(gc_execute_line(line, client)); // ПРИМЕЧАНИЕ: $J= игнорируется внутри парсера g-кода и используется для обнаружения движений ручного перемещения.
       break;
+    #ifdef ENABLE_AUTO_REPORT
+      case 'Q' : // Интервал автоотчётов о состоянии: $Q выводит его, $Q=ms задаёт, $Q=0 выключает. В любом состоянии.
+        if (line[2] == 0) {
+          grbl_sendf(client, "[AUTO:%u]\r\n", report_auto_get_interval());
+          break;
+        }
+        if (line[2] != '=') { return(STATUS_INVALID_STATEMENT); }
+        char_counter = 3;
+        if (!read_float(line, &char_counter, &value)) { return(STATUS_BAD_NUMBER_FORMAT); }
+        if (line[char_counter] != 0) { return(STATUS_INVALID_STATEMENT); }
+        if ((value != trunc(value)) || ((value != 0) &&
+            ((value < AUTO_REPORT_INTERVAL_MIN) || (value > AUTO_REPORT_INTERVAL_MAX)))) { return(STATUS_INVALID_STATEMENT); }
+        report_auto_set_interval((uint16_t)value);
+        break;
+    #endif
+    #ifdef ENABLE_JOB_STORE
+      case 'F' : // Хранилище заданий. Требования к состоянию проверяются внутри.
+        return(job_store_execute_line(line, client));
+    #endif
     case '$': case 'G': case 'C': case 'X':
       if ( line[2] != 0 ) { return(STATUS_INVALID_STATEMENT); }
       switch( line[1] ) {
@@ -233,7 +252,29 @@ uint8_t system_execute_line(char *line, uint8_t client)
             if (line[2] == 0) { system_execute_startup(line); }
           }
           break;
-        case 'S' : // Переводит Grbl в спящий режим [IDLE/ALARM]
+        #ifdef ENABLE_ACK_BATCHING
+          case 'A' : // Подтверждать строки пачками: $A=N даёт один ответ ok:N на N строк. [IDLE/ALARM]
+            if (line[2] != '=') { return(STATUS_INVALID_STATEMENT); }
+            char_counter = 3;
+            if (!read_float(line, &char_counter, &value)) { return(STATUS_BAD_NUMBER_FORMAT); }
+            if (line[char_counter] != 0) { return(STATUS_INVALID_STATEMENT); }
+            if ((value < 0) || (value > ACK_BATCH_MAX) || (value != trunc(value))) { return(STATUS_INVALID_STATEMENT); }
+            report_ack_request((uint8_t)value);
+            break;
+        #endif
+        #ifdef ENABLE_SERIAL_FRAMING
+          case 'B' : // Перейти в режим кадров. Ответ ok отправляется ещё текстом. [IDLE/ALARM]
+            if (line[2] != 0) { return(STATUS_INVALID_STATEMENT); }
+            if ((client != CLIENT_SERIAL) || frame_mode_active()) { return(STATUS_INVALID_STATEMENT); }
+            frame_enter();
+            break;
+        #endif
+        case 'S' :
+          if (!strcmp(&line[2], "AVE")) { // Записать изменённые настройки в EEPROM сейчас [IDLE/ALARM]
+            eeprom_store_commit();
+            break;
+          }
+          // Переводит Grbl в спящий режим [IDLE/ALARM]
           if ((line[2] != 'L') || (line[3] != 'P') || (line[4] != 0)) { return(STATUS_INVALID_STATEMENT); }
           system_set_exec_state_flag(EXEC_SLEEP); // Установить для немедленного выполнения спящего режима
           break;
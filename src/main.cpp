@@ -46,6 +46,9 @@ void setup()
   // Инициализация системы при включении питания.
   serial_init();   // Настройка последовательного соединения
   eeprom_init();   // Инициализация EEPROM
+  #ifdef ENABLE_JOB_STORE
+    job_store_init(); // Поиск заданий во флеш-памяти и закрытие прерванной загрузки
+  #endif
   settings_init(); // Загрузка настроек Grbl из EEPROM
   stepper_init();  // Конфигурация выводов шагового двигателя и таймеров прерываний
   system_init();   // Конфигурация выводов и прерываний по изменению состояния выводов
@@ -97,14 +100,45 @@ extern "C"
 
     if (EPIC_CHECK_GPIO_IRQ())
     {
+      #if defined(ENABLE_SPINDLE_SYNC) && !defined(SPINDLE_ENCODER_SIMULATED)
+      if (HAL_GPIO_LineInterruptState(SPINDLE_INDEX_LINE_IRQ))
+      {
+        spindle_encoder_index_isr(); // Время индексного импульса шпинделя, до остальной обработки
+      }
+      #endif
       pin_limit_vect();
     }
 
+    #ifdef ENABLE_AUTO_REPORT
+    if (AUTO_REPORT_TIMER_IRQ())
+    {
+      report_auto_timer_isr();
+      HAL_EPIC_Clear(AUTO_REPORT_TIMER_EPIC_MASK);
+    }
+    #endif
+
     if (EPIC_CHECK_UART_0())
     {
+      /* Передача: следующий байт из буфера передачи */
+      if ((UART_0->CONTROL1 & UART_CONTROL1_TXEIE_M) && (UART_0->FLAGS & UART_FLAGS_TXE_M))
+      {
+        serial_tx_isr();
+      }
+
       /* Прием данных: запись в буфер */
+      #ifdef ENABLE_SERIAL_FRAMING
+      if (HAL_USART_RXNE_ReadFlag(UART_0) && frame_mode_active())
+      {
+        // Режим кадров: байты разбирает приёмник кадров, строковый буфер не используется.
+        frame_receive_byte(serial_read(CLIENT_SERIAL));
+        HAL_USART_RXNE_ClearFlag(UART_0);
+      }
+      else
+      #endif
       if (HAL_USART_RXNE_ReadFlag(UART_0))
       {
+        // Расширенные команды реального времени (0x80 и выше) здесь не выполняются: эти байты
+        // входят в токенизированный g-код. См. gcode_token.h.
         line[buf_pointer] = serial_read(CLIENT_SERIAL);
         if (!(line_flags & LINE_FLAG_LINE_READ))
         {
@@ -114,7 +148,7 @@ extern "C"
           {
             line[buf_pointer] = '\0';
             buf_pointer = 0;
-            line_flags &= ~(LINE_FLAG_LINE_READ);
+            line_flags &= ~(LINE_FLAG_LINE_READ | LINE_FLAG_LINE_STARTED);
           }
           else
           {
@@ -172,6 +206,7 @@ extern "C"
               }
             }
             buf_pointer += 1;
+            line_flags |= LINE_FLAG_LINE_STARTED;
             if (buf_pointer >= LINE_BUFFER_SIZE)
               buf_pointer = 0;
           }
@@ -207,13 +242,6 @@ extern "C"
   int main()
   {
 
-    // Тестирование EEPROM
-    // char line[LINE_BUFFER_SIZE] = "3388HELLO";
-    // char line_result[LINE_BUFFER_SIZE] = "";
-    // eeprom_init();
-    // memcpy_to_eeprom_with_checksum(0, 1, (char*)line, 0, 10);
-    // memcpy_from_eeprom_with_checksum((char*)line_result, 0, 1, 0, 10);
-
     // Цикл инициализации Grbl при включении питания или аварийной остановке системы. В последнем случае все процессы
     // вернутся в этот цикл для чистой повторной инициализации.
     setup();
@@ -233,12 +261,37 @@ extern "C"
 
     // Сброс основных систем Grbl.
     serial_reset_read_buffer(CLIENT_ALL); // Очистка буфера чтения последовательного порта
+    #ifdef ENABLE_SERIAL_FRAMING
+      frame_init(); // Сброс возвращает в строчный режим
+    #endif
+    #ifdef ENABLE_ACK_BATCHING
+      report_ack_init(); // Сброс возвращает к ответу ok на каждую строку
+    #endif
+    #ifdef ENABLE_DELTA_STATUS_REPORT
+      report_status_init(); // После сброса первым идёт ключевой отчёт
+    #endif
+    #ifdef ENABLE_AUTO_REPORT
+      report_auto_init(); // Сброс выключает автоотчёты
+    #endif
+    #ifdef ENABLE_DIGITAL_OUTPUTS
+      digital_output_init(); // Только при включении питания. Парсер читает состояние выходов в gc_init().
+    #endif
     gc_init();                            // Установка парсера G-кода в состояние по умолчанию
     spindle_init();
+    #ifdef ENABLE_SPINDLE_SYNC
+      spindle_encoder_init(); // Таймер и вход индексного датчика шпинделя
+    #endif
     coolant_init();
     limits_init();
     probe_init();
     plan_reset(); // Очистка буфера блоков и переменных планировщика
+    mc_queue_reset(); // Очистка очереди разобранных перемещений и генератора дуг
+    #ifdef ENABLE_RASTER
+      raster_reset(); // Освободить строки растра, отброшенные вместе с буфером планировщика
+    #endif
+    #ifdef ENABLE_JOB_STORE
+      job_store_stop(); // Сброс останавливает задание и отбрасывает незавершённую загрузку
+    #endif
     st_reset();   // Очистка переменных подсистемы шагового двигателя.
 
     // Синхронизация очищенных позиций G-кода и планировщика с текущей системной позицией.
@@ -0,0 +1,154 @@
+/*
+ * arc_fixed_test.cpp - Тесты точности целочисленного ядра дуг (arc_fixed.cpp) против double
+ *
+ * Проверяет заявленную в arc_fixed.h оценку погрешности: CORDIC sin/cos и полный проход
+ * по сегментам дуги с коррекцией каждые N_ARC_CORRECTION сегментов, как в mc_arc().
+ * Для сравнения выводится погрешность исходного float-ядра на тех же дугах.
+ *
+ * Собирается с флагами прошивки: с -fsingle-precision-constant литерал M_PI становится float,
+ * поэтому точные значения в тесте считаются от pi, вычисленного в double.
+ *
+ * Сборка: g++ -std=gnu++11 -O2 -fsingle-precision-constant -o arc_fixed_test arc_fixed_test.cpp
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+
+#define N_ARC_CORRECTION 12 // Как в config.hpp
+
+// Подключаем реальное ядро из arc_fixed.cpp без остальной части Grbl.
+#include "../lib/grbl/src/arc_fixed.hpp"
+#define grbl_h
+#define ARC_FIXED_POINT_KERNEL
+#define max(a,b) (((a) > (b)) ? (a) : (b))
+#include "../lib/grbl/src/arc_fixed.cpp"
+
+static const double pi = 4.0 * atan(1.0); // Точное в double при любых флагах
+
+// Детерминированный генератор псевдослучайных чисел
+static uint32_t rng_state = 12345;
+static double rng_uniform() {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return (rng_state >> 8) / 16777216.0;
+}
+
+// Тест 1: CORDIC sin/cos во всём диапазоне углов, включая границы квадрантов
+void test_sincos() {
+    printf("Тест 1: CORDIC sin/cos против double\n");
+
+    double max_err = 0;
+    for (int64_t k = -400000; k <= 400000; k++) {
+        int64_t angle = (k * (ARC_FIXED_TURN / 200000)) + (k % 7) - 3; // Сдвиг на несколько единиц вокруг границ
+        int32_t c, s;
+        arc_fixed_sincos(angle, &c, &s);
+        double a = (double)angle / ARC_FIXED_TURN * 2 * pi;
+        double ec = fabs(c - cos(a) * ARC_FIXED_ONE);
+        double es = fabs(s - sin(a) * ARC_FIXED_ONE);
+        if (ec > max_err) max_err = ec;
+        if (es > max_err) max_err = es;
+    }
+    printf("  максимальная погрешность: %.3f LSB Q30\n", max_err);
+    assert(max_err <= 2.0);
+    printf("  ✓ Погрешность в пределах 2 LSB\n");
+}
+
+// Тест 2: Генерация дуг, как в mc_arc(), с коррекцией каждые N_ARC_CORRECTION сегментов
+void test_arcs() {
+    printf("Тест 2: Сегменты дуг против точной окружности в double\n");
+
+    const float arc_tolerance = 0.002;
+    double max_err_lsb = 0, max_rel_fixed = 0, max_rel_float = 0;
+    long total_segments = 0;
+
+    for (int n = 0; n < 2000; n++) {
+        float radius = 0.01 * pow(10.0, 5.3 * rng_uniform()); // 0.01 .. 2000 мм
+        double start = 2 * pi * rng_uniform();
+        float r_axis0 = radius * cos(start);
+        float r_axis1 = radius * sin(start);
+        float angular_travel = (rng_uniform() < 0.5 ? -1 : 1) * 2 * pi * rng_uniform();
+        uint16_t segments = floor(fabs(0.5 * angular_travel * radius) /
+                                  sqrt(arc_tolerance * (2 * radius - arc_tolerance)));
+        if (segments < 2) continue;
+        if (radius > 200 && segments > 4000) continue; // Ограничить время теста
+
+        arc_fixed_t arc;
+        arc_fixed_init(&arc, r_axis0, r_axis1, angular_travel, segments);
+
+        // Исходное float-ядро из mc_arc() для сравнения
+        float theta_per_segment = angular_travel / segments;
+        float cos_T = 2.0f - theta_per_segment * theta_per_segment;
+        float sin_T = theta_per_segment * 0.16666667f * (cos_T + 4.0f);
+        cos_T *= 0.5f;
+        float f0 = r_axis0, f1 = r_axis1;
+
+        double theta = (double)angular_travel / segments;
+        uint8_t count = 0;
+        for (uint16_t i = 1; i < segments; i++) {
+            if (count < N_ARC_CORRECTION) {
+                arc_fixed_rotate(&arc);
+                float fi = f0 * sin_T + f1 * cos_T;
+                f0 = f0 * cos_T - f1 * sin_T;
+                f1 = fi;
+                count++;
+            } else {
+                arc_fixed_correct(&arc, i);
+                float cos_Ti = cosf(i * theta_per_segment);
+                float sin_Ti = sinf(i * theta_per_segment);
+                f0 = r_axis0 * cos_Ti - r_axis1 * sin_Ti;
+                f1 = r_axis0 * sin_Ti + r_axis1 * cos_Ti;
+                count = 0;
+            }
+            double e0 = (double)r_axis0 * cos(i * theta) - (double)r_axis1 * sin(i * theta);
+            double e1 = (double)r_axis0 * sin(i * theta) + (double)r_axis1 * cos(i * theta);
+            double err = fmax(fabs(arc.r0 * (double)arc.scale_inv - e0), fabs(arc.r1 * (double)arc.scale_inv - e1));
+            double err_float = fmax(fabs(f0 - e0), fabs(f1 - e1));
+            double err_lsb = err / arc.scale_inv;
+            if (err_lsb > max_err_lsb) max_err_lsb = err_lsb;
+            if (err / radius > max_rel_fixed) max_rel_fixed = err / radius;
+            if (err_float / radius > max_rel_float) max_rel_float = err_float / radius;
+            total_segments++;
+        }
+    }
+    printf("  сегментов проверено: %ld\n", total_segments);
+    printf("  fixed: %.2f LSB, относительная погрешность %.3g\n", max_err_lsb, max_rel_fixed);
+    printf("  float: относительная погрешность %.3g (малоугловое приближение, для сравнения)\n", max_rel_float);
+    assert(max_err_lsb <= (N_ARC_CORRECTION + 1) * 6);
+    assert(max_rel_fixed < 1e-7);
+    printf("  ✓ Погрешность в пределах оценки из arc_fixed.h\n");
+}
+
+// Тест 3: Полный оборот в обе стороны и нулевой радиус
+void test_edge_cases() {
+    printf("Тест 3: Граничные случаи\n");
+
+    arc_fixed_t arc;
+    arc_fixed_init(&arc, 10.0f, 0.0f, 2 * pi, 100);
+    arc_fixed_correct(&arc, 100);
+    assert(fabs(arc.r0 * arc.scale_inv - 10.0) < 1e-5 && fabs(arc.r1 * arc.scale_inv) < 1e-5);
+
+    arc_fixed_init(&arc, 0.0f, -5.0f, -2 * pi, 64);
+    arc_fixed_correct(&arc, 16); // Четверть оборота по часовой: (0,-5) -> (-5,0)
+    assert(fabs(arc.r0 * arc.scale_inv + 5.0) < 1e-5 && fabs(arc.r1 * arc.scale_inv) < 1e-5);
+
+    arc_fixed_init(&arc, 0.0f, 0.0f, 1.0f, 10);
+    arc_fixed_rotate(&arc);
+    assert(arc.r0 == 0 && arc.r1 == 0);
+    printf("  ✓ Граничные случаи обработаны корректно\n");
+}
+
+int main() {
+    printf("Запуск тестов точности ядра дуг arc_fixed\n");
+    printf("=============================================================\n");
+
+    test_sincos();
+    test_arcs();
+    test_edge_cases();
+
+    printf("\n=============================================================\n");
+    printf("Все тесты пройдены успешно!\n");
+
+    return 0;
+}
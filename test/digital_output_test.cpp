@@ -0,0 +1,179 @@
+/*
+ * digital_output_test.cpp - Тесты синхронных (M62/M63) и немедленных (M64/M65) цифровых выходов
+ *
+ * Проверяет, что кадр несёт только выходы, изменённые его собственными M62/M63, и что M64/M65,
+ * выполненный, пока кадр ещё стоит в очереди, не отменяется при старте этого кадра.
+ * Парсер и digital_output.cpp подключаются целиком, пины и планировщик заменены заглушками.
+ *
+ * Сборка: g++ -std=gnu++11 -O2 -fsingle-precision-constant -o digital_output_test digital_output_test.cpp
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cassert>
+#include <cmath>
+
+// Заглушки типов и пинов HAL MIK32, которые упоминаются в заголовках Grbl
+typedef int HAL_StatusTypeDef;
+typedef int HAL_PinsTypeDef;
+typedef int GPIO_TypeDef;
+typedef int HAL_GPIO_PullTypeDef;
+typedef int HAL_GPIO_Line_Config;
+typedef int UART_TypeDef;
+#define GPIO_1       ((GPIO_TypeDef *)0)
+#define GPIO_PIN_10  10
+#define GPIO_PIN_11  11
+#define GPIO_PIN_14  14
+#define GPIO_PIN_15  15
+#define GPIO_PIN_LOW  0
+#define GPIO_PIN_HIGH 1
+
+// Заголовки Grbl в порядке grbl.hpp, без HAL
+#define grbl_h
+#include "../lib/grbl/src/config.hpp"
+#include "../lib/grbl/src/nuts_bolts.hpp"
+#include "../lib/grbl/src/settings.hpp"
+#include "../lib/grbl/src/system.hpp"
+#include "../lib/grbl/src/defaults.hpp"
+#include "../lib/grbl/src/cpu_map.hpp"
+#include "../lib/grbl/src/planner.hpp"
+#include "../lib/grbl/src/coolant_control.hpp"
+#include "../lib/grbl/src/digital_output.hpp"
+#include "../lib/grbl/src/gcode.hpp"
+#include "../lib/grbl/src/gcode_token.hpp"
+#include "../lib/grbl/src/motion_control.hpp"
+#include "../lib/grbl/src/protocol.hpp"
+#include "../lib/grbl/src/report.hpp"
+#include "../lib/grbl/src/spindle_control.hpp"
+#include "../lib/grbl/src/jog.hpp"
+
+// Состояние Grbl и заглушки модулей, которые вызывает парсер
+system_t sys;
+settings_t settings;
+int32_t sys_position[N_AXIS];
+
+// Уровни пинов по номеру GPIO_PIN_x
+static int pin_level[16];
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, HAL_PinsTypeDef pin, int level) { pin_level[pin] = level; }
+HAL_StatusTypeDef PinInitOutput(const HAL_PinsTypeDef pin, GPIO_TypeDef* port) { return(0); }
+void HAL_IRQ_DisableInterrupts() {}
+void HAL_IRQ_EnableInterrupts() {}
+
+float hypot_f(float x, float y) { return sqrtf(x*x + y*y); }
+uint8_t read_float(char *line, uint8_t *char_counter, float *float_ptr)
+{
+  char *end;
+  float value = strtof(line + *char_counter, &end);
+  if (end == line + *char_counter) { return(false); }
+  *float_ptr = value;
+  *char_counter = end - line;
+  return(true);
+}
+uint8_t gc_token_read_word(char *line, uint8_t *char_counter, char *letter, float *value) { return(false); }
+void gc_token_reset() {}
+void system_convert_array_steps_to_mpos(float *position, int32_t *steps) { memset(position, 0, sizeof(float)*N_AXIS); }
+void system_flag_wco_change() {}
+void system_set_exec_state_flag(uint8_t mask) {}
+uint8_t settings_read_coord_data(uint8_t coord_select, float *coord_data) { memset(coord_data, 0, sizeof(float)*N_AXIS); return(true); }
+void settings_write_coord_data(uint8_t coord_select, float *coord_data) {}
+void report_status_message(uint8_t status_code, uint8_t client) {}
+void report_feedback_message(uint8_t message_code) {}
+void protocol_buffer_synchronize() {}
+void protocol_execute_realtime() {}
+void spindle_sync(uint8_t state, float rpm) {}
+void spindle_set_state(uint8_t state, float rpm) {}
+void coolant_sync(uint8_t mode) {}
+void coolant_set_state(uint8_t mode) {}
+uint8_t jog_execute(plan_line_data_t *pl_data, parser_block_t *gc_block) { return(STATUS_OK); }
+void mc_dwell(float seconds) {}
+void mc_arc(float *target, plan_line_data_t *pl_data, float *position, float *offset, float radius,
+  uint8_t axis_0, uint8_t axis_1, uint8_t axis_linear, uint8_t is_clockwise_arc) {}
+void mc_spline(float *target, plan_line_data_t *pl_data, float *position, float *control_1, float *control_2) {}
+uint8_t mc_probe_cycle(float *target, plan_line_data_t *pl_data, uint8_t parser_flags) { return(GC_PROBE_FOUND); }
+void mc_canned_cycle(float *target, plan_line_data_t *pl_data, float *position, float r_level,
+  float clear_level, float peck, float dwell, uint8_t axis_linear, uint8_t cycle) {}
+
+// Очередь планировщика: mc_line запоминает данные кадра, start_block выполняет то, что
+// делает прерывание шагов на первом шаге кадра.
+static plan_line_data_t queue[8];
+static uint8_t queue_head, queue_tail;
+void mc_line(float *target, plan_line_data_t *pl_data) { queue[queue_head++] = *pl_data; }
+static void start_block()
+{
+  assert(queue_tail != queue_head);
+  plan_line_data_t *block = &queue[queue_tail++];
+  if (block->digital_out_set | block->digital_out_clear) {
+    digital_output_write_sync(block->digital_out_set, block->digital_out_clear, block->digital_out_epoch);
+  }
+}
+
+// Подключаем реальные модули без остальной части Grbl.
+#include "../lib/grbl/src/digital_output.cpp"
+#include "../lib/grbl/src/gcode.cpp"
+
+static uint8_t execute(const char *line)
+{
+  char buffer[LINE_BUFFER_SIZE];
+  strcpy(buffer, line);
+  return(gc_execute_line(buffer, CLIENT_SERIAL));
+}
+
+static void reset()
+{
+  digital_output_init();
+  gc_init();
+  queue_head = queue_tail = 0;
+}
+
+void test_sync_outputs() {
+  reset();
+  assert(execute("G1X1F100M62P0") == STATUS_OK);
+  assert(digital_output_get_state() == 0 && pin_level[GPIO_PIN_10] == GPIO_PIN_LOW);
+  start_block();
+  assert(digital_output_get_state() == bit(0) && pin_level[GPIO_PIN_10] == GPIO_PIN_HIGH);
+  assert(execute("X2M63P0") == STATUS_OK);
+  start_block();
+  assert(digital_output_get_state() == 0 && pin_level[GPIO_PIN_10] == GPIO_PIN_LOW);
+  printf("  ✓ M62/M63 переключают выход на первом шаге своего кадра\n");
+}
+
+void test_immediate_wins_over_queued_sync() {
+  reset();
+  // M62 P0 ставится в очередь, затем M65 P0 выключает выход, пока кадр ещё не начался.
+  assert(execute("G1X1F100M62P0") == STATUS_OK);
+  assert(execute("M65P0") == STATUS_OK);
+  assert(execute("X2") == STATUS_OK);
+  start_block();
+  assert(digital_output_get_state() == 0 && pin_level[GPIO_PIN_10] == GPIO_PIN_LOW);
+  start_block();
+  assert(digital_output_get_state() == 0);
+
+  // M64 на другом выходе не затирается кадром, который его не трогал.
+  assert(execute("X3M62P1") == STATUS_OK);
+  assert(execute("M64P2") == STATUS_OK);
+  assert(digital_output_get_state() == bit(2));
+  start_block();
+  assert(digital_output_get_state() == (bit(1)|bit(2)));
+
+  // Кадр, запланированный после M65, снова управляет выходом.
+  assert(execute("M65P1") == STATUS_OK);
+  assert(execute("X4M62P1") == STATUS_OK);
+  start_block();
+  assert(digital_output_get_state() == (bit(1)|bit(2)));
+  printf("  ✓ M64/M65 не отменяются кадрами M62/M63, стоявшими в очереди до них\n");
+}
+
+int main() {
+  printf("Запуск тестов цифровых выходов M62-M65\n");
+  printf("=============================================================\n");
+
+  test_sync_outputs();
+  test_immediate_wins_over_queued_sync();
+
+  printf("\n=============================================================\n");
+  printf("Все тесты пройдены успешно!\n");
+
+  return 0;
+}
@@ -1,8 +1,14 @@
 /*
- * eeprom_test.cpp - Тесты для функций memcpy_to_eeprom_with_checksum и memcpy_from_eeprom_with_checksum
- * 
- * Этот файл содержит модульные тесты для проверки корректности работы функций
- * работы с EEPROM с контрольными суммами.
+ * eeprom_test.cpp - Тесты журнала настроек в EEPROM (eeprom.cpp)
+ *
+ * Проверяет восстановление образа хранилища из журнала за один проход, запись только изменённых
+ * слов (одна запись — одно программирование двух слов), отложенную фиксацию изменений с
+ * объединением записей одного слова, равномерное стирание страниц при долгой работе, пропуск
+ * записи с прерванным программированием, фиксацию группы записей целиком при отключении питания
+ * посреди неё, восстановление последней целой копии блока, CRC-32 блоков и фоновое уплотнение
+ * журнала.
+ *
+ * Сборка: g++ -std=gnu++11 -O2 -fsingle-precision-constant -o eeprom_test eeprom_test.cpp
  */
 
 #include <cstdint>
@@ -10,311 +16,344 @@
 #include <cstdio>
 #include <cassert>
 
-// Заглушки для HAL функций - объявляем структуры и функции самостоятельно
-extern "C" {
-    typedef struct {
-        void* Instance;
-        uint32_t Mode;
-        uint32_t ErrorCorrection;
-        uint32_t EnableInterrupt;
-    } HAL_EEPROM_HandleTypeDef;
-    
-    typedef enum {
-        HAL_OK       = 0x00U,
-        HAL_ERROR    = 0x01U,
-        HAL_BUSY     = 0x02U,
-        HAL_TIMEOUT  = 0x03U
-    } HAL_StatusTypeDef;
-    
-    typedef enum {
-        HAL_EEPROM_MODE_TWO_STAGE = 0,
-        HAL_EEPROM_MODE_SINGLE_STAGE
-    } HAL_EEPROM_ModeTypeDef;
-    
-    typedef enum {
-        HAL_EEPROM_ECC_ENABLE = 0,
-        HAL_EEPROM_ECC_DISABLE
-    } HAL_EEPROM_ECCTypeDef;
-    
-    typedef enum {
-        HAL_EEPROM_SERR_ENABLE = 0,
-        HAL_EEPROM_SERR_DISABLE
-    } HAL_EEPROM_SERRTypeDef;
-    
-    typedef enum {
-        HAL_EEPROM_WRITE_SINGLE = 0,
-        HAL_EEPROM_WRITE_BURST
-    } HAL_EEPROM_WriteModeTypeDef;
-    
-    // Объявления функций
-    HAL_StatusTypeDef HAL_EEPROM_Init(HAL_EEPROM_HandleTypeDef *heeprom);
-    HAL_StatusTypeDef HAL_EEPROM_CalculateTimings(HAL_EEPROM_HandleTypeDef *heeprom, uint32_t clock_freq);
-    HAL_StatusTypeDef HAL_EEPROM_Erase(HAL_EEPROM_HandleTypeDef *heeprom, uint8_t start_page, uint8_t word_count, uint32_t write_mode, uint32_t timeout);
-    HAL_StatusTypeDef HAL_EEPROM_Write(HAL_EEPROM_HandleTypeDef *heeprom, uint16_t address, uint32_t *data, uint8_t word_count, uint32_t write_mode, uint32_t timeout);
-    HAL_StatusTypeDef HAL_EEPROM_Read(HAL_EEPROM_HandleTypeDef *heeprom, uint16_t address, uint32_t *data, uint8_t word_count, uint32_t timeout);
-}
+// Заглушки HAL EEPROM MIK32 с теми же сигнатурами, что и в mik32_hal_eeprom.h
+typedef struct {
+    void* Instance;
+    uint32_t Mode;
+    uint32_t ErrorCorrection;
+    uint32_t EnableInterrupt;
+} HAL_EEPROM_HandleTypeDef;
 
-// Константы из eeprom.cpp
-#define EEPROM_PAGE_WORDS 32
-#define EEPROM_PAGE_COUNT 64
-#define EEPROM_OP_TIMEOUT 100000
+typedef enum { HAL_OK = 0x00U, HAL_ERROR = 0x01U, HAL_BUSY = 0x02U, HAL_TIMEOUT = 0x03U } HAL_StatusTypeDef;
+typedef enum { HAL_EEPROM_WRITE_SINGLE = 0, HAL_EEPROM_WRITE_ALL } HAL_EEPROM_WriteModeTypeDef;
+#define HAL_EEPROM_MODE_TWO_STAGE 0
+#define HAL_EEPROM_ECC_ENABLE 0
+#define HAL_EEPROM_SERR_DISABLE 0
+#define EEPROM_REGS ((void*)0)
 
-// Глобальные переменные для симуляции EEPROM
-static uint32_t simulated_eeprom[EEPROM_PAGE_COUNT][EEPROM_PAGE_WORDS] = {0};
-static bool eeprom_initialized = false;
+#define EEPROM_STORE_WORDS 40
+#define min(a,b) (((a) < (b)) ? (a) : (b))
 
-// Заглушки HAL функций
-HAL_StatusTypeDef HAL_EEPROM_Init(HAL_EEPROM_HandleTypeDef *heeprom) {
-    eeprom_initialized = true;
-    return HAL_OK;
-}
+#include "../lib/grbl/src/eeprom.hpp"
+
+// Симуляция EEPROM: после стирания слова читаются нулями, программировать можно только стёртое слово.
+static uint32_t simulated_eeprom[EEPROM_PAGE_COUNT][EEPROM_PAGE_WORDS];
+static uint32_t erase_count[EEPROM_PAGE_COUNT];
+static uint32_t program_count;  // Операции программирования
+static uint32_t program_words;  // Запрограммированные слова
+static int32_t program_budget = -1; // Программирований до отключения питания, -1 — без отключения
 
-HAL_StatusTypeDef HAL_EEPROM_CalculateTimings(HAL_EEPROM_HandleTypeDef *heeprom, uint32_t clock_freq) {
+HAL_StatusTypeDef HAL_EEPROM_Init(HAL_EEPROM_HandleTypeDef *heeprom) { return HAL_OK; }
+void HAL_EEPROM_CalculateTimings(HAL_EEPROM_HandleTypeDef *heeprom, uint32_t frequency) {}
+
+HAL_StatusTypeDef HAL_EEPROM_Erase(HAL_EEPROM_HandleTypeDef *heeprom, uint16_t address, uint8_t data_len,
+                                   HAL_EEPROM_WriteModeTypeDef write_mode, uint32_t timeout) {
+    uint16_t page = address / (EEPROM_PAGE_WORDS * 4);
+    assert(address % (EEPROM_PAGE_WORDS * 4) == 0 && data_len == EEPROM_PAGE_WORDS && page < EEPROM_PAGE_COUNT);
+    if (program_budget == 0) { return HAL_OK; } // Питание отключено.
+    memset(simulated_eeprom[page], 0, sizeof(simulated_eeprom[page]));
+    erase_count[page]++;
     return HAL_OK;
 }
 
-HAL_StatusTypeDef HAL_EEPROM_Erase(HAL_EEPROM_HandleTypeDef *heeprom, uint8_t start_page, uint8_t word_count, uint32_t write_mode, uint32_t timeout) {
-    if (!eeprom_initialized) return HAL_ERROR;
-    if (start_page >= EEPROM_PAGE_COUNT) return HAL_ERROR;
-    
-    for (uint8_t page = 0; page < word_count && (start_page + page) < EEPROM_PAGE_COUNT; page++) {
-        for (int i = 0; i < EEPROM_PAGE_WORDS; i++) {
-            simulated_eeprom[start_page + page][i] = 0xFFFFFFFF;
-        }
+HAL_StatusTypeDef HAL_EEPROM_Write(HAL_EEPROM_HandleTypeDef *heeprom, uint16_t address, uint32_t *data, uint8_t data_len,
+                                   HAL_EEPROM_WriteModeTypeDef write_mode, uint32_t timeout) {
+    uint32_t *words = &simulated_eeprom[0][0] + address / 4;
+    // Запись не выходит за страницу и не перезаписывает запрограммированные слова.
+    assert(address / (EEPROM_PAGE_WORDS * 4) == (address + 4 * data_len - 1) / (EEPROM_PAGE_WORDS * 4));
+    if (program_budget == 0) { return HAL_OK; } // Питание отключено: EEPROM не меняется.
+    if (program_budget > 0) { program_budget--; }
+    for (uint8_t i = 0; i < data_len; i++) {
+        assert(words[i] == 0);
+        words[i] = data[i];
     }
+    program_count++;
+    program_words += data_len;
     return HAL_OK;
 }
 
-HAL_StatusTypeDef HAL_EEPROM_Write(HAL_EEPROM_HandleTypeDef *heeprom, uint16_t address, uint32_t *data, uint8_t word_count, uint32_t write_mode, uint32_t timeout) {
-    if (!eeprom_initialized) return HAL_ERROR;
-    
-    uint8_t start_page = address / (EEPROM_PAGE_WORDS * 4);
-    uint16_t offset_words = (address % (EEPROM_PAGE_WORDS * 4)) / 4;
-    
-    for (uint8_t i = 0; i < word_count; i++) {
-        uint8_t page = start_page + ((offset_words + i) / EEPROM_PAGE_WORDS);
-        uint8_t word_in_page = (offset_words + i) % EEPROM_PAGE_WORDS;
-        
-        if (page >= EEPROM_PAGE_COUNT) return HAL_ERROR;
-        
-        simulated_eeprom[page][word_in_page] = data[i];
-    }
+HAL_StatusTypeDef HAL_EEPROM_Read(HAL_EEPROM_HandleTypeDef *heeprom, uint16_t address, uint32_t *data, uint8_t data_len,
+                                  uint32_t timeout) {
+    memcpy(data, &simulated_eeprom[0][0] + address / 4, data_len * 4);
     return HAL_OK;
 }
 
-HAL_StatusTypeDef HAL_EEPROM_Read(HAL_EEPROM_HandleTypeDef *heeprom, uint16_t address, uint32_t *data, uint8_t word_count, uint32_t timeout) {
-    if (!eeprom_initialized) return HAL_ERROR;
-    
-    uint8_t start_page = address / (EEPROM_PAGE_WORDS * 4);
-    uint16_t offset_words = (address % (EEPROM_PAGE_WORDS * 4)) / 4;
-    
-    for (uint8_t i = 0; i < word_count; i++) {
-        uint8_t page = start_page + ((offset_words + i) / EEPROM_PAGE_WORDS);
-        uint8_t word_in_page = (offset_words + i) % EEPROM_PAGE_WORDS;
-        
-        if (page >= EEPROM_PAGE_COUNT) return HAL_ERROR;
-        
-        data[i] = simulated_eeprom[page][word_in_page];
+// Подключаем реальный модуль без остальной части Grbl.
+#define grbl_h
+#include "../lib/grbl/src/eeprom.cpp"
+
+// Новая микросхема: стёрта не полностью, с мусором от прошлой прошивки.
+static void reset_simulated_eeprom() {
+    for (int page = 0; page < EEPROM_PAGE_COUNT; page++) {
+        for (int i = 0; i < EEPROM_PAGE_WORDS; i++) { simulated_eeprom[page][i] = 0x12345678u * (page + 1) + i; }
     }
-    return HAL_OK;
+    memset(erase_count, 0, sizeof(erase_count));
+    program_count = program_words = 0;
+    eeprom_init();
 }
 
-// Заглушка для delay_ms
-void delay_ms(uint32_t ms) {
-    // Ничего не делаем в тестах
-    (void)ms;
+static uint32_t read_word(uint16_t key) {
+    uint32_t value;
+    eeprom_store_read_block(key, &value, sizeof(value));
+    return value;
 }
 
-// Включаем реальные функции из eeprom.cpp
-#include "../lib/grbl/src/eeprom.cpp"
+void test_load_and_write() {
+    reset_simulated_eeprom();
+    assert(!eeprom_store_load()); // Журнала нет: EEPROM стирается.
+    for (int page = 0; page < EEPROM_PAGE_COUNT; page++) { assert(erase_count[page] == 1); }
+    assert(read_word(5) == 0);
 
-// Вспомогательные функции для тестов
-void reset_simulated_eeprom() {
-    memset(simulated_eeprom, 0, sizeof(simulated_eeprom));
-    eeprom_initialized = false;
+    float coord[3] = { 1.5, -2.25, 100.0 };
+    eeprom_store_write_block(10, 3, coord, sizeof(coord));
+    char line[] = "G21G90";
+    eeprom_store_write_block(20, 4, line, sizeof(line)); // 7 байт, дополняется нулями до 4 слов
+    eeprom_store_commit();
+    // Нулевые слова не записываются: без записи слово и так равно нулю. За каждым блоком — CRC-32,
+    // за группой — метка фиксации.
+    uint32_t records = program_count - 1; // Без заголовка страницы
+    assert(records == (3 + 1) + (2 + 1) + 1);
+
+    // Перезагрузка: образ восстанавливается из журнала.
+    assert(eeprom_store_load());
+    float coord_read[3];
+    eeprom_store_read_block(10, coord_read, sizeof(coord_read));
+    assert(memcmp(coord, coord_read, sizeof(coord)) == 0);
+    char line_read[16];
+    eeprom_store_read_block(20, line_read, 16);
+    assert(strcmp(line, line_read) == 0);
+    assert(read_word(22) == 0 && read_word(23) == 0);
+    assert(eeprom_store_check_block(10, 3) && eeprom_store_check_block(20, 4));
+    assert(read_word(24) == eeprom_crc32((const uint8_t *)"G21G90\0\0\0\0\0\0\0\0\0", 16));
+    assert(!eeprom_store_check_block(30, 2)); // Блок, который не записывался
+    printf("  ✓ Образ хранилища восстанавливается из журнала\n");
 }
 
-void init_eeprom_for_test() {
+void test_single_word_write() {
     reset_simulated_eeprom();
-    eeprom_init();
+    eeprom_store_load();
+    uint32_t settings[7] = { 1, 2, 3, 4, 5, 6, 7 };
+    eeprom_store_write_block(0, 7, settings, sizeof(settings));
+    eeprom_store_commit();
+    // Изменение одной настройки — запись слова, запись CRC-32 блока и метка фиксации: по одному
+    // программированию двух слов, без стирания.
+    uint32_t count = program_count, words = program_words;
+    settings[3] = 40;
+    eeprom_store_write_block(0, 7, settings, sizeof(settings));
+    eeprom_store_commit();
+    assert(program_count == count + 3 && program_words == words + 6);
+    // Неизменённые данные не программируются.
+    eeprom_store_write_block(0, 7, settings, sizeof(settings));
+    assert(!eeprom_store_dirty());
+    eeprom_store_commit();
+    assert(program_count == count + 3);
+    for (int page = 0; page < EEPROM_PAGE_COUNT; page++) { assert(erase_count[page] == 1); }
+    eeprom_store_load();
+    assert(read_word(3) == 40 && read_word(6) == 7 && eeprom_store_check_block(0, 7));
+    printf("  ✓ Изменённое слово записывается одной записью\n");
 }
 
-// Тест 1: Базовая запись и чтение с контрольной суммой
-void test_basic_write_read() {
-    printf("Тест 1: Базовая запись и чтение с контрольной суммой\n");
-    
-    init_eeprom_for_test();
-    
-    char source_data[] = "Hello, EEPROM!";
-    char dest_buffer[50] = {0};
-    unsigned int data_size = strlen(source_data);
-    
-    // Записываем данные в EEPROM
-    memcpy_to_eeprom_with_checksum(0, 2, source_data, 0, data_size);
-    
-    // Читаем данные обратно
-    int result = memcpy_from_eeprom_with_checksum(dest_buffer, 0, 2, 0, data_size);
-    
-    // Проверяем результат
-    assert(result == 1); // Контрольная сумма должна совпадать
-    assert(strcmp(source_data, dest_buffer) == 0); // Данные должны быть идентичны
-    
-    printf("  ✓ Данные успешно записаны и прочитаны\n");
+void test_wear_leveling() {
+    reset_simulated_eeprom();
+    eeprom_store_load();
+    // Постоянные данные, которые уплотнение должно переносить, и часто меняющиеся слова.
+    uint32_t fixed[29];
+    for (int i = 0; i < 29; i++) { fixed[i] = 1000 + i; }
+    eeprom_store_write_block(10, 29, fixed, sizeof(fixed));
+    eeprom_store_commit();
+    uint32_t value = 0;
+    for (uint32_t n = 1; n <= 20000; n++) {
+        value = n;
+        eeprom_store_write_block(2*(n % 3), 1, &value, sizeof(value));
+        if (n % 7 == 0) { eeprom_store_write_block(6, 1, &value, 0); } // Обнуление слова
+        if (n % 7 == 3) { eeprom_store_write_block(6, 1, &value, sizeof(value)); }
+        eeprom_store_commit();
+        if (n % 50 == 0) { eeprom_store_compact(); }
+    }
+    // Стирания распределены по всем страницам равномерно.
+    uint32_t least = erase_count[0], most = erase_count[0];
+    for (int page = 1; page < EEPROM_PAGE_COUNT; page++) {
+        least = min(least, erase_count[page]);
+        if (erase_count[page] > most) { most = erase_count[page]; }
+    }
+    assert(least > 10 && most - least <= 1);
+
+    // После перезагрузки — последние значения, в том числе обнулённое слово.
+    eeprom_store_load();
+    assert(read_word(0) == 19998 && read_word(2) == 19999 && read_word(4) == 20000);
+    assert(read_word(6) == 0);
+    for (int i = 0; i < 29; i++) { assert(read_word(10 + i) == 1000u + i); }
+    for (int key = 0; key <= 6; key += 2) { assert(eeprom_store_check_block(key, 1)); }
+    assert(eeprom_store_check_block(10, 29));
+    printf("  ✓ Стирания распределены по страницам (от %u до %u на страницу)\n", least, most);
+}
+
+void test_crc32() {
+    // Контрольное значение CRC-32 (IEEE 802.3).
+    assert(eeprom_crc32((const uint8_t *)"123456789", 9) == 0xCBF43926);
+    assert(eeprom_crc32((const uint8_t *)"", 0) == 0);
+    printf("  ✓ CRC-32\n");
 }
 
-// Тест 2: Проверка контрольной суммы при повреждении данных
-void test_corrupted_data() {
-    printf("Тест 2: Проверка контрольной суммы при повреждении данных\n");
-    
-    init_eeprom_for_test();
-    
-    char source_data[] = "Test data for checksum";
-    char dest_buffer[50] = {0};
-    unsigned int data_size = strlen(source_data);
-    
-    // Записываем данные
-    memcpy_to_eeprom_with_checksum(0, 2, source_data, 0, data_size);
-    
-    // Повреждаем один байт в симулированной EEPROM
-    uint8_t* eeprom_bytes = (uint8_t*)simulated_eeprom;
-    eeprom_bytes[5] ^= 0xFF; // Инвертируем байт
-    
-    // Пытаемся прочитать
-    int result = memcpy_from_eeprom_with_checksum(dest_buffer, 0, 2, 0, data_size);
-    
-    // Контрольная сумма не должна совпадать
-    assert(result == 0);
-    
-    printf("  ✓ Контрольная сумма обнаружила повреждение данных\n");
+void test_deferred_commit() {
+    reset_simulated_eeprom();
+    eeprom_store_load();
+    uint32_t count = program_count;
+    // Изменения до фиксации видны при чтении, но EEPROM не программируется.
+    uint32_t value;
+    for (value = 1; value <= 50; value++) { eeprom_store_write_block(3, 1, &value, sizeof(value)); }
+    float offset[2] = { 12.5, -3.0 };
+    eeprom_store_write_block(30, 2, offset, sizeof(offset));
+    assert(read_word(3) == 50 && eeprom_store_dirty());
+    assert(program_count == count);
+    // Фиксация: по одной записи на изменённое слово и CRC-32 блока, метка фиксации и заголовок
+    // первой страницы.
+    eeprom_store_commit();
+    assert(!eeprom_store_dirty());
+    assert(program_count == count + 1 + (1 + 1) + (2 + 1) + 1);
+    // Изменение, не зафиксированное до перезагрузки, теряется.
+    value = 77;
+    eeprom_store_write_block(3, 1, &value, sizeof(value));
+    eeprom_store_load();
+    assert(read_word(3) == 50 && !eeprom_store_dirty());
+    float offset_read[2];
+    eeprom_store_read_block(30, offset_read, sizeof(offset_read));
+    assert(offset_read[0] == 12.5 && offset_read[1] == -3.0);
+    // Обнулённое слово записывается нулевой записью и после перезагрузки читается нулём.
+    value = 0;
+    eeprom_store_write_block(3, 1, &value, sizeof(value));
+    eeprom_store_commit();
+    eeprom_store_load();
+    assert(read_word(3) == 0);
+    printf("  ✓ Изменения фиксируются позже, по одной записи на слово\n");
 }
 
-// Тест 3: Запись с offset
-void test_write_with_offset() {
-    printf("Тест 3: Запись с offset\n");
-    
-    init_eeprom_for_test();
-    
-    char source_data[] = "OffsetTest";
-    char dest_buffer[50] = {0};
-    unsigned int data_size = strlen(source_data);
-    unsigned int offset = 10; // Смещение 10 байт
-    
-    // Записываем данные со смещением
-    memcpy_to_eeprom_with_checksum(0, 2, source_data, offset, data_size);
-    
-    // Читаем данные с тем же смещением
-    int result = memcpy_from_eeprom_with_checksum(dest_buffer, 0, 2, offset, data_size);
-    
-    assert(result == 1);
-    assert(strcmp(source_data, dest_buffer) == 0);
-    
-    printf("  ✓ Запись и чтение со смещением работают корректно\n");
+void test_interrupted_record() {
+    reset_simulated_eeprom();
+    eeprom_store_load();
+    uint32_t value = 111;
+    eeprom_store_write_block(4, 1, &value, sizeof(value));
+    eeprom_store_commit();
+    value = 222;
+    eeprom_store_write_block(4, 1, &value, sizeof(value));
+    eeprom_store_commit();
+    // Программирование записи 222 прервано: заголовок записан, значение — нет. Слоты: 111, CRC,
+    // метка, 222, CRC, метка.
+    uint32_t *record = &simulated_eeprom[0][1 + 2*3];
+    assert(record[1] == 222);
+    record[1] = 0;
+    assert(eeprom_store_load());
+    assert(read_word(4) == 111);
+    // CRC-32 группы не совпадает, и новая запись CRC-32 блока тоже не применяется.
+    assert(eeprom_store_check_block(4, 1));
+    // Следующая запись дописывается за последней.
+    value = 333;
+    eeprom_store_write_block(4, 1, &value, sizeof(value));
+    eeprom_store_commit();
+    assert(simulated_eeprom[0][1 + 2*6 + 1] == 333);
+    eeprom_store_load();
+    assert(read_word(4) == 333 && eeprom_store_check_block(4, 1));
+    printf("  ✓ Прерванная запись пропускается\n");
 }
 
-// Тест 4: Запись данных, занимающих несколько страниц
-void test_multiple_pages() {
-    printf("Тест 4: Запись данных, занимающих несколько страниц\n");
-    
-    init_eeprom_for_test();
-    
-    // Создаем данные размером больше одной страницы
-    unsigned int page_size_bytes = EEPROM_PAGE_WORDS * 4;
-    unsigned int data_size = page_size_bytes * 2 - 5; // Немного меньше двух полных страниц
-    
-    char* source_data = new char[data_size];
-    char* dest_buffer = new char[data_size];
-    
-    // Заполняем тестовыми данными
-    for (unsigned int i = 0; i < data_size; i++) {
-        source_data[i] = 'A' + (i % 26);
+void test_torn_commit() {
+    // Отключение питания после каждой записи группы и перед меткой: блок остаётся прежним целиком.
+    for (int32_t budget = 0; budget <= 4; budget++) {
+        reset_simulated_eeprom();
+        eeprom_store_load();
+        uint32_t settings[7] = { 1, 2, 3, 4, 5, 6, 7 };
+        eeprom_store_write_block(0, 7, settings, sizeof(settings));
+        eeprom_store_commit();
+        // Три слова и CRC-32 блока — четыре записи и метка.
+        settings[1] = 20; settings[3] = 40; settings[5] = 60;
+        eeprom_store_write_block(0, 7, settings, sizeof(settings));
+        program_budget = budget;
+        eeprom_store_commit();
+        program_budget = -1;
+        assert(eeprom_store_load());
+        assert(read_word(1) == 2 && read_word(3) == 4 && read_word(5) == 6);
+        assert(eeprom_store_check_block(0, 7));
+
+        // Записи прерванной группы не попадают в следующую.
+        uint32_t value = 99;
+        eeprom_store_write_block(20, 1, &value, sizeof(value));
+        eeprom_store_commit();
+        assert(eeprom_store_load());
+        assert(read_word(20) == 99 && eeprom_store_check_block(20, 1));
+        assert(read_word(1) == 2 && read_word(3) == 4 && eeprom_store_check_block(0, 7));
     }
-    
-    // Записываем данные, начиная со страницы 1
-    memcpy_to_eeprom_with_checksum(1, 3, source_data, 0, data_size);
-    
-    // Читаем данные
-    int result = memcpy_from_eeprom_with_checksum(dest_buffer, 1, 3, 0, data_size);
-    
-    assert(result == 1);
-    assert(memcmp(source_data, dest_buffer, data_size) == 0);
-    
-    delete[] source_data;
-    delete[] dest_buffer;
-    
-    printf("  ✓ Данные, занимающие несколько страниц, обрабатываются корректно\n");
+    printf("  ✓ Прерванная фиксация не оставляет части изменений\n");
 }
 
-// Тест 5: Граничные случаи (нулевой размер, неинициализированная EEPROM)
-void test_edge_cases() {
-    printf("Тест 5: Граничные случаи\n");
-    
-    // Тест с нулевым размером
+void test_recover_block() {
     reset_simulated_eeprom();
-    eeprom_init();
-    
-    char dummy_data[] = "Dummy";
-    char dummy_buffer[10] = {0};
-    
-    // Нулевой размер - функция должна корректно обработать
-    memcpy_to_eeprom_with_checksum(0, 1, dummy_data, 0, 0);
-    int result = memcpy_from_eeprom_with_checksum(dummy_buffer, 0, 1, 0, 0);
-    assert(result == 0); // При нулевом размере возвращает 0
-    
-    // Неинициализированная EEPROM
-    reset_simulated_eeprom(); // eeprom_initialized = false
-    memcpy_to_eeprom_with_checksum(0, 1, dummy_data, 0, 5);
-    result = memcpy_from_eeprom_with_checksum(dummy_buffer, 0, 1, 0, 5);
-    assert(result == 0); // Должен вернуть 0 при неинициализированной EEPROM
-    
-    // Некорректный номер страницы
-    init_eeprom_for_test();
-    memcpy_to_eeprom_with_checksum(EEPROM_PAGE_COUNT, 1, dummy_data, 0, 5); // Страница за пределами
-    result = memcpy_from_eeprom_with_checksum(dummy_buffer, EEPROM_PAGE_COUNT, 1, 0, 5);
-    assert(result == 0);
-    
-    printf("  ✓ Граничные случаи обрабатываются корректно\n");
+    eeprom_store_load();
+    // Журнал прежней версии, без меток фиксации: 111 и его CRC-32, затем 222 без новой CRC-32
+    // (фиксация прервана).
+    uint32_t crc = eeprom_crc32((const uint8_t *)"\x6f\0\0\0", 4);
+    uint32_t log[] = { ((uint32_t)EEPROM_PAGE_TAG_V1 << 24) | 1,
+                       eeprom_record_header(4, 111), 111, eeprom_record_header(5, crc), crc,
+                       eeprom_record_header(4, 222), 222 };
+    memcpy(simulated_eeprom[0], log, sizeof(log));
+    assert(eeprom_store_load());
+    assert(read_word(4) == 222 && !eeprom_store_check_block(4, 1));
+
+    // Последняя целая копия блока восстанавливается и записывается при следующей фиксации.
+    assert(eeprom_store_recover_block(4, 1));
+    assert(read_word(4) == 111 && eeprom_store_check_block(4, 1) && eeprom_store_dirty());
+    eeprom_store_commit();
+    assert(simulated_eeprom[1][0] >> 24 == EEPROM_PAGE_TAG); // Группа начинается с новой страницы.
+    assert(eeprom_store_load());
+    assert(read_word(4) == 111 && eeprom_store_check_block(4, 1));
+
+    // Блок, CRC-32 которого не совпадала ни разу, не меняется.
+    uint32_t value = 5;
+    assert(!eeprom_store_recover_block(30, 1));
+    eeprom_store_write_block(30, 1, &value, sizeof(value));
+    assert(eeprom_store_check_block(30, 1));
+    printf("  ✓ Блок с несовпавшей CRC-32 восстанавливается из журнала\n");
 }
 
-// Тест 6: Проверка алгоритма контрольной суммы
-void test_checksum_algorithm() {
-    printf("Тест 6: Проверка алгоритма контрольной суммы\n");
-    
-    // Вручную вычисляем контрольную сумму для проверки
-    uint8_t test_data[] = {0x01, 0x02, 0x03, 0x04};
-    uint8_t expected_checksum = 0;
-    
-    for (unsigned int i = 0; i < sizeof(test_data); ++i) {
-        expected_checksum = (expected_checksum << 1) | (expected_checksum >> 7);
-        expected_checksum += test_data[i];
+void test_background_compact() {
+    reset_simulated_eeprom();
+    eeprom_store_load();
+    // Журнал почти на всё кольцо, без уплотнения.
+    uint32_t value;
+    for (value = 1; eeprom_store_free_pages() > 2; value++) {
+        eeprom_store_write_block(7, 1, &value, sizeof(value));
+        eeprom_store_commit();
     }
-    
-    // Проверяем через реальные функции
-    init_eeprom_for_test();
-    
-    memcpy_to_eeprom_with_checksum(0, 1, (char*)test_data, 0, sizeof(test_data));
-    
-    // Читаем контрольную сумму из симулированной EEPROM
-    uint8_t* eeprom_bytes = (uint8_t*)simulated_eeprom;
-    uint8_t stored_checksum = eeprom_bytes[sizeof(test_data)]; // Контрольная сумма после данных
-    
-    assert(stored_checksum == expected_checksum);
-    
-    printf("  ✓ Алгоритм контрольной суммы работает корректно\n");
+    uint32_t erased = 0;
+    for (int page = 0; page < EEPROM_PAGE_COUNT; page++) { erased += erase_count[page]; }
+    assert(erased == EEPROM_PAGE_COUNT); // Запись ничего не стирала сама.
+    // Простой: по одной странице за вызов, до резерва.
+    eeprom_store_compact();
+    assert(eeprom_store_free_pages() == 3);
+    while (eeprom_store_free_pages() < EEPROM_STORE_RESERVE_PAGES) { eeprom_store_compact(); }
+    uint8_t pages = store_pages;
+    eeprom_store_compact();
+    assert(store_pages == pages);
+    eeprom_store_load();
+    assert(read_word(7) == value - 1);
+    printf("  ✓ Фоновое уплотнение журнала до резерва свободных страниц\n");
 }
 
 int main() {
-    printf("Запуск тестов для функций memcpy_to/from_eeprom_with_checksum\n");
+    printf("Запуск тестов журнала настроек в EEPROM\n");
     printf("=============================================================\n");
-    
-    test_basic_write_read();
-    test_corrupted_data();
-    test_write_with_offset();
-    test_multiple_pages();
-    test_edge_cases();
-    test_checksum_algorithm();
-    
+
+    test_crc32();
+    test_load_and_write();
+    test_single_word_write();
+    test_deferred_commit();
+    test_wear_leveling();
+    test_interrupted_record();
+    test_torn_commit();
+    test_recover_block();
+    test_background_compact();
+
     printf("\n=============================================================\n");
     printf("Все тесты пройдены успешно!\n");
-    
+
     return 0;
-}
\ No newline at end of file
+}
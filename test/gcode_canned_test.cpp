@@ -0,0 +1,192 @@
+/*
+ * gcode_canned_test.cpp - Тесты постоянных циклов сверления в парсере g-кода (gcode.cpp)
+ *
+ * Проверяет уровень отвода G98/G99 (начальный Z или плоскость R), сохранение режима отвода между
+ * кадрами, а также повторы L и отказ на L вне 1..255 и на число чистовых проходов H резьбового цикла
+ * G76 больше 255.
+ * Парсер подключается целиком, движения перехватываются заглушками.
+ *
+ * Сборка: g++ -std=gnu++11 -O2 -fsingle-precision-constant -o gcode_canned_test gcode_canned_test.cpp
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cassert>
+#include <cmath>
+
+// Заглушки типов HAL MIK32, которые упоминаются в заголовках Grbl
+typedef int HAL_StatusTypeDef;
+typedef int HAL_PinsTypeDef;
+typedef int GPIO_TypeDef;
+typedef int HAL_GPIO_PullTypeDef;
+typedef int HAL_GPIO_Line_Config;
+typedef int UART_TypeDef;
+
+// Заголовки Grbl в порядке grbl.hpp, без HAL
+#define grbl_h
+#define ENABLE_SPINDLE_SYNC
+#include "../lib/grbl/src/config.hpp"
+#include "../lib/grbl/src/nuts_bolts.hpp"
+#include "../lib/grbl/src/settings.hpp"
+#include "../lib/grbl/src/system.hpp"
+#include "../lib/grbl/src/defaults.hpp"
+#include "../lib/grbl/src/cpu_map.hpp"
+#include "../lib/grbl/src/planner.hpp"
+#include "../lib/grbl/src/coolant_control.hpp"
+#include "../lib/grbl/src/digital_output.hpp"
+#include "../lib/grbl/src/gcode.hpp"
+#include "../lib/grbl/src/gcode_token.hpp"
+#include "../lib/grbl/src/motion_control.hpp"
+#include "../lib/grbl/src/protocol.hpp"
+#include "../lib/grbl/src/report.hpp"
+#include "../lib/grbl/src/spindle_control.hpp"
+#include "../lib/grbl/src/jog.hpp"
+
+// Состояние Grbl и заглушки модулей, которые вызывает парсер
+system_t sys;
+settings_t settings;
+int32_t sys_position[N_AXIS];
+
+float hypot_f(float x, float y) { return sqrtf(x*x + y*y); }
+uint8_t read_float(char *line, uint8_t *char_counter, float *float_ptr)
+{
+  char *end;
+  float value = strtof(line + *char_counter, &end);
+  if (end == line + *char_counter) { return(false); }
+  *float_ptr = value;
+  *char_counter = end - line;
+  return(true);
+}
+uint8_t gc_token_read_word(char *line, uint8_t *char_counter, char *letter, float *value) { return(false); }
+void gc_token_reset() {}
+void system_convert_array_steps_to_mpos(float *position, int32_t *steps) { memset(position, 0, sizeof(float)*N_AXIS); }
+void system_flag_wco_change() {}
+void system_set_exec_state_flag(uint8_t mask) {}
+uint8_t settings_read_coord_data(uint8_t coord_select, float *coord_data) { memset(coord_data, 0, sizeof(float)*N_AXIS); return(true); }
+void settings_write_coord_data(uint8_t coord_select, float *coord_data) {}
+void report_status_message(uint8_t status_code, uint8_t client) {}
+void report_feedback_message(uint8_t message_code) {}
+void protocol_buffer_synchronize() {}
+void protocol_execute_realtime() {}
+void spindle_sync(uint8_t state, float rpm) {}
+void spindle_set_state(uint8_t state, float rpm) {}
+void coolant_sync(uint8_t mode) {}
+void coolant_set_state(uint8_t mode) {}
+uint8_t digital_output_get_state() { return(0); }
+uint16_t digital_output_get_epoch() { return(0); }
+void digital_output_set_immediate(uint8_t output, uint8_t state) {}
+uint8_t jog_execute(plan_line_data_t *pl_data, parser_block_t *gc_block) { return(STATUS_OK); }
+void mc_line(float *target, plan_line_data_t *pl_data) {}
+void mc_dwell(float seconds) {}
+void mc_arc(float *target, plan_line_data_t *pl_data, float *position, float *offset, float radius,
+  uint8_t axis_0, uint8_t axis_1, uint8_t axis_linear, uint8_t is_clockwise_arc) {}
+void mc_spline(float *target, plan_line_data_t *pl_data, float *position, float *control_1, float *control_2) {}
+uint8_t mc_probe_cycle(float *target, plan_line_data_t *pl_data, uint8_t parser_flags) { return(GC_PROBE_FOUND); }
+
+// Резьбовой цикл: запоминает число чистовых проходов.
+static int threads;
+static uint8_t thread_spring_passes;
+void mc_thread(float *target, plan_line_data_t *pl_data) {}
+void mc_threading_cycle(float z_end, plan_line_data_t *pl_data, float *position, float pitch,
+  float peak, float first_depth, float depth, float degression, float angle, uint8_t spring_passes)
+{
+  threads++;
+  thread_spring_passes = spring_passes;
+}
+
+// Цикл сверления: запоминает уровни и, как настоящий, оставляет позицию над отверстием на уровне отвода.
+static int holes;
+static float hole_r_level, hole_clear_level, hole_x;
+void mc_canned_cycle(float *target, plan_line_data_t *pl_data, float *position, float r_level,
+  float clear_level, float peck, float dwell, uint8_t axis_linear, uint8_t cycle)
+{
+  holes++;
+  hole_r_level = r_level;
+  hole_clear_level = clear_level;
+  hole_x = target[X_AXIS];
+  for (uint8_t idx = 0; idx < N_AXIS; idx++) { position[idx] = target[idx]; }
+  position[axis_linear] = clear_level;
+}
+
+// Подключаем реальный парсер без остальной части Grbl.
+#include "../lib/grbl/src/gcode.cpp"
+
+static uint8_t execute(const char *line)
+{
+  char buffer[LINE_BUFFER_SIZE];
+  strcpy(buffer, line);
+  return(gc_execute_line(buffer, CLIENT_SERIAL));
+}
+
+void test_retract_levels() {
+  gc_init();
+  assert(execute("G0Z10") == STATUS_OK);
+  // G99: возврат на плоскость R.
+  holes = 0;
+  assert(execute("G99G81X1Y1Z-2R2F100") == STATUS_OK);
+  assert(gc_state.modal.retract == RETRACT_MODE_R);
+  assert(holes == 1 && hole_r_level == 2.0 && hole_clear_level == 2.0);
+  assert(gc_state.position[Z_AXIS] == 2.0);
+  // Режим отвода сохраняется: следующее отверстие тоже с возвратом на R.
+  assert(execute("X2") == STATUS_OK);
+  assert(holes == 2 && hole_x == 2.0 && hole_clear_level == 2.0);
+
+  // G98: возврат на начальный Z, если он выше R.
+  assert(execute("G0Z10") == STATUS_OK);
+  assert(execute("G98G81X3Y1Z-2R2") == STATUS_OK);
+  assert(gc_state.modal.retract == RETRACT_MODE_OLD_Z);
+  assert(holes == 3 && hole_clear_level == 10.0);
+  assert(gc_state.position[Z_AXIS] == 10.0);
+  // Начальный Z ниже R: возврат на R.
+  assert(execute("G0Z1") == STATUS_OK);
+  assert(execute("G81X4Y1Z-2R2") == STATUS_OK);
+  assert(holes == 4 && hole_clear_level == 2.0);
+  printf("  ✓ G99 возвращает на плоскость R, G98 — на начальный Z\n");
+}
+
+void test_repeat_count() {
+  gc_init();
+  assert(execute("G0Z10") == STATUS_OK);
+  holes = 0;
+  assert(execute("G91G99G81X1Z-2R-8L3F100") == STATUS_OK);
+  assert(holes == 3 && hole_x == 3.0);
+  assert(execute("X1L255") == STATUS_OK);
+  assert(holes == 3 + 255);
+  // L вне 1..255 отвергается, а не переполняет uint8_t.
+  assert(execute("X1L0") == STATUS_NEGATIVE_VALUE);
+  assert(execute("X1L-1") == STATUS_NEGATIVE_VALUE);
+  assert(execute("X1L256") == STATUS_GCODE_MAX_VALUE_EXCEEDED);
+  assert(execute("X1L257") == STATUS_GCODE_MAX_VALUE_EXCEEDED);
+  assert(holes == 3 + 255);
+  printf("  ✓ Повторы L и отказ на L вне 1..255\n");
+}
+
+void test_spring_passes() {
+  gc_init();
+  gc_state.modal.spindle = SPINDLE_ENABLE_CW;
+  threads = 0;
+  assert(execute("G76Z-10P1I-1J0.2K1H255") == STATUS_OK);
+  assert(threads == 1 && thread_spring_passes == 255);
+  // H больше 255 отвергается, а не переполняет uint8_t. Отрицательное H — отказ, как для F, N, T и S.
+  assert(execute("G76Z-10P1I-1J0.2K1H256") == STATUS_GCODE_MAX_VALUE_EXCEEDED);
+  assert(execute("G76Z-10P1I-1J0.2K1H300") == STATUS_GCODE_MAX_VALUE_EXCEEDED);
+  assert(execute("G76Z-10P1I-1J0.2K1H-1") == STATUS_NEGATIVE_VALUE);
+  assert(threads == 1);
+  printf("  ✓ Отказ на H резьбового цикла G76 больше 255\n");
+}
+
+int main() {
+  printf("Запуск тестов постоянных циклов сверления\n");
+  printf("=============================================================\n");
+
+  test_retract_levels();
+  test_repeat_count();
+  test_spring_passes();
+
+  printf("\n=============================================================\n");
+  printf("Все тесты пройдены успешно!\n");
+
+  return 0;
+}
@@ -0,0 +1,309 @@
+/*
+ * gcode_token_test.cpp - Тесты декодера токенизированного g-кода (gcode_token.cpp)
+ *
+ * Проверяет, что токенизированное слово даёт ровно тот же float, что и read_float() на тексте,
+ * из которого оно получено (побитовое сравнение), включая цепочки относительных координат,
+ * а также отказ на повреждённых токенах и на словах-приращениях после сброса опорных значений.
+ *
+ * Сборка: g++ -std=gnu++11 -O2 -fsingle-precision-constant -o gcode_token_test gcode_token_test.cpp
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cassert>
+#include <string>
+
+#define N_AXIS 4 // Как в nuts_bolts.hpp
+#define MAX_INT_DIGITS 8
+#define bit(n) (1 << n)
+#define bit_true(x,mask) (x) |= (mask)
+#define bit_isfalse(x,mask) ((x & mask) == 0)
+
+// Копия decimal_to_float() и read_float() из nuts_bolts.cpp
+float decimal_to_float(uint32_t intval, int8_t exp)
+{
+  float fval;
+  fval = (float)intval;
+  if (fval != 0) {
+    while (exp <= -2) {
+      fval *= 0.01;
+      exp += 2;
+    }
+    if (exp < 0) {
+      fval *= 0.1;
+    } else if (exp > 0) {
+      do {
+        fval *= 10.0;
+      } while (--exp > 0);
+    }
+  }
+  return(fval);
+}
+
+uint8_t read_float(char *line, uint8_t *char_counter, float *float_ptr)
+{
+  char *ptr = line + *char_counter;
+  unsigned char c = *ptr++;
+  bool isnegative = false;
+  if (c == '-') { isnegative = true; c = *ptr++; }
+  else if (c == '+') { c = *ptr++; }
+  uint32_t intval = 0;
+  int8_t exp = 0;
+  uint8_t ndigit = 0;
+  bool isdecimal = false;
+  while(1) {
+    c -= '0';
+    if (c <= 9) {
+      ndigit++;
+      if (ndigit <= MAX_INT_DIGITS) {
+        if (isdecimal) { exp--; }
+        intval = (((intval << 2) + intval) << 1) + c;
+      } else {
+        if (!(isdecimal)) { exp++; }
+      }
+    } else if (c == (('.'-'0') & 0xff)  &&  !(isdecimal)) {
+      isdecimal = true;
+    } else {
+      break;
+    }
+    c = *ptr++;
+  }
+  if (!ndigit) { return(false); };
+  float fval = decimal_to_float(intval, exp);
+  *float_ptr = isnegative ? -fval : fval;
+  *char_counter = ptr - line - 1;
+  return(true);
+}
+
+// Подключаем реальный декодер без остальной части Grbl.
+#include "../lib/grbl/src/gcode_token.hpp"
+#define grbl_h
+#define ENABLE_GCODE_TOKENS
+#include "../lib/grbl/src/gcode_token.cpp"
+
+// Кодировщик, как Tokenizer в doc/script/gcode_tokenize.py
+// decimals < 0: слово-приращение, число знаков передаётся в байте токена.
+static void put_payload(std::string &out, int64_t value, int decimals) {
+    uint64_t n = (value >= 0) ? (uint64_t)value * 2 : (uint64_t)(-value) * 2 - 1;
+    if (decimals >= 0) { n = (n << 3) | decimals; }
+    char groups[8];
+    int count = 0;
+    do { groups[count++] = n & 0x3F; n >>= 6; } while (n);
+    while (count) { out += (char)(GC_TOKEN_PAYLOAD | groups[--count]); }
+}
+
+static bool ref_valid[N_AXIS];
+static int64_t ref_fixed[N_AXIS];
+static const char axis_letters[] = "XYZA";
+
+static std::string encode_word(char letter, int64_t value, uint8_t decimals, bool allow_delta) {
+    const char *a = strchr(axis_letters, letter);
+    int axis = a ? (int)(a - axis_letters) : -1;
+    int64_t scale = 1;
+    for (int i = decimals; i < GC_TOKEN_DECIMALS_MAX; i++) { scale *= 10; }
+    int64_t fixed = value * scale;
+    std::string out(1, (char)(GC_TOKEN_WORD + letter - 'A'));
+    put_payload(out, value, decimals);
+    if (axis >= 0) {
+        if (allow_delta && ref_valid[axis] && (ref_fixed[axis] % scale == 0)) {
+            std::string delta(1, (char)(GC_TOKEN_DELTA + axis * (GC_TOKEN_DECIMALS_MAX + 1) + decimals));
+            put_payload(delta, (fixed - ref_fixed[axis]) / scale, -1);
+            if (delta.size() < out.size()) { out = delta; }
+        }
+        ref_valid[axis] = true;
+        ref_fixed[axis] = fixed;
+    }
+    return out;
+}
+
+// Текстовая запись значения с заданным числом знаков после точки, как в g-коде.
+static std::string format_word(char letter, int64_t value, uint8_t decimals) {
+    char buf[32];
+    uint64_t mag = (value < 0) ? -value : value;
+    uint64_t div = 1;
+    for (int i = 0; i < decimals; i++) { div *= 10; }
+    if (decimals) {
+        snprintf(buf, sizeof(buf), "%c%s%llu.%0*llu", letter, value < 0 ? "-" : "",
+                 (unsigned long long)(mag / div), decimals, (unsigned long long)(mag % div));
+    } else {
+        snprintf(buf, sizeof(buf), "%c%s%llu", letter, value < 0 ? "-" : "", (unsigned long long)mag);
+    }
+    return buf;
+}
+
+static uint32_t rng_state = 12345;
+static uint32_t rng() {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 4;
+}
+
+// Случайное значение, представимое токеном: не более 8 цифр и int32 в единицах 1e-4.
+static int64_t random_value(uint8_t decimals) {
+    static const int64_t limits[] = { 10, 1000, 100000, 10000000, 99999999 };
+    int64_t limit = limits[rng() % 5];
+    int64_t scale = 1;
+    for (int i = decimals; i < GC_TOKEN_DECIMALS_MAX; i++) { scale *= 10; }
+    if (limit > INT32_MAX / scale) { limit = INT32_MAX / scale; }
+    int64_t v = rng() % (limit + 1);
+    return (rng() & 1) ? -v : v;
+}
+
+// Тест 1: Абсолютные и относительные слова дают тот же float, что read_float() на тексте
+void test_roundtrip() {
+    printf("Тест 1: Токены против read_float() на исходном тексте\n");
+
+    const char letters[] = "GMXYZAIJKFSPQRNTL";
+    long words = 0, deltas = 0;
+    size_t text_bytes = 0, token_bytes = 0;
+    for (int n = 0; n < 200000; n++) {
+        char letter = letters[rng() % (sizeof(letters) - 1)];
+        uint8_t decimals = rng() % (GC_TOKEN_DECIMALS_MAX + 1);
+        int64_t value = random_value(decimals);
+
+        std::string text = format_word(letter, value, decimals);
+        std::string token = encode_word(letter, value, decimals, true);
+        if ((uint8_t)token[0] >= GC_TOKEN_DELTA) { deltas++; }
+        text_bytes += text.size();
+        token_bytes += token.size();
+
+        char text_line[64], token_line[64];
+        strcpy(text_line, text.c_str());
+        strcpy(token_line, token.c_str());
+        uint8_t tc = 1, kc = 0;
+        float tv, kv;
+        char letter_out;
+        assert(read_float(text_line, &tc, &tv));
+        assert(gc_token_read_word(token_line, &kc, &letter_out, &kv));
+        assert(letter_out == letter);
+        assert(kc == token.size());
+        assert(memcmp(&tv, &kv, sizeof(float)) == 0);
+        words++;
+    }
+    printf("  слов: %ld, из них относительных: %ld\n", words, deltas);
+    printf("  текст %zu байт, токены %zu байт (%.2fx)\n", text_bytes, token_bytes,
+           (double)text_bytes / token_bytes);
+    printf("  ✓ Все значения совпадают побитово\n");
+}
+
+// Тест 2: Строка из текстовых и токенизированных слов вперемешку
+void test_mixed_line() {
+    printf("Тест 2: Смешанная строка\n");
+
+    memset(ref_valid, 0, sizeof(ref_valid));
+    std::string line = "G1" + encode_word('X', 12345, 3, true) + "Y-2.5" + encode_word('F', 1500, 0, true);
+    std::string next = encode_word('X', 12845, 3, true); // X12.845 относительно X12.345
+    assert((uint8_t)next[0] == GC_TOKEN_DELTA + 3); // Ось X, три знака
+
+    char buf[64];
+    strcpy(buf, (line + next).c_str());
+    uint8_t counter = 0;
+    const char expected_letters[] = "GXYFX";
+    const float expected_values[] = { 1.0f, 12.345f, -2.5f, 1500.0f, 12.845f };
+    for (int i = 0; i < 5; i++) {
+        char letter = buf[counter];
+        float value;
+        if ((uint8_t)letter >= GC_TOKEN_WORD) {
+            assert(gc_token_read_word(buf, &counter, &letter, &value));
+        } else {
+            counter++;
+            assert(read_float(buf, &counter, &value));
+        }
+        assert(letter == expected_letters[i]);
+        assert(value == expected_values[i]);
+    }
+    assert(buf[counter] == 0);
+    printf("  ✓ Строка разобрана как текстовая\n");
+}
+
+// Тест 3: Повреждённые токены отклоняются
+void test_malformed() {
+    printf("Тест 3: Повреждённые токены\n");
+
+    char letter;
+    float value;
+    uint8_t counter;
+
+    char no_payload[] = { (char)(GC_TOKEN_WORD + 'X' - 'A'), 0 };
+    counter = 0;
+    assert(!gc_token_read_word(no_payload, &counter, &letter, &value));
+
+    char bad_letter[] = { (char)(GC_TOKEN_WORD + 26), (char)0x80, 0 };
+    counter = 0;
+    assert(!gc_token_read_word(bad_letter, &counter, &letter, &value));
+
+    char bad_axis[] = { (char)(GC_TOKEN_DELTA + N_AXIS * (GC_TOKEN_DECIMALS_MAX + 1)), (char)0x80, 0 };
+    counter = 0;
+    assert(!gc_token_read_word(bad_axis, &counter, &letter, &value));
+
+    char too_long[] = { (char)GC_TOKEN_WORD, (char)0xBF, (char)0xBF, (char)0xBF, (char)0xBF,
+                        (char)0xBF, (char)0xBF, 0 };
+    counter = 0;
+    assert(!gc_token_read_word(too_long, &counter, &letter, &value));
+
+    std::string bad_decimals(1, (char)GC_TOKEN_WORD);
+    bad_decimals += (char)(GC_TOKEN_PAYLOAD | 5); // d = 5
+    counter = 0;
+    assert(!gc_token_read_word((char *)bad_decimals.c_str(), &counter, &letter, &value));
+
+    // Относительное значение с меньшим числом знаков, чем у опорного, не попадает в сетку значения.
+    memset(ref_valid, 0, sizeof(ref_valid));
+    std::string line = encode_word('Y', 12345, 4, false); // Y1.2345
+    line += (char)(GC_TOKEN_DELTA + 1 * (GC_TOKEN_DECIMALS_MAX + 1) + 1);
+    put_payload(line, 1, -1); // +0.1 с одним знаком: 1.3345 не записывается одним знаком
+    counter = 0;
+    assert(gc_token_read_word((char *)line.c_str(), &counter, &letter, &value));
+    assert(!gc_token_read_word((char *)line.c_str(), &counter, &letter, &value));
+    printf("  ✓ Повреждённые токены отклонены\n");
+}
+
+// Тест 4: После сброса опорных значений слово-приращение отклоняется до абсолютного слова
+void test_reset() {
+    printf("Тест 4: Сброс опорных значений\n");
+
+    char letter;
+    float value;
+    uint8_t counter;
+    char buf[16];
+
+    memset(ref_valid, 0, sizeof(ref_valid));
+    strcpy(buf, encode_word('X', 10, 0, true).c_str());
+    counter = 0;
+    assert(gc_token_read_word(buf, &counter, &letter, &value) && value == 10.0f);
+
+    // Строка с X15 отклонена до разбора: хост сдвинул опорное значение, Grbl — нет.
+    encode_word('X', 15, 0, true);
+    gc_token_reset();
+    std::string delta = encode_word('X', 20, 0, true); // +5 относительно X15
+    assert((uint8_t)delta[0] >= GC_TOKEN_DELTA);
+    strcpy(buf, delta.c_str());
+    counter = 0;
+    assert(!gc_token_read_word(buf, &counter, &letter, &value)); // А не X15 относительно X10
+
+    // Хост тоже сбросил опорные значения после ошибки: абсолютное слово, затем снова приращения.
+    memset(ref_valid, 0, sizeof(ref_valid));
+    std::string line = encode_word('X', 20, 0, true);
+    line += encode_word('X', 25, 0, true);
+    assert((uint8_t)line[0] < GC_TOKEN_DELTA);
+    strcpy(buf, line.c_str());
+    counter = 0;
+    assert(gc_token_read_word(buf, &counter, &letter, &value) && value == 20.0f);
+    assert(gc_token_read_word(buf, &counter, &letter, &value) && value == 25.0f);
+    printf("  ✓ Слово-приращение после сброса отклонено, абсолютное слово восстанавливает отсчёт\n");
+}
+
+int main() {
+    printf("Запуск тестов декодера токенизированного g-кода\n");
+    printf("=============================================================\n");
+
+    test_roundtrip();
+    test_mixed_line();
+    test_malformed();
+    test_reset();
+
+    printf("\n=============================================================\n");
+    printf("Все тесты пройдены успешно!\n");
+
+    return 0;
+}
@@ -0,0 +1,194 @@
+/*
+ * mc_queue_test.cpp - Тесты очереди предварительного разбора (motion_control.cpp, protocol.cpp)
+ *
+ * Проверяет, что запись лазерного пустого блока M3, ожидающая опустошения буфера
+ * (wait_spindle_sync), выполняется из точки проверки реального времени в состоянии IDLE,
+ * а не зависает навсегда. Подключаются настоящие motion_control.cpp и protocol.cpp,
+ * планировщик и остальная часть Grbl заменены заглушками.
+ *
+ * Сборка: g++ -std=gnu++11 -O2 -fsingle-precision-constant -o mc_queue_test mc_queue_test.cpp
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cassert>
+#include <cmath>
+
+// Заглушки типов HAL MIK32, которые упоминаются в заголовках Grbl
+typedef int HAL_StatusTypeDef;
+typedef int HAL_PinsTypeDef;
+typedef int GPIO_TypeDef;
+typedef int HAL_GPIO_PullTypeDef;
+typedef int HAL_GPIO_Line_Config;
+typedef int UART_TypeDef;
+
+// Заголовки Grbl в порядке grbl.hpp, без HAL
+#define grbl_h
+#define LINE_FLAG_OVERFLOW bit(0)
+#define LINE_FLAG_COMMENT_PARENTHESES bit(1)
+#define LINE_FLAG_COMMENT_SEMICOLON bit(2)
+#define LINE_FLAG_LINE_READ bit(3)
+#define LINE_FLAG_LINE_STARTED bit(4)
+#include "../lib/grbl/src/config.hpp"
+#include "../lib/grbl/src/nuts_bolts.hpp"
+#include "../lib/grbl/src/settings.hpp"
+#include "../lib/grbl/src/system.hpp"
+#include "../lib/grbl/src/defaults.hpp"
+#include "../lib/grbl/src/cpu_map.hpp"
+#include "../lib/grbl/src/planner.hpp"
+#include "../lib/grbl/src/coolant_control.hpp"
+#include "../lib/grbl/src/digital_output.hpp"
+#include "../lib/grbl/src/eeprom.hpp"
+#include "../lib/grbl/src/gcode.hpp"
+#include "../lib/grbl/src/gcode_token.hpp"
+#include "../lib/grbl/src/limits.hpp"
+#include "../lib/grbl/src/arc_fixed.hpp"
+#include "../lib/grbl/src/step_count.hpp"
+#include "../lib/grbl/src/motion_control.hpp"
+#include "../lib/grbl/src/print.hpp"
+#include "../lib/grbl/src/probe.hpp"
+#include "../lib/grbl/src/protocol.hpp"
+#include "../lib/grbl/src/report.hpp"
+#include "../lib/grbl/src/serial.hpp"
+#include "../lib/grbl/src/serial_frame.hpp"
+#include "../lib/grbl/src/raster.hpp"
+#include "../lib/grbl/src/spindle_control.hpp"
+#include "../lib/grbl/src/spindle_encoder.hpp"
+#include "../lib/grbl/src/stepper.hpp"
+#include "../lib/grbl/src/jog.hpp"
+#include "../lib/grbl/src/job_store.hpp"
+
+// Состояние Grbl
+system_t sys;
+settings_t settings;
+parser_state_t gc_state;
+int32_t sys_position[N_AXIS];
+int32_t sys_probe_position[N_AXIS];
+volatile uint8_t sys_probe_state;
+volatile uint8_t sys_rt_exec_state;
+volatile uint8_t sys_rt_exec_alarm;
+volatile uint8_t sys_rt_exec_motion_override;
+volatile uint8_t sys_rt_exec_accessory_override;
+
+// Планировщик: полон или нет, есть ли исполняемый блок, пуст ли новый блок.
+static uint8_t planner_full, planner_block_count, planner_empty_blocks;
+static plan_block_t planner_block;
+uint8_t plan_check_full_buffer() { return(planner_full); }
+plan_block_t *plan_get_current_block() { return(planner_block_count ? &planner_block : NULL); }
+uint8_t plan_buffer_line(float *target, plan_line_data_t *pl_data)
+{
+  if (planner_empty_blocks) { return(PLAN_EMPTY_BLOCK); }
+  planner_block_count++;
+  return(PLAN_OK);
+}
+void plan_reset() { planner_block_count = 0; }
+void plan_sync_position() {}
+void plan_cycle_reinitialize() {}
+void plan_update_velocity_profile_parameters() {}
+
+// Шпиндель: запоминаем синхронные установки из очереди.
+static uint8_t spindle_sets;
+static float spindle_rpm;
+void spindle_set_state(uint8_t state, float rpm) { spindle_sets++; spindle_rpm = rpm; }
+void spindle_sync(uint8_t state, float rpm) { spindle_set_state(state, rpm); }
+void spindle_stop() {}
+
+// Остальные модули не участвуют в тесте.
+float hypot_f(float x, float y) { return sqrtf(x*x + y*y); }
+void delay(uint8_t) {}
+void delay_sec(float seconds, uint8_t mode) {}
+void coolant_stop() {}
+uint8_t coolant_get_state() { return(0); }
+void coolant_set_state(uint8_t mode) {}
+void eeprom_store_commit() {}
+void eeprom_store_compact() {}
+char *frame_read_line(uint8_t *seq, uint8_t *type, uint16_t *length) { return(NULL); }
+void frame_send_ack(uint8_t seq, uint8_t status_code) {}
+void frame_service() {}
+uint8_t gc_execute_line(char *line, uint8_t client) { return(STATUS_OK); }
+void gc_token_reset() {}
+void gc_sync_position() {}
+void limits_disable() {}
+uint8_t limits_get_state() { return(0); }
+void limits_go_home(uint8_t cycle_mask) {}
+void limits_init() {}
+void limits_soft_check(float *target) {}
+void probe_configure_invert_mask(uint8_t is_probe_away) {}
+uint8_t probe_get_state() { return(0); }
+uint8_t raster_execute_scanline(uint8_t *data, uint16_t length) { return(STATUS_OK); }
+void report_ack_flush() {}
+void report_alarm_message(uint8_t alarm_code) {}
+void report_auto_service() {}
+void report_feedback_message(uint8_t message_code) {}
+void report_line_status(uint8_t status_code, uint8_t client) {}
+void report_probe_parameters(uint8_t client) {}
+void report_realtime_status(uint8_t client) {}
+void st_get_snapshot(st_snapshot_t *snapshot) { memset(snapshot, 0, sizeof(st_snapshot_t)); }
+void st_go_idle() {}
+void st_prep_buffer() {}
+void st_reset() {}
+void st_update_plan_block_parameters() {}
+void st_wake_up() {}
+uint8_t system_check_safety_door_ajar() { return(false); }
+void system_clear_exec_accessory_overrides() { sys_rt_exec_accessory_override = 0; }
+void system_clear_exec_alarm() { sys_rt_exec_alarm = 0; }
+void system_clear_exec_motion_overrides() { sys_rt_exec_motion_override = 0; }
+void system_clear_exec_state_flag(uint8_t mask) { sys_rt_exec_state &= ~mask; }
+void system_set_exec_accessory_override_flag(uint8_t mask) { sys_rt_exec_accessory_override |= mask; }
+void system_set_exec_alarm(uint8_t code) { sys_rt_exec_alarm = code; }
+void system_set_exec_state_flag(uint8_t mask) { sys_rt_exec_state |= mask; }
+uint8_t system_execute_line(char *line, uint8_t client) { return(STATUS_OK); }
+void system_execute_startup(char *line) {}
+
+// Подключаем реальные модули без остальной части Grbl.
+#include "../lib/grbl/src/motion_control.cpp"
+#include "../lib/grbl/src/protocol.cpp"
+
+void test_wait_spindle_sync_drains_in_idle() {
+  memset(&sys, 0, sizeof(sys));
+  settings.flags = BITFLAG_LASER_MODE;
+  mc_queue_reset();
+
+  // Буфер планировщика полон: M3 с нулевым перемещением уходит в очередь предварительного разбора.
+  sys.state = STATE_CYCLE;
+  planner_full = true;
+  planner_block_count = 1;
+  plan_line_data_t pl_data;
+  memset(&pl_data, 0, sizeof(pl_data));
+  pl_data.condition = PL_COND_FLAG_SPINDLE_CW;
+  pl_data.spindle_speed = 500.0;
+  float target[N_AXIS] = {0};
+  mc_line(target, &pl_data);
+  assert(mc_queue_pending() == 1);
+
+  // Место освободилось, но блок пустой: запись ждёт опустошения буфера, пока идёт цикл.
+  planner_full = false;
+  planner_empty_blocks = true;
+  protocol_execute_realtime();
+  assert(mc_queue_pending() == 1 && spindle_sets == 0);
+
+  // Цикл завершён, станок в IDLE: запись выполняется из точки проверки реального времени.
+  planner_block_count = 0;
+  sys.state = STATE_IDLE;
+  protocol_execute_realtime();
+  assert(mc_queue_pending() == 0);
+  assert(spindle_sets == 1 && spindle_rpm == 500.0);
+
+  // Синхронизация буфера больше не ждёт очередь.
+  protocol_buffer_synchronize();
+  printf("  ✓ Ожидающий пустой блок M3 выполняется в состоянии IDLE\n");
+}
+
+int main() {
+  printf("Запуск тестов очереди предварительного разбора\n");
+  printf("=============================================================\n");
+
+  test_wait_spindle_sync_drains_in_idle();
+
+  printf("\n=============================================================\n");
+  printf("Все тесты пройдены успешно!\n");
+
+  return 0;
+}
@@ -0,0 +1,206 @@
+/*
+ * print_format_test.cpp - Тесты целочисленного форматирования чисел (print.cpp)
+ *
+ * Сравнивает новый printFloat() и вывод координат из шагов (шаги * единицы отчёта на шаг,
+ * как report_buffer_axis_steps() в report.cpp) с прежним выводом: деление шагов на шаги/мм
+ * и прежний printFloat(). Новый вывод везде, кроме окрестности границы округления в пределах
+ * погрешности float, равен точному значению, округлённому от нуля. Точные десятичные значения
+ * выводятся так же, как раньше. Прежний вывод координат терял точность на промежуточном
+ * значении в мм и отличается не больше чем на 2 единицы последнего знака.
+ *
+ * Сборка: g++ -std=gnu++11 -O2 -fsingle-precision-constant -o print_format_test print_format_test.cpp
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cassert>
+#include <cmath>
+#include <string>
+
+// Заглушки Grbl, которые использует print.cpp
+#define N_DECIMAL_COORDVALUE_INCH 4
+#define N_DECIMAL_COORDVALUE_MM   3
+#define N_DECIMAL_RATEVALUE_INCH  1
+#define N_DECIMAL_RATEVALUE_MM    0
+#define INCH_PER_MM (0.0393701)
+#define BITFLAG_REPORT_INCHES 1
+#define bit_istrue(x,mask) ((x & mask) != 0)
+struct { uint8_t flags; } settings;
+
+static std::string out;
+void serial_write(uint8_t data) { out += (char)data; }
+void xprintf(const char *s) { out += s; }
+
+// Подключаем реальный модуль без остальной части Grbl.
+#include "../lib/grbl/src/print.hpp"
+#define grbl_h
+#include "../lib/grbl/src/print.cpp"
+
+// Прежний printFloat() до перехода на одно умножение, выводит в строку.
+static std::string old_printFloat(float n, uint8_t decimal_places) {
+    std::string s;
+    if (n < 0) { s += '-'; n = -n; }
+    uint8_t decimals = decimal_places;
+    while (decimals >= 2) { n *= 100; decimals -= 2; }
+    if (decimals) { n *= 10; }
+    n += 0.5;
+    unsigned char buf[13];
+    uint8_t i = 0;
+    uint32_t a = (long)n;
+    while (a > 0) { buf[i++] = (a % 10) + '0'; a /= 10; }
+    while (i < decimal_places) { buf[i++] = '0'; }
+    if (i == decimal_places) { buf[i++] = '0'; }
+    for (; i > 0; i--) {
+        if (i == decimal_places) { s += '.'; }
+        s += buf[i-1];
+    }
+    return s;
+}
+
+static std::string new_printFloat(float n, uint8_t decimal_places) {
+    out.clear();
+    printFloat(n, decimal_places);
+    return out;
+}
+
+// Вывод координаты из шагов, как report_buffer_axis_steps().
+static std::string new_steps(int32_t steps, float units_per_step, float offset, float units_per_mm,
+                             uint8_t decimals) {
+    char buf[PRINT_FLOAT_SIZE + 1];
+    float n = steps * units_per_step;
+    n -= offset * units_per_mm;
+    uint8_t length = print_scaled_to_buffer(buf, n, decimals);
+    assert(length <= PRINT_FLOAT_SIZE);
+    buf[length] = 0;
+    return buf;
+}
+
+// Расстояние от точного значения (в единицах последнего знака) до ближайшей границы округления.
+static double tie_distance(double scaled) {
+    double frac = fabs(scaled) - floor(fabs(scaled));
+    return fabs(frac - 0.5);
+}
+
+static long parse_units(const std::string &s) {
+    std::string digits;
+    for (char c : s) { if (c != '.') { digits += c; } }
+    return atol(digits.c_str());
+}
+
+static uint32_t rng_state = 4321;
+static uint32_t rng() {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 4;
+}
+
+// Проверяет новый вывод: вдали от границы округления он равен точному значению, округлённому
+// от нуля. Прежний вывод отличается не больше чем на 2 единицы последнего знака: в прежнем пути
+// значение в мм округлялось до float ещё до масштабирования. Возвращает true, если выводы разные.
+static bool check_parity(const std::string &old_text, const std::string &new_text, double exact_scaled,
+                         double tolerance) {
+    long new_units = parse_units(new_text);
+    if (tie_distance(exact_scaled) > tolerance) {
+        long correct = (long)floor(fabs(exact_scaled) + 0.5);
+        if (exact_scaled < 0) { correct = -correct; }
+        if (new_units != correct) {
+            printf("  неверное округление: %s (точно %.6f)\n", new_text.c_str(), exact_scaled);
+            assert(false);
+        }
+    }
+    if (labs(parse_units(old_text) - new_units) > 2) { printf("  %s / %s (точно %.6f)\n", old_text.c_str(), new_text.c_str(), exact_scaled); }
+    assert(labs(parse_units(old_text) - new_units) <= 2);
+    return old_text != new_text;
+}
+
+void test_printFloat() {
+    // Значения, которые float различает до последнего знака: до 2^22 единиц последнего знака, шаг float не больше половины единицы.
+    int differ = 0;
+    const int count = 200000;
+    for (int i = 0; i < count; i++) {
+        uint8_t decimals = rng() % (PRINT_DECIMALS_MAX + 1);
+        float n = ((int32_t)(rng() % 8388609) - 4194304) / (float)(1 << (rng() % 8)) / print_pow10[decimals];
+        double exact = (double)n * pow(10.0, decimals);
+        // Прежний путь округляет при каждом умножении, новый — один раз. Допуск растёт с величиной,
+        // как шаг float.
+        differ += check_parity(old_printFloat(n, decimals), new_printFloat(n, decimals), exact,
+                               4e-7 * fabs(exact) + 1e-6);
+    }
+    // Точные десятичные значения g-кода не расходятся совсем.
+    for (int32_t v = -200000; v <= 200000; v += 7) {
+        float n = v / 1000.0;
+        assert(old_printFloat(n, 3) == new_printFloat(n, 3));
+    }
+    assert(new_printFloat(0, 3) == "0.000");
+    assert(new_printFloat(-0.0001, 3) == "-0.000"); // Как прежде
+    assert(new_printFloat(12.5, 0) == "13");
+    assert(new_printFloat(123.45678, 4) == "123.4568");
+    printf("  ✓ printFloat округляет точно (отличий от прежнего вывода: %d из %d)\n", differ, count);
+}
+
+void test_axis_steps() {
+    const float spm_list[] = { 80.0, 100.0, 157.48, 250.0, 400.0, 3200.0, 78.7402, 1.0 };
+    const float offsets[] = { 0.0, 12.345, -250.0, 0.0005, 1000.1234 };
+    int differ = 0;
+    int total = 0;
+    for (int inches = 0; inches < 2; inches++) {
+        uint8_t decimals = inches ? N_DECIMAL_COORDVALUE_INCH : N_DECIMAL_COORDVALUE_MM;
+        float units_per_mm = inches ? print_pow10[N_DECIMAL_COORDVALUE_INCH] * INCH_PER_MM
+                                    : print_pow10[N_DECIMAL_COORDVALUE_MM];
+        for (float spm : spm_list) {
+            float units_per_step = units_per_mm / spm; // Как report_update_step_units()
+            for (float offset : offsets) {
+                for (int i = 0; i < 20000; i++) {
+                    int32_t steps = (int32_t)(rng() % 2000001) - 1000000;
+                    if (i < 2000) { steps = i - 1000; } // Все значения около нуля
+                    // Прежний путь: system_convert_axis_steps_to_mpos(), вычитание WCO, printFloat().
+                    float pos = steps / spm;
+                    pos -= offset;
+                    std::string old_text = inches ? old_printFloat(pos * INCH_PER_MM, decimals)
+                                                  : old_printFloat(pos, decimals);
+                    std::string new_text = new_steps(steps, units_per_step, offset, units_per_mm, decimals);
+                    double exact = ((double)steps / spm - offset) * units_per_mm;
+                    if (fabs(exact) >= 4194304) { continue; } // Последний знак уже за точностью float.
+                    // Погрешность float растёт с величиной: допуск в единицах последнего знака.
+                    double tolerance = 4e-7 * (fabs(exact) + fabs(offset * units_per_mm)) + 1e-6;
+                    differ += check_parity(old_text, new_text, exact, tolerance);
+                    total++;
+                }
+            }
+        }
+    }
+    printf("  ✓ Координаты из шагов округляются точно (отличий от прежнего вывода: %d из %d)\n",
+           differ, total);
+}
+
+void test_fixed() {
+    char buf[PRINT_FLOAT_SIZE + 1];
+    uint8_t length = print_fixed_to_buffer(buf, 4294967295u, 0);
+    buf[length] = 0;
+    assert(std::string(buf) == "4294967295");
+    length = print_fixed_to_buffer(buf, 5, 4);
+    buf[length] = 0;
+    assert(std::string(buf) == "0.0005");
+    length = print_fixed_to_buffer(buf, 0, 0);
+    buf[length] = 0;
+    assert(std::string(buf) == "0");
+    // Слишком большие значения ограничиваются и не выходят за PRINT_FLOAT_SIZE.
+    length = print_scaled_to_buffer(buf, -1.0e12, 3);
+    assert(length <= PRINT_FLOAT_SIZE);
+    printf("  ✓ Целые и граничные значения\n");
+}
+
+int main() {
+    printf("Запуск тестов целочисленного форматирования чисел\n");
+    printf("=============================================================\n");
+
+    test_fixed();
+    test_printFloat();
+    test_axis_steps();
+
+    printf("\n=============================================================\n");
+    printf("Все тесты пройдены успешно!\n");
+
+    return 0;
+}
@@ -0,0 +1,246 @@
+/*
+ * protocol_token_test.cpp - Тесты сброса опорных значений токенизированного g-кода (protocol.cpp)
+ *
+ * Проверяет, что строка, отклонённая до разбора или посреди разбора, сбрасывает опорные значения
+ * осей, и следующее слово-приращение отклоняется, а не отсчитывается от значения, которое хост уже
+ * сдвинул. Подключаются настоящие protocol.cpp и gcode_token.cpp, парсер заменён заглушкой,
+ * которая только декодирует слова.
+ *
+ * Сборка: g++ -std=gnu++11 -O2 -fsingle-precision-constant -o protocol_token_test protocol_token_test.cpp
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cassert>
+#include <cmath>
+#include <string>
+
+// Заглушки типов HAL MIK32, которые упоминаются в заголовках Grbl
+typedef int HAL_StatusTypeDef;
+typedef int HAL_PinsTypeDef;
+typedef int GPIO_TypeDef;
+typedef int HAL_GPIO_PullTypeDef;
+typedef int HAL_GPIO_Line_Config;
+typedef int UART_TypeDef;
+
+// Заголовки Grbl в порядке grbl.hpp, без HAL
+#define grbl_h
+#define LINE_FLAG_OVERFLOW bit(0)
+#define LINE_FLAG_COMMENT_PARENTHESES bit(1)
+#define LINE_FLAG_COMMENT_SEMICOLON bit(2)
+#define LINE_FLAG_LINE_READ bit(3)
+#define LINE_FLAG_LINE_STARTED bit(4)
+#include "../lib/grbl/src/config.hpp"
+#include "../lib/grbl/src/nuts_bolts.hpp"
+#include "../lib/grbl/src/settings.hpp"
+#include "../lib/grbl/src/system.hpp"
+#include "../lib/grbl/src/defaults.hpp"
+#include "../lib/grbl/src/cpu_map.hpp"
+#include "../lib/grbl/src/planner.hpp"
+#include "../lib/grbl/src/coolant_control.hpp"
+#include "../lib/grbl/src/digital_output.hpp"
+#include "../lib/grbl/src/eeprom.hpp"
+#include "../lib/grbl/src/gcode.hpp"
+#include "../lib/grbl/src/gcode_token.hpp"
+#include "../lib/grbl/src/limits.hpp"
+#include "../lib/grbl/src/arc_fixed.hpp"
+#include "../lib/grbl/src/step_count.hpp"
+#include "../lib/grbl/src/motion_control.hpp"
+#include "../lib/grbl/src/print.hpp"
+#include "../lib/grbl/src/probe.hpp"
+#include "../lib/grbl/src/protocol.hpp"
+#include "../lib/grbl/src/report.hpp"
+#include "../lib/grbl/src/serial.hpp"
+#include "../lib/grbl/src/serial_frame.hpp"
+#include "../lib/grbl/src/raster.hpp"
+#include "../lib/grbl/src/spindle_control.hpp"
+#include "../lib/grbl/src/spindle_encoder.hpp"
+#include "../lib/grbl/src/stepper.hpp"
+#include "../lib/grbl/src/jog.hpp"
+#include "../lib/grbl/src/job_store.hpp"
+
+// Состояние Grbl
+system_t sys;
+settings_t settings;
+parser_state_t gc_state;
+int32_t sys_position[N_AXIS];
+int32_t sys_probe_position[N_AXIS];
+volatile uint8_t sys_probe_state;
+volatile uint8_t sys_rt_exec_state;
+volatile uint8_t sys_rt_exec_alarm;
+volatile uint8_t sys_rt_exec_motion_override;
+volatile uint8_t sys_rt_exec_accessory_override;
+
+// Парсер: декодирует слова как gc_execute_line() и запоминает значение X. Текстовое слово E
+// отклоняет строку после слов перед ним, как ошибка в середине строки.
+static float parsed_x;
+uint8_t read_float(char *line, uint8_t *char_counter, float *float_ptr)
+{
+  char *end;
+  float value = strtof(line + *char_counter, &end);
+  if (end == line + *char_counter) { return(false); }
+  *float_ptr = value;
+  *char_counter = end - line;
+  return(true);
+}
+float decimal_to_float(uint32_t intval, int8_t exp) { return((float)intval * powf(10.0f, exp)); }
+uint8_t gc_execute_line(char *line, uint8_t client)
+{
+  uint8_t char_counter = 0;
+  char letter;
+  float value, x = parsed_x;
+  while (line[char_counter] != 0) {
+    letter = line[char_counter];
+    if ((uint8_t)letter >= GC_TOKEN_WORD) {
+      if (!gc_token_read_word(line, &char_counter, &letter, &value)) { return(STATUS_BAD_NUMBER_FORMAT); }
+    } else {
+      if (letter == 'E') { return(STATUS_GCODE_UNSUPPORTED_COMMAND); }
+      char_counter++;
+      if (!read_float(line, &char_counter, &value)) { return(STATUS_BAD_NUMBER_FORMAT); }
+    }
+    if (letter == 'X') { x = value; }
+  }
+  parsed_x = x;
+  return(STATUS_OK);
+}
+
+// Остальные модули не участвуют в тесте.
+float hypot_f(float x, float y) { return sqrtf(x*x + y*y); }
+void delay(uint8_t) {}
+void delay_sec(float seconds, uint8_t mode) {}
+void coolant_stop() {}
+uint8_t coolant_get_state() { return(0); }
+void coolant_set_state(uint8_t mode) {}
+void eeprom_store_commit() {}
+void eeprom_store_compact() {}
+char *frame_read_line(uint8_t *seq, uint8_t *type, uint16_t *length) { return(NULL); }
+void frame_send_ack(uint8_t seq, uint8_t status_code) {}
+void frame_service() {}
+void gc_sync_position() {}
+void limits_disable() {}
+uint8_t limits_get_state() { return(0); }
+void limits_go_home(uint8_t cycle_mask) {}
+void limits_init() {}
+void limits_soft_check(float *target) {}
+void probe_configure_invert_mask(uint8_t is_probe_away) {}
+uint8_t probe_get_state() { return(0); }
+uint8_t raster_execute_scanline(uint8_t *data, uint16_t length) { return(STATUS_OK); }
+void report_ack_flush() {}
+void report_alarm_message(uint8_t alarm_code) {}
+void report_auto_service() {}
+void report_feedback_message(uint8_t message_code) {}
+void report_line_status(uint8_t status_code, uint8_t client) {}
+void report_probe_parameters(uint8_t client) {}
+void report_realtime_status(uint8_t client) {}
+void st_get_snapshot(st_snapshot_t *snapshot) { memset(snapshot, 0, sizeof(st_snapshot_t)); }
+void st_go_idle() {}
+void st_prep_buffer() {}
+void st_reset() {}
+void st_update_plan_block_parameters() {}
+void st_wake_up() {}
+uint8_t system_check_safety_door_ajar() { return(false); }
+void system_clear_exec_accessory_overrides() { sys_rt_exec_accessory_override = 0; }
+void system_clear_exec_alarm() { sys_rt_exec_alarm = 0; }
+void system_clear_exec_motion_overrides() { sys_rt_exec_motion_override = 0; }
+void system_clear_exec_state_flag(uint8_t mask) { sys_rt_exec_state &= ~mask; }
+void system_set_exec_accessory_override_flag(uint8_t mask) { sys_rt_exec_accessory_override |= mask; }
+void system_set_exec_alarm(uint8_t code) { sys_rt_exec_alarm = code; }
+void system_set_exec_state_flag(uint8_t mask) { sys_rt_exec_state |= mask; }
+uint8_t system_execute_line(char *line, uint8_t client) { return(STATUS_OK); }
+void system_execute_startup(char *line) {}
+
+uint8_t plan_check_full_buffer() { return(false); }
+plan_block_t *plan_get_current_block() { return(NULL); }
+void plan_reset() {}
+void plan_sync_position() {}
+void plan_cycle_reinitialize() {}
+void plan_update_velocity_profile_parameters() {}
+void spindle_set_state(uint8_t state, float rpm) {}
+void spindle_stop() {}
+void mc_queue_reset() {}
+void mc_queue_service() {}
+uint8_t mc_queue_pending() { return(0); }
+
+// Подключаем реальные модули без остальной части Grbl.
+#include "../lib/grbl/src/gcode_token.cpp"
+#include "../lib/grbl/src/protocol.cpp"
+
+// Кодировщик оси X с целыми значениями, как Tokenizer в doc/script/gcode_tokenize.py.
+static bool host_ref_valid;
+static int32_t host_ref;
+static void put_payload(std::string &out, int64_t value, int decimals) {
+  uint64_t n = (value >= 0) ? (uint64_t)value * 2 : (uint64_t)(-value) * 2 - 1;
+  if (decimals >= 0) { n = (n << 3) | decimals; }
+  char groups[8];
+  int count = 0;
+  do { groups[count++] = n & 0x3F; n >>= 6; } while (n);
+  while (count) { out += (char)(GC_TOKEN_PAYLOAD | groups[--count]); }
+}
+static std::string encode_x(int32_t value) {
+  std::string out;
+  if (host_ref_valid) {
+    out += (char)(GC_TOKEN_DELTA + 0); // Ось X, без знаков после точки.
+    put_payload(out, value - host_ref, -1);
+  } else {
+    out += (char)(GC_TOKEN_WORD + 'X' - 'A');
+    put_payload(out, value, 0);
+  }
+  host_ref_valid = true;
+  host_ref = value;
+  return(out);
+}
+
+static uint8_t send(std::string line)
+{
+  char buffer[LINE_BUFFER_SIZE];
+  strcpy(buffer, line.c_str());
+  return(protocol_execute_host_line(buffer, CLIENT_SERIAL));
+}
+
+void test_locked_line() {
+  memset(&sys, 0, sizeof(sys));
+  gc_token_reset();
+  host_ref_valid = false;
+  assert(send("G1" + encode_x(10)) == STATUS_OK && parsed_x == 10.0f);
+
+  // В режиме тревоги строка отклонена без разбора, а хост уже отсчитывает от X15.
+  sys.state = STATE_ALARM;
+  assert(send(encode_x(15)) == STATUS_SYSTEM_GC_LOCK);
+  sys.state = STATE_IDLE;
+  assert(send(encode_x(20)) != STATUS_OK); // А не X15 относительно X10
+  assert(parsed_x == 10.0f);
+
+  // Хост сбрасывает опорные значения на ошибке: абсолютное слово, затем снова приращения.
+  host_ref_valid = false;
+  assert(send(encode_x(20)) == STATUS_OK && parsed_x == 20.0f);
+  assert(send(encode_x(25)) == STATUS_OK && parsed_x == 25.0f);
+  printf("  ✓ Слово-приращение после отклонённой строки отклонено\n");
+}
+
+void test_line_rejected_midway() {
+  memset(&sys, 0, sizeof(sys));
+  gc_token_reset();
+  host_ref_valid = false;
+  assert(send(encode_x(10)) == STATUS_OK);
+
+  // Ошибка после слова X: Grbl разобрал его, но строка не выполнена.
+  assert(send(encode_x(30) + "E1") == STATUS_GCODE_UNSUPPORTED_COMMAND);
+  assert(send(encode_x(35)) != STATUS_OK);
+  assert(parsed_x == 10.0f);
+  printf("  ✓ Строка с ошибкой в середине тоже сбрасывает опорные значения\n");
+}
+
+int main() {
+  printf("Запуск тестов сброса опорных значений токенизированного g-кода\n");
+  printf("=============================================================\n");
+
+  test_locked_line();
+  test_line_rejected_midway();
+
+  printf("\n=============================================================\n");
+  printf("Все тесты пройдены успешно!\n");
+
+  return 0;
+}
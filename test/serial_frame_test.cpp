@@ -0,0 +1,343 @@
+/*
+ * serial_frame_test.cpp - Тесты кадрового протокола последовательного порта (serial_frame.cpp)
+ *
+ * Проверяет CRC и экранирование кадров, очередь строк с окном подтверждений, повтор ACK на
+ * повторённые кадры (в том числе после перехода номеров через 255), NAK на потерю, порчу и переполнение окна, двоичные кадры строк растра 'S',
+ * а также real-time команды между кадрами и в кадре 'R'.
+ *
+ * Сборка: g++ -std=gnu++11 -O2 -o serial_frame_test serial_frame_test.cpp
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cassert>
+#include <string>
+#include <vector>
+
+// Заглушки Grbl, которые использует serial_frame.cpp
+#define LINE_BUFFER_SIZE 200
+#define SERIAL_FRAME_WINDOW 3 // Не делит 256: номера кадров и слоты очереди расходятся при переходе через 255
+#define CLIENT_SERIAL 1
+#define EXEC_STATUS_REPORT 1
+#define CMD_RESET 0x18
+#define CMD_STATUS_REPORT '?'
+#define CMD_CYCLE_START '~'
+#define CMD_FEED_HOLD '!'
+
+static std::vector<uint8_t> tx;        // Всё, что Grbl отправил
+static std::string realtime;           // Выполненные real-time команды
+static int status_reports;
+
+void serial_write(uint8_t data) { tx.push_back(data); }
+uint8_t serial_execute_realtime(uint8_t data, uint8_t client) { realtime += (char)data; return 1; }
+void system_set_exec_state_flag(uint8_t mask) { status_reports++; }
+void HAL_IRQ_DisableInterrupts() {}
+void HAL_IRQ_EnableInterrupts() {}
+
+// Подключаем реальный протокол без остальной части Grbl.
+#include "../lib/grbl/src/serial_frame.hpp"
+#define grbl_h
+#define ENABLE_SERIAL_FRAMING
+#include "../lib/grbl/src/serial_frame.cpp"
+
+// CRC-16/CCITT-FALSE побитно, как crc16() в doc/script/frame_stream.py
+static uint16_t crc16_ref(const std::vector<uint8_t> &data) {
+    uint16_t crc = 0xFFFF;
+    for (uint8_t b : data) {
+        crc ^= b << 8;
+        for (int i = 0; i < 8; i++) { crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1); }
+    }
+    return crc;
+}
+
+// Кодировщик кадров хоста, как encode_frame() в frame_stream.py
+static std::vector<uint8_t> encode_frame(char type, uint8_t seq, const std::string &payload) {
+    std::vector<uint8_t> body = { (uint8_t)type, seq };
+    body.insert(body.end(), payload.begin(), payload.end());
+    uint16_t crc = crc16_ref(body);
+    body.push_back(crc >> 8);
+    body.push_back(crc & 0xFF);
+    std::vector<uint8_t> out = { FRAME_START };
+    for (uint8_t b : body) {
+        if (b == FRAME_START || b == FRAME_END || b == FRAME_ESCAPE || b == CMD_RESET ||
+            b == '?' || b == '~' || b == '!') {
+            out.push_back(FRAME_ESCAPE);
+            b ^= FRAME_ESCAPE_XOR;
+        }
+        out.push_back(b);
+    }
+    out.push_back(FRAME_END);
+    return out;
+}
+
+static void feed(const std::vector<uint8_t> &bytes) {
+    for (uint8_t b : bytes) { frame_receive_byte(b); }
+}
+
+struct Reply { char type; uint8_t seq; int status; };
+
+// Разбирает отправленные Grbl кадры и очищает tx. Кадр с неверной CRC — ошибка теста.
+static std::vector<Reply> replies() {
+    std::vector<Reply> out;
+    size_t i = 0;
+    while (i < tx.size()) {
+        assert(tx[i] == FRAME_START);
+        std::vector<uint8_t> body;
+        for (i++; tx[i] != FRAME_END; i++) {
+            assert(tx[i] != FRAME_START && tx[i] != CMD_RESET && tx[i] != '?' && tx[i] != '~' && tx[i] != '!');
+            if (tx[i] == FRAME_ESCAPE) { body.push_back(tx[++i] ^ FRAME_ESCAPE_XOR); }
+            else { body.push_back(tx[i]); }
+        }
+        i++;
+        assert(body.size() >= 4);
+        uint16_t crc = (body[body.size()-2] << 8) | body[body.size()-1];
+        body.resize(body.size() - 2);
+        assert(crc16_ref(body) == crc);
+        out.push_back({ (char)body[0], body[1], body.size() > 2 ? body[2] : -1 });
+    }
+    tx.clear();
+    return out;
+}
+
+// Выполняет все строки из очереди, как protocol_main_loop(), со статусом status.
+static std::vector<std::string> execute_all(uint8_t status) {
+    std::vector<std::string> lines;
+    char *line;
+    uint8_t seq, type;
+    uint16_t length;
+    while ((line = frame_read_line(&seq, &type, &length)) != NULL) {
+        assert(type == 'L' && length == strlen(line));
+        lines.push_back(line);
+        frame_send_ack(seq, status);
+    }
+    return lines;
+}
+
+void test_crc() {
+    // Табличная CRC по полубайтам совпадает с побитной и с контрольным значением "123456789".
+    const char *check = "123456789";
+    assert(frame_crc16((const uint8_t *)check, 9) == 0x29B1);
+    std::vector<uint8_t> data;
+    for (int i = 0; i < 256; i++) {
+        data.push_back((uint8_t)(i * 37 + 11));
+        assert(frame_crc16(data.data(), data.size()) == crc16_ref(data));
+    }
+    printf("  ✓ CRC-16/CCITT совпадает с эталоном\n");
+}
+
+void test_lines_and_acks() {
+    frame_enter();
+    tx.clear();
+    // Полезная нагрузка с байтами, которые требуют экранирования, и токенами 0x80 и выше.
+    std::string tokenized = "G1";
+    tokenized += (char)0xD7; tokenized += (char)0x83;
+    std::string escaped = "$X?~!";
+    escaped += (char)FRAME_START; escaped += (char)FRAME_ESCAPE; escaped += (char)CMD_RESET;
+    feed(encode_frame('L', 0, "G0X1"));
+    feed(encode_frame('L', 1, tokenized));
+    feed(encode_frame('L', 2, escaped));
+    assert(realtime.empty()); // Экранированные '?', '~', '!' не выполняются как команды
+    std::vector<std::string> lines = execute_all(0);
+    assert(lines.size() == 3);
+    assert(lines[0] == "G0X1" && lines[1] == tokenized && lines[2] == escaped);
+    std::vector<Reply> r = replies();
+    assert(r.size() == 3);
+    for (int i = 0; i < 3; i++) { assert(r[i].type == 'A' && r[i].seq == i && r[i].status == 0); }
+
+    // Номера кадров переходят через 255.
+    for (int i = 3; i < 300; i++) {
+        feed(encode_frame('L', (uint8_t)i, "G1X" + std::to_string(i)));
+        lines = execute_all(i % 7);
+        assert(lines.size() == 1 && lines[0] == "G1X" + std::to_string(i));
+        r = replies();
+        assert(r.size() == 1 && r[0].seq == (uint8_t)i && r[0].status == i % 7);
+    }
+    printf("  ✓ Строки доставляются по порядку, ACK несёт статус\n");
+}
+
+void test_window() {
+    frame_enter();
+    tx.clear();
+    // Окно заполнено: следующий кадр отклоняется с NAK, пока строки не выполнены.
+    for (int i = 0; i < SERIAL_FRAME_WINDOW; i++) { feed(encode_frame('L', i, "G4P0")); }
+    feed(encode_frame('L', SERIAL_FRAME_WINDOW, "G4P1"));
+    frame_service();
+    std::vector<Reply> r = replies();
+    assert(r.size() == 1 && r[0].type == 'N' && r[0].seq == SERIAL_FRAME_WINDOW);
+    // Хост повторяет с первого неподтверждённого кадра (go-back-N).
+    assert(execute_all(0).size() == SERIAL_FRAME_WINDOW);
+    replies();
+    feed(encode_frame('L', SERIAL_FRAME_WINDOW, "G4P1"));
+    std::vector<std::string> lines = execute_all(0);
+    assert(lines.size() == 1 && lines[0] == "G4P1");
+    replies();
+    printf("  ✓ Переполнение окна даёт NAK\n");
+}
+
+void test_window_wrap() {
+    frame_enter();
+    tx.clear();
+    // Окно всё время заполнено, все ACK теряются, и хост повторяет последние кадры. Повторные ACK
+    // несут статусы своих строк и после перехода номеров через 255.
+    for (int base = 0; base < 600; base += SERIAL_FRAME_WINDOW) {
+        for (int i = base; i < base + SERIAL_FRAME_WINDOW; i++) {
+            feed(encode_frame('L', (uint8_t)i, "G1X" + std::to_string(i)));
+        }
+        char *line;
+        uint8_t seq, type;
+        uint16_t length;
+        for (int i = base; i < base + SERIAL_FRAME_WINDOW; i++) {
+            line = frame_read_line(&seq, &type, &length);
+            assert(line && seq == (uint8_t)i && std::string(line) == "G1X" + std::to_string(i));
+            frame_send_ack(seq, i % 251);
+        }
+        assert(frame_read_line(&seq, &type, &length) == NULL);
+        replies();
+        for (int i = base; i < base + SERIAL_FRAME_WINDOW; i++) {
+            feed(encode_frame('L', (uint8_t)i, "G1X" + std::to_string(i)));
+        }
+        frame_service();
+        std::vector<Reply> r = replies();
+        assert(r.size() == SERIAL_FRAME_WINDOW);
+        for (int i = 0; i < SERIAL_FRAME_WINDOW; i++) {
+            assert(r[i].type == 'A' && r[i].seq == (uint8_t)(base + i) && r[i].status == (base + i) % 251);
+        }
+        assert(execute_all(0).empty());
+    }
+    printf("  ✓ Окно не степени двойки работает после перехода номеров через 255\n");
+}
+
+void test_loss_and_repeat() {
+    frame_enter();
+    tx.clear();
+    // Кадр 1 потерян: на кадры 2 и 3 отправляется один NAK с ожидаемым номером.
+    feed(encode_frame('L', 0, "G0X0"));
+    feed(encode_frame('L', 2, "G0X2"));
+    feed(encode_frame('L', 3, "G0X3"));
+    frame_service();
+    std::vector<Reply> r = replies();
+    assert(r.size() == 1 && r[0].type == 'N' && r[0].seq == 1);
+
+    // Строка 0 выполнена, её ACK потерян. Хост повторяет 0, 1, 2, 3.
+    assert(execute_all(5).size() == 1);
+    replies();
+    feed(encode_frame('L', 0, "G0X0"));
+    feed(encode_frame('L', 1, "G0X1"));
+    feed(encode_frame('L', 2, "G0X2"));
+    feed(encode_frame('L', 3, "G0X3"));
+    frame_service();
+    r = replies();
+    assert(r.size() == 1 && r[0].type == 'A' && r[0].seq == 0 && r[0].status == 5);
+    std::vector<std::string> lines = execute_all(0);
+    assert(lines.size() == 3 && lines[0] == "G0X1" && lines[2] == "G0X3");
+
+    // Повтор кадра, который ещё в очереди, не ставится второй раз и не подтверждается заранее.
+    feed(encode_frame('L', 4, "G0X4"));
+    feed(encode_frame('L', 4, "G0X4"));
+    replies();
+    frame_service();
+    assert(replies().empty());
+    assert(execute_all(0).size() == 1);
+    replies();
+    printf("  ✓ Потерянные кадры и ACK восстанавливаются повтором\n");
+}
+
+void test_corruption() {
+    frame_enter();
+    tx.clear();
+    std::vector<uint8_t> frame = encode_frame('L', 0, "G0X10");
+    frame[4] ^= 0x01;
+    feed(frame);
+    frame_service();
+    std::vector<Reply> r = replies();
+    assert(r.size() == 1 && r[0].type == 'N' && r[0].seq == 0);
+    assert(execute_all(0).empty());
+
+    // Слишком длинный кадр отбрасывается целиком. NAK один на потерю, поэтому начинаем заново.
+    frame_enter();
+    feed(encode_frame('L', 0, std::string(LINE_BUFFER_SIZE, 'X')));
+    frame_service();
+    r = replies();
+    assert(r.size() == 1 && r[0].type == 'N');
+    assert(execute_all(0).empty());
+    // Самая длинная допустимая строка проходит.
+    std::string longest(LINE_BUFFER_SIZE - 1, 'Y');
+    feed(encode_frame('L', 0, longest));
+    std::vector<std::string> lines = execute_all(0);
+    assert(lines.size() == 1 && lines[0] == longest);
+    replies();
+    printf("  ✓ Повреждённые и слишком длинные кадры отклонены\n");
+}
+
+void test_scanline() {
+    frame_enter();
+    tx.clear();
+    // Двоичная строка растра: нули и байты кадра внутри полезной нагрузки доставляются целиком.
+    std::string scanline;
+    for (int i = 0; i < LINE_BUFFER_SIZE - 1; i++) { scanline += (char)(i * 7); }
+    feed(encode_frame('L', 0, "M4"));
+    feed(encode_frame('S', 1, scanline));
+    feed(encode_frame('S', 2, std::string(1, '\0')));
+    char *payload;
+    uint8_t seq, type;
+    uint16_t length;
+    payload = frame_read_line(&seq, &type, &length);
+    assert(payload && type == 'L' && seq == 0 && length == 2);
+    frame_send_ack(seq, 0);
+    payload = frame_read_line(&seq, &type, &length);
+    assert(payload && type == 'S' && seq == 1 && length == scanline.size());
+    assert(memcmp(payload, scanline.data(), length) == 0);
+    frame_send_ack(seq, 42);
+    payload = frame_read_line(&seq, &type, &length);
+    assert(payload && type == 'S' && seq == 2 && length == 1 && payload[0] == 0);
+    frame_send_ack(seq, 0);
+    assert(frame_read_line(&seq, &type, &length) == NULL);
+    std::vector<Reply> r = replies();
+    assert(r.size() == 3 && r[1].type == 'A' && r[1].seq == 1 && r[1].status == 42);
+    printf("  ✓ Двоичные кадры строк растра\n");
+}
+
+void test_realtime() {
+    frame_enter();
+    tx.clear();
+    realtime.clear();
+    status_reports = 0;
+    // ASCII команды между кадрами выполняются, прочие байты игнорируются.
+    std::vector<uint8_t> bytes = { '!', '?', 'G', 0x85, '~' };
+    feed(bytes);
+    assert(realtime == "!G~" && status_reports == 1);
+    // Расширенные команды передаются кадром 'R'.
+    realtime.clear();
+    std::string cmds;
+    cmds += (char)0x85; cmds += '?'; cmds += (char)0x91;
+    feed(encode_frame('R', 0, cmds));
+    assert(realtime == "\x85\x91" && status_reports == 2);
+    // Кадр 'X' возвращает в строковый режим.
+    feed(encode_frame('X', 0, ""));
+    assert(!frame_mode_active());
+    frame_enter();
+    frame_init();
+    assert(!frame_mode_active());
+    assert(replies().empty());
+    printf("  ✓ Real-time команды между кадрами и в кадре 'R'\n");
+}
+
+int main() {
+    printf("Запуск тестов кадрового протокола последовательного порта\n");
+    printf("=============================================================\n");
+
+    test_crc();
+    test_lines_and_acks();
+    test_window();
+    test_window_wrap();
+    test_loss_and_repeat();
+    test_corruption();
+    test_scanline();
+    test_realtime();
+
+    printf("\n=============================================================\n");
+    printf("Все тесты пройдены успешно!\n");
+
+    return 0;
+}
@@ -0,0 +1,197 @@
+/*
+ * spindle_encoder_test.cpp - Тесты времени индексных импульсов шпинделя (spindle_encoder.cpp)
+ *
+ * Проверяет измерение оборотов по индексным импульсам, остановку шпинделя по таймауту, переполнение
+ * 32-битного таймера, ожидание индексного импульса и обороты от него с интерполяцией между
+ * импульсами, а также имитацию импульсов по заданной скорости шпинделя (SPINDLE_ENCODER_SIMULATED).
+ * Модуль подключается дважды: с индексным входом и с имитацией.
+ *
+ * Сборка: g++ -std=gnu++11 -O2 -fsingle-precision-constant -o spindle_encoder_test spindle_encoder_test.cpp
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cassert>
+#include <cmath>
+
+// Заглушки Grbl и HAL MIK32, которые использует spindle_encoder.cpp
+#define ELRON_ACE_UNO
+#define ENABLE_SPINDLE_SYNC
+#define F_CPU 32000000
+#define SPINDLE_SYNC_MIN_RPM 30.0
+#define SPINDLE_STATE_DISABLE 0
+#define SPINDLE_STATE_CW 1
+#define TIMER32_STATE_DISABLE 0
+#define TIMER32_SOURCE_PRESCALER 0
+#define TIMER32_COUNTMODE_FORWARD 0
+#define HAL_GPIO_PULL_UP 1
+#define GPIO_IRQ_LINE_S 0
+#define SPINDLE_ENCODER_TIMER 1
+#define SPINDLE_INDEX_PORT 1
+#define SPINDLE_INDEX_BIT 6
+#define SPINDLE_INDEX_LINE_IRQ 6
+typedef int HAL_GPIO_Line_Config;
+typedef struct { uint8_t Source; uint16_t Prescaler; } TIMER32_ClockConfigTypeDef;
+typedef struct { int Instance; uint32_t Top; uint8_t State; TIMER32_ClockConfigTypeDef Clock;
+                 uint32_t InterruptMask; uint8_t CountMode; } TIMER32_HandleTypeDef;
+
+static uint32_t fake_time;    // Счёт таймера, мкс
+static uint16_t timer_prescaler;
+static int index_pin_irq = -1;
+void HAL_Timer32_Init(TIMER32_HandleTypeDef *timer) { timer_prescaler = timer->Clock.Prescaler; }
+void HAL_Timer32_Value_Clear(TIMER32_HandleTypeDef *timer) { fake_time = 0; }
+void HAL_Timer32_Start(TIMER32_HandleTypeDef *timer) {}
+uint32_t HAL_Timer32_Value_Get(TIMER32_HandleTypeDef *timer) { return fake_time; }
+void PinInitInputIRQ(int pin, int port, int pull, HAL_GPIO_Line_Config irq_line) { index_pin_irq = irq_line; }
+void ClearGPIOInterruptLines(uint8_t mask) {}
+
+struct { uint8_t abort; float spindle_speed; } sys;
+static uint8_t spindle_state;
+uint8_t spindle_get_state() { return spindle_state; }
+
+// Шпиндель для protocol_execute_realtime(): каждый вызов — 1 мс, с индексными импульсами через
+// spindle_period мкс, пока spindle_period не ноль.
+static uint32_t spindle_period;
+static uint32_t next_pulse;
+static void (*index_input)(uint32_t time);
+void protocol_execute_realtime() {
+    uint32_t end = fake_time + 1000;
+    while (spindle_period && index_input && (int32_t)(end - next_pulse) >= 0) {
+        fake_time = next_pulse;
+        index_input(next_pulse);
+        next_pulse += spindle_period;
+    }
+    fake_time = end;
+}
+
+// Подключаем реальный модуль без остальной части Grbl: с индексным входом и с имитацией.
+#include "../lib/grbl/src/spindle_encoder.hpp"
+#define grbl_h
+namespace hw {
+#include "../lib/grbl/src/spindle_encoder.cpp"
+}
+#define SPINDLE_ENCODER_SIMULATED
+namespace sim {
+#include "../lib/grbl/src/spindle_encoder.cpp"
+}
+
+static bool near(float a, float b, float tolerance) { return fabs(a - b) <= tolerance; }
+
+void test_rpm() {
+    hw::spindle_encoder_init();
+    assert(timer_prescaler == 31); // 1 МГц от 32 МГц
+    assert(index_pin_irq == SPINDLE_INDEX_LINE_IRQ);
+    assert(hw::spindle_encoder_rpm() == 0.0);
+    fake_time = 1000;
+    hw::spindle_encoder_index(1000);
+    assert(hw::spindle_encoder_rpm() == 0.0); // Один импульс ещё не даёт период
+    fake_time = 61000;
+    hw::spindle_encoder_index(61000);
+    fake_time += 100;
+    assert(near(hw::spindle_encoder_rpm(), 1000.0, 0.01));
+    // Через два периода без импульса шпиндель считается остановленным.
+    fake_time = 61000 + 2*60000;
+    assert(near(hw::spindle_encoder_rpm(), 1000.0, 0.01));
+    fake_time++;
+    assert(hw::spindle_encoder_rpm() == 0.0);
+    // Импульсы реже SPINDLE_SYNC_MIN_RPM — остановленный шпиндель.
+    hw::spindle_encoder_index(fake_time);
+    fake_time += SPINDLE_INDEX_PERIOD_MAX + 1;
+    hw::spindle_encoder_index(fake_time);
+    assert(hw::spindle_encoder_rpm() == 0.0);
+    printf("  ✓ Обороты по индексным импульсам и остановка шпинделя\n");
+}
+
+void test_timer_wrap() {
+    hw::spindle_encoder_init();
+    uint32_t t = 0xFFFFFFFFu - 20000;
+    hw::spindle_encoder_index(t);
+    t += 60000; // Переполнение счёта таймера
+    hw::spindle_encoder_index(t);
+    fake_time = t + 30000;
+    assert(near(hw::spindle_encoder_rpm(), 1000.0, 0.01));
+    printf("  ✓ Переполнение таймера импульсов\n");
+}
+
+void test_sync_revs() {
+    hw::spindle_encoder_init();
+    index_input = hw::spindle_encoder_index;
+    spindle_period = 100000; // 600 об/мин
+    next_pulse = 12345;
+    for (int i = 0; i < 300; i++) { protocol_execute_realtime(); } // Разгон, несколько оборотов
+    assert(near(hw::spindle_encoder_rpm(), 600.0, 0.01));
+
+    hw::spindle_encoder_sync_clear();
+    assert(!hw::spindle_encoder_sync_ready());
+    assert(hw::spindle_encoder_wait_index());
+    assert(hw::spindle_encoder_sync_ready());
+    uint32_t sync_pulse = next_pulse - spindle_period;
+    // Обороты от импульса синхронизации: четверть оборота вперёд, с экстраполяцией.
+    assert(near(hw::spindle_encoder_sync_revs(25000/60.0e6), 0.25, 1e-4));
+    // Через несколько оборотов отсчёт продолжается от того же импульса.
+    while ((int32_t)(fake_time - (sync_pulse + 3*spindle_period + 50000)) < 0) { protocol_execute_realtime(); }
+    assert(near(hw::spindle_encoder_sync_revs(350000/60.0e6), 3.5, 1e-4));
+    assert(near(hw::spindle_encoder_sync_revs(10*spindle_period/60.0e6), 10.0, 1e-3));
+    // Время до последнего импульса даёт обороты меньше числа импульсов.
+    assert(near(hw::spindle_encoder_sync_revs(150000/60.0e6), 1.5, 1e-4));
+    printf("  ✓ Обороты от индексного импульса синхронизации\n");
+}
+
+void test_wait_index_fail() {
+    // Шпиндель остановился во время ожидания.
+    spindle_period = 0;
+    assert(!hw::spindle_encoder_wait_index());
+    // Сброс во время ожидания.
+    spindle_period = 100000;
+    next_pulse = fake_time + 1000;
+    for (int i = 0; i < 300; i++) { protocol_execute_realtime(); }
+    sys.abort = true;
+    assert(!hw::spindle_encoder_wait_index());
+    sys.abort = false;
+    spindle_period = 0;
+    index_input = 0;
+    printf("  ✓ Ожидание индексного импульса прерывается остановкой шпинделя и сбросом\n");
+}
+
+void test_simulated() {
+    sim::spindle_encoder_init();
+    fake_time = 5000;
+    sys.spindle_speed = 1200.0;
+    spindle_state = SPINDLE_STATE_DISABLE;
+    assert(sim::spindle_encoder_rpm() == 0.0);
+    spindle_state = SPINDLE_STATE_CW;
+    assert(near(sim::spindle_encoder_rpm(), 1200.0, 0.01)); // Сразу на полной скорости
+    assert(sim::spindle_encoder_wait_index());
+    // Обороты растут с заданной скоростью: 1200 об/мин, 20 оборотов в секунду.
+    assert(near(sim::spindle_encoder_sync_revs(0.5/60.0), 10.0, 1e-3));
+    for (int i = 0; i < 1000; i++) { protocol_execute_realtime(); } // Секунда
+    assert(near(sim::spindle_encoder_sync_revs(1.25/60.0), 25.0, 1e-3));
+    // Долгий перерыв между чтениями обрабатывается сразу.
+    fake_time += 600000000;
+    assert(near(sim::spindle_encoder_rpm(), 1200.0, 0.01));
+    // Новая скорость — со следующего импульса.
+    sys.spindle_speed = 600.0;
+    fake_time += 100000;
+    assert(near(sim::spindle_encoder_rpm(), 600.0, 0.01));
+    // Ниже SPINDLE_SYNC_MIN_RPM шпиндель стоит.
+    sys.spindle_speed = 10.0;
+    assert(sim::spindle_encoder_rpm() == 0.0);
+    printf("  ✓ Имитация индексных импульсов по заданной скорости шпинделя\n");
+}
+
+int main() {
+    printf("Запуск тестов индексных импульсов шпинделя\n");
+    printf("=============================================================\n");
+
+    test_rpm();
+    test_timer_wrap();
+    test_sync_revs();
+    test_wait_index_fail();
+    test_simulated();
+
+    printf("\n=============================================================\n");
+    printf("Все тесты пройдены успешно!\n");
+
+    return 0;
+}
@@ -0,0 +1,187 @@
+/*
+ * step_count_test.cpp - Тесты целочисленного учёта шагов генератора сегментов (step_count.cpp)
+ *
+ * Прогоняет блоки в миллионы шагов через нарезку на сегменты, как st_prep_buffer(): разгон,
+ * движение с постоянной скоростью и торможение по float расстоянию, шаги сегмента — разность
+ * целых оставшихся шагов. Сумма шагов сегментов должна точно равняться step_event_count,
+ * в том числе с остановом подачи посреди блока. Для сравнения выводится, сколько шагов
+ * терял прежний учёт шагов во float.
+ *
+ * Сборка: g++ -std=gnu++11 -O2 -fsingle-precision-constant -o step_count_test step_count_test.cpp
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cassert>
+#include <cmath>
+
+#define ACCELERATION_TICKS_PER_SECOND 100 // Как в config.hpp
+#define DT_SEGMENT (1.0/(ACCELERATION_TICKS_PER_SECOND*60.0)) // Как в stepper.cpp
+
+// Подключаем реальный модуль без остальной части Grbl.
+#include "../lib/grbl/src/step_count.hpp"
+#define grbl_h
+#include "../lib/grbl/src/step_count.cpp"
+
+// Результат нарезки блока на сегменты
+struct Result {
+    uint64_t steps;      // Сумма шагов сегментов
+    uint32_t segments;
+    uint32_t max_n_step; // Сегмент не должен превышать uint16_t n_step
+    float max_lag;       // Наибольшее отставание конца сегмента от точного расстояния, шагов
+};
+
+// Нарезает блок millimeters мм на сегменты с разгоном до speed мм/мин и торможением до нуля,
+// как st_prep_buffer(). Сегменты идут от mm_start до mm_complete мм от конца блока.
+// steps_remaining — целые шаги, оставшиеся до первого сегмента, как prep.steps_remaining.
+static Result cut_block(uint32_t *steps_remaining, float step_per_mm, float millimeters, float mm_start,
+                        float mm_complete, float speed, float acceleration) {
+    Result r = { 0, 0, 0, 0.0 };
+    float mm_remaining = mm_start;
+    float current_speed = 0.0;
+    float accelerate_until = millimeters - 0.5 * speed * speed / acceleration;
+    float decelerate_after = 0.5 * speed * speed / acceleration;
+    while (mm_remaining > mm_complete) {
+        float dt = DT_SEGMENT;
+        if (mm_remaining > accelerate_until) {
+            current_speed = sqrt(2 * acceleration * (millimeters - mm_remaining)) + acceleration * dt;
+        } else if (mm_remaining > decelerate_after) {
+            current_speed = speed;
+        } else {
+            current_speed = sqrt(2 * acceleration * mm_remaining);
+        }
+        if (current_speed > speed) { current_speed = speed; }
+        if (current_speed < 1.0) { current_speed = 1.0; } // Минимальная скорость, как в планировщике
+        mm_remaining -= current_speed * dt;
+        if (mm_remaining < mm_complete) { mm_remaining = mm_complete; }
+
+        float step_dist_remaining = step_per_mm * mm_remaining;
+        uint32_t n_steps_remaining = step_count_remaining(step_dist_remaining, *steps_remaining);
+        assert(n_steps_remaining <= *steps_remaining);
+        uint32_t n_step = *steps_remaining - n_steps_remaining;
+        float partial = step_count_partial(n_steps_remaining, step_dist_remaining);
+        assert(partial >= 0.0 && partial <= 1.0);
+        if (n_step > r.max_n_step) { r.max_n_step = n_step; }
+        double lag = fabs((double)n_steps_remaining - (double)step_per_mm * mm_remaining);
+        if (lag > r.max_lag) { r.max_lag = lag; }
+        r.steps += n_step;
+        r.segments++;
+        *steps_remaining = n_steps_remaining;
+    }
+    return r;
+}
+
+// Прежний учёт шагов во float для того же блока: шаги сегмента из ceil() оставшихся шагов.
+static int64_t old_float_steps(uint32_t step_event_count, float millimeters, float speed,
+                               float acceleration) {
+    float steps_remaining = (float)step_event_count;
+    float step_per_mm = steps_remaining / millimeters;
+    float mm_remaining = millimeters;
+    int64_t steps = 0;
+    float accelerate_until = millimeters - 0.5 * speed * speed / acceleration;
+    float decelerate_after = 0.5 * speed * speed / acceleration;
+    while (mm_remaining > 0.0) {
+        float current_speed;
+        if (mm_remaining > accelerate_until) {
+            current_speed = sqrt(2 * acceleration * (millimeters - mm_remaining)) + acceleration * DT_SEGMENT;
+        } else if (mm_remaining > decelerate_after) {
+            current_speed = speed;
+        } else {
+            current_speed = sqrt(2 * acceleration * mm_remaining);
+        }
+        if (current_speed > speed) { current_speed = speed; }
+        if (current_speed < 1.0) { current_speed = 1.0; }
+        mm_remaining -= current_speed * DT_SEGMENT;
+        if (mm_remaining < 0.0) { mm_remaining = 0.0; }
+        float n_steps_remaining = ceil(step_per_mm * mm_remaining);
+        steps += (uint16_t)(ceil(steps_remaining) - n_steps_remaining); // n_step сегмента — uint16_t
+        steps_remaining = n_steps_remaining;
+    }
+    return steps;
+}
+
+// Тест 1: Граничные значения step_count_remaining() и step_count_partial()
+void test_bounds() {
+    printf("Тест 1: Граничные значения\n");
+    assert(step_count_remaining(0.0, 1000) == 0);
+    assert(step_count_remaining(-0.5, 1000) == 0); // Конец блока с погрешностью округления
+    assert(step_count_remaining(999.2, 1000) == 1000);
+    assert(step_count_remaining(1000.4, 1000) == 1000); // Не больше шагов до сегмента
+    assert(step_count_remaining(5.0e9, 4000000000u) == 4000000000u);
+    assert(step_count_remaining(20000000.0, 19999999) == 19999999);
+    // Выше 2^24 float различает только чётные числа: результат не превышает оставшиеся шаги.
+    for (uint32_t s = 16777210; s < 16777300; s++) {
+        for (int k = -16; k < 16; k++) {
+            float d = (float)(s + k * 0.5L); // Ближайший float к s + k/2
+            assert(step_count_remaining(d, s) <= s);
+        }
+    }
+    assert(step_count_partial(10, 9.25) == 0.75);
+    assert(step_count_partial(10, 10.0) == 0.0);
+    assert(step_count_partial(10, 10.5) == 0.0);
+    printf("  ✓ Шаги не уходят за границы блока\n");
+}
+
+// Тест 2: Длинные блоки в миллионы шагов выполняются без потерь
+void test_long_blocks() {
+    printf("Тест 2: Блоки в миллионы шагов\n");
+    struct { float millimeters; float step_per_mm; float speed; float acceleration; } blocks[] = {
+        { 3000.0, 400.0, 6000.0, 36000.0 },     // Ось 3 м, 400 шаг/мм: 1.2 млн шагов
+        { 3000.0, 6400.0, 250.0, 3600.0 },      // Та же ось с микрошагом 1/16: 19.2 млн шагов
+        { 3000.0, 6400.0, 30.0, 3600.0 },       // Медленно: много сегментов
+        { 4242.6407, 3200.0, 500.0, 18000.0 },  // Диагональ 3x3 м, 13.6 млн шагов
+        { 10000.0, 1600.0, 1000.0, 36000.0 },   // 16 млн шагов, около 2^24
+        { 2.5, 6400.0, 250.0, 3600.0 },         // Короткий блок с треугольным профилем
+    };
+    for (auto &b : blocks) {
+        // Нечётное число шагов: выше 2^24 оно не представимо во float.
+        uint32_t step_event_count = (uint32_t)lround((double)b.millimeters * b.step_per_mm) | 1;
+        uint32_t steps_remaining = step_event_count;
+        float step_per_mm = step_event_count / b.millimeters; // Как в st_prep_buffer()
+        Result r = cut_block(&steps_remaining, step_per_mm, b.millimeters, b.millimeters, 0.0, b.speed,
+                             b.acceleration);
+        int64_t old_steps = old_float_steps(step_event_count, b.millimeters, b.speed, b.acceleration);
+        printf("  %8u шагов, %7u сегментов, отставание до %.2f шага, прежний учёт: %+lld шагов\n",
+               step_event_count, r.segments, r.max_lag, (long long)(old_steps - step_event_count));
+        assert(r.steps == step_event_count);
+        assert(steps_remaining == 0);
+        assert(r.max_n_step <= 0xFFFF); // n_step сегмента — uint16_t
+        assert(r.max_lag <= 4.0);
+    }
+    printf("  ✓ Сумма шагов сегментов равна step_event_count\n");
+}
+
+// Тест 3: Останов подачи посреди длинного блока и продолжение с сохранённых целых шагов
+void test_hold() {
+    printf("Тест 3: Останов подачи посреди блока\n");
+    const float millimeters = 3000.0;
+    const uint32_t step_event_count = 19200001;
+    float step_per_mm = step_event_count / millimeters;
+    uint32_t steps_remaining = step_event_count;
+    uint64_t steps = 0;
+    float mm_start = millimeters;
+    const float holds[] = { 2999.0, 2000.123, 1777.777, 250.5, 0.001, 0.0 };
+    for (float mm_complete : holds) {
+        // Как pl_block->millimeters после останова: блок продолжается с оставшегося расстояния.
+        Result r = cut_block(&steps_remaining, step_per_mm, mm_start, mm_start, mm_complete, 250.0, 3600.0);
+        steps += r.steps;
+        mm_start = mm_complete;
+    }
+    assert(steps == step_event_count);
+    assert(steps_remaining == 0);
+    printf("  ✓ После остановов выполнены все %u шагов\n", step_event_count);
+}
+
+int main() {
+    printf("Запуск тестов целочисленного учёта шагов\n");
+    printf("=============================================================\n");
+
+    test_bounds();
+    test_long_blocks();
+    test_hold();
+
+    printf("\n=============================================================\n");
+    printf("Все тесты пройдены успешно!\n");
+
+    return 0;
+}